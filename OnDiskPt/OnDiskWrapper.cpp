@@ -25,6 +25,7 @@
 #include "OnDiskWrapper.h"
 #include "moses/Util.h"
 #include "util/exception.hh"
+#include "util/file.hh"
 #include "util/string_stream.hh"
 
 using namespace std;
@@ -35,6 +36,7 @@ namespace OnDiskPt
 int OnDiskWrapper::VERSION_NUM = 7;
 
 OnDiskWrapper::OnDiskWrapper()
+  :m_rootSourceNode(NULL)
 {
 }
 
@@ -43,9 +45,9 @@ OnDiskWrapper::~OnDiskWrapper()
   delete m_rootSourceNode;
 }
 
-void OnDiskWrapper::BeginLoad(const std::string &filePath)
+void OnDiskWrapper::BeginLoad(const std::string &filePath, util::LoadMethod loadMethod)
 {
-  if (!OpenForLoad(filePath)) {
+  if (!OpenForLoad(filePath, loadMethod)) {
     UTIL_THROW(util::FileOpenException, "Couldn't open for loading: " << filePath);
   }
 
@@ -56,22 +58,11 @@ void OnDiskWrapper::BeginLoad(const std::string &filePath)
   m_rootSourceNode = new PhraseNode(rootFilePos, *this);
 }
 
-bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
+bool OnDiskWrapper::OpenForLoad(const std::string &filePath, util::LoadMethod loadMethod)
 {
-  m_fileSource.open((filePath + "/Source.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileSource.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/Source.dat");
-
-  m_fileTargetInd.open((filePath + "/TargetInd.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetInd.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetInd.dat");
-
-  m_fileTargetColl.open((filePath + "/TargetColl.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetColl.is_open(),
-                util::FileOpenException,
-                "Couldn't open file " << filePath << "/TargetColl.dat");
+  Map(filePath + "/Source.dat", loadMethod, m_memSource);
+  Map(filePath + "/TargetInd.dat", loadMethod, m_memTargetInd);
+  Map(filePath + "/TargetColl.dat", loadMethod, m_memTargetColl);
 
   m_fileVocab.open((filePath + "/Vocab.dat").c_str(), ios::in);
   UTIL_THROW_IF(!m_fileVocab.is_open(),
@@ -92,6 +83,22 @@ bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
   return true;
 }
 
+void OnDiskWrapper::Map(const std::string &path, util::LoadMethod loadMethod, util::scoped_memory &mem)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(path.c_str()));
+  uint64_t size = util::SizeOrThrow(fd.get());
+  if (size == 0) {
+    return;
+  }
+
+  util::MapRead(loadMethod, fd.get(), 0, size, mem);
+
+  // lookups jump all over the trie, reading ahead just evicts useful pages
+  if (loadMethod == util::LAZY) {
+    util::AdviseRandom(mem.get(), mem.size());
+  }
+}
+
 bool OnDiskWrapper::LoadMisc()
 {
   char line[100000];
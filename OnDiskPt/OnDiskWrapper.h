@@ -22,6 +22,7 @@
 #include <fstream>
 #include "Vocab.h"
 #include "PhraseNode.h"
+#include "util/mmap.hh"
 
 namespace OnDiskPt
 {
@@ -39,13 +40,19 @@ protected:
   int m_numSourceFactors, m_numTargetFactors, m_numScores;
   std::fstream m_fileMisc, m_fileVocab, m_fileSource, m_fileTarget, m_fileTargetInd, m_fileTargetColl;
 
+  // read-only mappings of the source trie and target phrases, for loading.
+  // Nothing is written to them after BeginLoad() so any number of threads
+  // can read at once
+  util::scoped_memory m_memSource, m_memTargetInd, m_memTargetColl;
+
   size_t m_defaultNodeSize;
   PhraseNode *m_rootSourceNode;
 
   std::map<std::string, uint64_t> m_miscInfo;
 
   void SaveMisc();
-  bool OpenForLoad(const std::string &filePath);
+  bool OpenForLoad(const std::string &filePath, util::LoadMethod loadMethod);
+  void Map(const std::string &path, util::LoadMethod loadMethod, util::scoped_memory &mem);
   bool LoadMisc();
 
 public:
@@ -54,7 +61,10 @@ public:
   OnDiskWrapper();
   ~OnDiskWrapper();
 
-  void BeginLoad(const std::string &filePath);
+  // LAZY maps the files and leaves the kernel to page them in as nodes are
+  // read. POPULATE_OR_READ prefaults all of them up front. READ copies them
+  // into memory
+  void BeginLoad(const std::string &filePath, util::LoadMethod loadMethod = util::LAZY);
 
   void BeginSave(const std::string &filePath
                  , int numSourceFactors, int	numTargetFactors, int numScores);
@@ -83,6 +93,17 @@ public:
     return m_fileVocab;
   }
 
+  // file contents, after BeginLoad()
+  const char *GetSourceMem() const {
+    return static_cast<const char*>(m_memSource.get());
+  }
+  const char *GetTargetIndMem() const {
+    return static_cast<const char*>(m_memTargetInd.get());
+  }
+  const char *GetTargetCollMem() const {
+    return static_cast<const char*>(m_memTargetColl.get());
+  }
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
@@ -112,34 +112,32 @@ void TargetPhraseCollection::Save(OnDiskWrapper &onDiskWrapper)
 
 }
 
-void TargetPhraseCollection::ReadFromFile(size_t tableLimit, uint64_t filePos, OnDiskWrapper &onDiskWrapper)
+void TargetPhraseCollection::ReadFromFile(size_t tableLimit, uint64_t filePos, const OnDiskWrapper &onDiskWrapper)
 {
-  fstream &fileTPColl = onDiskWrapper.GetFileTargetColl();
-  fstream &fileTP = onDiskWrapper.GetFileTargetInd();
+  // both files are mapped, so this is pointer arithmetic rather than seeks
+  const char *memTPColl = onDiskWrapper.GetTargetCollMem() + filePos;
+  const char *memTP = onDiskWrapper.GetTargetIndMem();
 
   size_t numScores = onDiskWrapper.GetNumScores();
 
 
-  uint64_t numPhrases;
-
-  uint64_t currFilePos = filePos;
-  fileTPColl.seekg(filePos);
-  fileTPColl.read((char*) &numPhrases, sizeof(uint64_t));
+  uint64_t numPhrases = *(const uint64_t*) memTPColl;
 
   // table limit
   if (tableLimit) {
     numPhrases = std::min(numPhrases, (uint64_t) tableLimit);
   }
 
-  currFilePos += sizeof(uint64_t);
+  uint64_t currPos = sizeof(uint64_t);
 
+  m_coll.reserve(numPhrases);
   for (size_t ind = 0; ind < numPhrases; ++ind) {
     TargetPhrase *tp = new TargetPhrase(numScores);
 
-    uint64_t sizeOtherInfo = tp->ReadOtherInfoFromFile(currFilePos, fileTPColl);
-    tp->ReadFromFile(fileTP);
+    uint64_t sizeOtherInfo = tp->ReadOtherInfoFromMemory(memTPColl + currPos);
+    tp->ReadFromMemory(memTP);
 
-    currFilePos += sizeOtherInfo;
+    currPos += sizeOtherInfo;
 
     m_coll.push_back(tp);
   }
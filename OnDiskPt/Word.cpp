@@ -84,18 +84,6 @@ size_t Word::ReadFromMemory(const char *mem)
   return memUsed;
 }
 
-size_t Word::ReadFromFile(std::fstream &file)
-{
-  const size_t memAlloc = sizeof(uint64_t) + sizeof(char);
-  char mem[sizeof(uint64_t) + sizeof(char)];
-  file.read(mem, memAlloc);
-
-  size_t memUsed = ReadFromMemory(mem);
-  assert(memAlloc == memUsed);
-
-  return memAlloc;
-}
-
 int Word::Compare(const Word &compare) const
 {
   int ret;
@@ -11,10 +11,16 @@
 #include "util/murmur_hash.hh"
 #include "util/probing_hash_table.hh"
 #include "util/scoped.hh"
+#include "util/pcqueue.hh"
 #include "util/stream/chain.hh"
+#include "util/stream/multi_stream.hh"
 #include "util/stream/timer.hh"
 #include "util/tokenize_piece.hh"
 
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <functional>
 
 #include <stdint.h>
@@ -149,6 +155,108 @@ class Writer {
     const std::size_t block_size_;
 };
 
+// Words of whole sentences, each ending with </s>.  Shared by all shards.
+typedef boost::shared_ptr<std::vector<WordIndex> > SentenceBatch;
+
+const std::size_t kBatchWords = 1 << 20;
+
+// Counts the n-grams that hash to one shard.  Unlike Writer, n-grams are not
+// contiguous in the output so each is copied in whole.
+class ShardWriter {
+  public:
+    ShardWriter(std::size_t order, std::size_t shard, std::size_t shards, WordIndex end_sentence, const util::stream::ChainPosition &position, void *dedupe_mem, std::size_t dedupe_mem_size)
+      : block_(position), gram_(block_->Get(), order),
+        dedupe_invalid_(order, std::numeric_limits<WordIndex>::max()),
+        dedupe_(dedupe_mem, dedupe_mem_size, &dedupe_invalid_[0], DedupeHash(order), DedupeEquals(order)),
+        window_(order, kBOS),
+        shard_(shard), shards_(shards), end_sentence_(end_sentence),
+        block_size_(position.GetChain().BlockSize()) {
+      dedupe_.Clear();
+      assert(Dedupe::Size(position.GetChain().BlockSize() / position.GetChain().EntrySize(), kProbingMultiplier) == dedupe_mem_size);
+      if (order == 1 && shard == 0) {
+        // Add special words.  AdjustCounts is responsible if order != 1.
+        Add(kUNK, 0);
+        Add(kBOS, 0);
+      }
+    }
+
+    ~ShardWriter() {
+      block_->SetValidSize(reinterpret_cast<const uint8_t*>(gram_.begin()) - static_cast<const uint8_t*>(block_->Get()));
+      (++block_).Poison();
+    }
+
+    void Count(const std::vector<WordIndex> &words) {
+      WordIndex *const last = &window_.back();
+      for (std::vector<WordIndex>::const_iterator i = words.begin(); i != words.end(); ++i) {
+        *last = *i;
+        if (Shard() == shard_) Add();
+        if (*i == end_sentence_) {
+          std::fill(window_.begin(), window_.end(), kBOS);
+        } else {
+          std::copy(window_.begin() + 1, window_.end(), window_.begin());
+        }
+      }
+    }
+
+  private:
+    // Cheap: every shard looks at every n-gram.  Mixes the last two words,
+    // which vary the most.
+    std::size_t Shard() const {
+      uint64_t h = static_cast<uint64_t>(window_.back()) * 0x9e3779b97f4a7c15ULL;
+      if (window_.size() > 1) h ^= static_cast<uint64_t>(window_[window_.size() - 2]) * 0xc2b2ae3d27d4eb4fULL;
+      return static_cast<std::size_t>(h >> 32) % shards_;
+    }
+
+    void Add() {
+      std::copy(window_.begin(), window_.end(), gram_.begin());
+      Dedupe::MutableIterator at;
+      if (dedupe_.FindOrInsert(DedupeEntry::Construct(gram_.begin()), at)) {
+        NGram<BuildingPayload> already(at->key, gram_.Order());
+        ++(already.Value().count);
+        return;
+      }
+      gram_.Value().count = 1;
+      Next();
+    }
+
+    void Add(WordIndex unigram, uint64_t count) {
+      *gram_.begin() = unigram;
+      gram_.Value().count = count;
+      Next();
+    }
+
+    void Next() {
+      gram_.NextInMemory();
+      if (gram_.Base() != static_cast<uint8_t*>(block_->Get()) + block_size_) return;
+      dedupe_.Clear();
+      block_->SetValidSize(block_size_);
+      gram_.ReBase((++block_)->Get());
+    }
+
+    util::stream::Link block_;
+
+    NGram<BuildingPayload> gram_;
+
+    std::vector<WordIndex> dedupe_invalid_;
+    Dedupe dedupe_;
+
+    // Current n-gram, oldest word first.
+    std::vector<WordIndex> window_;
+
+    const std::size_t shard_, shards_;
+    const WordIndex end_sentence_;
+
+    const std::size_t block_size_;
+};
+
+void CountShard(std::size_t order, std::size_t shard, std::size_t shards, WordIndex end_sentence, const util::stream::ChainPosition &position, void *dedupe_mem, std::size_t dedupe_mem_size, util::PCQueue<SentenceBatch> &queue) {
+  ShardWriter writer(order, shard, shards, end_sentence, position, dedupe_mem, dedupe_mem_size);
+  SentenceBatch batch;
+  while ((batch = queue.Consume())) {
+    writer.Count(*batch);
+  }
+}
+
 } // namespace
 
 float CorpusCount::DedupeMultiplier(std::size_t order) {
@@ -159,11 +267,12 @@ std::size_t CorpusCount::VocabUsage(std::size_t vocab_estimate) {
   return ngram::GrowableVocab<ngram::WriteUniqueWords>::MemUsage(vocab_estimate);
 }
 
-CorpusCount::CorpusCount(util::FilePiece &from, int vocab_write, uint64_t &token_count, WordIndex &type_count, std::vector<bool> &prune_words, const std::string& prune_vocab_filename, std::size_t entries_per_block, WarningAction disallowed_symbol)
+CorpusCount::CorpusCount(util::FilePiece &from, int vocab_write, uint64_t &token_count, WordIndex &type_count, std::vector<bool> &prune_words, const std::string& prune_vocab_filename, std::size_t entries_per_block, WarningAction disallowed_symbol, std::size_t shards)
   : from_(from), vocab_write_(vocab_write), token_count_(token_count), type_count_(type_count),
     prune_words_(prune_words), prune_vocab_filename_(prune_vocab_filename),
     dedupe_mem_size_(Dedupe::Size(entries_per_block, kProbingMultiplier)),
-    dedupe_mem_(util::MallocOrThrow(dedupe_mem_size_)),
+    dedupe_mem_(util::MallocOrThrow(dedupe_mem_size_ * shards)),
+    shards_(shards),
     disallowed_symbol_action_(disallowed_symbol) {
 }
 
@@ -180,6 +289,31 @@ namespace {
         UTIL_THROW(FormatLoadException, "Special word " << word << " is not allowed in the corpus.  I plan to support models containing <unk> in the future.  Pass --skip_symbols to convert these symbols to whitespace.");
     }
   }
+
+  // Create list of unigrams that are supposed to be pruned
+  template <class Vocab> void ListPrunedWords(const Vocab &vocab, const std::string &prune_vocab_filename, const bool *delimiters, std::vector<bool> &prune_words) {
+    if (prune_vocab_filename.empty()) return;
+    try {
+      util::FilePiece prune_vocab_file(prune_vocab_filename.c_str());
+
+      prune_words.resize(vocab.Size(), true);
+      try {
+        while (true) {
+          StringPiece word(prune_vocab_file.ReadDelimited(delimiters));
+          prune_words[vocab.Index(word)] = false;
+        }
+      } catch (const util::EndOfFileException &e) {}
+
+      // Never prune <unk>, <s>, </s>
+      prune_words[kUNK] = false;
+      prune_words[kBOS] = false;
+      prune_words[kEOS] = false;
+
+    } catch (const util::Exception &e) {
+      std::cerr << e.what() << std::endl;
+      abort();
+    }
+  }
 } // namespace
 
 void CorpusCount::Run(const util::stream::ChainPosition &position) {
@@ -210,29 +344,73 @@ void CorpusCount::Run(const util::stream::ChainPosition &position) {
   token_count_ = count;
   type_count_ = vocab.Size();
 
-  // Create list of unigrams that are supposed to be pruned
-  if (!prune_vocab_filename_.empty()) {
-    try {
-      util::FilePiece prune_vocab_file(prune_vocab_filename_.c_str());
+  ListPrunedWords(vocab, prune_vocab_filename_, delimiters, prune_words_);
+}
 
-      prune_words_.resize(vocab.Size(), true);
-      try {
-        while (true) {
-          StringPiece word(prune_vocab_file.ReadDelimited(delimiters));
-          prune_words_[vocab.Index(word)] = false;
-        }
-      } catch (const util::EndOfFileException &e) {}
+void CorpusCount::Run(const util::stream::ChainPositions &positions) {
+  UTIL_THROW_IF(positions.size() > shards_, util::Exception, "CorpusCount was only given dedupe memory for " << shards_ << " chains");
+  ngram::GrowableVocab<ngram::WriteUniqueWords> vocab(type_count_, vocab_write_);
+  token_count_ = 0;
+  type_count_ = 0;
+  const WordIndex end_sentence = vocab.FindOrInsert("</s>");
+  const std::size_t order = NGram<BuildingPayload>::OrderFromSize(positions[0].GetChain().EntrySize());
 
-      // Never prune <unk>, <s>, </s>
-      prune_words_[kUNK] = false;
-      prune_words_[kBOS] = false;
-      prune_words_[kEOS] = false;
+  boost::ptr_vector<util::PCQueue<SentenceBatch> > queues;
+  boost::thread_group shards;
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    queues.push_back(new util::PCQueue<SentenceBatch>(2));
+    shards.add_thread(new boost::thread(CountShard, order, i, positions.size(), end_sentence, boost::cref(positions[i]), static_cast<uint8_t*>(dedupe_mem_.get()) + i * dedupe_mem_size_, dedupe_mem_size_, boost::ref(queues[i])));
+  }
 
-    } catch (const util::Exception &e) {
-      std::cerr << e.what() << std::endl;
-      abort();
+  uint64_t count = 0;
+  bool delimiters[256];
+  util::BoolCharacter::Build("\0\t\n\r ", delimiters);
+  SentenceBatch batch(new std::vector<WordIndex>());
+  batch->reserve(kBatchWords);
+  try {
+    try {
+      while(true) {
+        StringPiece line(from_.ReadLine());
+        for (util::TokenIter<util::BoolCharacter, true> w(line, delimiters); w; ++w) {
+          WordIndex word = vocab.FindOrInsert(*w);
+          if (word <= 2) {
+            ComplainDisallowed(*w, disallowed_symbol_action_);
+            continue;
+          }
+          batch->push_back(word);
+          ++count;
+        }
+        batch->push_back(end_sentence);
+        if (batch->size() >= kBatchWords) {
+          for (std::size_t i = 0; i < queues.size(); ++i) {
+            queues[i].Produce(batch);
+          }
+          batch.reset(new std::vector<WordIndex>());
+          batch->reserve(kBatchWords);
+        }
+      }
+    } catch (const util::EndOfFileException &e) {}
+    if (!batch->empty()) {
+      for (std::size_t i = 0; i < queues.size(); ++i) {
+        queues[i].Produce(batch);
+      }
     }
+  } catch (...) {
+    for (std::size_t i = 0; i < queues.size(); ++i) {
+      queues[i].Produce(SentenceBatch());
+    }
+    shards.join_all();
+    throw;
+  }
+  for (std::size_t i = 0; i < queues.size(); ++i) {
+    queues[i].Produce(SentenceBatch());
   }
+  shards.join_all();
+
+  token_count_ = count;
+  type_count_ = vocab.Size();
+
+  ListPrunedWords(vocab, prune_vocab_filename_, delimiters, prune_words_);
 }
 
 } // namespace builder
@@ -14,6 +14,7 @@ namespace util {
 class FilePiece;
 namespace stream {
 class ChainPosition;
+class ChainPositions;
 } // namespace stream
 } // namespace util
 
@@ -30,20 +31,29 @@ class CorpusCount {
 
     // token_count: out.
     // type_count aka vocabulary size.  Initialize to an estimate.  It is set to the exact value.
-    CorpusCount(util::FilePiece &from, int vocab_write, uint64_t &token_count, WordIndex &type_count, std::vector<bool> &prune_words, const std::string& prune_vocab_filename, std::size_t entries_per_block, WarningAction disallowed_symbol);
+    // shards: the number of chains Run(ChainPositions) will write to, each
+    // with entries_per_block.
+    CorpusCount(util::FilePiece &from, int vocab_write, uint64_t &token_count, WordIndex &type_count, std::vector<bool> &prune_words, const std::string& prune_vocab_filename, std::size_t entries_per_block, WarningAction disallowed_symbol, std::size_t shards = 1);
 
     void Run(const util::stream::ChainPosition &position);
 
+    // Read and number words on this thread, count n-grams on a thread per
+    // chain.  Each n-gram is always counted by the same chain, chosen by
+    // hash.  Chains are not in any particular order.
+    void Run(const util::stream::ChainPositions &positions);
+
   private:
     util::FilePiece &from_;
     int vocab_write_;
     uint64_t &token_count_;
     WordIndex &type_count_;
     std::vector<bool>& prune_words_;
-    const std::string& prune_vocab_filename_;
+    const std::string prune_vocab_filename_;
 
+    // Per shard.
     std::size_t dedupe_mem_size_;
     util::scoped_malloc dedupe_mem_;
+    std::size_t shards_;
 
     WarningAction disallowed_symbol_action_;
 };
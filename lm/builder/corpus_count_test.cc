@@ -8,8 +8,12 @@
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 #include "util/stream/chain.hh"
+#include "util/stream/multi_stream.hh"
 #include "util/stream/stream.hh"
 
+#include <map>
+#include <string>
+
 #define BOOST_TEST_MODULE CorpusCountTest
 #include <boost/test/unit_test.hpp>
 
@@ -76,4 +80,54 @@ BOOST_AUTO_TEST_CASE(Short) {
   BOOST_CHECK_EQUAL(sizeof(v) / sizeof(const char*), type_count);
 }
 
+BOOST_AUTO_TEST_CASE(Sharded) {
+  util::scoped_fd input_file(util::MakeTemp("corpus_count_test_temp"));
+  const char input[] = "looking on a little more loin\non a little more loin\non foo little more loin\nbar\n\n";
+  util::WriteOrThrow(input_file.get(), input, sizeof(input) - 1);
+  util::FilePiece input_piece(input_file.release(), "temp file");
+
+  util::stream::ChainConfig config;
+  config.entry_size = NGram<BuildingPayload>::TotalSize(3);
+  config.total_memory = config.entry_size * 20;
+  config.block_count = 2;
+
+  util::scoped_fd vocab(util::MakeTemp("corpus_count_test_vocab"));
+
+  util::stream::Chains chains(3);
+  for (std::size_t i = 0; i < 3; ++i) chains.push_back(config);
+  uint64_t token_count;
+  WordIndex type_count = 10;
+  std::vector<bool> prune_words;
+  const std::string prune_vocab_filename;
+  CorpusCount counter(input_piece, vocab.get(), token_count, type_count, prune_words, prune_vocab_filename, chains[0].BlockSize() / chains[0].EntrySize(), SILENT, 3);
+  chains >> boost::ref(counter);
+  util::stream::ChainPositions positions(chains);
+  chains >> util::stream::kRecycle;
+
+  const char *v[] = {"<unk>", "<s>", "</s>", "looking", "on", "a", "little", "more", "loin", "foo", "bar"};
+
+  // Each n-gram goes to one chain, but may appear more than once if it spans blocks.
+  std::map<std::string, uint64_t> counts;
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    for (NGramStream<BuildingPayload> stream(positions[i]); stream; ++stream) {
+      std::string text;
+      for (const WordIndex *w = stream->begin(); w != stream->end(); ++w) {
+        if (w != stream->begin()) text += ' ';
+        text += v[*w];
+      }
+      counts[text] += stream->Value().count;
+    }
+  }
+
+  BOOST_CHECK_EQUAL(15U, counts.size());
+  BOOST_CHECK_EQUAL(2U, counts["on a little"]);
+  BOOST_CHECK_EQUAL(3U, counts["little more loin"]);
+  BOOST_CHECK_EQUAL(3U, counts["more loin </s>"]);
+  BOOST_CHECK_EQUAL(2U, counts["<s> <s> on"]);
+  BOOST_CHECK_EQUAL(1U, counts["<s> <s> </s>"]);
+  BOOST_CHECK_EQUAL(1U, counts["<s> bar </s>"]);
+  chains.Wait();
+  BOOST_CHECK_EQUAL(sizeof(v) / sizeof(const char*), type_count);
+}
+
 }}} // namespaces
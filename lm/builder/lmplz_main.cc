@@ -5,6 +5,7 @@
 #include "util/file.hh"
 #include "util/file_piece.hh"
 #include "util/usage.hh"
+#include "util/write_compressed.hh"
 
 #include <iostream>
 
@@ -80,6 +81,7 @@ int main(int argc, char *argv[]) {
     discount_fallback_default.push_back("1");
     discount_fallback_default.push_back("1.5");
     bool verbose_header;
+    std::string compress_temp;
 
     options.add_options()
       ("help,h", po::bool_switch(), "Show this help message")
@@ -91,10 +93,12 @@ int main(int argc, char *argv[]) {
       ("interpolate_unigrams", po::value<bool>(&pipeline.initial_probs.interpolate_unigrams)->default_value(true)->implicit_value(true), "Interpolate the unigrams (default) as opposed to giving lots of mass to <unk> like SRI.  If you want SRI's behavior with a large <unk> and the old lmplz default, use --interpolate_unigrams 0.")
       ("skip_symbols", po::bool_switch(), "Treat <s>, </s>, and <unk> as whitespace instead of throwing an exception")
       ("temp_prefix,T", po::value<std::string>(&pipeline.sort.temp_prefix)->default_value("/tmp/lm"), "Temporary file prefix")
+      ("compress_temp", po::value<std::string>(&compress_temp)->default_value("none"), "Compress the temporary copy of the model that is kept before writing ARPA: none, lz4, zst or gz")
       ("memory,S", lm:: SizeOption(pipeline.sort.total_memory, util::GuessPhysicalMemory() ? "80%" : "1G"), "Sorting memory")
       ("minimum_block", lm::SizeOption(pipeline.minimum_block, "8K"), "Minimum block size to allow")
       ("sort_block", lm::SizeOption(pipeline.sort.buffer_size, "64M"), "Size of IO operations for sort (determines arity)")
       ("block_count", po::value<std::size_t>(&pipeline.block_count)->default_value(2), "Block count (per order)")
+      ("threads", po::value<std::size_t>(&pipeline.threads)->default_value(1), "Threads for counting n-grams in the corpus and for merge sort passes.  Memory is divided between them.  The model is the same for any number of threads.")
       ("vocab_estimate", po::value<lm::WordIndex>(&pipeline.vocab_estimate)->default_value(1000000), "Assume this vocabulary size for purposes of calculating memory in step 1 (corpus count) and pre-sizing the hash table")
       ("vocab_pad", po::value<uint64_t>(&pipeline.vocab_size_for_unk)->default_value(0), "If the vocabulary is smaller than this value, pad with <unk> to reach this size. Requires --interpolate_unigrams")
       ("verbose_header", po::bool_switch(&verbose_header), "Add a verbose header to the ARPA file that includes information such as token count, smoothing type, etc.")
@@ -179,6 +183,7 @@ int main(int argc, char *argv[]) {
     }
 
     util::NormalizeTempPrefix(pipeline.sort.temp_prefix);
+    pipeline.sort.merge_threads = pipeline.threads;
 
     lm::builder::InitialProbabilitiesConfig &initial = pipeline.initial_probs;
     // TODO: evaluate options for these.
@@ -202,7 +207,9 @@ int main(int argc, char *argv[]) {
       if (writing_intermediate) {
         pipeline.renumber_vocabulary = true;
       }
-      lm::builder::Output output(writing_intermediate ? intermediate : pipeline.sort.temp_prefix, writing_intermediate, pipeline.output_q);
+      util::Compression temp_compression = util::CompressionFromName(compress_temp);
+      UTIL_THROW_IF(!util::HaveCompression(temp_compression), util::CompressedException, "--compress_temp " << compress_temp << " was not compiled in.");
+      lm::builder::Output output(writing_intermediate ? intermediate : pipeline.sort.temp_prefix, writing_intermediate, pipeline.output_q, temp_compression);
       if (!writing_intermediate || vm.count("arpa")) {
         output.Add(new lm::builder::PrintHook(out.release(), verbose_header));
       }
@@ -37,7 +37,7 @@ class OutputHook {
 
 class Output : boost::noncopyable {
   public:
-    Output(StringPiece file_base, bool keep_buffer, bool output_q);
+    Output(StringPiece file_base, bool keep_buffer, bool output_q, util::Compression temp_compression = util::UNCOMPRESSED);
 
     // Takes ownership.
     void Add(OutputHook *hook) {
@@ -222,16 +222,38 @@ util::stream::Sort<SuffixOrder, CombineCounts> *CountText(int text_file /* input
     (static_cast<float>(config.block_count) + CorpusCount::DedupeMultiplier(config.order)) *
     // Chain likes memory expressed in terms of total memory.
     static_cast<float>(config.block_count);
-  util::stream::Chain chain(util::stream::ChainConfig(NGram<BuildingPayload>::TotalSize(config.order), config.block_count, memory_for_chain));
 
   type_count = config.vocab_estimate;
   util::FilePiece text(text_file, NULL, &std::cerr);
   text_file_name = text.FileName();
-  CorpusCount counter(text, vocab_file, token_count, type_count, prune_words, config.prune_vocab_file, chain.BlockSize() / chain.EntrySize(), config.disallowed_symbol_action);
-  chain >> boost::ref(counter);
 
-  util::scoped_ptr<util::stream::Sort<SuffixOrder, CombineCounts> > sorter(new util::stream::Sort<SuffixOrder, CombineCounts>(chain, config.sort, SuffixOrder(config.order), CombineCounts()));
-  chain.Wait(true);
+  // Each thread needs blocks of at least the minimum size.
+  const std::size_t threads = std::min<std::size_t>(config.threads, std::max<std::size_t>(1, memory_for_chain / (config.block_count * config.minimum_block)));
+  if (threads < config.threads) {
+    std::cerr << "Warning: counting with " << threads << " threads due to low memory." << std::endl;
+  }
+
+  if (threads <= 1) {
+    util::stream::Chain chain(util::stream::ChainConfig(NGram<BuildingPayload>::TotalSize(config.order), config.block_count, memory_for_chain));
+    CorpusCount counter(text, vocab_file, token_count, type_count, prune_words, config.prune_vocab_file, chain.BlockSize() / chain.EntrySize(), config.disallowed_symbol_action);
+    chain >> boost::ref(counter);
+
+    util::scoped_ptr<util::stream::Sort<SuffixOrder, CombineCounts> > sorter(new util::stream::Sort<SuffixOrder, CombineCounts>(chain, config.sort, SuffixOrder(config.order), CombineCounts()));
+    chain.Wait(true);
+    return sorter.release();
+  }
+
+  // Split the memory evenly, so each thread has a chain and dedupe table of its own.
+  util::stream::Chains chains(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    chains.push_back(util::stream::ChainConfig(NGram<BuildingPayload>::TotalSize(config.order), config.block_count, memory_for_chain / threads));
+  }
+  CorpusCount counter(text, vocab_file, token_count, type_count, prune_words, config.prune_vocab_file, chains[0].BlockSize() / chains[0].EntrySize(), config.disallowed_symbol_action, threads);
+  chains >> boost::ref(counter);
+
+  // Duplicates between chains are combined when merging.
+  util::scoped_ptr<util::stream::Sort<SuffixOrder, CombineCounts> > sorter(new util::stream::Sort<SuffixOrder, CombineCounts>(chains, config.sort, SuffixOrder(config.order), CombineCounts()));
+  chains.Wait(true);
   return sorter.release();
 }
 
@@ -32,6 +32,10 @@ struct PipelineConfig {
   // Number of blocks to use.  This will be overridden to 1 if everything fits.
   std::size_t block_count;
 
+  // Threads for counting n-grams in the corpus.  Each has its own chain and
+  // share of the memory.
+  std::size_t threads;
+
   // n-gram count thresholds for pruning. 0 values means no pruning for
   // corresponding n-gram order
   std::vector<uint64_t> prune_thresholds; //mjd
@@ -14,12 +14,13 @@ namespace {
 const char kMetadataHeader[] = "KenLM intermediate binary file";
 } // namespace
 
-ModelBuffer::ModelBuffer(StringPiece file_base, bool keep_buffer, bool output_q)
+ModelBuffer::ModelBuffer(StringPiece file_base, bool keep_buffer, bool output_q, util::Compression temp_compression)
   : file_base_(file_base.data(), file_base.size()), keep_buffer_(keep_buffer), output_q_(output_q),
+    compression_(keep_buffer ? util::UNCOMPRESSED : temp_compression),
     vocab_file_(keep_buffer ? util::CreateOrThrow((file_base_ + ".vocab").c_str()) : util::MakeTemp(file_base_)) {}
   
 ModelBuffer::ModelBuffer(StringPiece file_base)
-  : file_base_(file_base.data(), file_base.size()), keep_buffer_(false) {
+  : file_base_(file_base.data(), file_base.size()), keep_buffer_(false), compression_(util::UNCOMPRESSED) {
   const std::string full_name = file_base_ + ".kenlm_intermediate";
   util::FilePiece in(full_name.c_str());
   StringPiece token = in.ReadLine();
@@ -64,7 +65,11 @@ void ModelBuffer::Sink(util::stream::Chains &chains, const std::vector<uint64_t>
     } else {
       files_.push_back(util::MakeTemp(file_base_));
     }
-    chains[i] >> util::stream::Write(files_.back().get());
+    if (compression_ == util::UNCOMPRESSED) {
+      chains[i] >> util::stream::Write(files_.back().get());
+    } else {
+      chains[i] >> util::stream::CompressedWrite(util::DupOrThrow(files_.back().get()), compression_);
+    }
   }
   if (keep_buffer_) {
     util::scoped_fd metadata(util::CreateOrThrow((file_base_ + ".kenlm_intermediate").c_str()));
@@ -80,12 +85,18 @@ void ModelBuffer::Sink(util::stream::Chains &chains, const std::vector<uint64_t>
 void ModelBuffer::Source(util::stream::Chains &chains) {
   assert(chains.size() <= files_.size());
   for (unsigned int i = 0; i < chains.size(); ++i) {
-    chains[i] >> util::stream::PRead(files_[i].get());
+    Source(i, chains[i]);
   }
 }
 
 void ModelBuffer::Source(std::size_t order_minus_1, util::stream::Chain &chain) {
-  chain >> util::stream::PRead(files_[order_minus_1].get());
+  if (compression_ == util::UNCOMPRESSED) {
+    chain >> util::stream::PRead(files_[order_minus_1].get());
+  } else {
+    // The compressed stream has to be read from the beginning.
+    util::SeekOrThrow(files_[order_minus_1].get(), 0);
+    chain >> util::stream::CompressedRead(util::DupOrThrow(files_[order_minus_1].get()));
+  }
 }
 
 } // namespace
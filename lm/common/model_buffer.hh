@@ -7,6 +7,7 @@
 
 #include "util/file.hh"
 #include "util/fixed_array.hh"
+#include "util/write_compressed.hh"
 
 #include <string>
 #include <vector>
@@ -21,7 +22,8 @@ namespace lm {
 class ModelBuffer {
   public:
     // Construct for writing.  Must call VocabFile() and fill it with null-delimited vocab words.
-    ModelBuffer(StringPiece file_base, bool keep_buffer, bool output_q);
+    // If the buffer isn't kept, its temporary files are written with temp_compression.
+    ModelBuffer(StringPiece file_base, bool keep_buffer, bool output_q, util::Compression temp_compression = util::UNCOMPRESSED);
 
     // Load from file.
     explicit ModelBuffer(StringPiece file_base);
@@ -52,6 +54,7 @@ class ModelBuffer {
     const std::string file_base_;
     const bool keep_buffer_;
     bool output_q_;
+    util::Compression compression_;
     std::vector<uint64_t> counts_;
 
     util::scoped_fd vocab_file_;
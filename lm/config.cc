@@ -16,6 +16,7 @@ Config::Config() :
   probing_multiplier(1.5),
   building_memory(1073741824ULL), // 1 GB
   temporary_directory_prefix(""),
+  build_threads(1),
   arpa_complain(ALL),
   write_mmap(NULL),
   write_method(WRITE_AFTER),
@@ -71,6 +71,10 @@ struct Config {
   // defaults to input file name.
   std::string temporary_directory_prefix;
 
+  // Threads to parse n-grams with.  The n-grams are still inserted in file
+  // order, so the result does not depend on this.
+  std::size_t build_threads;
+
   // Level of complaining to do when loading from ARPA instead of binary format.
   enum ARPALoadComplain {ALL, EXPENSIVE, NONE};
   ARPALoadComplain arpa_complain;
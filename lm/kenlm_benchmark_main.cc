@@ -5,6 +5,7 @@
 #include "util/usage.hh"
 
 #include <stdint.h>
+#include <vector>
 
 namespace {
 
@@ -67,53 +68,121 @@ template <class Model, class Width> void QueryFromBytes(const Model &model, int
   std::cout << "RSSMax: " << util::RSSMax() << std::endl;
 }
 
-template <class Model, class Width> void DispatchFunction(const Model &model, bool query) {
-  if (query) {
-    QueryFromBytes<Model, Width>(model, 0);
-  } else {
-    ConvertToBytes<Model, Width>(model, 0);
+// Score many sentences in lockstep, one word from each per FullScoreBatch call.
+template <class Model, class Width> void BatchFromBytes(const Model &model, int fd_in) {
+  const std::size_t kLanes = 64;
+  const Width kEOS = model.GetVocabulary().EndSentence();
+
+  std::vector<Width> ids;
+  Width buf[4096];
+  while (std::size_t got = util::ReadOrEOF(fd_in, buf, sizeof(buf))) {
+    UTIL_THROW_IF2(got % sizeof(Width), "File size not a multiple of vocab id size " << sizeof(Width));
+    ids.insert(ids.end(), buf, buf + got / sizeof(Width));
+  }
+  // Sentence i is [starts[i], starts[i+1]).
+  std::vector<std::size_t> starts(1, 0);
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    if (ids[i] == kEOS) starts.push_back(i + 1);
+  }
+  if (starts.back() != ids.size()) starts.push_back(ids.size());
+
+  double loaded = util::CPUTime();
+  std::cout << "CPU_to_load: " << loaded << std::endl;
+
+  std::vector<std::size_t> pos(kLanes, 0), end(kLanes, 0);
+  std::vector<lm::ngram::State> lane_state(kLanes);
+  std::vector<lm::ngram::State> in(kLanes), out(kLanes);
+  std::vector<lm::WordIndex> words(kLanes);
+  std::vector<lm::FullScoreReturn> ret(kLanes);
+  std::vector<std::size_t> lane_of(kLanes);
+  std::size_t next_sentence = 0;
+
+  double total = 0.0;
+  while (true) {
+    std::size_t count = 0;
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+      if (pos[lane] == end[lane]) {
+        if (next_sentence + 1 >= starts.size()) continue;
+        pos[lane] = starts[next_sentence];
+        end[lane] = starts[next_sentence + 1];
+        ++next_sentence;
+        lane_state[lane] = model.BeginSentenceState();
+      }
+      in[count] = lane_state[lane];
+      words[count] = ids[pos[lane]];
+      lane_of[count] = lane;
+      ++count;
+    }
+    if (!count) break;
+    model.FullScoreBatch(&in[0], &words[0], count, &out[0], &ret[0]);
+    for (std::size_t i = 0; i < count; ++i) {
+      total += ret[i].prob;
+      lane_state[lane_of[i]] = out[i];
+      ++pos[lane_of[i]];
+    }
+  }
+  double after = util::CPUTime();
+  std::cerr << "Probability sum is " << total << std::endl;
+  std::cout << "Queries: " << ids.size() << std::endl;
+  std::cout << "CPU_excluding_load: " << (after - loaded) << "\nCPU_per_query: " << ((after - loaded) / static_cast<double>(ids.size())) << std::endl;
+  std::cout << "RSSMax: " << util::RSSMax() << std::endl;
+}
+
+enum Mode { VOCAB, QUERY, BATCH };
+
+template <class Model, class Width> void DispatchFunction(const Model &model, Mode mode) {
+  switch (mode) {
+    case VOCAB:
+      ConvertToBytes<Model, Width>(model, 0);
+      break;
+    case QUERY:
+      QueryFromBytes<Model, Width>(model, 0);
+      break;
+    case BATCH:
+      BatchFromBytes<Model, Width>(model, 0);
+      break;
   }
 }
 
-template <class Model> void DispatchWidth(const char *file, bool query) {
+template <class Model> void DispatchWidth(const char *file, Mode mode) {
   lm::ngram::Config config;
   config.load_method = util::READ;
   std::cerr << "Using load_method = READ." << std::endl;
   Model model(file, config);
   lm::WordIndex bound = model.GetVocabulary().Bound();
   if (bound <= 256) {
-    DispatchFunction<Model, uint8_t>(model, query);
+    DispatchFunction<Model, uint8_t>(model, mode);
   } else if (bound <= 65536) {
-    DispatchFunction<Model, uint16_t>(model, query);
+    DispatchFunction<Model, uint16_t>(model, mode);
   } else if (bound <= (1ULL << 32)) {
-    DispatchFunction<Model, uint32_t>(model, query);
+    DispatchFunction<Model, uint32_t>(model, mode);
   } else {
-    DispatchFunction<Model, uint64_t>(model, query);
+    DispatchFunction<Model, uint64_t>(model, mode);
   }
 }
 
-void Dispatch(const char *file, bool query) {
+void Dispatch(const char *file, Mode mode) {
   using namespace lm::ngram;
   lm::ngram::ModelType model_type;
   if (lm::ngram::RecognizeBinary(file, model_type)) {
     switch(model_type) {
       case PROBING:
-        DispatchWidth<lm::ngram::ProbingModel>(file, query);
+        DispatchWidth<lm::ngram::ProbingModel>(file, mode);
         break;
       case REST_PROBING:
-        DispatchWidth<lm::ngram::RestProbingModel>(file, query);
+        DispatchWidth<lm::ngram::RestProbingModel>(file, mode);
         break;
       case TRIE:
-        DispatchWidth<lm::ngram::TrieModel>(file, query);
+        DispatchWidth<lm::ngram::TrieModel>(file, mode);
         break;
       case QUANT_TRIE:
-        DispatchWidth<lm::ngram::QuantTrieModel>(file, query);
+        DispatchWidth<lm::ngram::QuantTrieModel>(file, mode);
         break;
       case ARRAY_TRIE:
-        DispatchWidth<lm::ngram::ArrayTrieModel>(file, query);
+        DispatchWidth<lm::ngram::ArrayTrieModel>(file, mode);
         break;
       case QUANT_ARRAY_TRIE:
-        DispatchWidth<lm::ngram::QuantArrayTrieModel>(file, query);
+        DispatchWidth<lm::ngram::QuantArrayTrieModel>(file, mode);
         break;
       default:
         UTIL_THROW(util::Exception, "Unrecognized kenlm model type " << model_type);
@@ -126,7 +195,7 @@ void Dispatch(const char *file, bool query) {
 } // namespace
 
 int main(int argc, char *argv[]) {
-  if (argc != 3 || (strcmp(argv[1], "vocab") && strcmp(argv[1], "query"))) {
+  if (argc != 3 || (strcmp(argv[1], "vocab") && strcmp(argv[1], "query") && strcmp(argv[1], "batch"))) {
     std::cerr
       << "Benchmark program for KenLM.  Intended usage:\n"
       << "#Convert text to vocabulary ids offline.  These ids are tied to a model.\n"
@@ -134,9 +203,14 @@ int main(int argc, char *argv[]) {
       << "#Ensure files are in RAM.\n"
       << "cat $text.vocab $model >/dev/null\n"
       << "#Timed query against the model.\n"
-      << argv[0] << " query $model <$text.vocab\n";
+      << argv[0] << " query $model <$text.vocab\n"
+      << "#Same, scoring 64 sentences at a time with the batched, prefetching API.\n"
+      << argv[0] << " batch $model <$text.vocab\n";
     return 1;
   }
-  Dispatch(argv[2], !strcmp(argv[1], "query"));
+  Mode mode = VOCAB;
+  if (!strcmp(argv[1], "query")) mode = QUERY;
+  if (!strcmp(argv[1], "batch")) mode = BATCH;
+  Dispatch(argv[2], mode);
   return 0;
 }
@@ -19,6 +19,7 @@ namespace ngram {
 namespace detail {
 
 template <class Search, class VocabularyT> const ModelType GenericModel<Search, VocabularyT>::kModelType = Search::kModelType;
+template <class Search, class VocabularyT> const std::size_t GenericModel<Search, VocabularyT>::kBatchDistance;
 
 template <class Search, class VocabularyT> uint64_t GenericModel<Search, VocabularyT>::Size(const std::vector<uint64_t> &counts, const Config &config) {
   return VocabularyT::Size(counts[0], config) + Search::Size(counts, config);
@@ -139,6 +140,27 @@ template <class Search, class VocabularyT> FullScoreReturn GenericModel<Search,
   return ret;
 }
 
+template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::FullScoreBatch(const State *in_states, const WordIndex *new_words, std::size_t count, State *out_states, FullScoreReturn *out) const {
+  // Fill the pipeline.
+  for (std::size_t i = 0; i < std::min(count, 2 * kBatchDistance); ++i) {
+    search_.Prefetch(in_states[i].words, in_states[i].words + in_states[i].length, new_words[i]);
+  }
+  for (std::size_t i = 0; i < std::min(count, kBatchDistance); ++i) {
+    search_.PrefetchNext(in_states[i].words, in_states[i].words + in_states[i].length, new_words[i]);
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    std::size_t ahead = i + 2 * kBatchDistance;
+    if (ahead < count) {
+      search_.Prefetch(in_states[ahead].words, in_states[ahead].words + in_states[ahead].length, new_words[ahead]);
+    }
+    ahead = i + kBatchDistance;
+    if (ahead < count) {
+      search_.PrefetchNext(in_states[ahead].words, in_states[ahead].words + in_states[ahead].length, new_words[ahead]);
+    }
+    out[i] = FullScore(in_states[i], new_words[i], out_states[i]);
+  }
+}
+
 template <class Search, class VocabularyT> FullScoreReturn GenericModel<Search, VocabularyT>::FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const {
   context_rend = std::min(context_rend, context_rbegin + P::Order() - 1);
   FullScoreReturn ret = ScoreExceptBackoff(context_rbegin, context_rend, new_word, out_state);
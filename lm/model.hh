@@ -93,6 +93,34 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
         // Amount of additional content that should be considered by the next call.
         unsigned char &next_use) const;
 
+    /* Hint that FullScore(in_state, new_word, ...) will be called soon.  This
+     * issues software prefetches for the table entries the query is likely to
+     * probe and has no other effect.  Callers with many independent queries
+     * (i.e. a decoder scoring a batch of hypotheses) should prefetch a few
+     * queries ahead of the one they are scoring to overlap cache misses.
+     */
+    void Prefetch(const State &in_state, const WordIndex new_word) const {
+      search_.Prefetch(in_state.words, in_state.words + in_state.length, new_word);
+    }
+
+    // Like Prefetch but for FullScoreForgotState.
+    void PrefetchForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word) const {
+      search_.Prefetch(context_rbegin, std::min(context_rend, context_rbegin + P::Order() - 1), new_word);
+    }
+
+    /* Score count independent queries:
+     *   out[i] = FullScore(in_states[i], new_words[i], out_states[i])
+     * with the same results as calling FullScore in a loop.  Lookups are
+     * pipelined across the batch so their cache misses overlap: query i + 2 *
+     * kBatchDistance has its addresses prefetched, query i + kBatchDistance
+     * reads what has arrived to prefetch the next level (trie only) and query
+     * i is scored.  Queries can't depend on each other: out_states must not
+     * overlap in_states.
+     */
+    void FullScoreBatch(const State *in_states, const WordIndex *new_words, std::size_t count, State *out_states, FullScoreReturn *out) const;
+
+    static const std::size_t kBatchDistance = 4;
+
     /* Return probabilities minus rest costs for an array of pointers.  The
      * first length should be the length of the n-gram to which pointers_begin
      * points.
@@ -1,7 +1,10 @@
 #include "lm/model.hh"
 
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <vector>
 
 #define BOOST_TEST_MODULE ModelTest
 #include <boost/test/unit_test.hpp>
@@ -443,6 +446,167 @@ BOOST_AUTO_TEST_CASE(rest_max) {
   SLOPPY_CHECK_CLOSE(-0.01916512, model.FullScore(state, model.GetVocabulary().EndSentence(), out).rest, 0.001);
 }
 
+// A 3-gram ARPA big enough that build_threads > 1 parses its 2-grams and
+// 3-grams in several chunks.  If positive, one 2-gram has that log
+// probability.
+const char *WriteManyNGramARPA(float positive) {
+  const char *name = "test_threads.arpa";
+  std::vector<std::string> words;
+  words.push_back("<unk>");
+  words.push_back("<s>");
+  words.push_back("</s>");
+  for (unsigned i = 0; words.size() < 300; ++i) {
+    char buf[16];
+    sprintf(buf, "w%u", i);
+    words.push_back(buf);
+  }
+  unsigned x = 1;
+  std::vector<std::string> lines[3];
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    x = x * 1103515245 + 12345;
+    char buf[64];
+    sprintf(buf, "-%u.%04u\t%s\t-0.%04u", 1 + (x >> 16) % 3, (x >> 8) % 10000, words[i].c_str(), x % 10000);
+    lines[0].push_back(buf);
+  }
+  for (std::size_t i = 0; i < words.size(); ++i) {
+    if (i == 2) continue;
+    for (std::size_t j = 0; j < words.size(); ++j) {
+      if (j == 1) continue;
+      x = x * 1103515245 + 12345;
+      char buf[64];
+      if (positive > 0.0 && lines[1].size() == 70000) {
+        sprintf(buf, "%f\t%s %s\t-0.%04u", positive, words[i].c_str(), words[j].c_str(), x % 10000);
+      } else {
+        sprintf(buf, "-%u.%04u\t%s %s\t-0.%04u", 1 + (x >> 16) % 3, (x >> 8) % 10000, words[i].c_str(), words[j].c_str(), x % 10000);
+      }
+      lines[1].push_back(buf);
+      if (i >= 10 || j < 3 || j >= 13) continue;
+      for (std::size_t k = 2; k < words.size(); ++k) {
+        x = x * 1103515245 + 12345;
+        sprintf(buf, "-%u.%04u\t%s %s %s", 1 + (x >> 16) % 3, (x >> 8) % 10000, words[i].c_str(), words[j].c_str(), words[k].c_str());
+        lines[2].push_back(buf);
+      }
+    }
+  }
+  std::ofstream out(name);
+  out << "\n\\data\\\n";
+  for (unsigned n = 0; n < 3; ++n) {
+    out << "ngram " << n + 1 << "=" << lines[n].size() << "\n";
+  }
+  for (unsigned n = 0; n < 3; ++n) {
+    out << "\n\\" << n + 1 << "-grams:\n";
+    for (std::size_t i = 0; i < lines[n].size(); ++i) {
+      out << lines[n][i] << "\n";
+    }
+  }
+  out << "\n\\end\\\n";
+  return name;
+}
+
+template <class ModelT> void CheckSameScores(const ModelT &a, const ModelT &b) {
+  BOOST_REQUIRE_EQUAL(a.GetVocabulary().Bound(), b.GetVocabulary().Bound());
+  State state_a(a.BeginSentenceState()), state_b(b.BeginSentenceState()), out_a, out_b;
+  unsigned x = 7;
+  for (unsigned i = 0; i < 20000; ++i) {
+    x = x * 1103515245 + 12345;
+    // Mostly words with 3-grams, so that long contexts come up.
+    WordIndex word = a.GetVocabulary().Index(i % 3 ? "w0" : "w5");
+    if (x % 4) word += (x >> 16) % 12;
+    else word = (x >> 16) % a.GetVocabulary().Bound();
+    FullScoreReturn ret_a(a.FullScore(state_a, word, out_a));
+    FullScoreReturn ret_b(b.FullScore(state_b, word, out_b));
+    BOOST_CHECK_EQUAL(ret_a.prob, ret_b.prob);
+    BOOST_CHECK_EQUAL(ret_a.ngram_length, ret_b.ngram_length);
+    BOOST_CHECK_EQUAL(ret_a.independent_left, ret_b.independent_left);
+    BOOST_CHECK_EQUAL(ret_a.extend_left, ret_b.extend_left);
+    BOOST_CHECK(out_a == out_b);
+    state_a = out_a;
+    state_b = out_b;
+  }
+}
+
+template <class ModelT> void BuildThreadsTest() {
+  Config config;
+  config.arpa_complain = Config::NONE;
+  config.messages = NULL;
+  config.positive_log_probability = SILENT;
+  const char *arpa = WriteManyNGramARPA(0.5);
+  {
+    ModelT serial(arpa, config);
+    config.build_threads = 4;
+    ModelT parallel(arpa, config);
+    CheckSameScores(serial, parallel);
+    // the positive log probability became 0, as it does when serial
+    State context, out;
+    parallel.FullScore(parallel.NullContextState(), parallel.GetVocabulary().Index("w232"), context);
+    FullScoreReturn ret(parallel.FullScore(context, parallel.GetVocabulary().Index("w32"), out));
+    BOOST_CHECK_EQUAL(2, ret.ngram_length);
+    BOOST_CHECK_EQUAL(0.0, ret.prob);
+  }
+  config.positive_log_probability = THROW_UP;
+  config.build_threads = 4;
+  BOOST_CHECK_THROW(ModelT(arpa, config), FormatLoadException);
+  remove(arpa);
+}
+
+BOOST_AUTO_TEST_CASE(build_threads_probing) {
+  BuildThreadsTest<ProbingModel>();
+}
+BOOST_AUTO_TEST_CASE(build_threads_trie) {
+  BuildThreadsTest<TrieModel>();
+}
+
+template <class ModelT> void FullScoreBatchTest() {
+  Config config;
+  config.arpa_complain = Config::NONE;
+  config.messages = NULL;
+  ModelT m(TestLocation(), config);
+  // Queries from all sorts of states: the null context, <s> and those
+  // reached by scoring each word after each word.
+  std::vector<State> in;
+  std::vector<WordIndex> words;
+  const WordIndex bound = m.GetVocabulary().Bound();
+  for (WordIndex w = 0; w < bound; ++w) {
+    in.push_back(m.NullContextState());
+    words.push_back(w);
+    in.push_back(m.BeginSentenceState());
+    words.push_back((w * 7) % bound);
+    for (WordIndex v = 0; v < bound; v += 3) {
+      State out;
+      m.FullScore(in[in.size() - 2 + v % 2], v, out);
+      in.push_back(out);
+      words.push_back((w + v) % bound);
+    }
+  }
+  // Batches shorter and longer than the prefetch pipeline.
+  const std::size_t sizes[] = {0, 1, 3, ModelT::kBatchDistance, 2 * ModelT::kBatchDistance + 1, in.size()};
+  for (std::size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+    std::size_t count = sizes[s];
+    std::vector<State> out_states(count + 1), loop_states(count + 1);
+    std::vector<FullScoreReturn> out(count + 1), loop(count + 1);
+    m.FullScoreBatch(count ? &in[0] : NULL, count ? &words[0] : NULL, count, &out_states[0], &out[0]);
+    for (std::size_t i = 0; i < count; ++i) {
+      loop[i] = m.FullScore(in[i], words[i], loop_states[i]);
+      BOOST_CHECK_EQUAL(loop[i].prob, out[i].prob);
+      BOOST_CHECK_EQUAL(loop[i].ngram_length, out[i].ngram_length);
+      BOOST_CHECK_EQUAL(loop[i].independent_left, out[i].independent_left);
+      BOOST_CHECK_EQUAL(loop[i].extend_left, out[i].extend_left);
+      BOOST_CHECK_EQUAL(loop[i].rest, out[i].rest);
+      BOOST_CHECK_EQUAL(loop_states[i], out_states[i]);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(full_score_batch_probing) {
+  FullScoreBatchTest<ProbingModel>();
+}
+BOOST_AUTO_TEST_CASE(full_score_batch_trie) {
+  FullScoreBatchTest<TrieModel>();
+}
+BOOST_AUTO_TEST_CASE(full_score_batch_quant_array_trie) {
+  FullScoreBatchTest<QuantArrayTrieModel>();
+}
+
 } // namespace
 } // namespace ngram
 } // namespace lm
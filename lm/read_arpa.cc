@@ -1,8 +1,18 @@
 #include "lm/read_arpa.hh"
 
 #include "lm/blank.hh"
+#include "lm/vocab.hh"
 #include "util/file.hh"
 
+#ifdef WITH_THREADS
+#include "util/pcqueue.hh"
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <streambuf>
+#endif
+
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -145,7 +155,214 @@ void ReadEnd(util::FilePiece &in) {
   } catch (const util::EndOfFileException &e) {}
 }
 
+#ifdef WITH_THREADS
+namespace detail {
+namespace {
+
+const std::size_t kChunkNGrams = 1 << 16;
+
+// Lets FilePiece read a chunk through its istream constructor.
+class ChunkBuf : public std::streambuf {
+  public:
+    explicit ChunkBuf(std::string &text) {
+      setg(&text[0], &text[0], &text[0] + text.size());
+    }
+};
+
+} // namespace
+
+template <class Weights> struct NGramChunk {
+  // Offset of the text in the ARPA file, for error messages.
+  uint64_t offset;
+  // One n-gram per line.
+  std::string text;
+  std::size_t lines;
+
+  // Filled in by a worker.
+  std::vector<WordIndex> words;
+  std::vector<Weights> weights;
+  std::string error;
+  // Positive probabilities, to warn about in file order.
+  PositiveProbWarn warn;
+  bool done;
+};
+
+template <class Voc, class Weights> class NGramChunks {
+  public:
+    typedef NGramChunk<Weights> Chunk;
+
+    NGramChunks(util::FilePiece &f, unsigned char n, uint64_t count, const Voc &vocab, const PositiveProbWarn &warn, std::size_t threads)
+      : f_(f), n_(n), count_(count), vocab_(vocab), warn_(warn.Deferred()),
+        ordered_(2 * threads), todo_(3 * threads),
+        current_(NULL), finished_(false), stop_(false) {
+      for (std::size_t i = 0; i < threads; ++i) {
+        workers_.add_thread(new boost::thread(&NGramChunks::Parse, this));
+      }
+      reader_ = boost::thread(&NGramChunks::Cut, this);
+    }
+
+    ~NGramChunks() {
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        stop_ = true;
+      }
+      delete current_;
+      // Chunks are still queued if the caller stopped early (i.e. an exception).
+      while (!finished_) {
+        Chunk *chunk = ordered_.Consume();
+        if (!chunk) break;
+        Wait(*chunk);
+        delete chunk;
+      }
+      reader_.join();
+      for (std::size_t i = 0; i < workers_.size(); ++i) {
+        todo_.Produce(NULL);
+      }
+      workers_.join_all();
+    }
+
+    const Chunk &Next() {
+      delete current_;
+      current_ = ordered_.Consume();
+      if (!current_) {
+        finished_ = true;
+        UTIL_THROW(FormatLoadException, "Ran out of " << static_cast<unsigned int>(n_) << "-grams");
+      }
+      Wait(*current_);
+      UTIL_THROW_IF(!current_->error.empty(), FormatLoadException, current_->error << " (counting from the chunk of " << static_cast<unsigned int>(n_) << "-grams that starts at byte " << current_->offset << ")");
+      return *current_;
+    }
+
+  private:
+    void Wait(const Chunk &chunk) {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (!chunk.done) done_.wait(lock);
+    }
+
+    bool Stopped() {
+      boost::mutex::scoped_lock lock(mutex_);
+      return stop_;
+    }
+
+    // Reader thread: split the section into chunks of whole lines.  Blank
+    // lines are dropped; ReadNGram would have skipped them as leading space.
+    void Cut() {
+      uint64_t remaining = count_;
+      while (remaining && !Stopped()) {
+        Chunk *chunk = new Chunk();
+        chunk->offset = f_.Offset();
+        chunk->lines = 0;
+        chunk->done = false;
+        try {
+          std::size_t want = static_cast<std::size_t>(std::min<uint64_t>(remaining, kChunkNGrams));
+          while (chunk->lines < want) {
+            StringPiece line(f_.ReadLine());
+            if (IsEntirelyWhiteSpace(line)) continue;
+            chunk->text.append(line.data(), line.size());
+            chunk->text.push_back('\n');
+            ++chunk->lines;
+          }
+        } catch (const util::Exception &e) {
+          chunk->error = e.what();
+          chunk->done = true;
+          ordered_.Produce(chunk);
+          break;
+        }
+        remaining -= chunk->lines;
+        ordered_.Produce(chunk);
+        todo_.Produce(chunk);
+      }
+      ordered_.Produce(NULL);
+    }
+
+    // Worker threads: parse exactly as ReadNGram would have.
+    void Parse() {
+      Chunk *chunk;
+      while ((chunk = todo_.Consume())) {
+        PositiveProbWarn &warn = chunk->warn;
+        warn = warn_;
+        try {
+          chunk->words.resize(chunk->lines * n_);
+          chunk->weights.resize(chunk->lines);
+          ChunkBuf buf(chunk->text);
+          std::istream stream(&buf);
+          util::FilePiece in(stream, NULL, chunk->text.size());
+          for (std::size_t i = 0; i < chunk->lines; ++i) {
+            ReadNGram(in, n_, vocab_, &chunk->words[i * n_], chunk->weights[i], warn);
+          }
+        } catch (const util::Exception &e) {
+          chunk->error = e.what();
+        }
+        // Only the consumer needs the parsed form.
+        std::string().swap(chunk->text);
+        boost::mutex::scoped_lock lock(mutex_);
+        chunk->done = true;
+        done_.notify_all();
+      }
+    }
+
+    util::FilePiece &f_;
+    const unsigned char n_;
+    const uint64_t count_;
+    const Voc &vocab_;
+    const PositiveProbWarn warn_;
+
+    // Chunks in file order, and those waiting to be parsed.
+    util::PCQueue<Chunk*> ordered_, todo_;
+
+    Chunk *current_;
+    bool finished_;
+
+    boost::mutex mutex_;
+    boost::condition_variable done_;
+    bool stop_;
+
+    boost::thread reader_;
+    boost::thread_group workers_;
+};
+
+} // namespace detail
+#endif // WITH_THREADS
+
+template <class Voc, class Weights> ParallelNGramReader<Voc, Weights>::ParallelNGramReader(util::FilePiece &f, unsigned char n, uint64_t count, const Voc &vocab, PositiveProbWarn &warn, std::size_t threads)
+  : f_(f), n_(n), vocab_(vocab), warn_(warn), chunks_(NULL), words_(NULL), weights_(NULL), weights_end_(NULL) {
+#ifdef WITH_THREADS
+  if (threads > 1 && count) {
+    chunks_ = new detail::NGramChunks<Voc, Weights>(f, n, count, vocab, warn, threads);
+  }
+#endif
+}
+
+template <class Voc, class Weights> ParallelNGramReader<Voc, Weights>::~ParallelNGramReader() {
+#ifdef WITH_THREADS
+  delete chunks_;
+#endif
+}
+
+template <class Voc, class Weights> void ParallelNGramReader<Voc, Weights>::NextChunk() {
+#ifdef WITH_THREADS
+  const detail::NGramChunk<Weights> &chunk = chunks_->Next();
+  warn_.Merge(chunk.warn);
+  words_ = chunk.words.empty() ? NULL : &chunk.words[0];
+  weights_ = chunk.weights.empty() ? NULL : &chunk.weights[0];
+  weights_end_ = weights_ + chunk.weights.size();
+#endif
+}
+
+template class ParallelNGramReader<ngram::ProbingVocabulary, Prob>;
+template class ParallelNGramReader<ngram::ProbingVocabulary, ProbBackoff>;
+template class ParallelNGramReader<ngram::ProbingVocabulary, RestWeights>;
+template class ParallelNGramReader<ngram::SortedVocabulary, Prob>;
+template class ParallelNGramReader<ngram::SortedVocabulary, ProbBackoff>;
+
 void PositiveProbWarn::Warn(float prob) {
+  if (deferred_ && action_ != THROW_UP) {
+    if (!held_) {
+      held_ = true;
+      prob_ = prob;
+    }
+    return;
+  }
   switch (action_) {
     case THROW_UP:
       UTIL_THROW(FormatLoadException, "Positive log probability " << prob << " in the model.  This is a bug in IRSTLM; you can set config.positive_log_probability = SILENT or pass -i to build_binary to substitute 0.0 for the log probability.  Error");
@@ -158,4 +375,14 @@ void PositiveProbWarn::Warn(float prob) {
   }
 }
 
+PositiveProbWarn PositiveProbWarn::Deferred() const {
+  PositiveProbWarn ret(action_);
+  ret.deferred_ = true;
+  return ret;
+}
+
+void PositiveProbWarn::Merge(const PositiveProbWarn &deferred) {
+  if (deferred.held_) Warn(deferred.prob_);
+}
+
 } // namespace lm
@@ -31,14 +31,24 @@ extern const bool kARPASpaces[256];
 // Positive log probability warning.
 class PositiveProbWarn {
   public:
-    PositiveProbWarn() : action_(THROW_UP) {}
+    PositiveProbWarn() : action_(THROW_UP), deferred_(false), held_(false), prob_(0.0) {}
 
-    explicit PositiveProbWarn(WarningAction action) : action_(action) {}
+    explicit PositiveProbWarn(WarningAction action) : action_(action), deferred_(false), held_(false), prob_(0.0) {}
 
     void Warn(float prob);
 
+    // A copy for parsing on another thread.  It throws as this would, but
+    // instead of complaining it holds on to the first positive probability
+    // until it is passed to Merge.
+    PositiveProbWarn Deferred() const;
+
+    // Warn about what a Deferred copy held on to, if anything.
+    void Merge(const PositiveProbWarn &deferred);
+
   private:
     WarningAction action_;
+    bool deferred_, held_;
+    float prob_;
 };
 
 template <class Voc, class Weights> void Read1Gram(util::FilePiece &f, Voc &vocab, Weights *unigrams, PositiveProbWarn &warn) {
@@ -90,6 +100,52 @@ template <class Voc, class Weights, class Iterator> void ReadNGram(util::FilePie
   }
 }
 
+namespace detail { template <class Voc, class Weights> class NGramChunks; }
+
+/* Reads the count n-grams of order n that follow ReadNGramHeader, giving the
+ * same results as calling ReadNGram count times.  With more than one thread,
+ * a reader thread cuts the section into chunks of lines, which are parsed
+ * concurrently and handed back in file order.  Whatever is built from them is
+ * therefore the same for any number of threads.  Nothing else may read from f
+ * until this is destroyed.
+ */
+template <class Voc, class Weights> class ParallelNGramReader {
+  public:
+    ParallelNGramReader(util::FilePiece &f, unsigned char n, uint64_t count, const Voc &vocab, PositiveProbWarn &warn, std::size_t threads);
+
+    ~ParallelNGramReader();
+
+    template <class Iterator> void Read(Iterator indices_out, Weights &weights) {
+      if (!chunks_) {
+        ReadNGram(f_, n_, vocab_, indices_out, weights, warn_);
+        return;
+      }
+      if (weights_ == weights_end_) NextChunk();
+      for (unsigned char i = 0; i < n_; ++i, ++indices_out) {
+        *indices_out = *words_++;
+      }
+      weights = *weights_++;
+    }
+
+  private:
+    void NextChunk();
+
+    util::FilePiece &f_;
+    const unsigned char n_;
+    const Voc &vocab_;
+    PositiveProbWarn &warn_;
+
+    detail::NGramChunks<Voc, Weights> *chunks_;
+
+    // Current chunk.
+    const WordIndex *words_;
+    const Weights *weights_, *weights_end_;
+
+    // Noncopyable.
+    ParallelNGramReader(const ParallelNGramReader &);
+    ParallelNGramReader &operator=(const ParallelNGramReader &);
+};
+
 } // namespace lm
 
 #endif // LM_READ_ARPA_H
@@ -8,6 +8,7 @@
 #include "lm/weights.hh"
 
 #include "util/bit_packing.hh"
+#include "util/prefetch.hh"
 #include "util/probing_hash_table.hh"
 
 #include <algorithm>
@@ -136,11 +137,31 @@ template <class Value> class HashedSearch {
       return true;
     }
 
+    /* Prefetch every bucket that scoring new_word after the context would
+     * probe.  Keys only depend on the words, so they can all be computed
+     * without touching the tables.  context is in reverse order and must not
+     * be longer than Order() - 1.
+     */
+    void Prefetch(const WordIndex *context_rbegin, const WordIndex *context_rend, WordIndex new_word) const {
+      util::PrefetchRead(&unigram_.Lookup(new_word));
+      Node node = static_cast<Node>(new_word);
+      const WordIndex *i = context_rbegin;
+      for (typename std::vector<Middle>::const_iterator mid = middle_.begin(); mid != middle_.end(); ++mid, ++i) {
+        if (i == context_rend) return;
+        node = CombineWordHash(node, *i);
+        mid->Prefetch(node);
+      }
+      if (i != context_rend) longest_.Prefetch(CombineWordHash(node, *i));
+    }
+
+    // Prefetch already covered every bucket.
+    void PrefetchNext(const WordIndex * /*context_rbegin*/, const WordIndex * /*context_rend*/, WordIndex /*new_word*/) const {}
+
   private:
     // Interpret config's rest cost build policy and pass the right template argument to ApplyBuild.
     void DispatchBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const Config &config, const ProbingVocabulary &vocab, PositiveProbWarn &warn);
 
-    template <class Build> void ApplyBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const ProbingVocabulary &vocab, PositiveProbWarn &warn, const Build &build);
+    template <class Build> void ApplyBuild(util::FilePiece &f, const std::vector<uint64_t> &counts, const ProbingVocabulary &vocab, PositiveProbWarn &warn, const Build &build, std::size_t threads);
 
     class Unigram {
       public:
@@ -99,6 +99,27 @@ template <class Quant, class Bhiksha> class TrieSearch {
       return true;
     }
 
+    /* Trie lookups are a chain of dependent reads, so only the unigram entry
+     * can be computed ahead of time.
+     */
+    void Prefetch(const WordIndex * /*context_rbegin*/, const WordIndex * /*context_rend*/, WordIndex new_word) const {
+      unigram_.Prefetch(new_word);
+    }
+
+    /* Second stage, once Prefetch has had time to land: read the unigram
+     * entry and prefetch the first probe of the bigram search.
+     */
+    void PrefetchNext(const WordIndex *context_rbegin, const WordIndex *context_rend, WordIndex new_word) const {
+      if (context_rbegin == context_rend) return;
+      Node node;
+      unigram_.Find(new_word, node);
+      if (middle_begin_ == middle_end_) {
+        longest_.Prefetch(*context_rbegin, node);
+      } else {
+        middle_begin_->Prefetch(*context_rbegin, node);
+      }
+    }
+
   private:
     friend void BuildTrie<Quant, Bhiksha>(SortedFiles &files, std::vector<uint64_t> &counts, const Config &config, TrieSearch<Quant, Bhiksha> &out, Quant &quant, SortedVocabulary &vocab, BinaryFormat &backing);
 
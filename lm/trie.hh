@@ -4,6 +4,8 @@
 #include "lm/weights.hh"
 #include "lm/word_index.hh"
 #include "util/bit_packing.hh"
+#include "util/prefetch.hh"
+#include "util/sorted_uniform.hh"
 
 #include <cstddef>
 
@@ -62,6 +64,10 @@ class Unigram {
       return unigram_;
     }
 
+    void Prefetch(WordIndex word) const {
+      util::PrefetchRead(unigram_ + word);
+    }
+
     UnigramPointer Find(WordIndex word, NodeRange &next) const {
       UnigramValue *val = unigram_ + word;
       next.begin = val->next;
@@ -81,6 +87,13 @@ class BitPacked {
       return insert_index_;
     }
 
+    // Prefetch the entry Find(word, range) will read first.
+    void Prefetch(WordIndex word, const NodeRange &range) const {
+      if (range.begin == range.end) return;
+      uint64_t guess = range.begin + util::PivotSelect<sizeof(WordIndex)>::T::Calc(word, max_vocab_, range.end - range.begin);
+      util::PrefetchRead(base_ + ((guess * total_bits_) >> 3));
+    }
+
   protected:
     static uint64_t BaseSize(uint64_t entries, uint64_t max_vocab, uint8_t remaining_bits);
 
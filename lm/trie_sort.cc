@@ -9,6 +9,7 @@
 #include "util/file_piece.hh"
 #include "util/mmap.hh"
 #include "util/proxy_iterator.hh"
+#include "util/scoped.hh"
 #include "util/sized_iterator.hh"
 
 #include <algorithm>
@@ -212,7 +213,7 @@ SortedFiles::SortedFiles(const Config &config, util::FilePiece &f, std::vector<u
   if (!mem.get()) UTIL_THROW(util::ErrnoException, "malloc failed for sort buffer size " << buffer);
 
   for (unsigned char order = 2; order <= counts.size(); ++order) {
-    ConvertToSorted(f, vocab, counts, file_prefix, order, warn, mem.get(), buffer);
+    ConvertToSorted(f, vocab, counts, file_prefix, order, warn, mem.get(), buffer, config.build_threads);
   }
   ReadEnd(f);
 }
@@ -237,7 +238,7 @@ class Closer {
 };
 } // namespace
 
-void SortedFiles::ConvertToSorted(util::FilePiece &f, const SortedVocabulary &vocab, const std::vector<uint64_t> &counts, const std::string &file_prefix, unsigned char order, PositiveProbWarn &warn, void *mem, std::size_t mem_size) {
+void SortedFiles::ConvertToSorted(util::FilePiece &f, const SortedVocabulary &vocab, const std::vector<uint64_t> &counts, const std::string &file_prefix, unsigned char order, PositiveProbWarn &warn, void *mem, std::size_t mem_size, std::size_t threads) {
   ReadNGramHeader(f, order);
   const size_t count = counts[order - 1];
   // Size of weights.  Does it include backoff?
@@ -247,6 +248,15 @@ void SortedFiles::ConvertToSorted(util::FilePiece &f, const SortedVocabulary &vo
   const size_t batch_size = std::min(count, mem_size / entry_size);
   uint8_t *const begin = reinterpret_cast<uint8_t*>(mem);
 
+  // The highest order has no backoff.
+  util::scoped_ptr<ParallelNGramReader<SortedVocabulary, Prob> > longest;
+  util::scoped_ptr<ParallelNGramReader<SortedVocabulary, ProbBackoff> > middle;
+  if (order == counts.size()) {
+    longest.reset(new ParallelNGramReader<SortedVocabulary, Prob>(f, order, count, vocab, warn, threads));
+  } else {
+    middle.reset(new ParallelNGramReader<SortedVocabulary, ProbBackoff>(f, order, count, vocab, warn, threads));
+  }
+
   std::deque<FILE*> files, contexts;
   Closer files_closer(files), contexts_closer(contexts);
 
@@ -256,12 +266,12 @@ void SortedFiles::ConvertToSorted(util::FilePiece &f, const SortedVocabulary &vo
     if (order == counts.size()) {
       for (; out != out_end; out += entry_size) {
         std::reverse_iterator<WordIndex*> it(reinterpret_cast<WordIndex*>(out) + order);
-        ReadNGram(f, order, vocab, it, *reinterpret_cast<Prob*>(out + words_size), warn);
+        longest->Read(it, *reinterpret_cast<Prob*>(out + words_size));
       }
     } else {
       for (; out != out_end; out += entry_size) {
         std::reverse_iterator<WordIndex*> it(reinterpret_cast<WordIndex*>(out) + order);
-        ReadNGram(f, order, vocab, it, *reinterpret_cast<ProbBackoff*>(out + words_size), warn);
+        middle->Read(it, *reinterpret_cast<ProbBackoff*>(out + words_size));
       }
     }
     // Sort full records by full n-gram.
@@ -0,0 +1,342 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2011- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/file_stream.hh"
+
+#include "ColumnarData.h"
+#include "FeatureData.h"
+#include "ScoreData.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace MosesTuning
+{
+
+namespace
+{
+
+const char kMagic[8] = {'M', 'E', 'R', 'T', 'C', 'O', 'L', '\0'};
+const uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  uint64_t sentences;
+  uint64_t hypotheses;
+  uint64_t columns;
+  uint64_t nonzeros;
+  uint64_t names_size;
+  uint64_t sparse_names_size;
+};
+
+uint64_t Padded(uint64_t bytes)
+{
+  return (bytes + 7) & ~static_cast<uint64_t>(7);
+}
+
+// Byte offsets of the sections, shared by the reader and the writers.
+struct Layout {
+  explicit Layout(const Header& h) {
+    names = sizeof(Header);
+    sparse_names = names + Padded(h.names_size);
+    sentence_ids = sparse_names + Padded(h.sparse_names_size);
+    row_begin = sentence_ids + sizeof(int64_t) * h.sentences;
+    matrix = row_begin + sizeof(uint64_t) * (h.sentences + 1);
+    sparse_begin = matrix + Padded(sizeof(float) * h.hypotheses * h.columns);
+    if (h.kind == ColumnarFile::FEATURES) {
+      sparse_column = sparse_begin + sizeof(uint64_t) * (h.hypotheses + 1);
+      sparse_value = sparse_column + Padded(sizeof(uint32_t) * h.nonzeros);
+      end = sparse_value + Padded(sizeof(float) * h.nonzeros);
+    } else {
+      sparse_column = sparse_value = end = sparse_begin;
+    }
+  }
+
+  uint64_t names, sparse_names, sentence_ids, row_begin, matrix;
+  uint64_t sparse_begin, sparse_column, sparse_value, end;
+};
+
+void InitHeader(ColumnarFile::Kind kind, Header& h)
+{
+  memset(&h, 0, sizeof(Header));
+  memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.kind = kind;
+}
+
+void Pad(util::FileStream& out, uint64_t written)
+{
+  const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  out.write(zeros, Padded(written) - written);
+}
+
+template <class T> void WriteValue(util::FileStream& out, T value)
+{
+  out.write(&value, sizeof(T));
+}
+
+// Sparse values the text writer would drop (SparseVector::write).
+bool Negligible(FeatureStatsType value)
+{
+  return fabs(value) < 0.00001;
+}
+
+// Sparse names read from n-best lists keep their trailing '=', which the
+// text format loses on the way back in.  Store them the way they reload.
+string SparseName(size_t id)
+{
+  string name = SparseVector::decode(id);
+  if (!name.empty() && name[name.size() - 1] == '=') {
+    name.resize(name.size() - 1);
+  }
+  return name;
+}
+
+} // namespace
+
+ColumnarFile::ColumnarFile(const string& filename, Kind kind)
+  : m_filename(filename)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(filename.c_str()));
+  const uint64_t size = util::SizeOrThrow(fd.get());
+  UTIL_THROW_IF(size < sizeof(Header), util::Exception,
+                filename << " is too short to hold columnar data");
+  util::MapRead(util::POPULATE_OR_READ, fd.get(), 0, size, m_mem);
+
+  Header h;
+  memcpy(&h, m_mem.begin(), sizeof(Header));
+  UTIL_THROW_IF(memcmp(h.magic, kMagic, sizeof(kMagic)), util::Exception,
+                filename << " is not columnar data");
+  UTIL_THROW_IF(h.version != kVersion, util::Exception,
+                filename << " has columnar version " << h.version << " but "
+                << kVersion << " was expected; it may have been written on a"
+                " machine with different byte order");
+  UTIL_THROW_IF(h.kind != static_cast<uint32_t>(kind), util::Exception,
+                filename << " holds " << (h.kind == FEATURES ? "features" : "scores")
+                << " where " << (kind == FEATURES ? "features" : "scores")
+                << " were expected");
+  const Layout layout(h);
+  UTIL_THROW_IF(layout.end != size, util::Exception,
+                filename << " is " << size << " bytes but its header implies "
+                << layout.end);
+
+  const char* base = m_mem.begin();
+  m_sentences = h.sentences;
+  m_columns = h.columns;
+  m_names.assign(base + layout.names, h.names_size);
+  m_sentence_ids = reinterpret_cast<const int64_t*>(base + layout.sentence_ids);
+  m_row_begin = reinterpret_cast<const uint64_t*>(base + layout.row_begin);
+  m_matrix = reinterpret_cast<const float*>(base + layout.matrix);
+  UTIL_THROW_IF(m_row_begin[m_sentences] != h.hypotheses, util::Exception,
+                filename << " has an inconsistent sentence index");
+
+  if (kind == FEATURES) {
+    m_sparse_begin = reinterpret_cast<const uint64_t*>(base + layout.sparse_begin);
+    m_sparse_column = reinterpret_cast<const uint32_t*>(base + layout.sparse_column);
+    m_sparse_value = reinterpret_cast<const float*>(base + layout.sparse_value);
+    UTIL_THROW_IF(m_sparse_begin[h.hypotheses] != h.nonzeros, util::Exception,
+                  filename << " has an inconsistent sparse feature index");
+  } else {
+    m_sparse_begin = NULL;
+    m_sparse_column = NULL;
+    m_sparse_value = NULL;
+  }
+
+  const char* name = base + layout.sparse_names;
+  const char* names_end = name + h.sparse_names_size;
+  while (name < names_end) {
+    const size_t length = strlen(name);
+    m_sparse_ids.push_back(SparseVector::encode(string(name, length)));
+    name += length + 1;
+  }
+}
+
+bool ColumnarFile::Is(const string& filename)
+{
+  ifstream in(filename.c_str(), ios::in | ios::binary);
+  char magic[sizeof(kMagic)];
+  if (!in.read(magic, sizeof(kMagic))) return false;
+  return memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+void WriteColumnar(const FeatureData& data, const string& filename)
+{
+  TRACE_ERR("saving columnar features into " << filename << endl);
+  Header h;
+  InitHeader(ColumnarFile::FEATURES, h);
+  h.sentences = data.size();
+  h.columns = data.NumberOfFeatures();
+  const string names = data.Features();
+  h.names_size = names.size();
+
+  // First pass: count rows and number the sparse features in order of
+  // appearance.
+  map<size_t, uint32_t> sparse_columns;
+  map<string, uint32_t> columns_by_name;
+  string sparse_names;
+  for (size_t s = 0; s < data.size(); ++s) {
+    const FeatureArray& array = data.get(s);
+    h.hypotheses += array.size();
+    for (size_t i = 0; i < array.size(); ++i) {
+      const FeatureStats& stats = array.get(i);
+      UTIL_THROW_IF(stats.size() != h.columns, util::Exception,
+                    "Sentence " << array.getIndex() << " has " << stats.size()
+                    << " dense features but " << h.columns << " are named");
+      const SparseVector& sparse = stats.getSparse();
+      const vector<size_t> ids = sparse.feats();
+      for (size_t j = 0; j < ids.size(); ++j) {
+        if (Negligible(sparse.get(ids[j]))) continue;
+        ++h.nonzeros;
+        if (sparse_columns.count(ids[j])) continue;
+        const string name = SparseName(ids[j]);
+        map<string, uint32_t>::const_iterator found = columns_by_name.find(name);
+        if (found == columns_by_name.end()) {
+          found = columns_by_name.insert(make_pair(name, columns_by_name.size())).first;
+          sparse_names += name;
+          sparse_names += '\0';
+        }
+        sparse_columns[ids[j]] = found->second;
+      }
+    }
+  }
+  h.sparse_names_size = sparse_names.size();
+
+  util::scoped_fd fd(util::CreateOrThrow(filename.c_str()));
+  util::FileStream out(fd.get(), 1 << 20);
+  out.write(&h, sizeof(Header));
+  out.write(names.data(), names.size());
+  Pad(out, names.size());
+  out.write(sparse_names.data(), sparse_names.size());
+  Pad(out, sparse_names.size());
+
+  for (size_t s = 0; s < data.size(); ++s) {
+    WriteValue<int64_t>(out, data.get(s).getIndex());
+  }
+  uint64_t row = 0;
+  for (size_t s = 0; s < data.size(); ++s) {
+    WriteValue<uint64_t>(out, row);
+    row += data.get(s).size();
+  }
+  WriteValue<uint64_t>(out, row);
+
+  for (size_t s = 0; s < data.size(); ++s) {
+    const FeatureArray& array = data.get(s);
+    for (size_t i = 0; i < array.size(); ++i) {
+      const FeatureStats& stats = array.get(i);
+      for (size_t j = 0; j < stats.size(); ++j) {
+        WriteValue<float>(out, stats.get(j));
+      }
+    }
+  }
+  Pad(out, sizeof(float) * h.hypotheses * h.columns);
+
+  // Sparse features, in three passes over the rows (begin, column, value).
+  uint64_t entry = 0;
+  for (size_t s = 0; s < data.size(); ++s) {
+    const FeatureArray& array = data.get(s);
+    for (size_t i = 0; i < array.size(); ++i) {
+      WriteValue<uint64_t>(out, entry);
+      const SparseVector& sparse = array.get(i).getSparse();
+      const vector<size_t> ids = sparse.feats();
+      for (size_t j = 0; j < ids.size(); ++j) {
+        if (!Negligible(sparse.get(ids[j]))) ++entry;
+      }
+    }
+  }
+  WriteValue<uint64_t>(out, entry);
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t s = 0; s < data.size(); ++s) {
+      const FeatureArray& array = data.get(s);
+      for (size_t i = 0; i < array.size(); ++i) {
+        const SparseVector& sparse = array.get(i).getSparse();
+        const vector<size_t> ids = sparse.feats();
+        for (size_t j = 0; j < ids.size(); ++j) {
+          const FeatureStatsType value = sparse.get(ids[j]);
+          if (Negligible(value)) continue;
+          if (pass == 0) {
+            WriteValue<uint32_t>(out, sparse_columns[ids[j]]);
+          } else {
+            WriteValue<float>(out, value);
+          }
+        }
+      }
+    }
+    Pad(out, sizeof(uint32_t) * h.nonzeros);
+  }
+  out.flush();
+}
+
+void WriteColumnar(const ScoreData& data, const string& filename)
+{
+  TRACE_ERR("saving columnar scores into " << filename << endl);
+  Header h;
+  InitHeader(ColumnarFile::SCORES, h);
+  h.sentences = data.size();
+  h.columns = data.NumberOfScores();
+  const string names = data.name();
+  h.names_size = names.size();
+  for (size_t s = 0; s < data.size(); ++s) {
+    const ScoreArray& array = data.get(s);
+    h.hypotheses += array.size();
+    for (size_t i = 0; i < array.size(); ++i) {
+      UTIL_THROW_IF(array.get(i).size() != h.columns, util::Exception,
+                    "Sentence " << array.getIndex() << " has " << array.get(i).size()
+                    << " score statistics but the scorer has " << h.columns);
+    }
+  }
+
+  util::scoped_fd fd(util::CreateOrThrow(filename.c_str()));
+  util::FileStream out(fd.get(), 1 << 20);
+  out.write(&h, sizeof(Header));
+  out.write(names.data(), names.size());
+  Pad(out, names.size());
+
+  for (size_t s = 0; s < data.size(); ++s) {
+    WriteValue<int64_t>(out, data.get(s).getIndex());
+  }
+  uint64_t row = 0;
+  for (size_t s = 0; s < data.size(); ++s) {
+    WriteValue<uint64_t>(out, row);
+    row += data.get(s).size();
+  }
+  WriteValue<uint64_t>(out, row);
+
+  for (size_t s = 0; s < data.size(); ++s) {
+    const ScoreArray& array = data.get(s);
+    for (size_t i = 0; i < array.size(); ++i) {
+      const ScoreStats& stats = array.get(i);
+      for (size_t j = 0; j < stats.size(); ++j) {
+        WriteValue<float>(out, stats.get(j));
+      }
+    }
+  }
+  Pad(out, sizeof(float) * h.hypotheses * h.columns);
+  out.flush();
+}
+
+}
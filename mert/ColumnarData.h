@@ -0,0 +1,143 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2011- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef MERT_COLUMNAR_DATA_H_
+#define MERT_COLUMNAR_DATA_H_
+
+/**
+ * Binary columnar feature and score data, written by extractor --columnar
+ * and memory mapped by mert, pro and kbmira instead of parsing text.
+ *
+ * A file holds one table, either features or score statistics:
+ *
+ *   header
+ *   names          feature map or score type, as in the text headers
+ *   sparse names   NUL terminated sparse feature names (features only)
+ *   sentence ids   int64[sentences]
+ *   row begin      uint64[sentences + 1], first hypothesis of each sentence
+ *   matrix         float[hypotheses * columns], one row per hypothesis
+ *   sparse begin   uint64[hypotheses + 1] (features only)
+ *   sparse column  uint32[nonzeros], index into the sparse names
+ *   sparse value   float[nonzeros]
+ *
+ * Sparse features are stored CSR style.  Every section starts on an 8 byte
+ * boundary.  Numbers are in native byte order; the header version doubles as
+ * a byte order check.
+**/
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "util/mmap.hh"
+
+#include "Types.h"
+
+namespace MosesTuning
+{
+
+class FeatureData;
+class ScoreData;
+
+class ColumnarFile
+{
+public:
+  typedef enum { FEATURES = 0, SCORES = 1 } Kind;
+
+  ColumnarFile(const std::string& filename, Kind kind);
+
+  /** Whether filename starts with the columnar magic (text and gzip don't). */
+  static bool Is(const std::string& filename);
+
+  const std::string& FileName() const {
+    return m_filename;
+  }
+
+  /** Feature map (features) or score type (scores). */
+  const std::string& Names() const {
+    return m_names;
+  }
+
+  std::size_t NumSentences() const {
+    return m_sentences;
+  }
+  std::size_t NumColumns() const {
+    return m_columns;
+  }
+
+  int SentenceIndex(std::size_t sentence) const {
+    return static_cast<int>(m_sentence_ids[sentence]);
+  }
+  std::size_t NumHypotheses(std::size_t sentence) const {
+    return m_row_begin[sentence + 1] - m_row_begin[sentence];
+  }
+
+  /** Dense features or score statistics of a hypothesis. */
+  const float* Row(std::size_t sentence, std::size_t hyp) const {
+    return m_matrix + (m_row_begin[sentence] + hyp) * m_columns;
+  }
+
+  /** Range of sparse entries of a hypothesis, for SparseColumn/SparseValue. */
+  std::size_t SparseBegin(std::size_t sentence, std::size_t hyp) const {
+    return m_sparse_begin[m_row_begin[sentence] + hyp];
+  }
+  std::size_t SparseEnd(std::size_t sentence, std::size_t hyp) const {
+    return m_sparse_begin[m_row_begin[sentence] + hyp + 1];
+  }
+  std::size_t SparseColumn(std::size_t entry) const {
+    return m_sparse_column[entry];
+  }
+  float SparseValue(std::size_t entry) const {
+    return m_sparse_value[entry];
+  }
+
+  /** SparseVector ids of the sparse columns, registered on open. */
+  const std::vector<std::size_t>& SparseIds() const {
+    return m_sparse_ids;
+  }
+
+private:
+  std::string m_filename;
+  util::scoped_memory m_mem;
+
+  std::size_t m_sentences;
+  std::size_t m_columns;
+  std::string m_names;
+  std::vector<std::size_t> m_sparse_ids;
+
+  const int64_t* m_sentence_ids;
+  const uint64_t* m_row_begin;
+  const float* m_matrix;
+  const uint64_t* m_sparse_begin;
+  const uint32_t* m_sparse_column;
+  const float* m_sparse_value;
+
+  // Not copyable: the pointers above point into m_mem.
+  ColumnarFile(const ColumnarFile&);
+  ColumnarFile& operator=(const ColumnarFile&);
+};
+
+void WriteColumnar(const FeatureData& data, const std::string& filename);
+void WriteColumnar(const ScoreData& data, const std::string& filename);
+
+}
+
+#endif  // MERT_COLUMNAR_DATA_H_
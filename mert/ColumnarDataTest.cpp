@@ -0,0 +1,124 @@
+#include "ColumnarData.h"
+#include "Data.h"
+#include "FeatureDataIterator.h"
+#include "ScoreDataIterator.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+
+#define BOOST_TEST_MODULE MertColumnarData
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+
+using namespace MosesTuning;
+
+namespace
+{
+
+class TempFile
+{
+public:
+  TempFile() : m_path(boost::filesystem::temp_directory_path() /
+                        boost::filesystem::unique_path()) {}
+  ~TempFile() {
+    boost::filesystem::remove(m_path);
+  }
+  std::string str() const {
+    return m_path.string();
+  }
+private:
+  boost::filesystem::path m_path;
+};
+
+// Two sentences, the second (id 7) with three hypotheses of which one has
+// sparse features.
+void FillData(Data& data)
+{
+  data.getFeatureData()->setFeatureMap("d_0 lm_0 ");
+  float dense[4][2] = {{0.5, -1}, {1.5, -2}, {2.5, -3}, {3.5, -4}};
+  int sentence[4] = {0, 7, 7, 7};
+  for (size_t i = 0; i < 4; ++i) {
+    FeatureStats features;
+    features.add(dense[i][0]);
+    features.add(dense[i][1]);
+    if (i == 2) {
+      features.addSparse("pp_a", 2);
+      features.addSparse("pp_b", -0.25);
+    }
+    data.getFeatureData()->add(features, sentence[i]);
+
+    std::vector<ScoreStatsType> stats(9, i);
+    ScoreStats scores;
+    scores.set(stats);
+    data.getScoreData()->add(scores, sentence[i]);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(columnar_round_trip)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  FillData(data);
+  TempFile featfile, scorefile;
+  data.saveColumnar(featfile.str(), scorefile.str());
+  BOOST_REQUIRE(ColumnarFile::Is(featfile.str()));
+  BOOST_REQUIRE(ColumnarFile::Is(scorefile.str()));
+
+  Data loaded(scorer.get());
+  loaded.load(featfile.str(), scorefile.str());
+  const FeatureDataHandle& features = loaded.getFeatureData();
+  const ScoreDataHandle& scores = loaded.getScoreData();
+  BOOST_REQUIRE_EQUAL((std::size_t)2, features->size());
+  BOOST_REQUIRE_EQUAL((std::size_t)2, scores->size());
+  BOOST_CHECK_EQUAL("d_0 lm_0 ", features->Features());
+  BOOST_CHECK_EQUAL(7, features->get(1).getIndex());
+  BOOST_REQUIRE_EQUAL((std::size_t)3, features->get(1).size());
+  BOOST_CHECK(features->get(1, 1) == data.getFeatureData()->get(1, 1));
+  BOOST_CHECK_EQUAL(2, features->get(1, 1).getSparse().get("pp_a"));
+  BOOST_CHECK_EQUAL(-0.25, features->get(1, 1).getSparse().get("pp_b"));
+  BOOST_CHECK_EQUAL((std::size_t)0, features->get(1, 2).getSparse().size());
+  BOOST_CHECK(scores->get(1, 2) == data.getScoreData()->get(1, 2));
+  BOOST_CHECK_EQUAL(3, scores->get(1, 2).get(8));
+}
+
+BOOST_AUTO_TEST_CASE(columnar_iterators)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  FillData(data);
+  TempFile featfile, scorefile;
+  data.saveColumnar(featfile.str(), scorefile.str());
+
+  FeatureDataIterator features(featfile.str());
+  ScoreDataIterator scores(scorefile.str());
+  BOOST_REQUIRE(features != FeatureDataIterator::end());
+  BOOST_CHECK_EQUAL((std::size_t)1, features->size());
+  ++features;
+  ++scores;
+  BOOST_REQUIRE_EQUAL((std::size_t)3, features->size());
+  BOOST_REQUIRE_EQUAL((std::size_t)3, scores->size());
+  BOOST_CHECK_EQUAL(2.5, (*features)[1].dense[0]);
+  BOOST_CHECK_EQUAL(2, (*features)[1].sparse.get("pp_a"));
+  BOOST_CHECK_EQUAL((std::size_t)9, (*scores)[2].size());
+  ++features;
+  ++scores;
+  BOOST_CHECK(features == FeatureDataIterator::end());
+  BOOST_CHECK(scores == ScoreDataIterator::end());
+}
+
+BOOST_AUTO_TEST_CASE(columnar_kind_mismatch)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  FillData(data);
+  TempFile featfile, scorefile;
+  data.saveColumnar(featfile.str(), scorefile.str());
+  BOOST_CHECK_THROW(ColumnarFile(featfile.str(), ColumnarFile::SCORES), util::Exception);
+
+  TempFile textfile;
+  data.getFeatureData()->save(textfile.str());
+  BOOST_CHECK(!ColumnarFile::Is(textfile.str()));
+}
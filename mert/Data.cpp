@@ -11,6 +11,7 @@
 #include <fstream>
 
 #include "Data.h"
+#include "ColumnarData.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
 #include "Util.h"
@@ -206,6 +207,12 @@ void Data::save(const std::string &featfile, const std::string &scorefile, bool
   m_score_data->save(scorefile, bin);
 }
 
+void Data::saveColumnar(const std::string &featfile, const std::string &scorefile)
+{
+  WriteColumnar(*m_feature_data, featfile);
+  WriteColumnar(*m_score_data, scorefile);
+}
+
 void Data::InitFeatureMap(const string& str)
 {
   string buf = str;
@@ -73,6 +73,9 @@ public:
 
   void save(const std::string &featfile, const std::string &scorefile, bool bin=false);
 
+  /** Save in the memory-mappable format of ColumnarData.h. */
+  void saveColumnar(const std::string &featfile, const std::string &scorefile);
+
   //ADDED BY TS
   void removeDuplicates();
   //END_ADDED
@@ -9,6 +9,7 @@
 #include "FeatureData.h"
 
 #include <limits>
+#include "ColumnarData.h"
 #include "FileStream.h"
 #include "Util.h"
 
@@ -67,9 +68,42 @@ void FeatureData::load(istream* is, const SparseVector& sparseWeights)
 }
 
 
+void FeatureData::load(const ColumnarFile& file, const SparseVector& sparseWeights)
+{
+  const vector<size_t>& sparseIds = file.SparseIds();
+  for (size_t s = 0; s < file.NumSentences(); ++s) {
+    FeatureArray entry;
+    entry.setIndex(file.SentenceIndex(s));
+    entry.NumberOfFeatures(file.NumColumns());
+    entry.Features(file.Names());
+    FeatureStats stats(file.NumColumns());
+    for (size_t h = 0; h < file.NumHypotheses(s); ++h) {
+      stats.reset();
+      const float* row = file.Row(s, h);
+      for (size_t i = 0; i < file.NumColumns(); ++i) {
+        stats.add(row[i]);
+      }
+      for (size_t i = file.SparseBegin(s, h); i < file.SparseEnd(s, h); ++i) {
+        stats.addSparse(sparseIds[file.SparseColumn(i)], file.SparseValue(i));
+      }
+      stats.mergeSparse(sparseWeights);
+      entry.add(stats);
+    }
+
+    if (size() == 0)
+      setFeatureMap(entry.Features());
+
+    add(entry);
+  }
+}
+
 void FeatureData::load(const string &file, const SparseVector& sparseWeights)
 {
   TRACE_ERR("loading feature data from " << file << endl);
+  if (ColumnarFile::Is(file)) {
+    load(ColumnarFile(file, ColumnarFile::FEATURES), sparseWeights);
+    return;
+  }
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
     throw runtime_error("Unable to open feature file: " + file);
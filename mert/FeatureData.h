@@ -18,6 +18,7 @@
 namespace MosesTuning
 {
 
+class ColumnarFile;
 
 class FeatureData
 {
@@ -88,6 +89,7 @@ public:
 
   void load(std::istream* is, const SparseVector& sparseWeights);
   void load(const std::string &file, const SparseVector& sparseWeights);
+  void load(const ColumnarFile& file, const SparseVector& sparseWeights);
 
   bool check_consistency() const;
 
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
+#include "ColumnarData.h"
 #include "FeatureArray.h"
 #include "FeatureDataIterator.h"
 
@@ -57,7 +58,7 @@ float ParseFloat(const StringPiece& str)
 
 bool operator==(FeatureDataItem const& item1, FeatureDataItem const& item2)
 {
-  return item1.dense==item1.dense && item1.sparse==item1.sparse;
+  return item1.dense==item2.dense && item1.sparse==item2.sparse;
 }
 
 size_t hash_value(FeatureDataItem const& item)
@@ -69,18 +70,46 @@ size_t hash_value(FeatureDataItem const& item)
 }
 
 
-FeatureDataIterator::FeatureDataIterator() {}
+FeatureDataIterator::FeatureDataIterator() : m_sentence(0) {}
 
-FeatureDataIterator::FeatureDataIterator(const string& filename)
+FeatureDataIterator::FeatureDataIterator(const string& filename) : m_sentence(0)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (ColumnarFile::Is(filename)) {
+    m_columnar.reset(new ColumnarFile(filename, ColumnarFile::FEATURES));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
 FeatureDataIterator::~FeatureDataIterator() {}
 
+void FeatureDataIterator::readNextColumnar()
+{
+  if (m_sentence == m_columnar->NumSentences()) {
+    m_columnar.reset();
+    return;
+  }
+  const ColumnarFile& file = *m_columnar;
+  const vector<size_t>& sparseIds = file.SparseIds();
+  m_next.resize(file.NumHypotheses(m_sentence));
+  for (size_t h = 0; h < m_next.size(); ++h) {
+    const float* row = file.Row(m_sentence, h);
+    m_next[h].dense.assign(row, row + file.NumColumns());
+    m_next[h].sparse.clear();
+    for (size_t i = file.SparseBegin(m_sentence, h); i < file.SparseEnd(m_sentence, h); ++i) {
+      m_next[h].sparse.set(sparseIds[file.SparseColumn(i)], file.SparseValue(i));
+    }
+  }
+  ++m_sentence;
+}
+
 void FeatureDataIterator::readNext()
 {
+  if (m_columnar) {
+    readNextColumnar();
+    return;
+  }
   m_next.clear();
   try {
     StringPiece marker = m_in->ReadDelimited();
@@ -131,6 +160,11 @@ void FeatureDataIterator::increment()
 
 bool FeatureDataIterator::equal(const FeatureDataIterator& rhs) const
 {
+  if (m_columnar || rhs.m_columnar) {
+    return m_columnar && rhs.m_columnar &&
+           m_columnar->FileName() == rhs.m_columnar->FileName() &&
+           m_sentence == rhs.m_sentence;
+  }
   if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
@@ -45,6 +45,7 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class ColumnarFile;
 
 class FileFormatException : public util::Exception
 {
@@ -96,7 +97,12 @@ private:
 
   void readNext();
 
+  void readNextColumnar();
+
   boost::shared_ptr<util::FilePiece> m_in;
+  // Used instead of m_in when the file is columnar.
+  boost::shared_ptr<ColumnarFile> m_columnar;
+  std::size_t m_sentence;
   std::vector<FeatureDataItem> m_next;
 };
 
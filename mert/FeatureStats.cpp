@@ -249,6 +249,11 @@ void FeatureStats::addSparse(const string& name, FeatureStatsType v)
   m_map.set(name,v);
 }
 
+void FeatureStats::addSparse(size_t id, FeatureStatsType v)
+{
+  m_map.set(id,v);
+}
+
 void FeatureStats::set(string &theString, const SparseVector& sparseWeights )
 {
   string substring, stringBuf;
@@ -267,6 +272,17 @@ void FeatureStats::set(string &theString, const SparseVector& sparseWeights )
     }
   }
 
+  mergeSparse(sparseWeights);
+  /*
+  cerr << "FS: ";
+  for (size_t i = 0; i < entries_; ++i) {
+    cerr << array_[i] << " ";
+  }
+  cerr << endl;*/
+}
+
+void FeatureStats::mergeSparse(const SparseVector& sparseWeights)
+{
   if (sparseWeights.size()) {
     //Merge the sparse features
     FeatureStatsType merged = inner_product(sparseWeights, m_map);
@@ -280,12 +296,6 @@ void FeatureStats::set(string &theString, const SparseVector& sparseWeights )
     */
     m_map.clear();
   }
-  /*
-  cerr << "FS: ";
-  for (size_t i = 0; i < entries_; ++i) {
-    cerr << array_[i] << " ";
-  }
-  cerr << endl;*/
 }
 
 void FeatureStats::loadbin(istream* is)
@@ -92,6 +92,7 @@ public:
   void expand();
   void add(FeatureStatsType v);
   void addSparse(const std::string& name, FeatureStatsType v);
+  void addSparse(std::size_t id, FeatureStatsType v);
 
   void clear() {
     memset((void*)m_array, 0, GetArraySizeWithBytes());
@@ -119,6 +120,9 @@ public:
 
   void set(std::string &theString, const SparseVector& sparseWeights);
 
+  /** Replace the sparse features by one dense feature, their weighted sum. */
+  void mergeSparse(const SparseVector& sparseWeights);
+
   inline std::size_t bytes() const {
     return GetArraySizeWithBytes();
   }
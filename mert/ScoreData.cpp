@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <fstream>
+#include "ColumnarData.h"
 #include "Scorer.h"
 #include "Util.h"
 #include "FileStream.h"
@@ -72,9 +73,34 @@ void ScoreData::load(istream* is)
   }
 }
 
+void ScoreData::load(const ColumnarFile& file)
+{
+  string score_type = file.Names();
+  for (size_t s = 0; s < file.NumSentences(); ++s) {
+    ScoreArray entry;
+    entry.setIndex(file.SentenceIndex(s));
+    entry.NumberOfScores(file.NumColumns());
+    entry.name(score_type);
+    ScoreStats stats(file.NumColumns());
+    for (size_t h = 0; h < file.NumHypotheses(s); ++h) {
+      stats.reset();
+      const float* row = file.Row(s, h);
+      for (size_t i = 0; i < file.NumColumns(); ++i) {
+        stats.add(row[i]);
+      }
+      entry.add(stats);
+    }
+    add(entry);
+  }
+}
+
 void ScoreData::load(const string &file)
 {
   TRACE_ERR("loading score data from " << file << endl);
+  if (ColumnarFile::Is(file)) {
+    load(ColumnarFile(file, ColumnarFile::SCORES));
+    return;
+  }
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
     throw runtime_error("Unable to open score file: " + file);
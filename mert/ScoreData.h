@@ -21,6 +21,7 @@ namespace MosesTuning
 {
 
 
+class ColumnarFile;
 class Scorer;
 
 class ScoreData
@@ -93,6 +94,7 @@ public:
 
   void load(std::istream* is);
   void load(const std::string &file);
+  void load(const ColumnarFile& file);
 
   bool check_consistency() const;
 
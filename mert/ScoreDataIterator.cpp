@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
+#include "ColumnarData.h"
 #include "ScoreArray.h"
 #include "ScoreDataIterator.h"
 
@@ -31,18 +32,41 @@ namespace MosesTuning
 {
 
 
-ScoreDataIterator::ScoreDataIterator() {}
+ScoreDataIterator::ScoreDataIterator() : m_sentence(0) {}
 
-ScoreDataIterator::ScoreDataIterator(const string& filename)
+ScoreDataIterator::ScoreDataIterator(const string& filename) : m_sentence(0)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (ColumnarFile::Is(filename)) {
+    m_columnar.reset(new ColumnarFile(filename, ColumnarFile::SCORES));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
 ScoreDataIterator::~ScoreDataIterator() {}
 
+void ScoreDataIterator::readNextColumnar()
+{
+  if (m_sentence == m_columnar->NumSentences()) {
+    m_columnar.reset();
+    return;
+  }
+  const ColumnarFile& file = *m_columnar;
+  m_next.resize(file.NumHypotheses(m_sentence));
+  for (size_t h = 0; h < m_next.size(); ++h) {
+    const float* row = file.Row(m_sentence, h);
+    m_next[h].assign(row, row + file.NumColumns());
+  }
+  ++m_sentence;
+}
+
 void ScoreDataIterator::readNext()
 {
+  if (m_columnar) {
+    readNextColumnar();
+    return;
+  }
   m_next.clear();
   try {
     StringPiece marker = m_in->ReadDelimited();
@@ -82,6 +106,11 @@ void ScoreDataIterator::increment()
 
 bool ScoreDataIterator::equal(const ScoreDataIterator& rhs) const
 {
+  if (m_columnar || rhs.m_columnar) {
+    return m_columnar && rhs.m_columnar &&
+           m_columnar->FileName() == rhs.m_columnar->FileName() &&
+           m_sentence == rhs.m_sentence;
+  }
   if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
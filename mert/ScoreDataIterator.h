@@ -41,6 +41,7 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class ColumnarFile;
 
 typedef std::vector<float> ScoreDataItem;
 
@@ -68,7 +69,12 @@ private:
 
   void readNext();
 
+  void readNextColumnar();
+
   boost::shared_ptr<util::FilePiece> m_in;
+  // Used instead of m_in when the file is columnar.
+  boost::shared_ptr<ColumnarFile> m_columnar;
+  std::size_t m_sentence;
   std::vector<ScoreDataItem> m_next;
 };
 
@@ -37,6 +37,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <utility>
 
 #include <boost/program_options.hpp>
+#include <boost/unordered_set.hpp>
 
 #include "BleuScorer.h"
 #include "FeatureDataIterator.h"
@@ -184,8 +185,9 @@ int main(int argc, char** argv)
   size_t sentenceId = 0;
   while(1) {
     vector<pair<size_t,size_t> > hypotheses;
-    //TODO: de-deuping. Collect hashes of score,feature pairs and
-    //only add index if it's unique.
+    // Successive iterations mostly repeat each other's hypotheses, so only
+    // sample from the distinct (features, scores) pairs.
+    boost::unordered_set<pair<FeatureDataItem,ScoreDataItem> > seen;
     if (featureDataIters[0] == FeatureDataIterator::end()) {
       break;
     }
@@ -203,7 +205,10 @@ int main(int argc, char** argv)
         exit(1);
       }
       for (size_t j = 0; j < featureDataIters[i]->size(); ++j) {
-        hypotheses.push_back(pair<size_t,size_t>(i,j));
+        if (seen.insert(make_pair(featureDataIters[i]->operator[](j),
+                                  scoreDataIters[i]->operator[](j))).second) {
+          hypotheses.push_back(pair<size_t,size_t>(i,j));
+        }
       }
     }
 
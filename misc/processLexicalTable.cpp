@@ -4,6 +4,7 @@
 #include "moses/Timer.h"
 #include "moses/InputFileStream.h"
 #include "moses/FF/LexicalReordering/LexicalReorderingTable.h"
+#include "moses/FF/LexicalReordering/LexicalReorderingTableHash.h"
 
 using namespace Moses;
 
@@ -15,7 +16,8 @@ void printHelp()
             "options: \n"
             "\t-in  string -- input table file name\n"
             "\t-out string -- prefix of binary table files\n"
-            "If -in is not specified reads from stdin\n"
+            "\t-hash       -- write one memory-mapped hash table, out.hashlexr\n"
+            "If -in is not specified reads from stdin (not with -hash)\n"
             "\n";
 }
 
@@ -24,6 +26,7 @@ int main(int argc, char** argv)
   std::cerr << "processLexicalTable v0.1 by Konrad Rawlik\n";
   std::string inFilePath;
   std::string outFilePath("out");
+  bool hash = false;
   if(1 >= argc) {
     printHelp();
     return 1;
@@ -36,6 +39,8 @@ int main(int argc, char** argv)
     } else if("-out" == arg && i+1 < argc) {
       ++i;
       outFilePath = argv[i];
+    } else if("-hash" == arg) {
+      hash = true;
     } else {
       //somethings wrong... print help
       printHelp();
@@ -45,7 +50,15 @@ int main(int argc, char** argv)
 
   bool success = false;
 
-  if(inFilePath.empty()) {
+  if(hash) {
+    if(inFilePath.empty()) {
+      printHelp();
+      return 1;
+    }
+    std::cerr << "processing " << inFilePath<< " to " << outFilePath << ".hashlexr\n";
+    LexicalReorderingTableHash::Create(inFilePath, outFilePath);
+    success = true;
+  } else if(inFilePath.empty()) {
     std::cerr << "processing stdin to " << outFilePath << ".*\n";
     success = LexicalReorderingTableTree::Create(std::cin, outFilePath);
   } else {
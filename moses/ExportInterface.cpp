@@ -198,6 +198,15 @@ batch_run()
 
 #ifdef WITH_THREADS
   ThreadPool pool(staticData.ThreadCount());
+
+  // length-aware scheduling. IOWrapper still writes output in order
+  bool longestFirst = params.isParamSpecified("longest-first");
+  if (longestFirst) {
+    pool.SetCostModel(params.isParamSpecified("longest-first-model"));
+    size_t window;
+    params.SetParameter<size_t>(window, "longest-first-window", 0);
+    pool.SetQueueLimit(window);
+  }
 #endif
 
   // using context for adaptation:
@@ -281,10 +290,15 @@ batch_run()
         VERBOSE(1,"[" << HERE << " added trg] " << trg << endl);
         VERBOSE(1,"[" << HERE << " added aln] " << aln << endl);
       }
+    } else if (longestFirst) {
+      pool.Submit(task, source->GetSize());
     } else pool.Submit(task);
 #else
-    pool.Submit(task);
-
+    if (longestFirst) {
+      pool.Submit(task, source->GetSize());
+    } else {
+      pool.Submit(task);
+    }
 #endif
 #else
     task->Run();
@@ -298,6 +312,16 @@ batch_run()
 
 //  cerr << "g_numHypos=" << Moses::g_numHypos << endl;
 
+  IFVERBOSE(1) {
+    BOOST_FOREACH(PhraseDictionary const* pd, PhraseDictionary::GetColl()) {
+      CacheStats stats = pd->GetCacheStats();
+      if (stats.hits + stats.misses)
+        std::cerr << "Translation option cache of "
+                  << pd->GetScoreProducerDescription() << ": " << stats
+                  << std::endl;
+    }
+  }
+
   FeatureFunction::Destroy();
 
   IFVERBOSE(0) util::PrintUsage(std::cerr);
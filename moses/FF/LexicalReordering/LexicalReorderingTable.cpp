@@ -1,6 +1,7 @@
 // -*- c++ -*-
 
 #include "LexicalReorderingTable.h"
+#include "LexicalReorderingTableHash.h"
 #include "moses/InputFileStream.h"
 #include "moses/StaticData.h"
 #include "moses/TranslationModel/PhraseDictionary.h"
@@ -16,25 +17,10 @@
 namespace Moses
 {
 
-//cleans str of leading and tailing spaces
+//cleans str of leading and tailing whitespace
 std::string auxClearString(const std::string& str)
 {
-  int i = 0, j = str.size()-1;
-  while(i <= j) {
-    if(' ' != str[i]) {
-      break;
-    } else {
-      ++i;
-    }
-  }
-  while(j >= i) {
-    if(' ' != str[j]) {
-      break;
-    } else {
-      --j;
-    }
-  }
-  return str.substr(i,j-i+1);
+  return Trim(str);
 }
 
 void auxAppend(IPhrase& head, const IPhrase& tail)
@@ -52,7 +38,7 @@ LoadAvailable(const std::string& filePath,
               const FactorList& e_factors,
               const FactorList& c_factors)
 {
-  //decide use Compact or Tree or Memory table
+  //decide use Compact or Hash or Tree or Memory table
 #ifdef HAVE_CMPH
   LexicalReorderingTable *compactLexr = NULL;
   compactLexr = LexicalReorderingTableCompact::CheckAndLoad(filePath + ".minlexr", f_factors, e_factors, c_factors);
@@ -60,7 +46,10 @@ LoadAvailable(const std::string& filePath,
     return compactLexr;
 #endif
   LexicalReorderingTable* ret;
-  if (FileExists(filePath+".binlexr.idx") )
+  if (FileExists(filePath+".hashlexr"))
+    ret = new LexicalReorderingTableHash(filePath, f_factors,
+                                         e_factors, c_factors);
+  else if (FileExists(filePath+".binlexr.idx") )
     ret = new LexicalReorderingTableTree(filePath, f_factors,
                                          e_factors, c_factors);
   else
@@ -0,0 +1,316 @@
+// -*- c++ -*-
+
+#include <cstdlib>
+#include <cstring>
+
+#include "LexicalReorderingTableHash.h"
+#include "moses/Util.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/file_piece.hh"
+#include "util/murmur_hash.hh"
+#include "util/tokenize_piece.hh"
+
+namespace Moses
+{
+
+namespace
+{
+
+const char kMagic[8] = {'m', 'o', 's', 'e', 's', 'L', 'R', 'H'};
+// Bumped on format changes; also catches tables built with other byte order.
+const uint32_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t numScores;
+  uint32_t keyFields;
+  uint32_t reserved;
+  uint64_t entries;
+  uint64_t tableBytes;
+};
+
+// header, codebook (float[numScores][256]), hash table, codes
+uint64_t TableOffset(std::size_t numScores)
+{
+  return sizeof(Header) + numScores * LexicalReorderingTableHash::CodebookSize * sizeof(float);
+}
+
+// strips the characters auxClearString does
+StringPiece TrimWhitespace(StringPiece str)
+{
+  const char* const kWhitespace = " \t\n\r";
+  while (!str.empty() && std::strchr(kWhitespace, str.data()[0])) str.remove_prefix(1);
+  while (!str.empty() && std::strchr(kWhitespace, str.data()[str.size() - 1])) str.remove_suffix(1);
+  return str;
+}
+
+// Same key as LexicalReorderingTableMemory::MakeKey, hashed.
+uint64_t HashKey(const StringPiece& f, const StringPiece& e, const StringPiece& c,
+                 bool hasE, bool hasC)
+{
+  std::string key(f.data(), f.size());
+  if (hasE) {
+    if (!key.empty()) key += "|||";
+    key.append(e.data(), e.size());
+  }
+  if (hasC) {
+    if (!key.empty()) key += "|||";
+    key.append(c.data(), c.size());
+  }
+  uint64_t hash = util::MurmurHash64A(key.data(), key.size());
+  // 0 marks empty buckets
+  return hash ? hash : 1;
+}
+
+void SplitLine(const StringPiece& line, std::vector<StringPiece>& fields)
+{
+  fields.clear();
+  for (util::TokenIter<util::MultiCharacter> it(line, util::MultiCharacter("|||")); it; ++it) {
+    fields.push_back(TrimWhitespace(*it));
+  }
+}
+
+void ParseScores(const StringPiece& field, std::vector<float>& scores)
+{
+  scores.clear();
+  char buf[64];
+  for (util::TokenIter<util::AnyCharacter, true> it(field, " \t"); it; ++it) {
+    UTIL_THROW_IF2(it->size() >= sizeof(buf), "Score too long: " << *it);
+    std::memcpy(buf, it->data(), it->size());
+    buf[it->size()] = 0;
+    scores.push_back(FloorScore(TransformScore(std::strtod(buf, NULL))));
+  }
+}
+
+// Histogram over the float order: the top 16 bits of a float, with the sign
+// folded so that bins sort like the values.  Resolution is relative, which
+// suits log probabilities.
+const std::size_t kBins = 1 << 16;
+
+std::size_t Bin(float value)
+{
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  bits = (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+  return bits >> 16;
+}
+
+struct Histogram {
+  Histogram() : count(kBins, 0), sum(kBins, 0.0) {}
+  std::vector<uint64_t> count;
+  std::vector<double> sum;
+};
+
+// Split the histogram into CodebookSize groups of about equal mass; the
+// group mean is its code's value.  Fills binToCode and codebook.
+void MakeCodebook(const Histogram& hist, std::vector<uint8_t>& binToCode, float* codebook)
+{
+  const std::size_t codes = LexicalReorderingTableHash::CodebookSize;
+  uint64_t left = 0;
+  std::size_t used = 0;
+  for (std::size_t b = 0; b < kBins; ++b) {
+    left += hist.count[b];
+    if (hist.count[b]) ++used;
+  }
+  binToCode.resize(kBins);
+  std::size_t code = 0;
+  uint64_t inGroup = 0;
+  double sum = 0;
+  for (std::size_t b = 0; b < kBins; ++b) {
+    if (!hist.count[b]) {
+      binToCode[b] = code;
+      continue;
+    }
+    bool full = (used <= codes) || (inGroup + hist.count[b] > left / (codes - code));
+    if (inGroup && full && code + 1 < codes) {
+      codebook[code] = sum / inGroup;
+      left -= inGroup;
+      ++code;
+      inGroup = 0;
+      sum = 0;
+    }
+    inGroup += hist.count[b];
+    sum += hist.sum[b];
+    binToCode[b] = code;
+  }
+  codebook[code] = inGroup ? sum / inGroup : 0;
+  for (++code; code < codes; ++code) codebook[code] = codebook[code - 1];
+}
+
+}
+
+void
+LexicalReorderingTableHash::
+Create(const std::string& inFileName, const std::string& outFileName)
+{
+  std::vector<StringPiece> fields;
+  std::vector<float> scores;
+
+  // Pass 1: shape of the table and score histograms for the codebooks.
+  std::size_t numFields = 0, numScores = 0;
+  uint64_t lines = 0;
+  std::vector<Histogram> hists;
+  {
+    util::FilePiece in(inFileName.c_str(), &std::cerr);
+    for (StringPiece line; in.ReadLineOrEOF(line); ++lines) {
+      SplitLine(line, fields);
+      ParseScores(fields.back(), scores);
+      if (lines == 0) {
+        numFields = fields.size();
+        numScores = scores.size();
+        UTIL_THROW_IF2(numFields < 2 || numFields > 4,
+                       "Expected 'f [||| e [||| c]] ||| scores' in " << inFileName);
+        hists.resize(numScores);
+      }
+      UTIL_THROW_IF2(fields.size() != numFields || scores.size() != numScores,
+                     "Line " << (lines + 1) << " of " << inFileName
+                     << " does not have the same shape as the first line");
+      for (std::size_t i = 0; i < numScores; ++i) {
+        const std::size_t bin = Bin(scores[i]);
+        ++hists[i].count[bin];
+        hists[i].sum[bin] += scores[i];
+      }
+    }
+  }
+  UTIL_THROW_IF2(lines == 0, "Empty reordering table " << inFileName);
+  UTIL_THROW_IF2(lines >> 32, "Too many phrase pairs in " << inFileName);
+
+  const std::size_t keyFields = numFields - 1;
+  const uint64_t tableBytes = Table::Size(lines, 1.5);
+  const uint64_t tableOffset = TableOffset(numScores);
+  const uint64_t codesOffset = tableOffset + tableBytes;
+
+  const std::string fileName = outFileName + ".hashlexr";
+  util::scoped_fd file;
+  util::scoped_memory mem(
+    util::MapZeroedWrite(fileName.c_str(), codesOffset + lines * numScores, file),
+    codesOffset + lines * numScores, util::scoped_memory::MMAP_ALLOCATED);
+  char* base = static_cast<char*>(mem.get());
+
+  float* codebook = reinterpret_cast<float*>(base + sizeof(Header));
+  std::vector<std::vector<uint8_t> > binToCode(numScores);
+  for (std::size_t i = 0; i < numScores; ++i) {
+    MakeCodebook(hists[i], binToCode[i], codebook + i * CodebookSize);
+  }
+  hists.clear();
+
+  // Pass 2: hash the keys and store the score codes.  A repeated key
+  // overwrites the earlier scores, as in LexicalReorderingTableMemory.
+  Table table(base + tableOffset, tableBytes);
+  uint8_t* codes = reinterpret_cast<uint8_t*>(base + codesOffset);
+  uint32_t entries = 0;
+  {
+    util::FilePiece in(inFileName.c_str());
+    for (StringPiece line; in.ReadLineOrEOF(line);) {
+      SplitLine(line, fields);
+      ParseScores(fields.back(), scores);
+      Entry entry;
+      entry.key = HashKey(fields[0], keyFields > 1 ? fields[1] : StringPiece(),
+                          keyFields > 2 ? fields[2] : StringPiece(),
+                          keyFields > 1, keyFields > 2);
+      entry.index = entries;
+      Table::MutableIterator it;
+      if (!table.FindOrInsert(entry, it)) ++entries;
+      uint8_t* out = codes + static_cast<uint64_t>(it->index) * numScores;
+      for (std::size_t i = 0; i < numScores; ++i) {
+        out[i] = binToCode[i][Bin(scores[i])];
+      }
+    }
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.numScores = numScores;
+  header.keyFields = keyFields;
+  header.entries = entries;
+  header.tableBytes = tableBytes;
+  std::memcpy(base, &header, sizeof(Header));
+
+  mem.reset();
+  util::ResizeOrThrow(file.get(), codesOffset + static_cast<uint64_t>(entries) * numScores);
+  std::cerr << "Stored " << entries << " phrase pairs with " << numScores
+            << " scores in " << fileName << "\n";
+}
+
+LexicalReorderingTableHash::
+LexicalReorderingTableHash(const std::string& filePath,
+                           const std::vector<FactorType>& f_factors,
+                           const std::vector<FactorType>& e_factors,
+                           const std::vector<FactorType>& c_factors)
+  : LexicalReorderingTable(f_factors, e_factors, c_factors)
+{
+  const std::string fileName = filePath + ".hashlexr";
+  util::scoped_fd file(util::OpenReadOrThrow(fileName.c_str()));
+  const uint64_t size = util::SizeOrThrow(file.get());
+  UTIL_THROW_IF2(size < sizeof(Header), fileName << " is too short");
+  util::MapRead(util::LAZY, file.get(), 0, size, m_mem);
+
+  Header header;
+  std::memcpy(&header, m_mem.begin(), sizeof(Header));
+  UTIL_THROW_IF2(std::memcmp(header.magic, kMagic, sizeof(kMagic)),
+                 fileName << " is not a hashed reordering table");
+  UTIL_THROW_IF2(header.version != kVersion,
+                 fileName << " has version " << header.version << ", expected "
+                 << kVersion << "; rebuild it with processLexicalTable -hash");
+  const std::size_t keyFields = !m_FactorsF.empty() + !m_FactorsE.empty() + !m_FactorsC.empty();
+  UTIL_THROW_IF2(header.keyFields != keyFields,
+                 fileName << " is keyed on " << header.keyFields
+                 << " phrases but the feature is configured for " << keyFields);
+  m_numScores = header.numScores;
+  const uint64_t tableOffset = TableOffset(m_numScores);
+  UTIL_THROW_IF2(size != tableOffset + header.tableBytes + header.entries * m_numScores,
+                 fileName << " is truncated");
+
+  char* base = const_cast<char*>(m_mem.begin());
+  m_codebook = reinterpret_cast<const float*>(base + sizeof(Header));
+  m_table = Table(base + tableOffset, header.tableBytes);
+  m_codes = reinterpret_cast<const uint8_t*>(base + tableOffset + header.tableBytes);
+}
+
+uint64_t
+LexicalReorderingTableHash::
+MakeKey(const Phrase& f, const Phrase& e, const Phrase& c) const
+{
+  const std::string fs = f.GetStringRep(m_FactorsF);
+  const std::string es = e.GetStringRep(m_FactorsE);
+  const std::string cs = c.GetStringRep(m_FactorsC);
+  return HashKey(TrimWhitespace(fs), TrimWhitespace(es), TrimWhitespace(cs),
+                 !m_FactorsE.empty(), !m_FactorsC.empty());
+}
+
+bool
+LexicalReorderingTableHash::
+Lookup(uint64_t key, Scores& scores) const
+{
+  Table::ConstIterator it;
+  if (!m_table.Find(key, it)) return false;
+  const uint8_t* codes = m_codes + static_cast<uint64_t>(it->index) * m_numScores;
+  scores.resize(m_numScores);
+  for (std::size_t i = 0; i < m_numScores; ++i) {
+    scores[i] = m_codebook[i * CodebookSize + codes[i]];
+  }
+  return true;
+}
+
+Scores
+LexicalReorderingTableHash::
+GetScore(const Phrase& f, const Phrase& e, const Phrase& c)
+{
+  Scores scores;
+  if (0 == c.GetSize()) {
+    Lookup(MakeKey(f, e, c), scores);
+    return scores;
+  }
+  // try from larger to smaller context, as the other tables do
+  for (size_t i = 0; i <= c.GetSize(); ++i) {
+    Phrase sub_c(c.GetSubString(Range(i, c.GetSize() - 1)));
+    if (Lookup(MakeKey(f, e, sub_c), scores)) return scores;
+  }
+  return scores;
+}
+
+}
@@ -0,0 +1,75 @@
+// -*- c++ -*-
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "util/mmap.hh"
+#include "util/probing_hash_table.hh"
+
+#include "LexicalReorderingTable.h"
+
+namespace Moses
+{
+
+//! Lexical reordering table in one binary file (<path>.hashlexr) that is
+//! memory mapped rather than parsed.  Phrase pairs are looked up through a
+//! probing hash table of 64 bit key hashes; each pair has one byte per
+//! score, decoded through a per-score codebook of 256 values.  Lookups only
+//! read the mapping, so all threads share the table without caches.
+class LexicalReorderingTableHash
+  : public LexicalReorderingTable
+{
+public:
+#pragma pack(push)
+#pragma pack(4)
+  struct Entry {
+    typedef uint64_t Key;
+    uint64_t key;
+    uint32_t index; // into the score codes
+
+    Key GetKey() const {
+      return key;
+    }
+    void SetKey(Key to) {
+      key = to;
+    }
+  };
+#pragma pack(pop)
+
+  typedef util::ProbingHashTable<Entry, util::IdentityHash> Table;
+
+  static const std::size_t CodebookSize = 256;
+
+  //! build <outFileName>.hashlexr from a text table; reads the input twice
+  static
+  void
+  Create(const std::string& inFileName, const std::string& outFileName);
+
+  LexicalReorderingTableHash(const std::string& filePath,
+                             const std::vector<FactorType>& f_factors,
+                             const std::vector<FactorType>& e_factors,
+                             const std::vector<FactorType>& c_factors);
+
+  virtual
+  std::vector<float>
+  GetScore(const Phrase& f, const Phrase& e, const Phrase& c);
+
+private:
+  uint64_t
+  MakeKey(const Phrase& f, const Phrase& e, const Phrase& c) const;
+
+  bool
+  Lookup(uint64_t key, Scores& scores) const;
+
+  util::scoped_memory m_mem;
+  Table m_table;
+  std::size_t m_numScores;
+  const float* m_codebook;
+  const uint8_t* m_codes;
+};
+
+}
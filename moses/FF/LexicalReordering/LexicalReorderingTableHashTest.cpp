@@ -0,0 +1,145 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2013- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "LexicalReorderingTable.h"
+#include "LexicalReorderingTableHash.h"
+#include "moses/Phrase.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+namespace fs = boost::filesystem;
+
+struct TempDir {
+  TempDir() : path(fs::temp_directory_path() / fs::unique_path("hashlexr-%%%%-%%%%")) {
+    fs::create_directories(path);
+  }
+  ~TempDir() {
+    fs::remove_all(path);
+  }
+  fs::path path;
+};
+
+Phrase MakePhrase(const string& str)
+{
+  Phrase phrase;
+  phrase.CreateFromString(Input, vector<FactorType>(1, 0), str, NULL);
+  return phrase;
+}
+
+// Both tables, built from the same text table
+struct Tables {
+  Tables(const string& text, bool context) {
+    const string path = (dir.path / "reordering-table").string();
+    ofstream(path.c_str()) << text;
+    LexicalReorderingTableHash::Create(path, path);
+    vector<FactorType> factors(1, 0), cFactors(context ? 1 : 0, 0);
+    memory.reset(new LexicalReorderingTableMemory(path, factors, factors, cFactors));
+    hash.reset(new LexicalReorderingTableHash(path, factors, factors, cFactors));
+  }
+  TempDir dir;
+  boost::scoped_ptr<LexicalReorderingTable> memory, hash;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(hashlexr)
+
+// With fewer distinct scores than codes, every score has a code of its own
+// and the tables agree exactly.
+BOOST_AUTO_TEST_CASE(exact)
+{
+  Tables t("a b ||| x ||| c d ||| 0.1 0.2 0.3 0.4 0.5 0.6\n"
+           "a b ||| x ||| d ||| 0.6 0.5 0.4 0.3 0.2 0.1\n"
+           "a b\t|||\tx ||| \t||| 0.9\t0.8 0.7 0.6 0.5 0.4\n"
+           "a ||| y z ||| c ||| 0.25 0.125 0.25 0.125 0.25 0.125\n", true);
+
+  const char* const lookups[][3] = {
+    {"a b", "x", "c d"},
+    {"a b", "x", "e c d"}, // backs off to "c d"
+    {"a b", "x", "e d"},   // backs off to "d"
+    {"a b", "x", "e"},     // backs off to no context
+    {"a", "y z", "d c"},
+    {"a", "y", "c"},
+  };
+  const size_t found[] = { 1, 1, 1, 1, 1, 0 };
+  for (size_t i = 0; i < sizeof(found) / sizeof(found[0]); ++i) {
+    const Phrase f = MakePhrase(lookups[i][0]);
+    const Phrase e = MakePhrase(lookups[i][1]);
+    const Phrase c = MakePhrase(lookups[i][2]);
+    const Scores want = t.memory->GetScore(f, e, c);
+    const Scores got = t.hash->GetScore(f, e, c);
+    BOOST_CHECK_EQUAL(found[i] * 6, want.size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(want.begin(), want.end(), got.begin(), got.end());
+  }
+}
+
+// Many distinct scores share 256 codes per score.  Scores are spread
+// evenly over [-5, 0] in the log domain, so a code's group of equal mass is
+// about 5 / 256 wide; the histogram the groups are cut from resolves 7
+// bits of mantissa, under 0.04 at this range.
+BOOST_AUTO_TEST_CASE(quantized)
+{
+  const size_t numPairs = 5000;
+  ostringstream text;
+  unsigned x = 12345;
+  for (size_t i = 0; i < numPairs; ++i) {
+    text << "f" << i << " g" << i % 7 << " ||| e" << i % 13 << " |||";
+    for (size_t j = 0; j < 6; ++j) {
+      x = x * 1103515245 + 12345;
+      text << " " << exp(-5.0 * ((x >> 8) & 0xffff) / 0x10000);
+    }
+    text << "\n";
+  }
+  Tables t(text.str(), false);
+
+  const Phrase none;
+  double maxError = 0, sumError = 0;
+  for (size_t i = 0; i < numPairs; ++i) {
+    ostringstream f, e;
+    f << "f" << i << " g" << i % 7;
+    e << "e" << i % 13;
+    const Scores want = t.memory->GetScore(MakePhrase(f.str()), MakePhrase(e.str()), none);
+    const Scores got = t.hash->GetScore(MakePhrase(f.str()), MakePhrase(e.str()), none);
+    BOOST_REQUIRE_EQUAL(6, want.size());
+    BOOST_REQUIRE_EQUAL(6, got.size());
+    for (size_t j = 0; j < 6; ++j) {
+      const double error = fabs(want[j] - got[j]);
+      maxError = max(maxError, error);
+      sumError += error;
+    }
+  }
+  BOOST_CHECK_LT(maxError, 0.05);
+  BOOST_CHECK_LT(sumError / (numPairs * 6), 0.01);
+
+  BOOST_CHECK(t.hash->GetScore(MakePhrase("f1 g2"), MakePhrase("e1"), none).empty());
+  BOOST_CHECK(t.hash->GetScore(MakePhrase("f1"), MakePhrase("e1"), none).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
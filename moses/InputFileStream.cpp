@@ -21,6 +21,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "InputFileStream.h"
 #include "gzfilebuf.h"
+#include "util/file.hh"
+#include "util/write_compressed.hh"
 #include <iostream>
 
 using namespace std;
@@ -34,6 +36,9 @@ InputFileStream::InputFileStream(const std::string &filePath)
   if (filePath.size() > 3 &&
       filePath.substr(filePath.size() - 3, 3) == ".gz") {
     m_streambuf = new gzfilebuf(filePath.c_str());
+  } else if (util::CompressionFromExtension(filePath) != util::UNCOMPRESSED) {
+    // zstd or lz4
+    m_streambuf = new util::ReadCompressedBuf(util::OpenReadOrThrow(filePath.c_str()));
   } else {
     std::filebuf* fb = new std::filebuf();
     fb = fb->open(filePath.c_str(), std::ios::in);
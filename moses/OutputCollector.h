@@ -34,6 +34,7 @@
 #include <ostream>
 #include <fstream>
 #include <string>
+#include "OutputFileStream.h"
 #include "Util.h"
 #include "util/exception.hh"
 namespace Moses
@@ -54,16 +55,16 @@ public:
 
   OutputCollector(std::string xout, std::string xerr = "")
     : m_nextOutput(0) {
-    // TO DO open magic streams instead of regular ofstreams! [UG]
-
     if (xout == "/dev/stderr") {
       m_outStream = &std::cerr;
       m_isHoldingOutputStream = false;
     } else if (xout.size() && xout != "/dev/stdout" && xout != "-") {
-      m_outStream = new std::ofstream(xout.c_str());
-      UTIL_THROW_IF2(!m_outStream->good(), "Failed to open output file"
-                     << xout);
+      // compressed if the name ends in .gz, .zst or .lz4
+      OutputFileStream *out = new OutputFileStream;
+      m_outStream = out;
       m_isHoldingOutputStream = true;
+      UTIL_THROW_IF2(!out->Open(xout), "Failed to open output file"
+                     << xout);
     } else {
       m_outStream = &std::cout;
       m_isHoldingOutputStream = false;
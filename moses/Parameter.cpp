@@ -109,6 +109,9 @@ Parameter::Parameter()
   AddParam(search_opts,"disable-discarding", "dd", "disable hypothesis discarding"); // ??? memory management? UG
   AddParam(search_opts,"phrase-drop-allowed", "da", "if present, allow dropping of source words"); //da = drop any (word); see -du for comparison
   AddParam(search_opts,"threads","th", "number of threads to use in decoding (defaults to single-threaded)");
+  AddParam(search_opts,"longest-first", "multi-threaded decoding: translate queued sentences longest first. Output order is unchanged");
+  AddParam(search_opts,"longest-first-model", "with longest-first, order by decoding time per sentence length, learnt while decoding");
+  AddParam(search_opts,"longest-first-window", "with longest-first, number of sentences read ahead and queued (default 0 = unlimited)");
 
   // distortion options
   po::options_description disto_opts("Distortion options");
@@ -0,0 +1,104 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "TranslationModel/ShardedClockCache.h"
+
+using namespace Moses;
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(sharded_clock_cache)
+
+typedef ShardedClockCache<size_t, string> Cache;
+
+BOOST_AUTO_TEST_CASE(find_insert)
+{
+  Cache cache(1000, 4);
+  string value;
+  BOOST_CHECK(!cache.Find(1, value));
+
+  cache.Insert(1, "one", 10);
+  BOOST_CHECK(cache.Find(1, value));
+  BOOST_CHECK_EQUAL("one", value);
+
+  // first insertion wins
+  cache.Insert(1, "uno", 10);
+  BOOST_CHECK(cache.Find(1, value));
+  BOOST_CHECK_EQUAL("one", value);
+
+  CacheStats stats = cache.GetStats();
+  BOOST_CHECK_EQUAL(2, stats.hits);
+  BOOST_CHECK_EQUAL(1, stats.misses);
+  BOOST_CHECK_EQUAL(1, stats.insertions);
+  BOOST_CHECK_EQUAL(1, stats.entries);
+  BOOST_CHECK_EQUAL(10, stats.bytes);
+}
+
+BOOST_AUTO_TEST_CASE(byte_bound)
+{
+  // one shard, room for 3 entries
+  Cache cache(30, 1);
+  for (size_t i = 0; i < 100; ++i) {
+    cache.Insert(i, "x", 10);
+  }
+  CacheStats stats = cache.GetStats();
+  BOOST_CHECK_EQUAL(100, stats.insertions);
+  BOOST_CHECK_EQUAL(97, stats.evictions);
+  BOOST_CHECK_EQUAL(3, stats.entries);
+  BOOST_CHECK_EQUAL(30, stats.bytes);
+}
+
+BOOST_AUTO_TEST_CASE(second_chance)
+{
+  Cache cache(30, 1);
+  string value;
+  cache.Insert(1, "a", 10);
+  cache.Insert(2, "b", 10);
+  cache.Insert(3, "c", 10);
+
+  // clears all referenced bits, evicts 1
+  cache.Insert(4, "d", 10);
+  BOOST_CHECK(!cache.Find(1, value));
+
+  // 2 was used since, so 3 or 4 goes next
+  BOOST_CHECK(cache.Find(2, value));
+  cache.Insert(5, "e", 10);
+  BOOST_CHECK(cache.Find(2, value));
+  BOOST_CHECK(cache.Find(5, value));
+  BOOST_CHECK_EQUAL(3, cache.GetStats().entries);
+}
+
+BOOST_AUTO_TEST_CASE(clear)
+{
+  Cache cache(1000, 4);
+  string value;
+  for (size_t i = 0; i < 10; ++i) {
+    cache.Insert(i, "x", 10);
+  }
+  cache.Clear();
+  BOOST_CHECK(!cache.Find(5, value));
+  BOOST_CHECK_EQUAL(0, cache.GetStats().bytes);
+  BOOST_CHECK_EQUAL(0, cache.GetStats().entries);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
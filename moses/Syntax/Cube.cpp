@@ -13,8 +13,9 @@ namespace Moses
 namespace Syntax
 {
 
-Cube::Cube(const SHyperedgeBundle &bundle)
+Cube::Cube(const SHyperedgeBundle &bundle, SArena &arena)
   : m_bundle(bundle)
+  , m_arena(arena)
 {
   // Create the SHyperedge for the 'corner' of the cube.
   std::vector<int> coordinates(bundle.stacks.size()+1, 0);
@@ -29,14 +30,14 @@ Cube::Cube(const SHyperedgeBundle &bundle)
 
 Cube::~Cube()
 {
-  // Delete the SHyperedges belonging to any unpopped items.  Note that the
-  // coordinate vectors are not deleted here since they are owned by m_visited
-  // (and so will be deleted by its destructor).
+  // Return the SHyperedges belonging to any unpopped items (and their heads)
+  // to the arena.  Note that the coordinate vectors are not deleted here since
+  // they are owned by m_visited (and so will be deleted by its destructor).
   while (!m_queue.empty()) {
     QueueItem item = m_queue.top();
     m_queue.pop();
-    // Delete hyperedge and its head (head deletes hyperedge).
-    delete item.first->head;  // TODO shared ownership of head vertex?
+    m_arena.FreeVertex(item.first->head);
+    m_arena.FreeHyperedge(item.first);
   }
 }
 
@@ -88,9 +89,9 @@ void Cube::CreateNeighbour(const std::vector<int> &coordinates)
 
 SHyperedge *Cube::CreateHyperedge(const std::vector<int> &coordinates)
 {
-  SHyperedge *hyperedge = new SHyperedge();
+  SHyperedge *hyperedge = m_arena.NewHyperedge();
 
-  SVertex *head = new SVertex();
+  SVertex *head = m_arena.NewVertex();
   head->best = hyperedge;
   head->pvertex = 0;  // FIXME???
   head->states.resize(
@@ -99,8 +100,7 @@ SHyperedge *Cube::CreateHyperedge(const std::vector<int> &coordinates)
 
   hyperedge->tail.resize(coordinates.size()-1);
   for (std::size_t i = 0; i < coordinates.size()-1; ++i) {
-    boost::shared_ptr<SVertex> pred = (*m_bundle.stacks[i])[coordinates[i]];
-    hyperedge->tail[i] = pred.get();
+    hyperedge->tail[i] = (*m_bundle.stacks[i])[coordinates[i]];
   }
 
   hyperedge->label.inputWeight = m_bundle.inputWeight;
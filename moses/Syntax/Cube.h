@@ -6,6 +6,7 @@
 
 #include <boost/unordered_set.hpp>
 
+#include "SArena.h"
 #include "SHyperedge.h"
 #include "SHyperedgeBundle.h"
 
@@ -20,7 +21,7 @@ namespace Syntax
 class Cube
 {
 public:
-  Cube(const SHyperedgeBundle &);
+  Cube(const SHyperedgeBundle &, SArena &);
   ~Cube();
 
   SHyperedge *Pop();
@@ -54,6 +55,7 @@ private:
   void CreateNeighbours(const std::vector<int> &);
 
   const SHyperedgeBundle &m_bundle;
+  SArena &m_arena;
   CoordinateSet m_visited;
   Queue m_queue;
 };
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Cube.h"
+#include "SArena.h"
 #include "SHyperedge.h"
 #include "SHyperedgeBundle.h"
 
@@ -16,7 +17,7 @@ class CubeQueue
 {
 public:
   template<typename InputIterator>
-  CubeQueue(InputIterator, InputIterator);
+  CubeQueue(InputIterator, InputIterator, SArena &);
 
   ~CubeQueue();
 
@@ -41,10 +42,10 @@ private:
 };
 
 template<typename InputIterator>
-CubeQueue::CubeQueue(InputIterator first, InputIterator last)
+CubeQueue::CubeQueue(InputIterator first, InputIterator last, SArena &arena)
 {
   while (first != last) {
-    m_queue.push(new Cube(*first++));
+    m_queue.push(new Cube(*first++, arena));
   }
 }
 
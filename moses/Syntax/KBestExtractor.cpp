@@ -3,8 +3,6 @@
 #include "moses/ScoreComponentCollection.h"
 #include "moses/StaticData.h"
 
-#include <boost/scoped_ptr.hpp>
-
 #include <vector>
 
 namespace Moses
@@ -14,7 +12,7 @@ namespace Syntax
 
 // Extract the k-best list from the search graph.
 void KBestExtractor::Extract(
-  const std::vector<boost::shared_ptr<SVertex> > &topLevelVertices,
+  const SVertexStack &topLevelVertices,
   std::size_t k, KBestVec &kBestList)
 {
   kBestList.clear();
@@ -23,19 +21,20 @@ void KBestExtractor::Extract(
   }
 
   // Create a new SVertex, supremeVertex, that has the best top-level SVertex as
-  // its predecessor and has the same score.
-  std::vector<boost::shared_ptr<SVertex> >::const_iterator p =
-    topLevelVertices.begin();
+  // its predecessor and has the same score.  Its incoming hyperedges are kept
+  // in edges, which is sized up front so that pointers into it stay valid.
+  SVertexStack::const_iterator p = topLevelVertices.begin();
   SVertex &bestTopLevelVertex = **p;
-  boost::scoped_ptr<SVertex> supremeVertex(new SVertex());
-  supremeVertex->pvertex = 0;
-  supremeVertex->best = new SHyperedge();
-  supremeVertex->best->head = supremeVertex.get();
-  supremeVertex->best->tail.push_back(&bestTopLevelVertex);
-  supremeVertex->best->label.futureScore =
+  std::vector<SHyperedge> edges(topLevelVertices.size());
+  SVertex supremeVertex;
+  supremeVertex.pvertex = 0;
+  supremeVertex.best = &edges[0];
+  supremeVertex.best->head = &supremeVertex;
+  supremeVertex.best->tail.push_back(&bestTopLevelVertex);
+  supremeVertex.best->label.futureScore =
     bestTopLevelVertex.best->label.futureScore;
-  supremeVertex->best->label.deltas = bestTopLevelVertex.best->label.deltas;
-  supremeVertex->best->label.translation = 0;
+  supremeVertex.best->label.deltas = bestTopLevelVertex.best->label.deltas;
+  supremeVertex.best->label.translation = 0;
 
   // For each alternative top-level SVertex, add a new incoming hyperedge to
   // supremeVertex.
@@ -44,19 +43,17 @@ void KBestExtractor::Extract(
     UTIL_THROW_IF2((*p)->best->label.futureScore >
                    bestTopLevelVertex.best->label.futureScore,
                    "top-level SVertices are not correctly sorted");
-    // Note: there's no need for a smart pointer here: supremeVertex will take
-    // ownership of altEdge.
-    SHyperedge *altEdge = new SHyperedge();
-    altEdge->head = supremeVertex.get();
-    altEdge->tail.push_back((*p).get());
+    SHyperedge *altEdge = &edges[p - topLevelVertices.begin()];
+    altEdge->head = &supremeVertex;
+    altEdge->tail.push_back(*p);
     altEdge->label.futureScore = (*p)->best->label.futureScore;
     altEdge->label.deltas = (*p)->best->label.deltas;
     altEdge->label.translation = 0;
-    supremeVertex->recombined.push_back(altEdge);
+    supremeVertex.recombined.push_back(altEdge);
   }
 
   // Create the target vertex then lazily fill its k-best list.
-  boost::shared_ptr<KVertex> targetVertex = FindOrCreateVertex(*supremeVertex);
+  boost::shared_ptr<KVertex> targetVertex = FindOrCreateVertex(supremeVertex);
   LazyKthBest(targetVertex, k, k);
 
   // Copy the k-best list from the target vertex, but drop the top edge from
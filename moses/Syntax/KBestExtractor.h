@@ -14,6 +14,7 @@
 
 #include "SHyperedge.h"
 #include "SVertex.h"
+#include "SVertexStack.h"
 
 namespace Moses
 {
@@ -76,8 +77,7 @@ public:
 
   // Extract the k-best list from the search hypergraph given the full, sorted
   // list of top-level SVertices.
-  void Extract(const std::vector<boost::shared_ptr<SVertex> > &, std::size_t,
-               KBestVec &);
+  void Extract(const SVertexStack &, std::size_t, KBestVec &);
 
   static Phrase GetOutputPhrase(const Derivation &);
   static TreePointer GetOutputTree(const Derivation &);
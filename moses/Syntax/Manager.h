@@ -5,6 +5,7 @@
 #include "moses/BaseManager.h"
 
 #include "KBestExtractor.h"
+#include "SArena.h"
 
 namespace Moses
 {
@@ -53,6 +54,9 @@ public:
 protected:
   boost::unordered_set<Word> m_oovs;
 
+  // Owns the SVertex and SHyperedge objects created while decoding.
+  SArena m_arena;
+
 private:
   // Syntax-specific helper functions used to implement OutputNBest.
   void OutputNBestList(OutputCollector *collector,
@@ -50,7 +50,7 @@ void Manager<Parser>::InitializeCharts()
     PVertex &pvertex = m_pchart.AddVertex(tmp);
 
     // SVertex
-    boost::shared_ptr<SVertex> v(new SVertex());
+    SVertex *v = m_arena.NewVertex();
     v->best = 0;
     v->pvertex = &pvertex;
     SChart::Cell &scell = m_schart.GetCell(i,i);
@@ -200,7 +200,7 @@ void Manager<Parser>::Decode()
 
       // Use cube pruning to extract SHyperedges from SHyperedgeBundles.
       // Collect the SHyperedges into buffers, one for each category.
-      CubeQueue cubeQueue(bundles.Begin(), bundles.End());
+      CubeQueue cubeQueue(bundles.Begin(), bundles.End(), m_arena);
       std::size_t count = 0;
       typedef boost::unordered_map<Word, std::vector<SHyperedge*>,
               SymbolHasher, SymbolEqualityPred > BufferMap;
@@ -238,9 +238,7 @@ void Manager<Parser>::Decode()
         for (SChart::Cell::NMap::Iterator p = scell.nonTerminalStacks.Begin();
              p != scell.nonTerminalStacks.End(); ++p) {
           SVertexStack &stack = p->second;
-          if (stack.size() > stackLimit) {
-            stack.resize(stackLimit);
-          }
+          m_arena.PruneStack(stack, stackLimit);
         }
       }
 
@@ -261,7 +259,7 @@ const SHyperedge *Manager<Parser>::GetBestSHyperedge() const
     return 0;
   }
   assert(stacks.Size() == 1);
-  const std::vector<boost::shared_ptr<SVertex> > &stack = stacks.Begin()->second;
+  const SVertexStack &stack = stacks.Begin()->second;
   // TODO Throw exception if stack is empty?  Or return 0?
   return stack[0]->best;
 }
@@ -284,7 +282,7 @@ void Manager<Parser>::ExtractKBest(
     return;
   }
   assert(stacks.Size() == 1);
-  const std::vector<boost::shared_ptr<SVertex> > &stack = stacks.Begin()->second;
+  const SVertexStack &stack = stacks.Begin()->second;
   // TODO Throw exception if stack is empty?  Or return 0?
 
   KBestExtractor extractor;
@@ -346,7 +344,7 @@ void Manager<Parser>::RecombineAndSort(const std::vector<SHyperedge*> &buffer,
   // Step 1: Create a map containing a single instance of each distinct vertex
   // (where distinctness is defined by the state value).  The hyperedges'
   // head pointers are updated to point to the vertex instances in the map and
-  // any 'duplicate' vertices are deleted.
+  // any 'duplicate' vertices are returned to the arena.
 // TODO Set?
   typedef boost::unordered_map<SVertex *, SVertex *,
           SVertexRecombinationHasher,
@@ -373,8 +371,7 @@ void Manager<Parser>::RecombineAndSort(const std::vector<SHyperedge*> &buffer,
     } else {
       storedVertex->recombined.push_back(h);
     }
-    h->head->best = 0;
-    delete h->head;
+    m_arena.FreeVertex(h->head);
     h->head = storedVertex;
   }
 
@@ -382,7 +379,7 @@ void Manager<Parser>::RecombineAndSort(const std::vector<SHyperedge*> &buffer,
   stack.clear();
   stack.reserve(map.size());
   for (Map::const_iterator p = map.begin(); p != map.end(); ++p) {
-    stack.push_back(boost::shared_ptr<SVertex>(p->first));
+    stack.push_back(p->first);
   }
 
   // Step 3: Sort the vertices in the stack.
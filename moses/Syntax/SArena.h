@@ -0,0 +1,73 @@
+#pragma once
+
+#include "moses/ObjectPool.h"
+
+#include "SHyperedge.h"
+#include "SVertex.h"
+#include "SVertexStack.h"
+
+namespace Moses
+{
+namespace Syntax
+{
+
+// Per-sentence storage for the search hypergraph.  SVertex and SHyperedge
+// objects are allocated from pools owned by the manager instead of being
+// individually heap-allocated and reference counted.  Everything is destroyed
+// en bloc when the arena is, i.e. when the sentence has been decoded.
+//
+// Objects that are discarded during search (recombined vertices, unpopped
+// cube items, pruned vertices) can be handed back for reuse.
+class SArena
+{
+public:
+  SArena()
+    : m_vertices("SVertex", kInitialSize)
+    , m_hyperedges("SHyperedge", kInitialSize) {}
+
+  SVertex *NewVertex() {
+    return new (m_vertices.getPtr()) SVertex();
+  }
+
+  SHyperedge *NewHyperedge() {
+    return new (m_hyperedges.getPtr()) SHyperedge();
+  }
+
+  void FreeVertex(SVertex *v) {
+    m_vertices.freeObject(v);
+  }
+
+  void FreeHyperedge(SHyperedge *h) {
+    m_hyperedges.freeObject(h);
+  }
+
+  // Truncates stack to limit vertices, returning the pruned vertices and
+  // their incoming hyperedges for reuse.  Nothing may refer to them yet.
+  void PruneStack(SVertexStack &stack, std::size_t limit) {
+    if (stack.size() <= limit) {
+      return;
+    }
+    for (SVertexStack::iterator p = stack.begin() + limit; p != stack.end();
+         ++p) {
+      SVertex *v = *p;
+      if (v->best) {
+        FreeHyperedge(v->best);
+      }
+      for (std::vector<SHyperedge*>::iterator q = v->recombined.begin();
+           q != v->recombined.end(); ++q) {
+        FreeHyperedge(*q);
+      }
+      FreeVertex(v);
+    }
+    stack.resize(limit);
+  }
+
+private:
+  static const std::size_t kInitialSize = 1024;
+
+  ObjectPool<SVertex> m_vertices;
+  ObjectPool<SHyperedge> m_hyperedges;
+};
+
+}  // Syntax
+}  // Moses
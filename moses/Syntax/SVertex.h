@@ -15,8 +15,9 @@ struct SHyperedge;
 
 // A vertex in the search hypergraph.
 //
-// Important: a SVertex owns its incoming SHyperedge objects and its FFState
-// objects and will delete them on destruction.
+// Important: a SVertex owns its FFState objects and will delete them on
+// destruction.  Its incoming SHyperedge objects are owned by the SArena that
+// the vertex was allocated from.
 struct SVertex {
   ~SVertex();
 
@@ -2,8 +2,6 @@
 
 #include <vector>
 
-#include <boost/shared_ptr.hpp>
-
 #include "SHyperedge.h"
 #include "SVertex.h"
 
@@ -12,12 +10,12 @@ namespace Moses
 namespace Syntax
 {
 
-typedef std::vector<boost::shared_ptr<SVertex> > SVertexStack;
+// The vertices are owned by the manager's SArena.
+typedef std::vector<SVertex*> SVertexStack;
 
 struct SVertexStackContentOrderer {
 public:
-  bool operator()(const boost::shared_ptr<SVertex> &x,
-                  const boost::shared_ptr<SVertex> &y) {
+  bool operator()(const SVertex *x, const SVertex *y) {
     return x->best->label.futureScore > y->best->label.futureScore;
   }
 };
@@ -83,7 +83,7 @@ void Manager<RuleMatcher>::InitializeStacks()
 
     // For terminals only, add a single SVertex.
     if (node.children.empty()) {
-      boost::shared_ptr<SVertex> v(new SVertex());
+      SVertex *v = m_arena.NewVertex();
       v->best = 0;
       v->pvertex = &(node.pvertex);
       stack.push_back(v);
@@ -149,7 +149,7 @@ void Manager<RuleMatcher>::Decode()
 
     // Use cube pruning to extract SHyperedges from SHyperedgeBundles and
     // collect the SHyperedges in a buffer.
-    CubeQueue cubeQueue(bundles.Begin(), bundles.End());
+    CubeQueue cubeQueue(bundles.Begin(), bundles.End(), m_arena);
     std::size_t count = 0;
     std::vector<SHyperedge*> buffer;
     while (count < popLimit && !cubeQueue.IsEmpty()) {
@@ -167,8 +167,8 @@ void Manager<RuleMatcher>::Decode()
     RecombineAndSort(buffer, stack);
 
     // Prune stack.
-    if (stackLimit > 0 && stack.size() > stackLimit) {
-      stack.resize(stackLimit);
+    if (stackLimit > 0) {
+      m_arena.PruneStack(stack, stackLimit);
     }
   }
 }
@@ -245,7 +245,7 @@ void Manager<RuleMatcher>::RecombineAndSort(
   // Step 1: Create a map containing a single instance of each distinct vertex
   // (where distinctness is defined by the state value).  The hyperedges'
   // head pointers are updated to point to the vertex instances in the map and
-  // any 'duplicate' vertices are deleted.
+  // any 'duplicate' vertices are returned to the arena.
 // TODO Set?
   typedef boost::unordered_map<SVertex *, SVertex *,
           SVertexRecombinationHasher,
@@ -272,8 +272,7 @@ void Manager<RuleMatcher>::RecombineAndSort(
     } else {
       storedVertex->recombined.push_back(h);
     }
-    h->head->best = 0;
-    delete h->head;
+    m_arena.FreeVertex(h->head);
     h->head = storedVertex;
   }
 
@@ -281,7 +280,7 @@ void Manager<RuleMatcher>::RecombineAndSort(
   stack.clear();
   stack.reserve(map.size());
   for (Map::const_iterator p = map.begin(); p != map.end(); ++p) {
-    stack.push_back(boost::shared_ptr<SVertex>(p->first));
+    stack.push_back(p->first);
   }
 
   // Step 3: Sort the vertices in the stack.
@@ -192,6 +192,12 @@ public:
     return m_ruleSource;
   }
 
+  //! approximate bytes held by this target phrase, for byte-bounded caches
+  size_t GetMemoryEstimate() const {
+    return sizeof(TargetPhrase) + GetSize() * sizeof(Word)
+           + m_scoreBreakdown.Size() * sizeof(FValue);
+  }
+
   const PhraseDictionary *GetContainer() const {
     return m_container;
   }
@@ -101,6 +101,15 @@ public:
   bool IsEmpty() const {
     return m_collection.empty();
   }
+  //! approximate bytes held by the collection and its phrases
+  size_t GetMemoryEstimate() const {
+    size_t ret = sizeof(TargetPhraseCollection)
+                 + m_collection.capacity() * sizeof(const TargetPhrase*);
+    for (const_iterator iter = begin(); iter != end(); ++iter) {
+      ret += (*iter)->GetMemoryEstimate();
+    }
+    return ret;
+  }
   //! add a new entry into collection
   void Add(TargetPhrase *targetPhrase) {
     m_collection.push_back(targetPhrase);
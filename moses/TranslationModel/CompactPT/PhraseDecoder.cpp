@@ -454,9 +454,9 @@ TargetPhraseVectorPtr PhraseDecoder::DecodeCollection(
   return tpv;
 }
 
-void PhraseDecoder::PruneCache()
+CacheStats PhraseDecoder::GetCacheStats() const
 {
-  m_decodingCache.Prune();
+  return m_decodingCache.GetStats();
 }
 
 }
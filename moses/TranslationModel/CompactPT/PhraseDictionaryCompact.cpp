@@ -177,7 +177,9 @@ CleanUpAfterSentenceProcessing(const InputType &source)
   if(!m_sentenceCache.get())
     m_sentenceCache.reset(new PhraseCache());
 
-  m_phraseDecoder->PruneCache();
+  if(m_phraseDecoder)
+    VERBOSE(2, "Decoding cache of " << GetScoreProducerDescription() << ": "
+            << m_phraseDecoder->GetCacheStats() << std::endl);
   m_sentenceCache->clear();
 
   ReduceCache();
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_PhraseDictionaryCompact_h
 
 #include <boost/unordered_map.hpp>
+#include <boost/thread/tss.hpp>
 
 #ifdef WITH_THREADS
 #ifdef BOOST_HAS_PTHREADS
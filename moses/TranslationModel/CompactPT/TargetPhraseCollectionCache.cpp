@@ -25,8 +25,5 @@ namespace Moses
 {
 
 
-boost::thread_specific_ptr<TargetPhraseCollectionCache::CacheMap>
-TargetPhraseCollectionCache::m_phraseCache;
-
 }
 
@@ -22,15 +22,13 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_TargetPhraseCollectionCache_h
 #define moses_TargetPhraseCollectionCache_h
 
-#include <map>
-#include <set>
 #include <vector>
 
-#include <boost/thread/tss.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "moses/Phrase.h"
 #include "moses/TargetPhraseCollection.h"
+#include "moses/TranslationModel/ShardedClockCache.h"
 
 namespace Moses
 {
@@ -39,121 +37,69 @@ namespace Moses
 typedef std::vector<TargetPhrase> TargetPhraseVector;
 typedef boost::shared_ptr<TargetPhraseVector> TargetPhraseVectorPtr;
 
-/** Implementation of Persistent Cache **/
+/** Implementation of Persistent Cache.
+  * Shared by all decoding threads and bounded by bytes, see
+  * ShardedClockCache. Cached collections are never modified.
+  **/
 class TargetPhraseCollectionCache
 {
 private:
-  size_t m_max;
-  float m_tolerance;
-
   struct LastUsed {
-    clock_t m_clock;
     TargetPhraseVectorPtr m_tpv;
     size_t m_bitsLeft;
 
-    LastUsed() : m_clock(0), m_bitsLeft(0) {}
+    LastUsed() : m_bitsLeft(0) {}
 
-    LastUsed(clock_t clock, TargetPhraseVectorPtr tpv, size_t bitsLeft = 0)
-      : m_clock(clock), m_tpv(tpv), m_bitsLeft(bitsLeft) {}
+    LastUsed(TargetPhraseVectorPtr tpv, size_t bitsLeft = 0)
+      : m_tpv(tpv), m_bitsLeft(bitsLeft) {}
   };
 
-  typedef std::map<Phrase, LastUsed> CacheMap;
-  static boost::thread_specific_ptr<CacheMap> m_phraseCache;
-
-public:
-
-  typedef CacheMap::iterator iterator;
-  typedef CacheMap::const_iterator const_iterator;
-
-  TargetPhraseCollectionCache(size_t max = 5000, float tolerance = 0.2)
-    : m_max(max), m_tolerance(tolerance) {
-  }
+  typedef ShardedClockCache<Phrase, LastUsed> CacheMap;
+  CacheMap m_phraseCache;
 
-  iterator Begin() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
+  static size_t GetMemoryEstimate(const Phrase &sourcePhrase,
+                                  const TargetPhraseVector &tpv) {
+    size_t ret = sizeof(LastUsed) + sizeof(TargetPhraseVector)
+                 + sizeof(Phrase) + sourcePhrase.GetSize() * sizeof(Word);
+    for(TargetPhraseVector::const_iterator it = tpv.begin(); it != tpv.end(); it++)
+      ret += it->GetMemoryEstimate();
+    return ret;
   }
 
-  const_iterator Begin() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
-  }
-
-  iterator End() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
-  }
+public:
 
-  const_iterator End() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
+  TargetPhraseCollectionCache(size_t maxBytes = 64 * 1024 * 1024)
+    : m_phraseCache(maxBytes) {
   }
 
   /** retrieve translations for source phrase from persistent cache **/
   void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
              size_t bitsLeft = 0, size_t maxRank = 0) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    // check if source phrase is already in cache
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end())
-      // if found, just update clock
-      it->second.m_clock = clock();
-    else {
-      // else, add to cache
-      if(maxRank && tpv->size() > maxRank) {
-        TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
-        tpv_temp->resize(maxRank);
-        std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv_temp, bitsLeft);
-      } else
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv, bitsLeft);
+    if(maxRank && tpv->size() > maxRank) {
+      TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
+      tpv_temp->resize(maxRank);
+      std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
+      tpv = tpv_temp;
     }
+    // if already in cache, only marks it as used
+    m_phraseCache.Insert(sourcePhrase, LastUsed(tpv, bitsLeft),
+                         GetMemoryEstimate(sourcePhrase, *tpv));
   }
 
-  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end()) {
-      LastUsed &lu = it->second;
-      lu.m_clock = clock();
+  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase) const {
+    LastUsed lu;
+    if(m_phraseCache.Find(sourcePhrase, lu))
       return std::make_pair(lu.m_tpv, lu.m_bitsLeft);
-    } else
+    else
       return std::make_pair(TargetPhraseVectorPtr(), 0);
   }
 
-  // if cache full, reduce
-  void Prune() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    if(m_phraseCache->size() > m_max * (1 + m_tolerance)) {
-      typedef std::set<std::pair<clock_t, Phrase> > Cands;
-      Cands cands;
-      for(CacheMap::iterator it = m_phraseCache->begin();
-          it != m_phraseCache->end(); it++) {
-        LastUsed &lu = it->second;
-        cands.insert(std::make_pair(lu.m_clock, it->first));
-      }
-
-      for(Cands::iterator it = cands.begin(); it != cands.end(); it++) {
-        const Phrase& p = it->second;
-        m_phraseCache->erase(p);
-
-        if(m_phraseCache->size() < (m_max * (1 - m_tolerance)))
-          break;
-      }
-    }
+  CacheStats GetStats() const {
+    return m_phraseCache.GetStats();
   }
 
   void CleanUp() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    m_phraseCache->clear();
+    m_phraseCache.Clear();
   }
 
 };
@@ -39,6 +39,7 @@ PhraseDictionary::PhraseDictionary(const std::string &line, bool registerNow)
   : DecodeFeature(line, registerNow)
   , m_tableLimit(20) // default
   , m_maxCacheSize(DEFAULT_MAX_TRANS_OPT_CACHE_SIZE)
+  , m_cache(new CacheColl(DEFAULT_MAX_TRANS_OPT_CACHE_BYTES))
 {
   m_id = s_staticColl.size();
   s_staticColl.push_back(this);
@@ -56,25 +57,18 @@ PhraseDictionary::
 GetTargetPhraseCollectionLEGACY(const Phrase& src) const
 {
   TargetPhraseCollection::shared_ptr ret;
-  typedef std::pair<TargetPhraseCollection::shared_ptr , clock_t> entry;
   if (m_maxCacheSize) {
     CacheColl &cache = GetCache();
 
     size_t hash = hash_value(src);
 
-    CacheColl::iterator iter;
-    iter = cache.find(hash);
-
-    if (iter == cache.end()) {
+    if (!cache.Find(hash, ret)) {
       // not in cache, need to look up from phrase table
       ret = GetTargetPhraseCollectionNonCacheLEGACY(src);
       if (ret) { // make a copy
         ret.reset(new TargetPhraseCollection(*ret));
       }
-      cache[hash] = entry(ret, clock());
-    } else { // in cache. just use it
-      iter->second.second = clock();
-      ret = iter->second.first;
+      cache.Insert(hash, ret, ret ? ret->GetMemoryEstimate() : sizeof(ret));
     }
   } else {
     // don't use cache. look up from phrase table
@@ -105,6 +99,8 @@ SetParameter(const std::string& key, const std::string& value)
 {
   if (key == "cache-size") {
     m_maxCacheSize = Scan<size_t>(value);
+  } else if (key == "cache-bytes") {
+    m_cache->SetMaxBytes(Scan<size_t>(value));
   } else if (key == "path") {
     m_filePath = value;
   } else if (key == "table-limit") {
@@ -164,51 +160,24 @@ GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
   }
 }
 
-// reduce presistent cache by half of maximum size
+// report the persistent cache. Eviction happens on insertion
 void PhraseDictionary::ReduceCache() const
 {
-  Timer reduceCacheTime;
-  reduceCacheTime.start();
-  CacheColl &cache = GetCache();
-  if (cache.size() <= m_maxCacheSize) return; // not full
-
-  // find cutoff for last used time
-  priority_queue< clock_t > lastUsedTimes;
-  CacheColl::iterator iter;
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    lastUsedTimes.push( iter->second.second );
-    iter++;
-  }
-  for( size_t i=0; i < lastUsedTimes.size()-m_maxCacheSize/2; i++ )
-    lastUsedTimes.pop();
-  clock_t cutoffLastUsedTime = lastUsedTimes.top();
-
-  // remove all old entries
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    if (iter->second.second < cutoffLastUsedTime) {
-      CacheColl::iterator iterRemove = iter++;
-      // delete iterRemove->second.first;
-      cache.erase(iterRemove);
-    } else iter++;
-  }
-  VERBOSE(2,"Reduced persistent translation option cache in "
-          << reduceCacheTime << " seconds." << std::endl);
+  if (m_maxCacheSize == 0) return;
+  VERBOSE(2,"Translation option cache of " << GetScoreProducerDescription()
+          << ": " << m_cache->GetStats() << std::endl);
+}
+
+CacheStats PhraseDictionary::GetCacheStats() const
+{
+  return m_cache->GetStats();
 }
 
 CacheColl &
 PhraseDictionary::
 GetCache() const
 {
-  CacheColl *cache;
-  cache = m_cache.get();
-  if (cache == NULL) {
-    cache = new CacheColl;
-    m_cache.reset(cache);
-  }
-  assert(cache);
-  return *cache;
+  return *m_cache;
 }
 
 bool PhraseDictionary::SatisfyBackoff(const InputPath &inputPath) const
@@ -31,13 +31,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <vector>
 #include <string>
 #include <boost/unordered_map.hpp>
-
-#ifdef WITH_THREADS
-#include <boost/thread/tss.hpp>
-#else
 #include <boost/scoped_ptr.hpp>
-#include <ctime>
-#endif
 
 #include "moses/Phrase.h"
 #include "moses/TargetPhrase.h"
@@ -45,6 +39,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/InputPath.h"
 #include "moses/FF/DecodeFeature.h"
 #include "moses/ContextScope.h"
+#include "moses/TranslationModel/ShardedClockCache.h"
 
 namespace Moses
 {
@@ -56,9 +51,9 @@ class ChartCellCollectionBase;
 class ChartRuleLookupManager;
 class ChartParser;
 
-// typedef std::pair<TargetPhraseCollection::shared_ptr, clock_t> TPCollLastUse;
-typedef std::pair<TargetPhraseCollection::shared_ptr, clock_t> CacheCollEntry;
-typedef boost::unordered_map<size_t, CacheCollEntry> CacheColl;
+//! persistent translation option cache, shared by all threads. Keyed by
+//! source phrase hash (or any other id the phrase table chooses)
+typedef ShardedClockCache<size_t, TargetPhraseCollection::shared_ptr> CacheColl;
 
 /**
   * Abstract base class for phrase dictionaries (tables).
@@ -90,6 +85,10 @@ public:
     return m_id;
   }
 
+  //! counters of the translation option cache shared by all threads; all
+  //! zero if the cache is off
+  CacheStats GetCacheStats() const;
+
   // virtual
   // void
   // Release(ttasksptr const& ttask, TargetPhraseCollection const*& tpc) const;
@@ -169,19 +168,15 @@ protected:
   bool SatisfyBackoff(const InputPath &inputPath) const;
 
   // cache
-  size_t m_maxCacheSize; // 0 = no caching
+  size_t m_maxCacheSize; // 0 = no caching. Otherwise bounded by cache-bytes
 
-#ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::thread_specific_ptr<CacheColl> m_cache;
-#else
-  mutable boost::scoped_ptr<CacheColl> m_cache;
-#endif
+  boost::scoped_ptr<CacheColl> m_cache;
 
   virtual
   TargetPhraseCollection::shared_ptr
   GetTargetPhraseCollectionNonCacheLEGACY(const Phrase& src) const;
 
+  // log cache counters. The cache bounds itself on insertion
   void ReduceCache() const;
 
 protected:
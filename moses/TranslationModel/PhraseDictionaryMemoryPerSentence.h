@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <boost/thread/tss.hpp>
 #include "PhraseDictionary.h"
 #include "moses/TypeDef.h"
 #include "moses/TranslationTask.h"
@@ -63,13 +63,10 @@ GetTargetPhraseCollection(InputPath &inputPath) const
 
   CacheColl &cache = GetCache();
 
-  CacheColl::iterator iter;
-  iter = cache.find(hash);
-
-  if (iter != cache.end()) {
+  TargetPhraseCollection::shared_ptr cached;
+  if (cache.Find(hash, cached)) {
     // already in cache
-    TargetPhraseCollection::shared_ptr tpColl = iter->second.first;
-    inputPath.SetTargetPhrases(*this, tpColl, NULL);
+    inputPath.SetTargetPhrases(*this, cached, NULL);
   } else {
     // TRANSLITERATE
     const util::temp_file inFile;
@@ -99,7 +96,7 @@ GetTargetPhraseCollection(InputPath &inputPath) const
       TargetPhrase *tp = *iter;
       tpColl->Add(tp);
     }
-    cache[hash] = CacheCollEntry(tpColl, clock());
+    cache.Insert(hash, tpColl, tpColl->GetMemoryEstimate());
     inputPath.SetTargetPhrases(*this, tpColl, NULL);
   }
 }
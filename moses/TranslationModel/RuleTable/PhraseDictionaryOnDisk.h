@@ -29,11 +29,8 @@
 #include "OnDiskPt/Word.h"
 #include "OnDiskPt/PhraseNode.h"
 
-#ifdef WITH_THREADS
-#include <boost/thread/tss.hpp>
-#else
 #include <boost/scoped_ptr.hpp>
-#endif
+#include "util/mmap.hh"
 
 namespace Moses
 {
@@ -51,11 +48,10 @@ class PhraseDictionaryOnDisk : public PhraseDictionary
   friend class ChartRuleLookupManagerOnDisk;
 
 protected:
-#ifdef WITH_THREADS
-  boost::thread_specific_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#else
+  // loaded once and shared by all threads. The table is memory mapped and
+  // only read from, so lookups don't need a lock
   boost::scoped_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#endif
+  util::LoadMethod m_loadMethod;
 
   size_t m_maxSpanDefault, m_maxSpanLabelled;
 
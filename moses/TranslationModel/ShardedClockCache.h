@@ -0,0 +1,243 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_ShardedClockCache_h
+#define moses_ShardedClockCache_h
+
+#include <vector>
+#include <ostream>
+
+#include <boost/atomic.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+#include <stdint.h>
+
+#ifdef WITH_THREADS
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+#endif
+
+namespace Moses
+{
+
+//! Counters of a ShardedClockCache, summed over all shards
+struct CacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t insertions;
+  uint64_t evictions;
+  size_t entries;
+  size_t bytes;
+
+  CacheStats()
+    : hits(0), misses(0), insertions(0), evictions(0), entries(0), bytes(0) {
+  }
+};
+
+inline std::ostream& operator<<(std::ostream &out, const CacheStats &stats)
+{
+  out << "hits=" << stats.hits
+      << " misses=" << stats.misses
+      << " insertions=" << stats.insertions
+      << " evictions=" << stats.evictions
+      << " entries=" << stats.entries
+      << " bytes=" << stats.bytes;
+  return out;
+}
+
+/** Cache shared by all decoding threads, bounded by (estimated) bytes.
+  *
+  * Keys are spread over a fixed number of shards, each with its own
+  * reader-writer lock, so threads looking up different phrases rarely
+  * contend. Find() only takes the read lock and marks the entry as
+  * referenced; Insert() takes the write lock and evicts with the CLOCK
+  * (second chance) algorithm until the shard is back within its share of
+  * the budget.
+  */
+template <class Key, class Value, class Hash = boost::hash<Key> >
+class ShardedClockCache : boost::noncopyable
+{
+public:
+  ShardedClockCache(size_t maxBytes, size_t numShards = 64)
+    : m_maxBytes(maxBytes) {
+    m_shards.resize(numShards ? numShards : 1);
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      m_shards[i] = new Shard();
+    }
+  }
+
+  ~ShardedClockCache() {
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      delete m_shards[i];
+    }
+  }
+
+  size_t GetMaxBytes() const {
+    return m_maxBytes;
+  }
+
+  //! only while the cache is not yet shared, eg. when reading parameters
+  void SetMaxBytes(size_t maxBytes) {
+    m_maxBytes = maxBytes;
+  }
+
+  //! look up key. If found, copy the cached value into value
+  bool Find(const Key &key, Value &value) const {
+    const Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::shared_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+    typename Map::const_iterator iter = shard.map.find(key);
+    if (iter == shard.map.end()) {
+      shard.misses.fetch_add(1, boost::memory_order_relaxed);
+      return false;
+    }
+    iter->second->referenced.store(true, boost::memory_order_relaxed);
+    value = iter->second->value;
+    shard.hits.fetch_add(1, boost::memory_order_relaxed);
+    return true;
+  }
+
+  //! add value, unless another thread got there first. bytes is the
+  //! caller's estimate of the memory held by value
+  void Insert(const Key &key, const Value &value, size_t bytes) {
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+    std::pair<typename Map::iterator, bool> inserted
+      = shard.map.insert(std::make_pair(key, static_cast<Entry*>(NULL)));
+    if (!inserted.second) {
+      inserted.first->second->referenced.store(true, boost::memory_order_relaxed);
+      return;
+    }
+
+    Entry *entry = new Entry(key, value, bytes);
+    inserted.first->second = entry;
+    shard.clock.push_back(entry);
+    shard.bytes += bytes;
+    ++shard.insertions;
+
+    Evict(shard, m_maxBytes / m_shards.size());
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      Shard &shard = *m_shards[i];
+#ifdef WITH_THREADS
+      boost::unique_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+      Evict(shard, 0);
+    }
+  }
+
+  CacheStats GetStats() const {
+    CacheStats ret;
+    for (size_t i = 0; i < m_shards.size(); ++i) {
+      const Shard &shard = *m_shards[i];
+#ifdef WITH_THREADS
+      boost::shared_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+      ret.hits += shard.hits.load(boost::memory_order_relaxed);
+      ret.misses += shard.misses.load(boost::memory_order_relaxed);
+      ret.insertions += shard.insertions;
+      ret.evictions += shard.evictions;
+      ret.entries += shard.clock.size();
+      ret.bytes += shard.bytes;
+    }
+    return ret;
+  }
+
+private:
+  struct Entry {
+    Key key;
+    Value value;
+    size_t bytes;
+    boost::atomic<bool> referenced;
+
+    Entry(const Key &k, const Value &v, size_t b)
+      : key(k), value(v), bytes(b), referenced(true) {
+    }
+  };
+
+  typedef boost::unordered_map<Key, Entry*, Hash> Map;
+
+  struct Shard : boost::noncopyable {
+    Map map;
+    std::vector<Entry*> clock; // entries in insertion order, swept by hand
+    size_t hand;
+    size_t bytes;
+
+    mutable boost::atomic<uint64_t> hits, misses; // updated under read lock
+    uint64_t insertions, evictions;
+
+#ifdef WITH_THREADS
+    mutable boost::shared_mutex lock;
+#endif
+
+    Shard()
+      : hand(0), bytes(0), hits(0), misses(0), insertions(0), evictions(0) {
+    }
+
+    ~Shard() {
+      for (size_t i = 0; i < clock.size(); ++i) {
+        delete clock[i];
+      }
+    }
+  };
+
+  std::vector<Shard*> m_shards;
+  size_t m_maxBytes;
+  Hash m_hash;
+
+  Shard &GetShard(const Key &key) const {
+    // the maps bucket on the low bits of the same hash, pick the shard
+    // from the high bits
+    uint64_t hash = static_cast<uint64_t>(m_hash(key)) * 0x9E3779B97F4A7C15ULL;
+    return *m_shards[(hash >> 32) % m_shards.size()];
+  }
+
+  // caller holds the shard's write lock
+  void Evict(Shard &shard, size_t budget) {
+    while (shard.bytes > budget && !shard.clock.empty()) {
+      if (shard.hand >= shard.clock.size()) {
+        shard.hand = 0;
+      }
+      Entry *entry = shard.clock[shard.hand];
+      if (entry->referenced.exchange(false, boost::memory_order_relaxed)) {
+        // second chance
+        ++shard.hand;
+        continue;
+      }
+
+      shard.map.erase(entry->key);
+      shard.bytes -= entry->bytes;
+      shard.clock[shard.hand] = shard.clock.back();
+      shard.clock.pop_back();
+      delete entry;
+      ++shard.evictions;
+    }
+  }
+};
+
+}
+
+#endif
@@ -43,6 +43,7 @@ int with_sfas;
 bool incremental = false; // build / grow vocabs automatically
 bool is_conll    = false; // text or conll format?
 bool quiet       = false; // no progress reporting
+size_t threads   = 0;     // for sorting; 0: all cores
 
 string vocabBase; // base name for existing vocabs that should be used
 string baseName;  // base name for all files
@@ -367,7 +368,7 @@ build_mmTSA(string infile, string outfile)
   boost::shared_ptr<mmTtrack<Token> > T(new mmTtrack<Token>(infile));
   bdBitset filter;
   filter.resize(T->size(),true);
-  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr));
+  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr),threads);
   S.save_as_mm_tsa(outfile);
   // exit(0);
 }
@@ -463,6 +464,9 @@ interpret_args(int ac, char* av[])
      ->default_value(0)->implicit_value(1),
      "also build dependency chain arrays")
 
+    ("threads,T", po::value<size_t>(&threads)->default_value(0),
+     "number of threads for sorting (0: all cores)")
+
     ("conll,c", po::bool_switch(&is_conll),
      "corpus is in CoNLL format (default: plain text)")
 
@@ -0,0 +1,171 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#define BOOST_TEST_MODULE PstatsCacheTest
+#include <boost/test/unit_test.hpp>
+
+#include "ug_bitext_pstats_cache.h"
+
+using namespace sapt;
+
+namespace {
+
+struct NoDelete { void operator()(void const*) const { } };
+
+// stands in for a suffix array
+SPTR<void const> root(int* x)
+{
+  return SPTR<void const>(x, NoDelete());
+}
+
+SPTR<pstats> stats()
+{
+  return SPTR<pstats>(new pstats(false));
+}
+
+// what an entry with empty statistics takes up
+size_t entry_size()
+{
+  PstatsCache cache(1 << 20);
+  int x;
+  cache.add(root(&x), 1, 100, stats(), 1);
+  return cache.stats().bytes;
+}
+
+BOOST_AUTO_TEST_CASE(capacity) {
+  size_t const B = entry_size();
+  BOOST_REQUIRE_GT(B, 0);
+  PstatsCache cache(3 * B + B / 2);
+  int x;
+  SPTR<void const> r = root(&x);
+  for (uint64_t pid = 0; pid < 20; ++pid) {
+    // each newer entry is worth a bit more, so it always gets in
+    BOOST_CHECK(cache.add(r, pid, 100, stats(), 1 + pid));
+    BOOST_CHECK_LE(cache.stats().bytes, cache.capacity());
+  }
+  PstatsCache::Stats s = cache.stats();
+  BOOST_CHECK_EQUAL(3, s.entries);
+  BOOST_CHECK_EQUAL(3 * B, s.bytes);
+  BOOST_CHECK_EQUAL(20, s.admitted);
+  BOOST_CHECK_EQUAL(17, s.evictions);
+  // the newest three are left
+  BOOST_CHECK(cache.get(r, 19, 100));
+  BOOST_CHECK(cache.get(r, 17, 100));
+  BOOST_CHECK(!cache.get(r, 16, 100));
+
+  // reserve only ever grows the capacity
+  cache.reserve(B);
+  BOOST_CHECK_EQUAL(3 * B + B / 2, cache.capacity());
+  cache.reserve(4 * B);
+  BOOST_CHECK_EQUAL(4 * B, cache.capacity());
+}
+
+BOOST_AUTO_TEST_CASE(too_large) {
+  size_t const B = entry_size();
+  int x;
+  SPTR<void const> r = root(&x);
+
+  PstatsCache disabled;
+  BOOST_CHECK(!disabled.add(r, 1, 100, stats(), 1));
+
+  PstatsCache cache(B - 1);
+  BOOST_CHECK(!cache.add(r, 1, 100, stats(), 1e9));
+  PstatsCache::Stats s = cache.stats();
+  BOOST_CHECK_EQUAL(0, s.entries);
+  BOOST_CHECK_EQUAL(0, s.bytes);
+  BOOST_CHECK_EQUAL(0, s.admitted);
+  BOOST_CHECK_EQUAL(1, s.rejected);
+  BOOST_CHECK(!cache.get(r, 1, 100));
+}
+
+BOOST_AUTO_TEST_CASE(eviction_order) {
+  size_t const B = entry_size();
+  PstatsCache cache(3 * B);
+  int x;
+  SPTR<void const> r = root(&x);
+  BOOST_CHECK(cache.add(r, 1, 100, stats(), 1));
+  BOOST_CHECK(cache.add(r, 2, 100, stats(), 2.5));
+  BOOST_CHECK(cache.add(r, 3, 100, stats(), 2));
+
+  // cheaper than everything in the cache: turned away
+  BOOST_CHECK(!cache.add(r, 4, 100, stats(), 0.5));
+  BOOST_CHECK_EQUAL(3, cache.stats().entries);
+
+  // the cheapest entry goes first, and the inflation value rises to its
+  // priority
+  BOOST_CHECK(cache.add(r, 5, 100, stats(), 6));
+  BOOST_CHECK(!cache.get(r, 1, 100));
+
+  // a hit lifts 3 (now 1 + 2) above 2 (2.5)
+  BOOST_CHECK(cache.get(r, 3, 100));
+  BOOST_CHECK(cache.add(r, 6, 100, stats(), 3));
+  BOOST_CHECK(!cache.get(r, 2, 100));
+  BOOST_CHECK(cache.get(r, 3, 100));
+  BOOST_CHECK(cache.get(r, 5, 100));
+  BOOST_CHECK(cache.get(r, 6, 100));
+
+  // keys differ in the sample size and the suffix array too
+  BOOST_CHECK(!cache.get(r, 3, 1000));
+  int y;
+  BOOST_CHECK(!cache.get(root(&y), 3, 100));
+
+  PstatsCache::Stats s = cache.stats();
+  BOOST_CHECK_EQUAL(5, s.admitted);
+  BOOST_CHECK_EQUAL(1, s.rejected);
+  BOOST_CHECK_EQUAL(2, s.evictions);
+}
+
+BOOST_AUTO_TEST_CASE(expired_root) {
+  size_t const B = entry_size();
+  PstatsCache cache(3 * B);
+  int x;
+  SPTR<void const> r = root(&x);
+  SPTR<pstats> p = stats();
+  BOOST_CHECK(cache.add(r, 1, 100, p, 1));
+  BOOST_CHECK(cache.add(r, 2, 100, stats(), 1));
+  BOOST_CHECK(cache.get(r, 1, 100) == p);
+
+  // a new suffix array at the same address finds nothing of the old one's
+  r.reset();
+  SPTR<void const> r2 = root(&x);
+  BOOST_CHECK(!cache.get(r2, 1, 100));
+  PstatsCache::Stats s = cache.stats();
+  BOOST_CHECK_EQUAL(1, s.entries);
+  BOOST_CHECK_EQUAL(B, s.bytes);
+
+  // and can put its own statistics in place of the old ones
+  SPTR<pstats> p2 = stats();
+  BOOST_CHECK(cache.add(r2, 2, 100, p2, 1));
+  BOOST_CHECK(cache.get(r2, 2, 100) == p2);
+  BOOST_CHECK_EQUAL(1, cache.stats().entries);
+
+  // while the root is alive, adding again keeps the first statistics
+  BOOST_CHECK(cache.add(r2, 2, 100, stats(), 1));
+  BOOST_CHECK(cache.get(r2, 2, 100) == p2);
+}
+
+BOOST_AUTO_TEST_CASE(counters) {
+  size_t const B = entry_size();
+  PstatsCache cache(2 * B);
+  int x;
+  SPTR<void const> r = root(&x);
+  BOOST_CHECK(!cache.get(r, 1, 100));
+  BOOST_CHECK(cache.add(r, 1, 100, stats(), 0.25));
+  BOOST_CHECK(cache.add(r, 2, 100, stats(), 0.5));
+  BOOST_CHECK(cache.get(r, 1, 100));
+  BOOST_CHECK(cache.get(r, 1, 100));
+  BOOST_CHECK(cache.get(r, 2, 100));
+  BOOST_CHECK(!cache.get(r, 3, 100));
+  BOOST_CHECK(!cache.add(r, 3, 100, stats(), 0.125));
+
+  PstatsCache::Stats s = cache.stats();
+  BOOST_CHECK_EQUAL(3, s.hits);
+  BOOST_CHECK_EQUAL(2, s.misses);
+  BOOST_CHECK_EQUAL(2, s.admitted);
+  BOOST_CHECK_EQUAL(1, s.rejected);
+  BOOST_CHECK_EQUAL(0, s.evictions);
+  BOOST_CHECK_EQUAL(2, s.entries);
+  BOOST_CHECK_EQUAL(2 * B, s.bytes);
+  BOOST_CHECK_EQUAL(2 * B, s.capacity);
+  BOOST_CHECK_CLOSE(1.0, s.time_saved, 1e-9);
+}
+
+} // namespace
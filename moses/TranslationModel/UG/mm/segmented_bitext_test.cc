@@ -0,0 +1,263 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE SegmentedBitextTest
+#include <boost/format.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ug_segmented_bitext.h"
+
+using namespace sapt;
+using namespace std;
+
+namespace {
+
+typedef L2R_Token<SimpleWordId> Token;
+typedef SegmentedBitext<Token> dynbitext;
+
+// sentence pair i is "a<i> x" ||| "b<i> y"
+void add(dynbitext& bt, size_t first, size_t n)
+{
+  vector<string> s1, s2, aln;
+  for (size_t i = first; i < first + n; ++i) {
+    s1.push_back((boost::format("a%d x") % i).str());
+    s2.push_back((boost::format("b%d y") % i).str());
+    aln.push_back("0-0 1-1");
+  }
+  bt.add(s1, s2, aln);
+}
+
+// the sizes of the segments, oldest first
+vector<size_t> sizes(dynbitext const& bt)
+{
+  vector<size_t> ret;
+  SPTR<dynbitext::segments_t const> segs = bt.segments();
+  for (size_t k = 0; k < segs->size(); ++k)
+    ret.push_back((*segs)[k]->T1->size());
+  return ret;
+}
+
+string str(Ttrack<Token> const& t, size_t sid, TokenIndex const& V)
+{
+  string ret;
+  for (Token const* x = t.sntStart(sid); x < t.sntEnd(sid); ++x)
+    ret += V[x->id()] + string(" ");
+  return ret;
+}
+
+// checks that the segments hold sentence pairs 0 .. n-1, in order
+void check_order(dynbitext const& bt, size_t n)
+{
+  SPTR<dynbitext::segments_t const> segs = bt.segments();
+  size_t i = 0;
+  for (size_t k = 0; k < segs->size(); ++k) {
+    Bitext<Token> const& seg = *(*segs)[k];
+    BOOST_REQUIRE_EQUAL(seg.T1->size(), seg.T2->size());
+    BOOST_REQUIRE_EQUAL(seg.T1->size(), seg.Tx->size());
+    for (size_t sid = 0; sid < seg.T1->size(); ++sid, ++i) {
+      BOOST_CHECK_EQUAL((boost::format("a%d x ") % i).str(),
+                        str(*seg.T1, sid, *seg.V1));
+      BOOST_CHECK_EQUAL((boost::format("b%d y ") % i).str(),
+                        str(*seg.T2, sid, *seg.V2));
+    }
+  }
+  BOOST_CHECK_EQUAL(n, i);
+  BOOST_CHECK_EQUAL(n, bt.size());
+}
+
+// the segments after adding one sentence pair at a time, for n = 1 .. 7
+size_t const expected[][3] = {
+  { 1 }, { 2 }, { 2, 1 }, { 4 }, { 4, 1 }, { 4, 2 }, { 4, 2, 1 }
+};
+
+void check_merges(dynbitext& bt, bool background)
+{
+  for (size_t n = 1; n <= 7; ++n) {
+    add(bt, n - 1, 1);
+    if (background) bt.wait();
+    size_t const* e = expected[n-1];
+    vector<size_t> want(e, e + (e[2] ? 3 : e[1] ? 2 : 1));
+    vector<size_t> got = sizes(bt);
+    BOOST_CHECK_EQUAL_COLLECTIONS(want.begin(), want.end(),
+                                  got.begin(), got.end());
+    check_order(bt, n);
+  }
+}
+
+struct TempDir {
+  string path;
+  TempDir() {
+    char tmpl[] = "/tmp/segmented_bitext_test.XXXXXX";
+    BOOST_REQUIRE(mkdtemp(tmpl));
+    path = tmpl;
+  }
+  ~TempDir() { rmdir(path.c_str()); }
+  bool empty() const {
+    DIR* d = opendir(path.c_str());
+    size_t n = 0;
+    while (dirent* e = readdir(d))
+      if (string(e->d_name) != "." && string(e->d_name) != "..") ++n;
+    closedir(d);
+    return n == 0;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(merge_in_add) {
+  SPTR<TokenIndex> V1(new TokenIndex), V2(new TokenIndex);
+  dynbitext bt(V1, V2, 1000, 1, 100);
+  BOOST_CHECK_EQUAL(0, bt.size());
+  check_merges(bt, false);
+}
+
+BOOST_AUTO_TEST_CASE(merge_in_background) {
+  SPTR<TokenIndex> V1(new TokenIndex), V2(new TokenIndex);
+  dynbitext bt(V1, V2, 1000, 1, 0);
+  check_merges(bt, true);
+}
+
+BOOST_AUTO_TEST_CASE(revision) {
+  SPTR<TokenIndex> V1(new TokenIndex), V2(new TokenIndex);
+  dynbitext bt(V1, V2, 1000, 1, 0);
+  size_t r0 = bt.revision();
+  add(bt, 0, 1);
+  add(bt, 1, 1);
+  bt.wait();
+  // merges don't change the revision
+  BOOST_CHECK_EQUAL(r0 + 2, bt.revision());
+  BOOST_CHECK_EQUAL(1, bt.segments()->size());
+}
+
+BOOST_AUTO_TEST_CASE(chain) {
+  SPTR<TokenIndex> V1(new TokenIndex), V2(new TokenIndex);
+  dynbitext bt(V1, V2, 1000, 1, 100);
+  SPTR<Bitext<Token> const> chain;
+  bt.segments(NULL, &chain);
+  BOOST_CHECK_EQUAL(0, chain->T1->size());
+  BOOST_CHECK_EQUAL(0, chain->T1->numTokens());
+  add(bt, 0, 7);
+  add(bt, 7, 2);
+  add(bt, 9, 1);
+  BOOST_CHECK_EQUAL(3, bt.segments(NULL, &chain)->size());
+  BOOST_CHECK_EQUAL(10, chain->T1->size());
+  BOOST_CHECK_EQUAL(10, chain->T2->size());
+  BOOST_CHECK_EQUAL(10, chain->Tx->size());
+  BOOST_CHECK_EQUAL(20, chain->T1->numTokens());
+  BOOST_CHECK_EQUAL(20, chain->T2->numTokens());
+  for (size_t i = 0; i < 10; ++i) {
+    BOOST_CHECK_EQUAL((boost::format("a%d x ") % i).str(),
+                      str(*chain->T1, i, *V1));
+    BOOST_CHECK_EQUAL((boost::format("b%d y ") % i).str(),
+                      str(*chain->T2, i, *V2));
+    BOOST_CHECK_EQUAL(i, chain->T2->findSid(chain->T2->sntStart(i) + 1));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(spill) {
+  TempDir dir;
+  SPTR<TokenIndex> V1(new TokenIndex), V2(new TokenIndex);
+  dynbitext bt(V1, V2, 1000, 1, 100);
+  bt.spill_to(dir.path, 4);
+  check_merges(bt, false);
+  SPTR<dynbitext::segments_t const> segs = bt.segments();
+  BOOST_CHECK(dynamic_cast<mmSegment<Token> const*>((*segs)[0].get()));
+  BOOST_CHECK(!dynamic_cast<mmSegment<Token> const*>((*segs)[1].get()));
+  // the mapped segment can be searched
+  vector<id_type> x(1, (*V1)["x"]);
+  TSA<Token>::tree_iterator m((*segs)[0]->I1.get(), &x[0], 1);
+  BOOST_CHECK_EQUAL(1, m.size());
+  BOOST_CHECK_EQUAL(4, m.approxOccurrenceCount());
+  // the files are gone as soon as they are mapped
+  BOOST_CHECK(dir.empty());
+}
+
+BOOST_AUTO_TEST_CASE(failed_merge) {
+  SPTR<TokenIndex> V1(new TokenIndex), V2(new TokenIndex);
+  dynbitext bt(V1, V2, 1000, 1, 0);
+  bt.spill_to("/nonexistent/segmented_bitext_test", 2);
+  add(bt, 0, 1);
+  add(bt, 1, 1);
+  BOOST_CHECK_THROW(bt.wait(), util::Exception);
+  // the segments stay as they were
+  BOOST_CHECK_EQUAL(2, bt.segments()->size());
+  check_order(bt, 2);
+  // the error is reported once
+  bt.wait();
+  bt.spill_to("", 0);
+  add(bt, 2, 1);
+  bt.wait();
+  check_order(bt, 3);
+}
+
+// sentence pair i is "x a<i%3>" ||| "y b<i%3>" for even i, "z b<i%3>" for odd i
+void add_pool(vector<string>& s1, vector<string>& s2, vector<string>& aln,
+              size_t first, size_t n)
+{
+  for (size_t i = first; i < first + n; ++i) {
+    s1.push_back((boost::format("x a%d") % (i % 3)).str());
+    s2.push_back((boost::format("%s b%d") % (i % 2 ? "z" : "y") % (i % 3)).str());
+    aln.push_back("0-0 1-1");
+  }
+}
+
+BOOST_AUTO_TEST_CASE(pool) {
+  SPTR<TokenIndex> V1(new TokenIndex), V2(new TokenIndex);
+  dynbitext bt(V1, V2, 1000, 1, 100);
+  vector<string> s1, s2, aln;
+  size_t const n[] = { 7, 2, 1 };
+  for (size_t i = 0, first = 0; i < 3; first += n[i++]) {
+    vector<string> t1, t2, a;
+    add_pool(t1, t2, a, first, n[i]);
+    bt.add(t1, t2, a);
+    add_pool(s1, s2, aln, first, n[i]);
+  }
+  SPTR<dynbitext::segments_t const> segs = bt.segments();
+  BOOST_REQUIRE_EQUAL(3, segs->size());
+
+  // the same sentence pairs in one bitext
+  imBitext<Token> empty(V1, V2, 1000, 1);
+  SPTR<imBitext<Token> > all = empty.add(s1, s2, aln);
+
+  vector<id_type> src(1, (*V1)["x"]);
+  vector<SPTR<TSA<Token>::tree_iterator> > m(segs->size());
+  vector<SPTR<pstats> > stats(segs->size());
+  for (size_t k = 0; k < segs->size(); ++k) {
+    m[k].reset(new TSA<Token>::tree_iterator((*segs)[k]->I1.get(),
+                                             &src[0], 1));
+    BOOST_REQUIRE_EQUAL(1, m[k]->size());
+    stats[k] = (*segs)[k]->lookup(*m[k]);
+  }
+  vector<PhrasePair<Token> > pooled;
+  dynbitext::pool(*segs, m, stats, pooled);
+
+  TSA<Token>::tree_iterator mall(all->I1.get(), &src[0], 1);
+  SPTR<pstats> sall = all->lookup(mall);
+  vector<PhrasePair<Token> > want;
+  expand(mall, *all, *sall, want, NULL);
+  PhrasePair<Token>::SortByTargetIdSeq sorter;
+  sort(want.begin(), want.end(), sorter);
+
+  BOOST_REQUIRE_EQUAL(want.size(), pooled.size());
+  for (size_t i = 0; i < want.size(); ++i) {
+    BOOST_CHECK_EQUAL(0, sorter.cmp(want[i], pooled[i]));
+    BOOST_CHECK_EQUAL(want[i].raw1, pooled[i].raw1);
+    BOOST_CHECK_EQUAL(want[i].sample1, pooled[i].sample1);
+    BOOST_CHECK_EQUAL(want[i].good1, pooled[i].good1);
+    BOOST_CHECK_EQUAL(want[i].raw2, pooled[i].raw2);
+    BOOST_CHECK_EQUAL(want[i].joint, pooled[i].joint);
+  }
+  BOOST_CHECK_EQUAL(10, pooled.front().raw1);
+
+  vector<id_type> y(1, (*V2)["y"]);
+  Token const* ty = reinterpret_cast<Token const*>(&y[0]);
+  BOOST_CHECK_EQUAL(5, dynbitext::count(*segs, ty, 1, true));
+  BOOST_CHECK_EQUAL(10, dynbitext::count(*segs,
+                                         reinterpret_cast<Token const*>(&src[0]),
+                                         1, false));
+}
+
+} // namespace
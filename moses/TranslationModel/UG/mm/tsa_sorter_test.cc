@@ -0,0 +1,126 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE TsaSorterTest
+#include <boost/test/unit_test.hpp>
+
+#include "ug_im_tsa.h"
+#include "ug_im_ttrack.h"
+#include "ug_corpus_token.h"
+#include "tpt_tokenindex.h"
+
+using namespace sapt;
+using namespace std;
+
+namespace {
+
+// Enough tokens that the sorter hands out several slices per round (it
+// keeps arrays of under 64k positions on one thread). A small vocabulary
+// and repeated sentences give long shared prefixes and identical suffixes.
+string corpus()
+{
+  ostringstream out;
+  unsigned x = 12345;
+  vector<string> prev;
+  for (size_t sid = 0; sid < 30000; ++sid) {
+    x = x * 1103515245 + 12345;
+    if (sid && x % 5 == 0) {
+      for (size_t i = 0; i < prev.size(); ++i) out << prev[i] << " ";
+      out << "\n";
+      continue;
+    }
+    prev.clear();
+    size_t len = 1 + (x >> 16) % 12;
+    for (size_t i = 0; i < len; ++i) {
+      x = x * 1103515245 + 12345;
+      prev.push_back(string(1, char('a' + (x >> 16) % 4)));
+      out << prev.back() << " ";
+    }
+    out << "\n";
+  }
+  return out.str();
+}
+
+// The order of the sorter it replaced: token by token to the end of the
+// sentence, a shorter suffix first; identical suffixes in corpus order.
+template<typename TOKEN>
+class SuffixLess
+{
+  Ttrack<TOKEN> const& m_corpus;
+public:
+  typedef typename Ttrack<TOKEN>::Position cpos;
+  SuffixLess(Ttrack<TOKEN> const& c) : m_corpus(c) { }
+
+  bool operator()(cpos const& A, cpos const& B) const
+  {
+    TOKEN const* a = m_corpus.getToken(A);
+    TOKEN const* b = m_corpus.getToken(B);
+    TOKEN const* stopA = a->stop(m_corpus, A.sid);
+    TOKEN const* stopB = b->stop(m_corpus, B.sid);
+    for (; a != stopA && b != stopB; a = a->next(), b = b->next())
+      if (a->id() != b->id()) return a->id() < b->id();
+    return a == stopA && b != stopB;
+  }
+};
+
+template<typename TOKEN>
+vector<typename Ttrack<TOKEN>::Position>
+suffixes(imTSA<TOKEN> const& tsa)
+{
+  typedef typename Ttrack<TOKEN>::Position cpos;
+  cpos const* a = reinterpret_cast<cpos const*>(tsa.arrayStart());
+  cpos const* z = reinterpret_cast<cpos const*>(tsa.arrayEnd());
+  return vector<cpos>(a, z);
+}
+
+template<typename TOKEN>
+void check(bdBitset const* filter)
+{
+  typedef typename Ttrack<TOKEN>::Position cpos;
+  TokenIndex V;
+  V.setDynamic(true);
+  istringstream in(corpus());
+  SPTR<imTtrack<TOKEN> > C(new imTtrack<TOKEN>(in, V));
+  BOOST_REQUIRE_GT(C->numTokens(), 150000);
+
+  imTSA<TOKEN> one(C, filter, NULL, 1);
+  imTSA<TOKEN> four(C, filter, NULL, 4);
+  vector<cpos> s1 = suffixes(one), s4 = suffixes(four);
+
+  vector<cpos> want;
+  for (size_t sid = 0; sid < C->size(); ++sid)
+    if (!filter || filter->test(sid))
+      for (size_t k = 0; k < C->sntLen(sid); ++k)
+        want.push_back(cpos(sid, k));
+  stable_sort(want.begin(), want.end(), SuffixLess<TOKEN>(*C));
+
+  BOOST_REQUIRE_EQUAL(want.size(), s1.size());
+  BOOST_REQUIRE_EQUAL(want.size(), s4.size());
+  size_t bad1 = 0, bad4 = 0;
+  for (size_t i = 0; i < want.size(); ++i) {
+    bad1 += want[i].sid != s1[i].sid || want[i].offset != s1[i].offset;
+    bad4 += want[i].sid != s4[i].sid || want[i].offset != s4[i].offset;
+  }
+  BOOST_CHECK_EQUAL(0, bad1);
+  BOOST_CHECK_EQUAL(0, bad4);
+  BOOST_CHECK_EQUAL(one.getCorpusSize(), four.getCorpusSize());
+}
+
+BOOST_AUTO_TEST_CASE(suffix_array) {
+  check<L2R_Token<SimpleWordId> >(NULL);
+}
+
+BOOST_AUTO_TEST_CASE(prefix_array) {
+  check<R2L_Token<SimpleWordId> >(NULL);
+}
+
+BOOST_AUTO_TEST_CASE(filtered) {
+  bdBitset filter(30000);
+  for (size_t i = 0; i < filter.size(); i += 3) filter.set(i);
+  check<L2R_Token<SimpleWordId> >(&filter);
+}
+
+} // namespace
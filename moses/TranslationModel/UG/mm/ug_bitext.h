@@ -576,12 +576,33 @@ namespace sapt
         if (m_num_workers > 1)
           ag->add_workers(m_num_workers);
       }
-    ret = ag->add_job(this, phrase, max_sample, bias);
+    ret = ag->add_job(this, phrase, max_sample, bias, false);
     if (cache) cache->set(phrase.getPid(),ret);
     UTIL_THROW_IF2(ret == NULL, "Couldn't schedule sampling job.");
     return ret;
   }
 
+  template<typename Token>
+  SPTR<pstats>
+  Bitext<Token>::
+  lookup(iter const& phrase, int max_sample) const
+  {
+    SPTR<pstats> ret = prep2(phrase, max_sample);
+    UTIL_THROW_IF2(!ret, "Got NULL pointer where I expected a valid pointer.");
+    if (m_num_workers <= 1)
+      {
+        boost::unique_lock<boost::shared_mutex> guard(m_lock);
+        typename agenda::worker(*this->ag)();
+      }
+    else
+      {
+        boost::unique_lock<boost::mutex> lock(ret->lock);
+        while (ret->in_progress)
+          ret->ready.wait(lock);
+      }
+    return ret;
+  }
+
   // worker for scoring and sorting phrase table entries in parallel
   template<typename Token>
   class pstats2pplist
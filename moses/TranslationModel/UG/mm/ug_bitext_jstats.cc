@@ -98,4 +98,17 @@ namespace sapt
   aln() const
   { return my_aln; }
 
+  size_t
+  jstats::
+  memory() const
+  {
+    // map nodes cost about four pointers on top of their payload
+    size_t ret = my_aln.capacity() * sizeof(my_aln[0]);
+    for (size_t i = 0; i < my_aln.size(); ++i)
+      ret += my_aln[i].second.capacity();
+    if (sids) ret += sizeof(*sids) + sids->capacity() * sizeof(uint32_t);
+    ret += indoc.size() * (sizeof(std::pair<uint32_t,uint32_t>) + 4 * sizeof(void*));
+    return ret;
+  }
+
 } // namespace sapt
@@ -50,6 +50,7 @@ namespace sapt
     bool valid();
     uint32_t dcnt_fwd(PhraseOrientation const idx) const;
     uint32_t dcnt_bwd(PhraseOrientation const idx) const;
+    size_t memory() const; // approximate heap footprint in bytes
     void fill_lr_vec(LRModel::Direction const& dir,
                      LRModel::ModelType const& mdl,
                      std::vector<float>& v);
@@ -91,5 +91,19 @@ namespace sapt
       this->ready.wait(lock);
   }
 
+  size_t
+  pstats::
+  memory() const
+  {
+    size_t ret = sizeof(pstats);
+    ret += indoc.bucket_count() * sizeof(void*);
+    ret += indoc.size() * (sizeof(indoc_map_t::value_type) + 2 * sizeof(void*));
+    ret += trg.bucket_count() * sizeof(void*);
+    ret += trg.size() * (sizeof(trg_map_t::value_type) + 2 * sizeof(void*));
+    for (trg_map_t::const_iterator m = trg.begin(); m != trg.end(); ++m)
+      ret += m->second.memory();
+    return ret;
+  }
+
 } // end of namespace sapt
 
@@ -59,6 +59,10 @@ namespace sapt
 		 int const po_fwd,       // fwd phrase orientation
 		 int const po_bwd);      // bwd phrase orientation
     void wait() const;
+
+    // approximate heap footprint in bytes; only meaningful once sampling
+    // has finished
+    size_t memory() const;
   };
 
 }
@@ -0,0 +1,174 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include <boost/functional/hash.hpp>
+#include "ug_bitext_pstats_cache.h"
+
+namespace sapt
+{
+  PstatsCache::Stats::
+  Stats()
+    : hits(0), misses(0), admitted(0), rejected(0), evictions(0)
+    , entries(0), bytes(0), capacity(0), time_saved(0)
+  { }
+
+  bool
+  PstatsCache::Key::
+  operator==(Key const& other) const
+  {
+    return root == other.root && pid == other.pid && samples == other.samples;
+  }
+
+  size_t
+  PstatsCache::KeyHash::
+  operator()(Key const& k) const
+  {
+    size_t seed = 0;
+    boost::hash_combine(seed, k.root);
+    boost::hash_combine(seed, k.pid);
+    boost::hash_combine(seed, k.samples);
+    return seed;
+  }
+
+  PstatsCache::
+  PstatsCache(size_t capacity)
+    : m_capacity(capacity), m_bytes(0), m_inflation(0), m_serial(0)
+  { }
+
+  PstatsCache&
+  PstatsCache::
+  global()
+  {
+    static PstatsCache cache;
+    return cache;
+  }
+
+  void
+  PstatsCache::
+  reserve(size_t bytes)
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    if (bytes > m_capacity) m_capacity = bytes;
+  }
+
+  size_t
+  PstatsCache::
+  capacity() const
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    return m_capacity;
+  }
+
+  // CALLER MUST LOCK!
+  void
+  PstatsCache::
+  enqueue(Entry& e)
+  {
+    double priority = m_inflation + e.cost / e.bytes;
+    e.pos = m_queue.insert(std::make_pair(std::make_pair(priority, m_serial++),
+                                          e.pos->second)).first;
+  }
+
+  // CALLER MUST LOCK!
+  void
+  PstatsCache::
+  erase(map_t::iterator m)
+  {
+    m_bytes -= m->second.bytes;
+    m_queue.erase(m->second.pos);
+    m_entries.erase(m);
+  }
+
+  SPTR<pstats>
+  PstatsCache::
+  get(SPTR<void const> const& root, uint64_t pid, size_t samples)
+  {
+    Key key = { root.get(), pid, samples };
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    map_t::iterator m = m_entries.find(key);
+    if (m != m_entries.end() && m->second.root.expired())
+      { // left over from a suffix array that has since been released
+        erase(m);
+        m = m_entries.end();
+      }
+    if (m == m_entries.end())
+      {
+        ++m_stats.misses;
+        return SPTR<pstats>();
+      }
+    ++m_stats.hits;
+    m_stats.time_saved += m->second.cost;
+    // renew the entry's priority
+    queue_t::iterator old = m->second.pos;
+    enqueue(m->second);
+    m_queue.erase(old);
+    return m->second.stats;
+  }
+
+  bool
+  PstatsCache::
+  add(SPTR<void const> const& root, uint64_t pid, size_t samples,
+      SPTR<pstats> const& stats, double cost)
+  {
+    Key key = { root.get(), pid, samples };
+    size_t bytes = stats->memory() + sizeof(map_t::value_type)
+      + sizeof(queue_t::value_type) + 8 * sizeof(void*);
+    double priority;
+
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    map_t::iterator m = m_entries.find(key);
+    if (m != m_entries.end())
+      {
+        if (!m->second.root.expired()) return true;
+        erase(m);
+      }
+    priority = m_inflation + cost / bytes;
+
+    // Turn the entry away if it doesn't fit or would displace entries that
+    // are worth more.
+    size_t freed = 0;
+    queue_t::iterator q = m_queue.begin();
+    while (m_bytes - freed + bytes > m_capacity && q != m_queue.end())
+      {
+        if (q->first.first > priority) break;
+        freed += m_entries.find(q->second)->second.bytes;
+        ++q;
+      }
+    if (m_bytes - freed + bytes > m_capacity)
+      {
+        ++m_stats.rejected;
+        return false;
+      }
+
+    while (m_queue.begin() != q)
+      {
+        m_inflation = m_queue.begin()->first.first;
+        erase(m_entries.find(m_queue.begin()->second));
+        ++m_stats.evictions;
+      }
+
+    // evictions have raised the inflation value
+    priority = m_inflation + cost / bytes;
+    Entry& e = m_entries[key];
+    e.root  = root;
+    e.stats = stats;
+    e.bytes = bytes;
+    e.cost  = cost;
+    e.pos = m_queue.insert(std::make_pair(std::make_pair(priority, m_serial++),
+                                          key)).first;
+    m_bytes += bytes;
+    ++m_stats.admitted;
+    return true;
+  }
+
+  PstatsCache::Stats
+  PstatsCache::
+  stats() const
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    Stats ret = m_stats;
+    ret.entries  = m_entries.size();
+    ret.bytes    = m_bytes;
+    ret.capacity = m_capacity;
+    return ret;
+  }
+
+} // end of namespace sapt
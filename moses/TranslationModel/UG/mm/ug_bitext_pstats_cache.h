@@ -0,0 +1,107 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+// A process-wide cache of finished phrase statistics, shared by all threads
+// and bitexts and bounded in bytes rather than entries. Entries are keyed by
+// the suffix array node they were sampled from (the TSA and the phrase id)
+// and by the sample size.
+//
+// Admission and eviction follow GreedyDual-Size: an entry's priority is its
+// sampling time per byte plus an inflation value that rises to the priority
+// of each evicted entry, so that expensive, small and recently used entries
+// stay longest. A new entry is turned away if its priority is below that of
+// the entries it would displace.
+//
+// Entries only hold a weak reference to their suffix array, so a cache
+// entry never keeps a bitext alive, and a suffix array that happens to be
+// allocated where a released one used to be finds no stale entries.
+
+#include <map>
+#include <utility>
+
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include "ug_bitext_pstats.h"
+
+namespace sapt
+{
+  class PstatsCache
+  {
+  public:
+    struct Stats
+    {
+      uint64_t hits, misses;
+      uint64_t admitted, rejected, evictions;
+      size_t entries, bytes, capacity;
+      double time_saved; // seconds of sampling avoided by hits
+      Stats();
+    };
+
+  private:
+    struct Key
+    {
+      void const* root;
+      uint64_t pid;
+      size_t samples;
+      bool operator==(Key const& other) const;
+    };
+
+    struct KeyHash
+    {
+      size_t operator()(Key const& k) const;
+    };
+
+    // eviction order: (priority, serial number) -> key
+    typedef std::map<std::pair<double, uint64_t>, Key> queue_t;
+
+    struct Entry
+    {
+      boost::weak_ptr<void const> root;
+      SPTR<pstats> stats;
+      size_t bytes;
+      double cost; // seconds it took to sample stats
+      queue_t::iterator pos;
+    };
+
+    typedef boost::unordered_map<Key, Entry, KeyHash> map_t;
+
+    mutable boost::mutex m_lock;
+    size_t   m_capacity;  // in bytes
+    size_t   m_bytes;     // in use
+    double   m_inflation; // priority of the last evicted entry
+    uint64_t m_serial;
+    map_t    m_entries;
+    queue_t  m_queue;
+    Stats    m_stats;
+
+    void enqueue(Entry& e);
+    void erase(map_t::iterator m);
+
+  public:
+    PstatsCache(size_t capacity = 0);
+
+    /// the cache shared by all phrase tables; disabled until something
+    /// reserves space in it
+    static PstatsCache& global();
+
+    /// grow the capacity to at least bytes
+    void reserve(size_t bytes);
+    size_t capacity() const;
+
+    /// cached statistics for phrase pid in root, sampled with the given
+    /// sample size, or NULL
+    SPTR<pstats>
+    get(SPTR<void const> const& root, uint64_t pid, size_t samples);
+
+    /// offer finished statistics that took cost seconds to sample; returns
+    /// false if they were turned away
+    bool
+    add(SPTR<void const> const& root, uint64_t pid, size_t samples,
+        SPTR<pstats> const& stats, double cost);
+
+    Stats stats() const;
+  };
+
+} // end of namespace sapt
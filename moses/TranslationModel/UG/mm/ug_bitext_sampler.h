@@ -11,12 +11,14 @@
 
 #include "ug_bitext.h"
 #include "ug_bitext_pstats.h"
+#include "ug_bitext_pstats_cache.h"
 #include "ug_sampling_bias.h"
 #include "ug_tsa_array_entry.h"
 #include "ug_bitext_phrase_extraction_record.h"
 #include "moses/TranslationModel/UG/generic/threading/ug_ref_counter.h"
 #include "moses/TranslationModel/UG/generic/threading/ug_thread_safe_counter.h"
 #include "moses/TranslationModel/UG/generic/sorting/NBestList.h"
+#include "util/usage.hh"
 namespace sapt
 {
   
@@ -71,6 +73,8 @@ BitextSampler : public Moses::reference_counter
   boost::taus88 m_rnd;  // every job has its own pseudo random generator
   double m_bias_total;
   bool m_track_sids; // track sentence ids in stats?
+  uint64_t const m_pid; // id of the lookup phrase
+  PstatsCache* m_cache; // where to offer the finished stats, if anywhere
 
   size_t consider_sample(TokenPosition const& p);
   size_t perform_random_sampling();
@@ -92,6 +96,8 @@ public:
   ~BitextSampler();
   SPTR<pstats> stats();
   bool done() const;
+  // offer the stats to cache when sampling is done
+  void cache_in(PstatsCache* cache);
 #ifdef MMT
 #include "mmt_bitext_sampler-inc.h"
 #else
@@ -204,6 +210,8 @@ BitextSampler(SPTR<Bitext<Token> const> const& bitext,
   , m_num_occurrences(phrase.ca())
   , m_rnd(0)
   , m_track_sids(track_sids)
+  , m_pid(phrase.getPid())
+  , m_cache(NULL)
 {
   m_stats.reset(new pstats(m_track_sids));
   m_stats->raw_cnt = phrase.ca();
@@ -225,6 +233,9 @@ BitextSampler(BitextSampler const& other)
   , m_min_samples(other.m_min_samples)
   , m_num_occurrences(other.m_num_occurrences)
   , m_rnd(0)
+  , m_track_sids(other.m_track_sids)
+  , m_pid(other.m_pid)
+  , m_cache(other.m_cache)
 {
   // lock both instances
   boost::unique_lock<boost::mutex> mylock(m_lock);
@@ -356,11 +367,14 @@ operator()()
 {
   if (m_finished) return true;
   boost::unique_lock<boost::mutex> lock(m_lock);
+  double start = m_cache ? util::WallTime() : 0;
   if (m_method == full_coverage)
     perform_full_phrase_extraction(); // consider all occurrences 
   else if (m_method == random_sampling)
     perform_random_sampling();
   else UTIL_THROW2("Unsupported sampling method.");
+  if (m_cache)
+    m_cache->add(m_root, m_pid, m_samples, m_stats, util::WallTime() - start);
   m_finished = true;
   m_ready.notify_all();
   return true;
@@ -376,6 +390,14 @@ done() const
   return m_next == m_stop;
 }
 
+template<typename Token>
+void
+BitextSampler<Token>::
+cache_in(PstatsCache* cache)
+{
+  m_cache = cache;
+}
+
 template<typename Token>
 SPTR<pstats> 
 BitextSampler<Token>::
@@ -30,6 +30,20 @@ namespace sapt
 	std::vector<std::string> const& s2,
 	std::vector<std::string> const& a) const;
 
+    /// a new bitext with the sentence pairs of all /parts/, in order, which
+    /// must use the same vocabularies; the suffix arrays are built once for
+    /// all of them
+    static SPTR<imBitext<TKN> >
+    merge(std::vector<Bitext<TKN> const*> const& parts,
+          size_t max_sample = 5000, size_t num_workers = 4,
+          size_t threads = 0);
+
+    /// write the corpus tracks and suffix arrays to the files that open()
+    /// maps (base+L1+".mct", base+L1+"-"+L2+".mam", base+L1+".sfa", ...);
+    /// the vocabularies are not written
+    void save(std::string const base, std::string const L1,
+              std::string const L2) const;
+
   };
 
   template<typename TKN>
@@ -103,6 +117,50 @@ namespace sapt
     throw "Not yet implemented";
   }
 
+  template<typename TKN>
+  SPTR<imBitext<TKN> >
+  imBitext<TKN>::
+  merge(std::vector<Bitext<TKN> const*> const& parts,
+        size_t max_sample, size_t num_workers, size_t threads)
+  {
+    UTIL_THROW_IF2(parts.empty(), "Nothing to merge.");
+    std::vector<Ttrack<char> const*> tx;
+    std::vector<Ttrack<TKN> const*> t1, t2;
+    BOOST_FOREACH(Bitext<TKN> const* b, parts)
+      {
+        tx.push_back(b->Tx.get());
+        t1.push_back(b->T1.get());
+        t2.push_back(b->T2.get());
+      }
+    SPTR<imBitext<TKN> > ret;
+    ret.reset(new imBitext<TKN>(parts.front()->V1, parts.front()->V2,
+                                max_sample, num_workers));
+    ret->myTx = concatenate<char>(tx);
+    ret->myT1 = concatenate<TKN>(t1);
+    ret->myT2 = concatenate<TKN>(t2);
+    ret->myI1.reset(new imTSA<TKN>(ret->myT1, NULL, NULL, threads));
+    ret->myI2.reset(new imTSA<TKN>(ret->myT2, NULL, NULL, threads));
+    ret->Tx = ret->myTx;
+    ret->T1 = ret->myT1;
+    ret->T2 = ret->myT2;
+    ret->I1 = ret->myI1;
+    ret->I2 = ret->myI2;
+    return ret;
+  }
+
+  template<typename TKN>
+  void
+  imBitext<TKN>::
+  save(std::string const base, std::string const L1, std::string const L2) const
+  {
+    UTIL_THROW_IF2(!myI1 || !myI2, "Can't save an empty bitext.");
+    save_as_mm_ttrack(*this->T1, base+L1+".mct");
+    save_as_mm_ttrack(*this->T2, base+L2+".mct");
+    save_as_mm_ttrack(*this->Tx, base+L1+"-"+L2+".mam");
+    myI1->save_as_mm_tsa(base+L1+".sfa");
+    myI2->save_as_mm_tsa(base+L2+".sfa");
+  }
+
   // What's up with this function???? UG
   template<typename TKN>
   void
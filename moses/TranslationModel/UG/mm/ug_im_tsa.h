@@ -3,9 +3,6 @@
 #ifndef _ug_im_tsa_h
 #define _ug_im_tsa_h
 
-// TO DO:
-// - multi-threaded sorting during TSA construction (currently painfully slow!)
-
 #include <iostream>
 
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -17,6 +14,7 @@
 #include "tpt_tightindex.h"
 #include "tpt_tokenindex.h"
 #include "ug_tsa_base.h"
+#include "ug_tsa_sorter.h"
 #include "tpt_pickler.h"
 
 #include "moses/TranslationModel/UG/generic/threading/ug_thread_pool.h"
@@ -26,32 +24,6 @@ namespace sapt
 {
   namespace bio=boost::iostreams;
 
-  template<typename TOKEN, typename SORTER>
-  class TsaSorter
-  {
-  public:
-    typedef typename Ttrack<TOKEN>::Position cpos;
-    typedef typename std::vector<cpos>::iterator iter;
-  private:
-    SORTER m_sorter;
-    iter m_begin;
-    iter m_end;
-  public:
-    TsaSorter(SORTER sorter, iter& begin, iter& end)
-      : m_sorter(sorter),
-        m_begin(begin),
-        m_end(end) { }
-    
-    bool 
-    operator()()
-    {
-      std::sort(m_begin, m_end, m_sorter);
-      return true;
-    }
-    
-  };
-
-
  //-----------------------------------------------------------------------
   template<typename TOKEN>
   class imTSA : public TSA<TOKEN>
@@ -184,8 +156,8 @@ namespace sapt
     // They allows us to
     //    a. allocate the exact amount of memory we need
     //    b. place tokens into the right 'section' in the array, based on
-    //       the ID of the first token in the sequence. We can then sort
-    //       each section separately.
+    //       the ID of the first token in the sequence. TsaSorter then
+    //       refines the sections in parallel.
 
     if (log) *log << "counting tokens ... ";
     int slimit = 65536;
@@ -195,69 +167,34 @@ namespace sapt
     // even make a difference.
 
     std::vector<count_type> wcnt; // word counts
-    sufa.resize(c->count_tokens(wcnt,filter,slimit,log));
+    // sufa is only allocated once sorting is done, to keep the peak
+    // memory use down
+    count_type numTokens = c->count_tokens(wcnt,filter,slimit,log);
 
-    if (log) *log << sufa.size() << "." << std::endl;
-    // exit(1);
-    // we use a second std::vector that keeps track for each ID of the current insertion
-    // position in the array
-    std::vector<count_type> tmp(wcnt.size(),0);
-    for (size_t i = 1; i < wcnt.size(); ++i)
-      tmp[i] = tmp[i-1] + wcnt[i-1];
-
-    // Now dump all token positions into the right place in sufa
-    this->corpusSize = 0;
-    for (id_type sid = filter->find_first();
-	 sid < filter->size();
-	 sid = filter->find_next(sid))
-      {
-	TOKEN const* k = c->sntStart(sid);
-	TOKEN const* const stop = c->sntEnd(sid);
-	if (stop - k >= slimit) continue;
-        this->corpusSize++;
-	for (ushort p=0; k < stop; ++p,++k)
-	  {
-	    id_type wid = k->id();
-            cpos& cpos = sufa[tmp[wid]++];
-            cpos.sid    = sid;
-            cpos.offset = p;
-            assert(p < c->sntLen(sid));
-	  }
-      }
+    if (log) *log << numTokens << "." << std::endl;
 
     // Now sort the array
     if (log) *log << "sorting .... with " << threads << " threads." << std::endl;
 #ifndef NO_MOSES
     double start_time = util::WallTime();
 #endif
-    boost::scoped_ptr<ug::ThreadPool> tpool;
-    tpool.reset(new ug::ThreadPool(threads));
-    
-    index.resize(wcnt.size()+1,0);
-    typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
-    sorter_t sorter(c.get());
-    for (size_t i = 0; i < wcnt.size(); i++)
-      {
-        // if (log && wcnt[i] > 5000)
-        //   *log << "sorting " << wcnt[i]
-        //        << " entries starting with id " << i << "." << std::endl;
-        index[i+1] = index[i]+wcnt[i];
-        assert(index[i+1]==tmp[i]); // sanity check
-        if (wcnt[i]>1)
-	  {
-	    typename std::vector<cpos>::iterator b,e;
-	    b = sufa.begin()+index[i];
-	    e = sufa.begin()+index[i+1];
-	    TsaSorter<TOKEN,sorter_t> foo(sorter,b,e);
-	    tpool->add(foo);
-	    // sort(sufa.begin()+index[i],sufa.begin()+index[i+1],sorter);
-	  }
-      }
-    tpool.reset();
+    TsaSorter<TOKEN> sorter(*c, *filter, slimit, threads, log);
+    sorter.sort(wcnt, sufa);
 #ifndef NO_MOSES
     if (log) *log << "Done sorting after " << util::WallTime() - start_time
 		  << " seconds." << std::endl;
 #endif
+
+    this->corpusSize = 0;
+    for (id_type sid = filter->find_first();
+	 sid < filter->size();
+	 sid = filter->find_next(sid))
+      if (c->sntLen(sid) < size_t(slimit)) this->corpusSize++;
+
+    index.resize(wcnt.size()+1,0);
+    for (size_t i = 0; i < wcnt.size(); i++)
+      index[i+1] = index[i]+wcnt[i];
+
     this->startArray = reinterpret_cast<char const*>(&(*sufa.begin()));
     this->endArray   = reinterpret_cast<char const*>(&(*sufa.end()));
     this->numTokens  = sufa.size();
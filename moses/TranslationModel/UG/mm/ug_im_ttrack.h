@@ -222,5 +222,25 @@ namespace sapt
     return ret;
   }
 
+  /// a new track with the sentences of all /parts/, in order
+  template<typename TOKEN>
+  boost::shared_ptr<imTtrack<TOKEN> >
+  concatenate(std::vector<Ttrack<TOKEN> const*> const& parts)
+  {
+    typedef std::vector<std::vector<TOKEN> > data_t;
+    boost::shared_ptr<data_t> d(new data_t());
+    size_t total = 0;
+    BOOST_FOREACH(Ttrack<TOKEN> const* t, parts)
+      if (t) total += t->size();
+    d->reserve(total);
+    BOOST_FOREACH(Ttrack<TOKEN> const* t, parts)
+      {
+        if (!t) continue;
+        for (size_t sid = 0; sid < t->size(); ++sid)
+          d->push_back(std::vector<TOKEN>(t->sntStart(sid), t->sntEnd(sid)));
+      }
+    return boost::shared_ptr<imTtrack<TOKEN> >(new imTtrack<TOKEN>(d));
+  }
+
 }
 #endif
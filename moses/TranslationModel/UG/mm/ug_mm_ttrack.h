@@ -9,9 +9,11 @@
 #ifndef __ug_mm_ttrack
 #define __ug_mm_ttrack
 
+#include <fstream>
 #include <sstream>
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 #include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/shared_ptr.hpp>
@@ -23,6 +25,7 @@
 #include "num_read_write.h"
 #include "ug_load_primer.h"
 #include "ug_tsa_base.h"
+#include "util/exception.hh"
 
 namespace sapt
 {
@@ -250,5 +253,28 @@ namespace sapt
     return z-a;
   }
 
+  /// write the sentences of /t/ to /fname/ as an mmTtrack file
+  template<typename TKN>
+  void
+  save_as_mm_ttrack(Ttrack<TKN> const& t, std::string const& fname)
+  {
+    std::ofstream out(fname.c_str());
+    mmTtrack<TKN> dummy;
+    dummy.write_blank_file_header(out);
+    std::vector<id_type> idx;
+    idx.reserve(t.size() + 1);
+    idx.push_back(0);
+    for (size_t sid = 0; sid < t.size(); ++sid)
+      {
+        size_t len = t.sntLen(sid);
+        if (len) out.write(reinterpret_cast<char const*>(t.sntStart(sid)),
+                           len * sizeof(TKN));
+        idx.push_back(idx.back() + len);
+      }
+    dummy.write_index_and_finalize(out, idx, idx.back());
+    out.close();
+    UTIL_THROW_IF2(!out, "Error writing '" << fname << "'.");
+  }
+
 }
 #endif
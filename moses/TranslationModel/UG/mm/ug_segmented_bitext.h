@@ -0,0 +1,604 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+
+// A dynamic bitext kept as a log of immutable segments, oldest first. add() indexes new sentence pairs as a segment of their own instead
+// of re-indexing everything added so far. Whenever the newest segments
+// together have grown at least as large as the one before them, they are
+// merged into one; merges beyond a size limit run on a background thread
+// while queries carry on with the unmerged segments. There are thus
+// O(log n) segments, and each sentence pair is re-indexed O(log n) times.
+// Optionally, merged segments above a size limit are written to disk in the
+// format of mtt-build and mapped back in, so that the bulk of the dynamic
+// bitext doesn't live on the heap.
+//
+// Queries take a snapshot of the segment list with segments() and look up
+// phrases in each segment; a snapshot never changes. Feature functions that
+// need corpus-wide statistics get a BitextChain of the snapshot.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "ug_im_bitext.h"
+
+namespace sapt
+{
+  // A segment of a SegmentedBitext that has been written to disk and is
+  // mapped from there. It shares the vocabularies of the dynamic bitext.
+  template<typename TKN>
+  class mmSegment : public Bitext<TKN>
+  {
+  public:
+    mmSegment(SPTR<TokenIndex> const& V1, SPTR<TokenIndex> const& V2,
+              size_t max_sample, size_t num_workers);
+    void open(std::string const base, std::string const L1, std::string L2);
+  };
+
+  template<typename TKN>
+  mmSegment<TKN>::
+  mmSegment(SPTR<TokenIndex> const& V1, SPTR<TokenIndex> const& V2,
+            size_t max_sample, size_t num_workers)
+    : Bitext<TKN>(new mmTtrack<TKN>(), new mmTtrack<TKN>(), new mmTtrack<char>(),
+                  NULL, NULL, new mmTSA<TKN>(), new mmTSA<TKN>(),
+                  max_sample, num_workers)
+  {
+    this->V1 = V1;
+    this->V2 = V2;
+  }
+
+  template<typename TKN>
+  void
+  mmSegment<TKN>::
+  open(std::string const base, std::string const L1, std::string L2)
+  {
+    mmTtrack<TKN>&  t1 = *reinterpret_cast<mmTtrack<TKN>*>(this->T1.get());
+    mmTtrack<TKN>&  t2 = *reinterpret_cast<mmTtrack<TKN>*>(this->T2.get());
+    mmTtrack<char>& tx = *reinterpret_cast<mmTtrack<char>*>(this->Tx.get());
+    t1.open(base+L1+".mct");
+    t2.open(base+L2+".mct");
+    tx.open(base+L1+"-"+L2+".mam");
+    mmTSA<TKN>& i1 = *reinterpret_cast<mmTSA<TKN>*>(this->I1.get());
+    mmTSA<TKN>& i2 = *reinterpret_cast<mmTSA<TKN>*>(this->I2.get());
+    i1.open(base+L1+".sfa", this->T1);
+    i2.open(base+L2+".sfa", this->T2);
+    assert(this->T1->size() == this->T2->size());
+  }
+
+  // The sentences of several tracks, one after the other, as one track.
+  // Nothing is copied.
+  template<typename TKN>
+  class TtrackChain : public Ttrack<TKN>
+  {
+    std::vector<SPTR<Ttrack<TKN> const> > m_parts;
+    std::vector<size_t> m_start; // first sentence of each part, and the end
+    size_t m_num_tokens;
+
+    size_t
+    part(size_t sid) const
+    {
+      return (std::upper_bound(m_start.begin(), m_start.end(), sid)
+              - m_start.begin() - 1);
+    }
+
+  public:
+    TtrackChain() : m_start(1, 0), m_num_tokens(0) { }
+
+    void
+    append(SPTR<Ttrack<TKN> const> const& t)
+    {
+      if (!t || !t->size()) return;
+      m_parts.push_back(t);
+      m_start.push_back(m_start.back() + t->size());
+      m_num_tokens += t->numTokens();
+    }
+
+    TKN const*
+    sntStart(size_t sid) const
+    {
+      size_t p = part(sid);
+      return m_parts[p]->sntStart(sid - m_start[p]);
+    }
+
+    TKN const*
+    sntEnd(size_t sid) const
+    {
+      size_t p = part(sid);
+      return m_parts[p]->sntEnd(sid - m_start[p]);
+    }
+
+    size_t size() const { return m_start.back(); }
+    size_t numTokens() const { return m_num_tokens; }
+
+    id_type
+    findSid(TKN const* t) const
+    {
+      for (size_t p = 0; p < m_parts.size(); ++p)
+        {
+          id_type sid = m_parts[p]->findSid(t);
+          if (sid < m_parts[p]->size() && m_parts[p]->sntStart(sid) <= t
+              && t < m_parts[p]->sntEnd(sid))
+            return m_start[p] + sid;
+        }
+      return size();
+    }
+  };
+
+  // A list of segments as one bitext, for feature functions that need
+  // corpus-wide statistics such as the token counts. It has no suffix
+  // arrays, so it can't be searched.
+  template<typename TKN>
+  class BitextChain : public Bitext<TKN>
+  {
+    template<typename T>
+    static TtrackChain<T>*
+    chain(std::vector<SPTR<Bitext<TKN> > > const& segs,
+          SPTR<Ttrack<T> > Bitext<TKN>::* track)
+    {
+      TtrackChain<T>* ret = new TtrackChain<T>();
+      for (size_t i = 0; i < segs.size(); ++i)
+        ret->append((*segs[i]).*track);
+      return ret;
+    }
+
+  public:
+    BitextChain(std::vector<SPTR<Bitext<TKN> > > const& segs,
+                SPTR<TokenIndex> const& V1, SPTR<TokenIndex> const& V2)
+      : Bitext<TKN>(chain(segs, &Bitext<TKN>::T1), chain(segs, &Bitext<TKN>::T2),
+                    chain(segs, &Bitext<TKN>::Tx), NULL, NULL, NULL, NULL)
+    {
+      this->V1 = V1;
+      this->V2 = V2;
+    }
+
+    void
+    open(std::string const base, std::string const L1, std::string const L2)
+    {
+      UTIL_THROW2("A BitextChain can't be opened.");
+    }
+  };
+
+  template<typename TKN>
+  class SegmentedBitext
+  {
+  public:
+    typedef Bitext<TKN> segment_t;
+    typedef std::vector<SPTR<segment_t> > segments_t;
+
+  private:
+    SPTR<TokenIndex> m_V1, m_V2;
+    size_t m_max_sample, m_num_workers;
+    size_t m_sync_limit; // merges of up to this many sentence pairs are done
+                         // in add() itself
+    std::string m_spill_dir; // where to write large merged segments, if set
+    size_t m_spill_limit;    // ... of at least this many sentence pairs
+
+    boost::mutex m_add_lock;     // one add() at a time
+    mutable boost::mutex m_lock; // guards the members below
+    SPTR<segments_t const> m_segments;
+    SPTR<Bitext<TKN> const> m_chain; // of m_segments
+    size_t m_revision;
+    size_t m_merging; // number of leading segments being merged in the
+                      // background, if any
+    boost::scoped_ptr<boost::thread> m_merger;
+    std::exception_ptr m_error; // from a failed background merge
+
+    static size_t size(segment_t const& s) { return s.T1 ? s.T1->size() : 0; }
+
+    // sets m_segments and m_chain; m_lock must be held
+    void set_segments(SPTR<segments_t const> const& segs);
+
+    size_t merge_start(segments_t const& segs, size_t floor) const;
+
+    void install(segments_t const& segs, size_t first, size_t count,
+                 SPTR<segment_t> const& merged, bool background);
+
+    // a background merge failed; its segments stay as they are
+    void fail(std::exception_ptr const& e);
+
+    // rethrows the error of a failed background merge, if any
+    void check();
+
+    // merges segments [first, first + count) of segs into one
+    SPTR<segment_t>
+    merge(segments_t const& segs, size_t first, size_t count) const;
+
+    // writes seg to a fresh directory in m_spill_dir and maps it back in
+    SPTR<segment_t> spill(imBitext<TKN> const& seg) const;
+
+    class Merger
+    {
+      SegmentedBitext* m_bitext;
+      SPTR<segments_t const> m_segments;
+      size_t m_first, m_count;
+    public:
+      Merger(SegmentedBitext* b, SPTR<segments_t const> const& segs,
+             size_t first, size_t count)
+        : m_bitext(b), m_segments(segs), m_first(first), m_count(count) { }
+
+      void
+      operator()()
+      {
+        try
+          {
+            SPTR<segment_t> merged
+              = m_bitext->merge(*m_segments, m_first, m_count);
+            m_bitext->install(*m_segments, m_first, m_count, merged, true);
+          }
+        catch (...)
+          {
+            m_bitext->fail(std::current_exception());
+          }
+      }
+    };
+
+  public:
+    SegmentedBitext(SPTR<TokenIndex> const& V1, SPTR<TokenIndex> const& V2,
+                    size_t max_sample = 5000, size_t num_workers = 4,
+                    size_t sync_limit = 10000);
+    ~SegmentedBitext();
+
+    /// write merged segments of at least min_size sentence pairs to
+    /// directory dir and map them from there; an empty dir turns this off.
+    /// Not to be called while add() or a background merge is running.
+    /// The files are unlinked once they are mapped.
+    void spill_to(std::string const& dir, size_t min_size);
+
+    /// add sentence pairs (one per line; alignments in symal format);
+    /// if a background merge has failed since the last add() or wait(),
+    /// rethrows its error instead
+    void add(std::vector<std::string> const& s1,
+             std::vector<std::string> const& s2,
+             std::vector<std::string> const& aln);
+
+    /// the current segments, oldest first, their revision and all of them
+    /// as one bitext for corpus-wide statistics; there is at least one
+    SPTR<segments_t const>
+    segments(size_t* revision = NULL,
+             SPTR<Bitext<TKN> const>* chain = NULL) const;
+
+    /// changes whenever sentence pairs are added, but not on merges
+    size_t revision() const;
+
+    /// number of sentence pairs in all segments
+    size_t size() const;
+
+    /// wait for a background merge to finish; rethrows its error if it
+    /// failed
+    void wait();
+
+    /// occurrences of the phrase [start, start + len) of L1 (or L2, if
+    /// L2 is set) in all of segs
+    static size_t
+    count(segments_t const& segs, TKN const* start, size_t len, bool L2);
+
+    /// pool the phrase pairs of a source phrase found in several segments:
+    /// m[k] is the source phrase in segs[k] (NULL if not found) and
+    /// stats[k] the result of its lookup. Phrase pairs with the same target
+    /// phrase are merged and sorted by target phrase; source and target
+    /// phrase counts are totals over all segments.
+    static void
+    pool(segments_t const& segs,
+         std::vector<SPTR<typename TSA<TKN>::tree_iterator> > const& m,
+         std::vector<SPTR<pstats> > const& stats,
+         std::vector<PhrasePair<TKN> >& dest, std::ostream* log = NULL);
+  };
+
+  template<typename TKN>
+  SegmentedBitext<TKN>::
+  SegmentedBitext(SPTR<TokenIndex> const& V1, SPTR<TokenIndex> const& V2,
+                  size_t max_sample, size_t num_workers, size_t sync_limit)
+    : m_V1(V1), m_V2(V2)
+    , m_max_sample(max_sample), m_num_workers(num_workers)
+    , m_sync_limit(sync_limit), m_spill_limit(0)
+    , m_revision(0), m_merging(0)
+  {
+    // Until something is added, there's one empty segment, so that there's
+    // always a bitext to ask for corpus statistics.
+    SPTR<segment_t> empty(new imBitext<TKN>(V1, V2, max_sample, num_workers));
+    set_segments(SPTR<segments_t const>(new segments_t(1, empty)));
+  }
+
+  template<typename TKN>
+  SegmentedBitext<TKN>::
+  ~SegmentedBitext()
+  {
+    if (m_merger) m_merger->join();
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  spill_to(std::string const& dir, size_t min_size)
+  {
+    m_spill_dir = dir;
+    m_spill_limit = min_size;
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  wait()
+  {
+    if (m_merger) m_merger->join();
+    check();
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  fail(std::exception_ptr const& e)
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    m_merging = 0;
+    if (!m_error) m_error = e;
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  check()
+  {
+    std::exception_ptr e;
+    {
+      boost::lock_guard<boost::mutex> guard(m_lock);
+      std::swap(e, m_error);
+    }
+    if (e) std::rethrow_exception(e);
+  }
+
+  template<typename TKN>
+  SPTR<typename SegmentedBitext<TKN>::segments_t const>
+  SegmentedBitext<TKN>::
+  segments(size_t* revision, SPTR<Bitext<TKN> const>* chain) const
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    if (revision) *revision = m_revision;
+    if (chain) *chain = m_chain;
+    return m_segments;
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  set_segments(SPTR<segments_t const> const& segs)
+  {
+    m_segments = segs;
+    m_chain.reset(new BitextChain<TKN>(*segs, m_V1, m_V2));
+  }
+
+  template<typename TKN>
+  size_t
+  SegmentedBitext<TKN>::
+  revision() const
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    return m_revision;
+  }
+
+  template<typename TKN>
+  size_t
+  SegmentedBitext<TKN>::
+  size() const
+  {
+    SPTR<segments_t const> segs = segments();
+    size_t ret = 0;
+    BOOST_FOREACH(SPTR<segment_t> const& s, *segs)
+      ret += size(*s);
+    return ret;
+  }
+
+  template<typename TKN>
+  size_t
+  SegmentedBitext<TKN>::
+  count(segments_t const& segs, TKN const* start, size_t len, bool L2)
+  {
+    size_t ret = 0;
+    BOOST_FOREACH(SPTR<segment_t> const& s, segs)
+      {
+        TSA<TKN> const* I = (L2 ? s->I2 : s->I1).get();
+        if (!I) continue;
+        typename TSA<TKN>::tree_iterator m(I, start, len);
+        if (m.size() == len) ret += m.approxOccurrenceCount();
+      }
+    return ret;
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  pool(segments_t const& segs,
+       std::vector<SPTR<typename TSA<TKN>::tree_iterator> > const& m,
+       std::vector<SPTR<pstats> > const& stats,
+       std::vector<PhrasePair<TKN> >& dest, std::ostream* log)
+  {
+    // Each segment's phrase pairs only know the counts in that segment.
+    uint32_t raw1 = 0, sample1 = 0, good1 = 0;
+    dest.clear();
+    for (size_t k = 0; k < segs.size(); ++k)
+      {
+        if (!m[k]) continue;
+        raw1    += stats[k]->raw_cnt;
+        sample1 += stats[k]->sample_cnt;
+        good1   += stats[k]->good;
+        expand(*m[k], *segs[k], *stats[k], dest, log);
+      }
+
+    typename PhrasePair<TKN>::SortByTargetIdSeq sorter;
+    std::sort(dest.begin(), dest.end(), sorter);
+    size_t n = 0;
+    for (size_t i = 0; i < dest.size(); ++i)
+      {
+        if (n && sorter.cmp(dest[n-1], dest[i]) == 0)
+          {
+            dest[n-1] += dest[i];
+            continue;
+          }
+        if (n != i) dest[n] = dest[i];
+        ++n;
+      }
+    dest.resize(n);
+
+    BOOST_FOREACH(PhrasePair<TKN>& pp, dest)
+      {
+        pp.raw1    = raw1;
+        pp.sample1 = sample1;
+        pp.good1   = good1;
+        if (segs.size() > 1)
+          pp.raw2 = count(segs, pp.start2, pp.len2, true);
+      }
+  }
+
+  // The run of newest segments that is due for merging starts where a
+  // segment is larger than all newer ones together; returns segs.size() - 1
+  // or more if there's nothing to merge. Segments before floor are off
+  // limits.
+  template<typename TKN>
+  size_t
+  SegmentedBitext<TKN>::
+  merge_start(segments_t const& segs, size_t floor) const
+  {
+    if (segs.size() < floor + 2) return segs.size();
+    size_t first = segs.size() - 1;
+    size_t total = size(*segs[first]);
+    while (first > floor && size(*segs[first-1]) <= total)
+      total += size(*segs[--first]);
+    return first;
+  }
+
+  template<typename TKN>
+  SPTR<typename SegmentedBitext<TKN>::segment_t>
+  SegmentedBitext<TKN>::
+  merge(segments_t const& segs, size_t first, size_t count) const
+  {
+    // all in one go, so that each sentence pair is copied and each suffix
+    // array is built only once
+    std::vector<Bitext<TKN> const*> parts;
+    for (size_t i = first; i < first + count; ++i)
+      parts.push_back(segs[i].get());
+    SPTR<imBitext<TKN> > ret
+      = imBitext<TKN>::merge(parts, m_max_sample, m_num_workers);
+    if (m_spill_dir.empty() || size(*ret) < m_spill_limit) return ret;
+    return spill(*ret);
+  }
+
+  template<typename TKN>
+  SPTR<typename SegmentedBitext<TKN>::segment_t>
+  SegmentedBitext<TKN>::
+  spill(imBitext<TKN> const& seg) const
+  {
+    std::string tmpl = m_spill_dir + "/sapt-XXXXXX";
+    std::vector<char> dir(tmpl.begin(), tmpl.end());
+    dir.push_back(0);
+    UTIL_THROW_IF2(!mkdtemp(&dir[0]), "Can't create a directory in '"
+                   << m_spill_dir << "': " << strerror(errno));
+    std::string base = std::string(&dir[0]) + "/";
+    char const* files[] = { "1.mct", "2.mct", "1-2.mam", "1.sfa", "2.sfa" };
+
+    SPTR<mmSegment<TKN> > ret;
+    try
+      {
+        seg.save(base, "1", "2");
+        ret.reset(new mmSegment<TKN>(m_V1, m_V2, m_max_sample,
+                                     m_num_workers));
+        ret->open(base, "1", "2");
+      }
+    catch (...)
+      {
+        for (size_t i = 0; i < 5; ++i) std::remove((base + files[i]).c_str());
+        rmdir(&dir[0]);
+        throw;
+      }
+    // the mappings keep the data around
+    for (size_t i = 0; i < 5; ++i) std::remove((base + files[i]).c_str());
+    rmdir(&dir[0]);
+    return ret;
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  install(segments_t const& segs, size_t first, size_t count,
+          SPTR<segment_t> const& merged, bool background)
+  {
+    boost::lock_guard<boost::mutex> guard(m_lock);
+    // Concurrent merges work on disjoint runs of segments, but one may
+    // have shifted the other's run.
+    segments_t const& cur = *m_segments;
+    size_t at = std::find(cur.begin(), cur.end(), segs[first]) - cur.begin();
+    UTIL_THROW_IF2(at + count > cur.size() ||
+                   !std::equal(segs.begin() + first,
+                               segs.begin() + first + count,
+                               cur.begin() + at),
+                   "Segments to be merged have disappeared.");
+    SPTR<segments_t> ret(new segments_t(cur.begin(), cur.begin() + at));
+    ret->push_back(merged);
+    ret->insert(ret->end(), cur.begin() + at + count, cur.end());
+    set_segments(ret);
+    if (background) m_merging = 0;
+  }
+
+  template<typename TKN>
+  void
+  SegmentedBitext<TKN>::
+  add(std::vector<std::string> const& s1,
+      std::vector<std::string> const& s2,
+      std::vector<std::string> const& aln)
+  {
+    boost::lock_guard<boost::mutex> add_guard(m_add_lock);
+    check();
+    imBitext<TKN> empty(m_V1, m_V2, m_max_sample, m_num_workers);
+    SPTR<segment_t> seg = empty.add(s1, s2, aln);
+
+    SPTR<segments_t const> segs;
+    size_t floor;
+    {
+      boost::lock_guard<boost::mutex> guard(m_lock);
+      SPTR<segments_t> foo(new segments_t(*m_segments));
+      if (foo->size() == 1 && size(*foo->front()) == 0) foo->clear();
+      foo->push_back(seg);
+      set_segments(segs = foo);
+      ++m_revision;
+      floor = m_merging;
+    }
+
+    // A background merge only touches segments before floor.
+    size_t first = merge_start(*segs, floor);
+    if (first + 1 >= segs->size()) return;
+    size_t count = segs->size() - first;
+    size_t total = 0;
+    for (size_t i = first; i < segs->size(); ++i)
+      total += size(*(*segs)[i]);
+    if (total > m_sync_limit && floor)
+      {
+        // The background thread is busy; keep the newest segments from
+        // piling up meanwhile by merging as many of them as is cheap.
+        while (total > m_sync_limit && first + 1 < segs->size())
+          total -= size(*(*segs)[first++]);
+        count = segs->size() - first;
+        if (count < 2) return;
+      }
+    if (total <= m_sync_limit)
+      install(*segs, first, count, merge(*segs, first, count), false);
+    else
+      {
+        // for the thread of the previous merge, which has finished; if it
+        // failed, the next add() or wait() will say so
+        if (m_merger) m_merger->join();
+        {
+          boost::lock_guard<boost::mutex> guard(m_lock);
+          m_merging = first + count;
+        }
+        m_merger.reset(new boost::thread(Merger(this, segs, first, count)));
+      }
+  }
+
+} // end of namespace sapt
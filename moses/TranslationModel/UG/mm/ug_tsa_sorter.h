@@ -0,0 +1,403 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#ifndef _ug_tsa_sorter_h
+#define _ug_tsa_sorter_h
+
+// Suffix sorting for imTSA construction by prefix doubling over token ids.
+//
+// The positions of all tokens are first bucketed by token id, as before.
+// Each round then refines the groups of positions that still share their
+// first h tokens by the rank of the position h tokens further on, so that
+// afterwards they are sorted by their first 2h tokens. Suffixes end at the
+// end of their sentence; a shorter suffix sorts before its extensions, as
+// in ttrack::Position::LESS. Since sentences are shorter than 65536
+// tokens, at most 16 rounds are needed.
+//
+// Work within a round is split across threads by group. Apart from the
+// result, memory use is three (four, if next() is not monotonic, as for
+// dependency chains) 32 bit numbers per token. Identical suffixes end up in
+// corpus order, so the result is deterministic.
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "ug_tsa_base.h"
+#include "ug_typedefs.h"
+
+#include "moses/TranslationModel/UG/generic/threading/ug_thread_pool.h"
+#include "util/exception.hh"
+
+namespace sapt
+{
+  template<typename TOKEN>
+  class TsaSorter
+  {
+  public:
+    typedef typename Ttrack<TOKEN>::Position cpos;
+
+    /// sentences not in filter and sentences of slimit or more tokens are
+    /// skipped, as in Ttrack::count_tokens()
+    TsaSorter(Ttrack<TOKEN> const& c, bdBitset const& filter, size_t slimit,
+              size_t threads, std::ostream* log = NULL);
+
+    /// sort all positions into sufa; wcnt are the token counts from
+    /// Ttrack::count_tokens()
+    void
+    sort(std::vector<count_type> const& wcnt, std::vector<cpos>& sufa);
+
+  private:
+    typedef count_type pos_t; // position index in corpus order
+    typedef std::pair<pos_t, pos_t> range_t;
+
+    // marks the first position of a group in m_sa between the two
+    // halves of a round
+    static pos_t const HEAD = pos_t(1) << 31;
+
+    // smallest amount of work (in positions) worth handing to a thread;
+    // small arrays, such as those of new sentences in a dynamic bitext, are
+    // sorted without starting any
+    static size_t const MIN_SLICE = size_t(1) << 16;
+
+    Ttrack<TOKEN> const& m_corpus;
+    bdBitset const& m_filter;
+    size_t m_slimit;
+    size_t m_threads;
+    std::ostream* m_log;
+
+    std::vector<pos_t> m_sa;   // position indices in suffix order so far
+    std::vector<pos_t> m_rank; // 1 + start of each position's group in m_sa;
+                               // m_rank[n] = 0 stands for the sentence end
+    std::vector<pos_t> m_jump; // position h tokens further on, or n
+    std::vector<pos_t> m_jump2; // scratch space for doubling m_jump
+    int m_direction;           // 1 / -1 if m_jump always moves forward /
+                               // backward, else 0
+    size_t m_maxlen;           // longest sentence
+    std::vector<range_t> m_groups; // groups in m_sa still to be refined
+    std::vector<size_t> m_cuts;    // m_groups split into jobs
+    std::vector<std::vector<range_t> > m_refined; // per job
+
+    bool
+    use(id_type sid) const
+    {
+      return m_corpus.sntLen(sid) < m_slimit;
+    }
+
+    void init(std::vector<count_type> const& wcnt);
+    void refine(size_t job, size_t first, size_t last);
+    void rerank(size_t job, size_t first, size_t last);
+    void double_jumps(size_t job, size_t first, size_t last);
+    void invert(size_t job, size_t first, size_t last);
+
+    typedef void (TsaSorter::*step_t)(size_t, size_t, size_t);
+
+    class Job
+    {
+      TsaSorter* m_sorter;
+      step_t m_step;
+      size_t m_job, m_first, m_last;
+    public:
+      Job(TsaSorter* s, step_t step, size_t job, size_t first, size_t last)
+        : m_sorter(s), m_step(step), m_job(job), m_first(first), m_last(last)
+      { }
+
+      bool
+      operator()()
+      {
+        (m_sorter->*m_step)(m_job, m_first, m_last);
+        return true;
+      }
+    };
+
+    // run step over [0,n) in equal slices, on all threads
+    void for_range(step_t step, size_t n);
+    // split m_groups into slices with about equal numbers of positions
+    void cut_groups();
+    // run step over the slices of m_groups
+    void for_groups(step_t step);
+  };
+
+  template<typename TOKEN>
+  TsaSorter<TOKEN>::
+  TsaSorter(Ttrack<TOKEN> const& c, bdBitset const& filter, size_t slimit,
+            size_t threads, std::ostream* log)
+    : m_corpus(c), m_filter(filter), m_slimit(slimit)
+    , m_threads(threads ? threads : boost::thread::hardware_concurrency())
+    , m_log(log), m_direction(0), m_maxlen(0)
+  {
+    if (m_threads == 0) m_threads = 1;
+  }
+
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  for_range(step_t step, size_t n)
+  {
+    size_t slices = std::min(n / MIN_SLICE + 1, m_threads);
+    if (slices <= 1)
+      {
+        if (n) (this->*step)(0, 0, n);
+        return;
+      }
+    boost::scoped_ptr<ug::ThreadPool> tpool(new ug::ThreadPool(m_threads));
+    for (size_t i = 0; i < slices; ++i)
+      {
+        Job job(this, step, i, n * i / slices, n * (i+1) / slices);
+        tpool->add(job);
+      }
+    tpool.reset();
+  }
+
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  cut_groups()
+  {
+    size_t total = 0;
+    BOOST_FOREACH(range_t const& g, m_groups)
+      total += g.second - g.first;
+    // several slices per thread so that one big group doesn't hold up the rest
+    size_t const slice = std::max(total / (8 * m_threads) + 1, MIN_SLICE);
+    m_cuts.assign(1, 0);
+    size_t size = 0;
+    for (size_t i = 0; i < m_groups.size(); ++i)
+      {
+        size += m_groups[i].second - m_groups[i].first;
+        if (size >= slice)
+          {
+            m_cuts.push_back(i + 1);
+            size = 0;
+          }
+      }
+    if (m_cuts.back() < m_groups.size()) m_cuts.push_back(m_groups.size());
+    m_refined.resize(m_cuts.size() - 1);
+  }
+
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  for_groups(step_t step)
+  {
+    if (m_cuts.size() <= 2)
+      {
+        if (m_cuts.size() == 2) (this->*step)(0, m_cuts[0], m_cuts[1]);
+        return;
+      }
+    boost::scoped_ptr<ug::ThreadPool> tpool(new ug::ThreadPool(m_threads));
+    for (size_t i = 0; i + 1 < m_cuts.size(); ++i)
+      {
+        Job job(this, step, i, m_cuts[i], m_cuts[i+1]);
+        tpool->add(job);
+      }
+    tpool.reset();
+  }
+
+  // Bucket the positions by their first token and link each position to
+  // the next one in its suffix.
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  init(std::vector<count_type> const& wcnt)
+  {
+    std::vector<count_type> start(wcnt.size() + 1, 0);
+    for (size_t i = 0; i < wcnt.size(); ++i)
+      start[i+1] = start[i] + wcnt[i];
+    size_t const n = start.back();
+    UTIL_THROW_IF2(n >= HEAD, "Too many tokens (" << n << ") for imTSA; "
+                   << "the limit is " << HEAD - 1 << ".");
+
+    m_sa.resize(n);
+    m_jump.resize(n + 1);
+    m_jump[n] = n;
+    bool forward = true, backward = true;
+    std::vector<count_type> tmp(start.begin(), start.end() - 1);
+    pos_t g = 0;
+    for (size_t sid = m_filter.find_first(); sid < m_filter.size();
+         sid = m_filter.find_next(sid))
+      {
+        if (!use(sid)) continue;
+        TOKEN const* const bos = m_corpus.sntStart(sid);
+        TOKEN const* const eos = m_corpus.sntEnd(sid);
+        m_maxlen = std::max(m_maxlen, size_t(eos - bos));
+        for (TOKEN const* t = bos; t < eos; ++t, ++g)
+          {
+            m_sa[tmp[t->id()]++] = g;
+            TOKEN const* x = next(t);
+            if (x >= bos && x < eos)
+              {
+                m_jump[g] = g - (t - bos) + (x - bos);
+                forward  = forward  && x > t;
+                backward = backward && x < t;
+              }
+            else m_jump[g] = n;
+          }
+      }
+    m_direction = forward ? 1 : backward ? -1 : 0;
+
+    m_rank.resize(n + 1);
+    m_rank[n] = 0;
+    m_groups.clear();
+    for (size_t i = 0; i < wcnt.size(); ++i)
+      {
+        for (size_t k = start[i]; k < start[i+1]; ++k)
+          m_rank[m_sa[k]] = start[i] + 1;
+        if (wcnt[i] > 1)
+          m_groups.push_back(range_t(start[i], start[i+1]));
+      }
+  }
+
+  // Sort each group by the rank of the positions h tokens further on and
+  // mark where the new groups start. Ranks are left alone until rerank(),
+  // so that all groups in a round see the same ranks.
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  refine(size_t job, size_t first, size_t last)
+  {
+    std::vector<range_t>& refined = m_refined[job];
+    refined.clear();
+    std::vector<std::pair<pos_t, pos_t> > keys; // rank further on, position
+    for (size_t i = first; i < last; ++i)
+      {
+        range_t const& grp = m_groups[i];
+        keys.resize(grp.second - grp.first);
+        for (size_t k = grp.first; k < grp.second; ++k)
+          {
+            pos_t g = m_sa[k];
+            keys[k - grp.first] = std::make_pair(m_rank[m_jump[g]], g);
+          }
+        std::sort(keys.begin(), keys.end());
+        // new groups of one are done, and so is a group of suffixes that
+        // all ended (key 0), which can only come first
+        size_t head = grp.first;
+        for (size_t k = grp.first; k <= grp.second; ++k)
+          {
+            if (k < grp.second && k > head
+                && keys[k - grp.first].first == keys[head - grp.first].first)
+              {
+                m_sa[k] = keys[k - grp.first].second;
+                continue;
+              }
+            if (k - head > 1 && keys[head - grp.first].first)
+              refined.push_back(range_t(head, k));
+            if (k == grp.second) break;
+            head = k;
+            m_sa[k] = keys[k - grp.first].second | HEAD;
+          }
+      }
+  }
+
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  rerank(size_t job, size_t first, size_t last)
+  {
+    for (size_t i = first; i < last; ++i)
+      {
+        range_t const& grp = m_groups[i];
+        pos_t rank = 0;
+        for (size_t k = grp.first; k < grp.second; ++k)
+          {
+            if (m_sa[k] & HEAD)
+              {
+                m_sa[k] &= ~HEAD;
+                rank = k + 1;
+              }
+            m_rank[m_sa[k]] = rank;
+          }
+      }
+  }
+
+  // out of place; only used when next() isn't monotonic
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  double_jumps(size_t job, size_t first, size_t last)
+  {
+    for (size_t g = first; g < last; ++g)
+      m_jump2[g] = m_jump[m_jump[g]];
+  }
+
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  invert(size_t job, size_t first, size_t last)
+  {
+    for (size_t k = first; k < last; ++k)
+      m_rank[m_sa[k]] = k;
+  }
+
+  template<typename TOKEN>
+  void
+  TsaSorter<TOKEN>::
+  sort(std::vector<count_type> const& wcnt, std::vector<cpos>& sufa)
+  {
+    init(wcnt);
+    size_t const n = m_sa.size();
+    for (size_t h = 1; h < m_maxlen && m_groups.size(); h *= 2)
+      {
+        if (m_log)
+          *m_log << "  " << m_groups.size() << " groups share their first "
+                 << h << " token(s)" << std::endl;
+        cut_groups();
+        for_groups(&TsaSorter::refine);
+        for_groups(&TsaSorter::rerank);
+
+        std::vector<range_t> groups;
+        BOOST_FOREACH(std::vector<range_t> const& r, m_refined)
+          groups.insert(groups.end(), r.begin(), r.end());
+        m_groups.swap(groups);
+        if (2 * h >= m_maxlen || m_groups.empty()) break;
+
+        // now jump 2h tokens
+        if (m_direction > 0)
+          {
+            // m_jump[g] > g: the target isn't updated yet
+            for (size_t g = 0; g < n; ++g)
+              m_jump[g] = m_jump[m_jump[g]];
+          }
+        else if (m_direction < 0)
+          {
+            for (size_t g = n; g-- > 0;)
+              m_jump[g] = m_jump[m_jump[g]];
+          }
+        else
+          {
+            m_jump2.resize(n + 1, n);
+            m_jump2[n] = n;
+            for_range(&TsaSorter::double_jumps, n);
+            m_jump.swap(m_jump2);
+          }
+      }
+    std::vector<pos_t>().swap(m_jump2);
+    std::vector<pos_t>().swap(m_jump);
+    std::vector<range_t>().swap(m_groups);
+    std::vector<std::vector<range_t> >().swap(m_refined);
+
+    // m_rank becomes the inverse of m_sa, which maps positions back to
+    // sentence ids and offsets
+    for_range(&TsaSorter::invert, n);
+    std::vector<pos_t>().swap(m_sa);
+    sufa.resize(n);
+    pos_t g = 0;
+    for (size_t sid = m_filter.find_first(); sid < m_filter.size();
+         sid = m_filter.find_next(sid))
+      {
+        if (!use(sid)) continue;
+        size_t const len = m_corpus.sntLen(sid);
+        for (size_t offset = 0; offset < len; ++offset, ++g)
+          {
+            cpos& p = sufa[m_rank[g]];
+            p.sid = sid;
+            p.offset = offset;
+          }
+      }
+    std::vector<pos_t>().swap(m_rank);
+  }
+
+} // end of namespace sapt
+#endif
@@ -8,6 +8,7 @@
 #include <boost/thread/locks.hpp>
 #include <algorithm>
 #include "util/exception.hh"
+#include "util/murmur_hash.hh"
 #include <set>
 #include "util/usage.hh"
 
@@ -70,6 +71,7 @@ namespace Moses
     , bias_key(((char*)this)+3)
     , cache_key(((char*)this)+2)
     , context_key(((char*)this)+1)
+    , m_pstats_cache(NULL)
     , m_track_coord(false)
       // , m_tpc_ctr(0)
       // , m_ifactor(1,0)
@@ -192,6 +194,13 @@ namespace Moses
     if (m_workers == 0) m_workers = StaticData::Instance().ThreadCount();
     else m_workers = min(m_workers,size_t(boost::thread::hardware_concurrency()));
     
+    // merged segments of the dynamic bitext of at least dyn-spill-size
+    // sentence pairs are written to dyn-spill-dir and mapped from there
+    dflt = pair<string,string>("dyn-spill-dir","");
+    m_dyn_spill_dir = param.insert(dflt).first->second;
+    dflt = pair<string,string>("dyn-spill-size","100000");
+    m_dyn_spill_size = atoi(param.insert(dflt).first->second.c_str());
+
     dflt = pair<string,string>("bias-loglevel","0");
     m_bias_loglevel = atoi(param.insert(dflt).first->second.c_str());
 
@@ -207,6 +216,16 @@ namespace Moses
     // this cache keeps track of the most frequently used target
     // phrase collections even when not actively in use
 
+    // size in MB of the pstats cache shared by all Mmsapt instances;
+    // 0 means that sampling results are only cached per context
+    dflt = pair<string,string>("pstats-cache","0");
+    size_t pstats_cache_mb = atoi(param.insert(dflt).first->second.c_str());
+    if (pstats_cache_mb)
+      {
+        m_pstats_cache = &sapt::PstatsCache::global();
+        m_pstats_cache->reserve(pstats_cache_mb << 20);
+      }
+
     // Feature functions are initialized  in function Load();
     param.insert(pair<string,string>("pfwd",   "g"));
     param.insert(pair<string,string>("pbwd",   "g"));
@@ -327,6 +346,8 @@ namespace Moses
     known_parameters.push_back("config");
     known_parameters.push_back("coord");
     known_parameters.push_back("cumb");
+    known_parameters.push_back("dyn-spill-dir");
+    known_parameters.push_back("dyn-spill-size");
     known_parameters.push_back("extra");
     known_parameters.push_back("feature-sets");
     known_parameters.push_back("input-factor");
@@ -344,6 +365,7 @@ namespace Moses
     known_parameters.push_back("pbwd");
     known_parameters.push_back("pfwd");
     known_parameters.push_back("prov");
+    known_parameters.push_back("pstats-cache");
     known_parameters.push_back("rare");
     known_parameters.push_back("sample");
     known_parameters.push_back("min-sample");
@@ -391,11 +413,8 @@ namespace Moses
     while(getline(in2,line)) text2.push_back(line);
     while(getline(ina,line)) symal.push_back(line);
 
-    scoped_ptr<boost::unique_lock<shared_mutex> > guard;
-    if (locking) guard.reset(new boost::unique_lock<shared_mutex>(m_lock));
-    btdyn = btdyn->add(text1,text2,symal);
-    assert(btdyn);
-    cerr << "Loaded " << btdyn->T1->size() << " sentence pairs" << endl;
+    btdyn->add(text1,text2,symal);
+    cerr << "Loaded " << btdyn->size() << " sentence pairs" << endl;
   }
 
   template<typename fftype>
@@ -538,7 +557,9 @@ namespace Moses
     btfix->open(m_bname, L1, L2);
     btfix->setDefaultSampleSize(m_default_sample_size);
 
-    btdyn.reset(new imbitext(btfix->V1, btfix->V2, m_default_sample_size, m_workers));
+    btdyn.reset(new dynbitext(btfix->V1, btfix->V2, m_default_sample_size, m_workers));
+    if (m_dyn_spill_dir.size())
+      btdyn->spill_to(m_dyn_spill_dir, m_dyn_spill_size);
     if (m_bias_file.size())
       load_bias(m_bias_file);
 
@@ -566,8 +587,7 @@ namespace Moses
     vector<string> S1(1,s1);
     vector<string> S2(1,s2);
     vector<string> ALN(1,a);
-    boost::unique_lock<boost::shared_mutex> guard(m_lock);
-    btdyn = btdyn->add(S1,S2,ALN);
+    btdyn->add(S1,S2,ALN);
   }
 
 
@@ -577,10 +597,13 @@ namespace Moses
             Phrase const& src,
             PhrasePair<Token>* fix,
             PhrasePair<Token>* dyn,
-            SPTR<Bitext<Token> > const& dynbt) const
+            dynbitext::segments_t const& dynbt,
+            bitext const& dynchain) const
   {
     UTIL_THROW_IF2(!fix && !dyn, HERE <<
                    ": Can't create target phrase from nothing.");
+    // Feature functions see all segments of the dynamic bitext as one
+    // bitext; the counts in *dyn are pooled over all segments.
     vector<float> fvals(this->m_numScoreComponents);
     PhrasePair<Token> pool = fix ? *fix : *dyn;
     if (fix)
@@ -591,19 +614,17 @@ namespace Moses
     if (dyn)
       {
         BOOST_FOREACH(SPTR<pscorer> const& ff, m_active_ff_dyn)
-          (*ff)(*dynbt, *dyn, &fvals);
+          (*ff)(dynchain, *dyn, &fvals);
       }
 
     if (fix && dyn) { pool += *dyn; }
     else if (fix)
       {
         PhrasePair<Token> zilch; zilch.init();
-        TSA<Token>::tree_iterator m(dynbt->I2.get(), fix->start2, fix->len2);
-        if (m.size() == fix->len2)
-          zilch.raw2 = m.approxOccurrenceCount();
+        zilch.raw2 = dynbitext::count(dynbt, fix->start2, fix->len2, true);
         pool += zilch;
         BOOST_FOREACH(SPTR<pscorer> const& ff, m_active_ff_dyn)
-          (*ff)(*dynbt, ff->allowPooling() ? pool : zilch, &fvals);
+          (*ff)(dynchain, ff->allowPooling() ? pool : zilch, &fvals);
       }
     else if (dyn)
       {
@@ -613,7 +634,7 @@ namespace Moses
           zilch.raw2 = m.approxOccurrenceCount();
         pool += zilch;
         BOOST_FOREACH(SPTR<pscorer> const& ff, m_active_ff_fix)
-          (*ff)(*dynbt, ff->allowPooling() ? pool : zilch, &fvals);
+          (*ff)(dynchain, ff->allowPooling() ? pool : zilch, &fvals);
       }
     if (fix)
       {
@@ -623,7 +644,7 @@ namespace Moses
     else
       {
         BOOST_FOREACH(SPTR<pscorer> const& ff, m_active_ff_common)
-          (*ff)(*dynbt, pool, &fvals);
+          (*ff)(dynchain, pool, &fvals);
       }
 
     TargetPhrase* tp = new TargetPhrase(const_cast<ttasksptr&>(ttask), this);
@@ -700,6 +721,18 @@ namespace Moses
       }
   }
   
+  void
+  Mmsapt::
+  lookup_dyn(ttasksptr const& ttask, dynbitext::segments_t const& dynbt,
+             vector<SPTR<TSA<Token>::tree_iterator> > const& mdyn,
+             vector<PhrasePair<Token> >& ppdyn) const
+  {
+    vector<SPTR<pstats> > stats(dynbt.size());
+    for (size_t k = 0; k < dynbt.size(); ++k)
+      if (mdyn[k]) stats[k] = dynbt[k]->lookup(ttask, *mdyn[k]);
+    dynbitext::pool(dynbt, mdyn, stats, ppdyn, m_bias_log);
+  }
+
   // TargetPhraseCollection::shared_ptr
   // Mmsapt::
   // GetTargetPhraseCollectionLEGACY(const Phrase& src) const
@@ -720,38 +753,46 @@ namespace Moses
     fillIdSeq(src, m_ifactor, *(btfix->V1), sphrase);
     if (sphrase.size() == 0) return ret;
     
-    // Reserve a local copy of the dynamic bitext in its current form. /btdyn/
-    // is set to a new copy of the dynamic bitext every time a sentence pair
-    // is added. /dyn/ keeps the old bitext around as long as we need it.
-    SPTR<imBitext<Token> > dyn;
-    { // braces are needed for scoping mutex lock guard!
-      boost::unique_lock<boost::shared_mutex> guard(m_lock);
-      assert(btdyn);
-      dyn = btdyn;
-    }
-    assert(dyn);
-
-    // lookup phrases in both bitexts
+    // Take a snapshot of the segments of the dynamic bitext. add() only
+    // ever replaces btdyn's list of segments, so /dyn/ keeps the segments
+    // we look at around as long as we need them.
+    size_t revision;
+    SPTR<bitext const> dynchain;
+    SPTR<dynbitext::segments_t const> dyn = btdyn->segments(&revision, &dynchain);
+
+    // lookup phrases in the static bitext and each dynamic segment
     TSA<Token>::tree_iterator mfix(btfix->I1.get(), &sphrase[0], sphrase.size());
-    TSA<Token>::tree_iterator mdyn(dyn->I1.get());
-    if (dyn->I1.get()) // we have a dynamic bitext
-      for (size_t i = 0; mdyn.size() == i && i < sphrase.size(); ++i)
-        mdyn.extend(sphrase[i]);
+    vector<SPTR<TSA<Token>::tree_iterator> > mdyn(dyn->size());
+    bool found_dyn = false;
+    for (size_t k = 0; k < dyn->size(); ++k)
+      {
+        if (!(*dyn)[k]->I1) continue;
+        SPTR<TSA<Token>::tree_iterator> m;
+        m.reset(new TSA<Token>::tree_iterator((*dyn)[k]->I1.get()));
+        for (size_t i = 0; m->size() == i && i < sphrase.size(); ++i)
+          m->extend(sphrase[i]);
+        if (m->size() != sphrase.size()) continue;
+        mdyn[k] = m;
+        found_dyn = true;
+      }
 
-    if (mdyn.size() != sphrase.size() && mfix.size() != sphrase.size())
+    if (!found_dyn && mfix.size() != sphrase.size())
       return ret; // phrase not found in either bitext
 
-    // do we have cached results for this phrase?
+    // do we have cached results for this phrase? Phrases only in the
+    // dynamic bitext have no id that is stable across segments, so we
+    // hash the id sequence.
     uint64_t phrasekey = (mfix.size() == sphrase.size()
-                          ? (mfix.getPid()<<1) 
-                          : (mdyn.getPid()<<1)+1);
+                          ? (mfix.getPid()<<1)
+                          : (util::MurmurHashNative(&sphrase[0], sphrase.size()
+                                                    * sizeof(id_type))<<1)+1);
 
     // get context-specific cache of items previously looked up
     SPTR<ContextScope> const& scope = ttask->GetScope();
     SPTR<TPCollCache> cache = scope->get<TPCollCache>(cache_key);
     if (!cache) cache = m_cache; // no context-specific cache, use global one
 
-    ret = cache->get(phrasekey, dyn->revision());
+    ret = cache->get(phrasekey, revision);
     // TO DO: we should revise the revision mechanism: we take the
     // length of the dynamic bitext (in sentences) at the time the PT
     // entry was stored as the time stamp. For each word in the
@@ -777,13 +818,18 @@ namespace Moses
     // TO DO: have Bitexts return lists of PhrasePairs instead of pstats
     // no need to expand pstats at every single lookup again, especially
     // for btfix.
-    SPTR<pstats> sfix,sdyn;
+    SPTR<pstats> sfix;
 
     if (mfix.size() == sphrase.size()) 
       {
         SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get());
         SPTR<pstats> const* foo = context->cache1->get(mfix.getPid());
-        if (foo) { sfix = *foo; sfix->wait(); }
+        bool shared = m_pstats_cache && !context->bias;
+        if (foo) sfix = *foo;
+        else if (shared)
+          sfix = m_pstats_cache->get(btfix->I1, mfix.getPid(),
+                                     m_default_sample_size);
+        if (sfix) sfix->wait();
         else 
           {
             BitextSampler<Token> s(btfix, mfix, context->bias, 
@@ -791,14 +837,12 @@ namespace Moses
                                    m_default_sample_size, 
                                    m_sampling_method,
                                    m_track_coord);
+            if (shared) s.cache_in(m_pstats_cache);
             s();
             sfix = s.stats();
           }
       }
 
-    if (mdyn.size() == sphrase.size()) 
-      sdyn = dyn->lookup(ttask, mdyn);
-
     vector<PhrasePair<Token> > ppfix,ppdyn;
     PhrasePair<Token>::SortByTargetIdSeq sort_by_tgt_id;
     if (sfix)
@@ -806,11 +850,8 @@ namespace Moses
         expand(mfix, *btfix, *sfix, ppfix, m_bias_log);
         sort(ppfix.begin(), ppfix.end(),sort_by_tgt_id);
       }
-    if (sdyn)
-      {
-        expand(mdyn, *dyn, *sdyn, ppdyn, m_bias_log);
-        sort(ppdyn.begin(), ppdyn.end(),sort_by_tgt_id);
-      }
+    if (found_dyn)
+      lookup_dyn(ttask, *dyn, mdyn, ppdyn);
 
     // now we have two lists of Phrase Pairs, let's merge them
     PhrasePair<Token>::SortByTargetIdSeq sorter;
@@ -818,12 +859,12 @@ namespace Moses
     while (i < ppfix.size() && k < ppdyn.size())
       {
         int cmp = sorter.cmp(ppfix[i], ppdyn[k]);
-        if      (cmp  < 0) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,dyn));
-        else if (cmp == 0) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],&ppdyn[k++],dyn));
-        else               ret->Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],dyn));
+        if      (cmp  < 0) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,*dyn,*dynchain));
+        else if (cmp == 0) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],&ppdyn[k++],*dyn,*dynchain));
+        else               ret->Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],*dyn,*dynchain));
       }
-    while (i < ppfix.size()) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,dyn));
-    while (k < ppdyn.size()) ret->Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],dyn));
+    while (i < ppfix.size()) ret->Add(mkTPhrase(ttask,src,&ppfix[i++],NULL,*dyn,*dynchain));
+    while (k < ppdyn.size()) ret->Add(mkTPhrase(ttask,src,NULL,&ppdyn[k++],*dyn,*dynchain));
 
     // Pruning should not be done here but outside!
     if (m_tableLimit) ret->Prune(true, m_tableLimit);
@@ -974,11 +1015,19 @@ namespace Moses
       {
         SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get(), true);
         uint64_t pid = mfix.getPid();
-        if (!context->cache1->get(pid))
+        bool shared = m_pstats_cache && !context->bias;
+        SPTR<pstats> cached;
+        if (context->cache1->get(pid))
+          ; // already sampled or being sampled for this context
+        else if (shared && (cached = m_pstats_cache->get(btfix->I1, pid,
+                                                         m_default_sample_size)))
+          context->cache1->get(pid, cached);
+        else
           {
             BitextSampler<Token> s(btfix, mfix, context->bias, 
                                    m_min_sample_size, m_default_sample_size, 
                                    m_sampling_method, m_track_coord);
+            if (shared) s.cache_in(m_pstats_cache);
             if (*context->cache1->get(pid, s.stats()) == s.stats())
               m_thread_pool->add(s);
           }
@@ -987,21 +1036,20 @@ namespace Moses
         return true;
       }
 
-    SPTR<imBitext<Token> > dyn;
-    { // braces are needed for scoping lock!
-      boost::unique_lock<boost::shared_mutex> guard(m_lock);
-      dyn = btdyn;
-    }
-    assert(dyn);
-    TSA<Token>::tree_iterator mdyn(dyn->I1.get());
-    if (dyn->I1.get())
+    SPTR<dynbitext::segments_t const> dyn = btdyn->segments();
+    bool found = false;
+    BOOST_FOREACH(SPTR<bitext> const& bt, *dyn)
       {
+        if (!bt->I1) continue;
+        TSA<Token>::tree_iterator mdyn(bt->I1.get());
         for (size_t i = 0; mdyn.size() == i && i < myphrase.size(); ++i)
           mdyn.extend(myphrase[i]);
         // let's assume a uniform bias over the foreground corpus
-        if (mdyn.size() == myphrase.size()) dyn->prep(ttask, mdyn, m_track_coord);
+        if (mdyn.size() != myphrase.size()) continue;
+        bt->prep(ttask, mdyn, m_track_coord);
+        found = true;
       }
-    return mdyn.size() == myphrase.size();
+    return found;
   }
 
 #if 0
@@ -21,7 +21,9 @@
 #include "moses/TranslationModel/UG/mm/ug_typedefs.h"
 #include "moses/TranslationModel/UG/mm/tpt_pickler.h"
 #include "moses/TranslationModel/UG/mm/ug_bitext.h"
+#include "moses/TranslationModel/UG/mm/ug_segmented_bitext.h"
 #include "moses/TranslationModel/UG/mm/ug_bitext_sampler.h"
+#include "moses/TranslationModel/UG/mm/ug_bitext_pstats_cache.h"
 #include "moses/TranslationModel/UG/mm/ug_lexical_phrase_scorer2.h"
 
 #include "moses/TranslationModel/UG/TargetPhraseCollectionCache.h"
@@ -66,13 +68,14 @@ namespace Moses
     typedef sapt::L2R_Token<sapt::SimpleWordId> Token;
     typedef sapt::mmBitext<Token> mmbitext;
     typedef sapt::imBitext<Token> imbitext;
+    typedef sapt::SegmentedBitext<Token> dynbitext;
     typedef sapt::Bitext<Token>     bitext;
     typedef sapt::TSA<Token>           tsa;
     typedef sapt::PhraseScorer<Token> pscorer;
   private:
     // vector<SPTR<bitext> > shards;
     SPTR<mmbitext> btfix;
-    SPTR<imbitext> btdyn;
+    SPTR<dynbitext> btdyn;
     std::string m_bname, m_extra_data, m_bias_file,m_bias_server;
     std::string L1;
     std::string L2;
@@ -83,6 +86,8 @@ namespace Moses
     size_t m_default_sample_size;
     size_t m_min_sample_size;
     size_t m_workers;  // number of worker threads for sampling the bitexts
+    std::string m_dyn_spill_dir; // where to map large segments of btdyn from
+    size_t m_dyn_spill_size;     // minimum size of those, in sentence pairs
     std::vector<std::string> m_feature_set_names; // one or more of: standard, datasource
     std::string m_bias_logfile;
     boost::scoped_ptr<std::ofstream> m_bias_logger; // for logging to a file
@@ -102,6 +107,8 @@ namespace Moses
     boost::shared_ptr<sapt::SamplingBias> m_bias; // for global default bias
     boost::shared_ptr<TPCollCache> m_cache; // for global default bias
     size_t m_cache_size;  //
+    sapt::PstatsCache* m_pstats_cache; // shared cache of unbiased sampling
+                                       // results for btfix, if enabled
     // size_t input_factor;  //
     // size_t output_factor; // we can actually return entire Tokens!
 
@@ -185,7 +192,16 @@ namespace Moses
               Phrase const& src,
               sapt::PhrasePair<Token>* fix,
               sapt::PhrasePair<Token>* dyn,
-              SPTR<sapt::Bitext<Token> > const& dynbt) const;
+              dynbitext::segments_t const& dynbt,
+              bitext const& dynchain) const;
+
+    // phrase pairs from the segments of the dynamic bitext in which the
+    // source phrase was found (mdyn[i] for segment i, NULL if not found),
+    // pooled and sorted by target phrase
+    void
+    lookup_dyn(ttasksptr const& ttask, dynbitext::segments_t const& dynbt,
+               std::vector<SPTR<tsa::tree_iterator> > const& mdyn,
+               std::vector<sapt::PhrasePair<Token> >& ppdyn) const;
 
     void
     process_pstats
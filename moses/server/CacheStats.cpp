@@ -0,0 +1,59 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "CacheStats.h"
+#include <map>
+#include <string>
+#include <boost/foreach.hpp>
+#include "moses/TranslationModel/PhraseDictionary.h"
+
+#if PT_UG
+#include "moses/TranslationModel/UG/mm/ug_bitext_pstats_cache.h"
+#endif
+
+namespace MosesServer
+{
+  CacheStats::
+  CacheStats()
+  {
+    this->_signature = "S:";
+    this->_help = "Returns hit, eviction and size counters of the shared "
+      "phrase statistics cache and, under phrase-tables, of each phrase "
+      "table's translation option cache";
+  }
+
+  void
+  CacheStats::
+  execute(xmlrpc_c::paramList const& paramList,
+          xmlrpc_c::value *   const  retvalP)
+  {
+    std::map<std::string, xmlrpc_c::value> ret;
+#if PT_UG
+    sapt::PstatsCache::Stats s = sapt::PstatsCache::global().stats();
+    ret["hits"]       = xmlrpc_c::value_i8(s.hits);
+    ret["misses"]     = xmlrpc_c::value_i8(s.misses);
+    ret["admitted"]   = xmlrpc_c::value_i8(s.admitted);
+    ret["rejected"]   = xmlrpc_c::value_i8(s.rejected);
+    ret["evictions"]  = xmlrpc_c::value_i8(s.evictions);
+    ret["entries"]    = xmlrpc_c::value_i8(s.entries);
+    ret["bytes"]      = xmlrpc_c::value_i8(s.bytes);
+    ret["capacity"]   = xmlrpc_c::value_i8(s.capacity);
+    ret["time-saved"] = xmlrpc_c::value_double(s.time_saved);
+#endif
+    std::map<std::string, xmlrpc_c::value> tables;
+    BOOST_FOREACH(Moses::PhraseDictionary const* pd,
+                  Moses::PhraseDictionary::GetColl())
+      {
+        Moses::CacheStats s = pd->GetCacheStats();
+        std::map<std::string, xmlrpc_c::value> t;
+        t["hits"]       = xmlrpc_c::value_i8(s.hits);
+        t["misses"]     = xmlrpc_c::value_i8(s.misses);
+        t["insertions"] = xmlrpc_c::value_i8(s.insertions);
+        t["evictions"]  = xmlrpc_c::value_i8(s.evictions);
+        t["entries"]    = xmlrpc_c::value_i8(s.entries);
+        t["bytes"]      = xmlrpc_c::value_i8(s.bytes);
+        tables[pd->GetScoreProducerDescription()] = xmlrpc_c::value_struct(t);
+      }
+    ret["phrase-tables"] = xmlrpc_c::value_struct(tables);
+    *retvalP = xmlrpc_c::value_struct(ret);
+  }
+
+}
@@ -0,0 +1,22 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+#include <xmlrpc-c/server_abyss.hpp>
+
+namespace MosesServer
+{
+  // Reports the counters of the phrase statistics cache that sampling
+  // phrase tables (Mmsapt) share across threads, and those of each phrase
+  // table's translation option cache.
+  class
+  CacheStats : public xmlrpc_c::method
+  {
+  public:
+    CacheStats();
+
+    void execute(xmlrpc_c::paramList const& paramList,
+                 xmlrpc_c::value *   const  retvalP);
+  };
+
+}
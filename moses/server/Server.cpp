@@ -10,12 +10,14 @@ namespace MosesServer
       m_updater(new Updater),
       m_optimizer(new Optimizer),
       m_translator(new Translator(*this)),
-      m_close_session(new CloseSession(*this))
+      m_close_session(new CloseSession(*this)),
+      m_cache_stats(new CacheStats)
   {
     m_registry.addMethod("translate", m_translator);
     m_registry.addMethod("updater",   m_updater);
     m_registry.addMethod("optimize",  m_optimizer);
     m_registry.addMethod("close_session", m_close_session);
+    m_registry.addMethod("cache_stats", m_cache_stats);
   }
 
   Server::
@@ -14,6 +14,7 @@
 #include "Optimizer.h"
 #include "Updater.h"
 #include "CloseSession.h"
+#include "CacheStats.h"
 #include "Session.h"
 #include "moses/parameters/ServerOptions.h"
 #include <string>
@@ -29,6 +30,7 @@ namespace MosesServer
     xmlrpc_c::methodPtr const m_optimizer;
     xmlrpc_c::methodPtr const m_translator;
     xmlrpc_c::methodPtr const m_close_session;
+    xmlrpc_c::methodPtr const m_cache_stats;
     std::string m_pidfile;
   public:
     Server(Moses::Parameter& params);
@@ -11,15 +11,14 @@
 #include "HypothesisColl.h"
 #include "ManagerBase.h"
 #include "System.h"
-#include "MemPoolAllocator.h"
 
 using namespace std;
 
 namespace Moses2
 {
 
-HypothesisColl::HypothesisColl(const ManagerBase &mgr)
-  :m_coll(MemPoolAllocator<const HypothesisBase*>(mgr.GetPool()))
+HypothesisColl::HypothesisColl(const ManagerBase &mgr, size_t reserve)
+  :m_coll(mgr.GetPool(), reserve)
   ,m_sortedHypos(NULL)
 {
   m_bestScore = -std::numeric_limits<float>::infinity();
@@ -52,7 +51,7 @@ void HypothesisColl::Add(
   Recycler<HypothesisBase*> &hypoRecycle,
   ArcLists &arcLists)
 {
-  size_t maxStackSize = mgr.system.options.search.stack_size;
+  size_t maxStackSize = mgr.GetStackSize();
 
   if (GetSize() > maxStackSize * 2) {
     //cerr << "maxStackSize=" << maxStackSize << " " << GetSize() << endl;
@@ -107,26 +106,23 @@ void HypothesisColl::Add(
 
 StackAdd HypothesisColl::Add(const HypothesisBase *hypo)
 {
-  std::pair<_HCType::iterator, bool> addRet = m_coll.insert(hypo);
+  const HypothesisBase **existing = m_coll.Insert(hypo);
   //cerr << endl << "new=" << hypo->Debug(hypo->GetManager().system) << endl;
 
   // CHECK RECOMBINATION
-  if (addRet.second) {
+  if (existing == NULL) {
     // equiv hypo doesn't exists
     //cerr << "Added " << hypo << endl;
     return StackAdd(true, NULL);
   } else {
-    HypothesisBase *hypoExisting = const_cast<HypothesisBase*>(*addRet.first);
+    HypothesisBase *hypoExisting = const_cast<HypothesisBase*>(*existing);
     //cerr << "hypoExisting=" << hypoExisting->Debug(hypo->GetManager().system) << endl;
 
     if (hypo->GetFutureScore() > hypoExisting->GetFutureScore()) {
       // incoming hypo is better than the one we have
-      const HypothesisBase * const &hypoExisting1 = *addRet.first;
-      const HypothesisBase *&hypoExisting2 =
-        const_cast<const HypothesisBase *&>(hypoExisting1);
-      hypoExisting2 = hypo;
+      *existing = hypo;
 
-      //cerr << "Added " << hypo << " dicard existing " << hypoExisting2 << endl;
+      //cerr << "Added " << hypo << " dicard existing " << hypoExisting << endl;
       return StackAdd(true, hypoExisting);
     } else {
       // already storing the best hypo. discard incoming hypo
@@ -153,7 +149,7 @@ const Hypotheses &HypothesisColl::GetSortedAndPrunedHypos(
     // prune
     Recycler<HypothesisBase*> &recycler = mgr.GetHypoRecycle();
 
-    size_t maxStackSize = mgr.system.options.search.stack_size;
+    size_t maxStackSize = mgr.GetStackSize();
     if (maxStackSize && m_sortedHypos->size() > maxStackSize) {
       for (size_t i = maxStackSize; i < m_sortedHypos->size(); ++i) {
         HypothesisBase *hypo = const_cast<HypothesisBase*>((*m_sortedHypos)[i]);
@@ -174,7 +170,7 @@ const Hypotheses &HypothesisColl::GetSortedAndPrunedHypos(
 
 void HypothesisColl::PruneHypos(const ManagerBase &mgr, ArcLists &arcLists)
 {
-  size_t maxStackSize = mgr.system.options.search.stack_size;
+  size_t maxStackSize = mgr.GetStackSize();
 
   Recycler<HypothesisBase*> &recycler = mgr.GetHypoRecycle();
 
@@ -203,7 +199,7 @@ void HypothesisColl::PruneHypos(const ManagerBase &mgr, ArcLists &arcLists)
 
 void HypothesisColl::SortHypos(const ManagerBase &mgr, const HypothesisBase **sortedHypos) const
 {
-  size_t maxStackSize = mgr.system.options.search.stack_size;
+  size_t maxStackSize = mgr.GetStackSize();
   //assert(maxStackSize); // can't do stack=0 - unlimited stack size. No-one ever uses that
   //assert(GetSize() > maxStackSize);
   //assert(sortedHypos.size() == GetSize());
@@ -253,14 +249,14 @@ void HypothesisColl::Delete(const HypothesisBase *hypo)
 {
   //cerr << "hypo=" << hypo << " " << m_coll.size() << endl;
 
-  size_t erased = m_coll.erase(hypo);
-  UTIL_THROW_IF2(erased != 1, "couldn't erase hypo " << hypo);
+  bool erased = m_coll.Erase(hypo);
+  UTIL_THROW_IF2(!erased, "couldn't erase hypo " << hypo);
 }
 
 void HypothesisColl::Clear()
 {
   m_sortedHypos = NULL;
-  m_coll.clear();
+  m_coll.Clear();
 
   m_bestScore = -std::numeric_limits<float>::infinity();
   m_worstScore = std::numeric_limits<float>::infinity();
@@ -5,9 +5,8 @@
  *      Author: hieu
  */
 #pragma once
-#include <boost/unordered_set.hpp>
 #include "HypothesisBase.h"
-#include "MemPoolAllocator.h"
+#include "RecombinationTable.h"
 #include "Recycler.h"
 #include "Array.h"
 #include "legacy/Util2.h"
@@ -23,7 +22,8 @@ typedef Array<const HypothesisBase*> Hypotheses;
 class HypothesisColl
 {
 public:
-  HypothesisColl(const ManagerBase &mgr);
+  // reserve = expected number of hypos, 0 to size the table as hypos arrive
+  HypothesisColl(const ManagerBase &mgr, size_t reserve = 0);
 
   void Add(const ManagerBase &mgr,
            HypothesisBase *hypo,
@@ -53,9 +53,7 @@ public:
   std::string Debug(const System &system) const;
 
 protected:
-  typedef boost::unordered_set<const HypothesisBase*,
-          UnorderedComparer<HypothesisBase>, UnorderedComparer<HypothesisBase>,
-          MemPoolAllocator<const HypothesisBase*> > _HCType;
+  typedef RecombinationTable _HCType;
 
   _HCType m_coll;
   mutable Hypotheses *m_sortedHypos;
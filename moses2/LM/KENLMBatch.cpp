@@ -5,6 +5,7 @@
  *      Author: hieu
  */
 #include <boost/foreach.hpp>
+#include <algorithm>
 #include <sstream>
 #include <vector>
 
@@ -84,7 +85,7 @@ private:
 /////////////////////////////////////////////////////////////////
 KENLMBatch::KENLMBatch(size_t startInd, const std::string &line)
   :StatefulFeatureFunction(startInd, line)
-  ,m_numHypos(0)
+  ,m_prefetchDistance(8)
 {
   cerr << "KENLMBatch::KENLMBatch" << endl;
   ReadParameters();
@@ -303,6 +304,8 @@ void KENLMBatch::SetParameter(const std::string& key,
     m_load_method =
       boost::lexical_cast<bool>(value) ?
       util::LAZY : util::POPULATE_OR_READ;
+  } else if (key == "prefetch-distance") {
+    m_prefetchDistance = Scan<size_t>(value);
   } else if (key == "load") {
     if (value == "lazy") {
       m_load_method = util::LAZY;
@@ -325,37 +328,51 @@ void KENLMBatch::SetParameter(const std::string& key,
 }
 
 void KENLMBatch::EvaluateWhenAppliedBatch(
+  const System &system,
   const Batch &batch) const
 {
-  {
-    // write lock
-    boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-    m_batches.push_back(&batch);
-    m_numHypos += batch.size();
+  // The hypotheses in a batch are independent, so the n-gram keys of
+  // hypothesis i + m_prefetchDistance can be prefetched while hypothesis i is
+  // being scored. By the time we get to it, its buckets should be in cache.
+  size_t ahead = std::min(m_prefetchDistance, batch.size());
+  for (size_t i = 0; i < ahead; ++i) {
+    Prefetch(*batch[i]);
   }
-  //cerr << "m_numHypos=" << m_numHypos << endl;
 
-  if (m_numHypos > 0) {
-    // process batch
-    EvaluateWhenAppliedBatch();
-
-    m_batches.clear();
-    m_numHypos = 0;
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (i + ahead < batch.size()) {
+      Prefetch(*batch[i + ahead]);
+    }
 
-    m_threadNeeded.notify_all();
-  } else {
-    boost::mutex::scoped_lock lock(m_mutex);
-    m_threadNeeded.wait(lock);
+    Hypothesis *hypo = batch[i];
+    hypo->EvaluateWhenApplied(*this);
   }
 }
 
-void KENLMBatch::EvaluateWhenAppliedBatch() const
+void KENLMBatch::Prefetch(const Hypothesis &hypo) const
 {
-  BOOST_FOREACH(const Batch *batch, m_batches) {
-    //cerr << "batch=" << batch->size() << endl;
-    BOOST_FOREACH(Hypothesis *hypo, *batch) {
-      hypo->EvaluateWhenApplied(*this);
-    }
+  const TargetPhrase<Moses2::Word> &tp = hypo.GetTargetPhrase();
+  if (!tp.GetSize()) {
+    return;
+  }
+
+  const lm::ngram::State &in_state =
+    static_cast<const KenLMState&>(*hypo.GetPrevHypo()->GetState(GetStatefulInd())).state;
+
+  // Same words as EvaluateWhenApplied() scores with the running state.
+  // Context is in reverse order: words of this phrase followed by the
+  // previous state. The real state may be shorter if the LM backs off, in
+  // which case a few of the higher-order prefetches are wasted.
+  const size_t numWords = std::min(tp.GetSize(), (size_t) m_ngram->Order() - 1);
+  lm::WordIndex context[2 * KENLM_MAX_ORDER];
+  lm::WordIndex *contextEnd = std::copy(in_state.words,
+                                        in_state.words + in_state.length, context + numWords);
+
+  for (size_t pos = 0; pos < numWords; ++pos) {
+    lm::WordIndex *contextBegin = context + numWords - pos;
+    lm::WordIndex id = TranslateID(tp[pos]);
+    m_ngram->PrefetchForgotState(contextBegin, contextEnd, id);
+    *(contextBegin - 1) = id;
   }
 }
 
@@ -7,11 +7,6 @@
 #pragma once
 
 #include <boost/shared_ptr.hpp>
-#include <boost/bind.hpp>
-#include <boost/thread.hpp>
-#ifdef __linux
-#include <pthread.h>
-#endif
 
 #include "../FF/StatefulFeatureFunction.h"
 #include "lm/model.hh"
@@ -62,6 +57,7 @@ public:
                                    FFState &state) const;
 
   virtual void EvaluateWhenAppliedBatch(
+    const System &system,
     const Batch &batch) const;
 
 protected:
@@ -87,15 +83,10 @@ protected:
   std::vector<lm::WordIndex> m_lmIdLookup;
 
   // batch
-  mutable std::vector<const Batch*> m_batches;
-  mutable size_t m_numHypos;
+  // how many hypotheses ahead of the one being scored to issue prefetches for
+  size_t m_prefetchDistance;
 
-  mutable boost::shared_mutex m_accessLock;
-
-  mutable boost::mutex m_mutex;
-  mutable boost::condition_variable m_threadNeeded;
-
-  void EvaluateWhenAppliedBatch() const;
+  void Prefetch(const Hypothesis &hypo) const;
 
 };
 
@@ -5,6 +5,7 @@
 #include "System.h"
 #include "Phrase.h"
 #include "TranslationTask.h"
+#include "TranslationPipeline.h"
 #include "MemPoolAllocator.h"
 #include "server/Server.h"
 #include "legacy/InputFileStream.h"
@@ -51,6 +52,19 @@ int main(int argc, char** argv)
   }
 
   cerr << "Decoding took " << timer.get_elapsed_time() << endl;
+
+  std::vector<Moses2::MemPool::Stats> poolStats;
+  Moses2::MemPool::Stats totalPoolStats;
+  system.GetPoolStats(poolStats, totalPoolStats);
+  // one line per pool only with -v 2 or more
+  int verbose;
+  params.SetParameter(verbose, "verbose", 1);
+  if (verbose >= 2) {
+    for (size_t i = 0; i < poolStats.size(); ++i) {
+      cerr << "Pool " << i << ": " << poolStats[i] << endl;
+    }
+  }
+  cerr << "Pools: " << totalPoolStats << endl;
   //	cerr << "g_numHypos=" << g_numHypos << endl;
   cerr << "Finished" << endl;
   return EXIT_SUCCESS;
@@ -80,17 +94,8 @@ void batch_run(Moses2::Parameter &params, Moses2::System &system, Moses2::Thread
 {
   istream &inStream = GetInputStream(params);
 
-  long translationId = 0;
-  string line;
-  while (getline(inStream, line)) {
-    //cerr << "line=" << line << endl;
-    boost::shared_ptr<Moses2::TranslationTask> task(new Moses2::TranslationTask(system, line, translationId));
-
-    //cerr << "START pool.Submit()" << endl;
-    pool.Submit(task);
-    //task->Run();
-    ++translationId;
-  }
+  Moses2::TranslationPipeline pipeline(system, pool, system.options.server.numThreads);
+  pipeline.Run(inStream);
 
   pool.Stop(true);
 
@@ -26,6 +26,7 @@ ManagerBase::ManagerBase(System &sys, const TranslationTask &task,
   ,task(task)
   ,m_inputStr(inputStr)
   ,m_translationId(translationId)
+  ,m_stackSize(sys.options.search.stack_size)
   ,m_pool(NULL)
   ,m_systemPool(NULL)
   ,m_hypoRecycle(NULL)
@@ -38,6 +39,7 @@ ManagerBase::~ManagerBase()
 
   if (m_pool) {
     GetPool().Reset();
+    system.UpdatePoolStats(GetPool());
   }
   if (m_hypoRecycle) {
     GetHypoRecycle().Clear();
@@ -65,9 +65,19 @@ public:
     return m_translationId;
   }
 
+  // max hypos per stack. Defaults to the system setting, the server lowers
+  // it for requests that would otherwise miss their deadline
+  size_t GetStackSize() const {
+    return m_stackSize;
+  }
+  void SetStackSize(size_t stackSize) {
+    m_stackSize = stackSize;
+  }
+
 protected:
   std::string m_inputStr;
   long m_translationId;
+  size_t m_stackSize;
   InputType *m_input;
 
   mutable MemPool *m_pool, *m_systemPool;
@@ -15,25 +15,66 @@ using namespace std;
 namespace Moses2
 {
 
-MemPool::Page::Page(std::size_t vSize) :
-  size(vSize)
+namespace
 {
-  mem = (uint8_t*) util::MallocOrThrow(size);
+// Pages at least this big are rounded up to whole huge pages and come from
+// util::HugeMalloc, so the pages that stick around across sentences can be
+// backed by transparent huge pages.
+const size_t HUGE_PAGE_SIZE = 1 << 21;
+}
+
+MemPool::Page::Page(std::size_t vSize)
+{
+  if (vSize >= HUGE_PAGE_SIZE) {
+    vSize = (vSize + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    util::HugeMalloc(vSize, false, alloc);
+  } else {
+    alloc.reset(util::MallocOrThrow(vSize), vSize, util::scoped_memory::MALLOC_ALLOCATED);
+  }
+  size = vSize;
+  mem = (uint8_t*) alloc.get();
   end = mem + size;
 }
 
-MemPool::Page::~Page()
+////////////////////////////////////////////////////
+MemPool::Stats::Stats()
+  :resets(0)
+  ,lastHighWater(0)
+  ,maxHighWater(0)
+  ,totalHighWater(0)
+  ,retained(0)
+  ,trimmed(0)
 {
-  free(mem);
 }
+
+void MemPool::Stats::Add(const Stats &other)
+{
+  resets += other.resets;
+  lastHighWater = std::max(lastHighWater, other.lastHighWater);
+  maxHighWater = std::max(maxHighWater, other.maxHighWater);
+  totalHighWater += other.totalHighWater;
+  retained += other.retained;
+  trimmed += other.trimmed;
+}
+
+std::ostream &operator<<(std::ostream &out, const MemPool::Stats &stats)
+{
+  out << "resets=" << stats.resets
+      << " high-water last=" << stats.lastHighWater
+      << " max=" << stats.maxHighWater
+      << " mean=" << stats.GetMeanHighWater()
+      << " retained=" << stats.retained
+      << " trimmed=" << stats.trimmed;
+  return out;
+}
+
 ////////////////////////////////////////////////////
 MemPool::MemPool(size_t initSize) :
-  m_currSize(initSize), m_currPage(0)
+  m_currSize(initSize), m_currPage(0), m_maxRetained(0)
 {
-  Page *page = new Page(m_currSize);
-  m_pages.push_back(page);
+  AddPage(m_currSize);
 
-  current_ = page->mem;
+  current_ = m_pages[0]->mem;
   //cerr << "new memory pool";
 }
 
@@ -43,6 +84,13 @@ MemPool::~MemPool()
   RemoveAllInColl(m_pages);
 }
 
+void MemPool::AddPage(std::size_t size)
+{
+  Page *page = new Page(size);
+  m_pages.push_back(page);
+  m_stats.retained += page->size;
+}
+
 uint8_t *MemPool::More(std::size_t size)
 {
   ++m_currPage;
@@ -51,8 +99,8 @@ uint8_t *MemPool::More(std::size_t size)
     m_currSize <<= 1;
     std::size_t amount = std::max(m_currSize, size);
 
-    Page *page = new Page(amount);
-    m_pages.push_back(page);
+    AddPage(amount);
+    Page *page = m_pages.back();
 
     uint8_t *ret = page->mem;
     current_ = ret + size;
@@ -73,9 +121,40 @@ uint8_t *MemPool::More(std::size_t size)
 
 void MemPool::Reset()
 {
+  // everything in earlier pages counts as used, including what was skipped
+  // at the end of each page
+  size_t used = current_ - m_pages[m_currPage]->mem;
+  for (size_t i = 0; i < m_currPage; ++i) {
+    used += m_pages[i]->size;
+  }
+
+  ++m_stats.resets;
+  m_stats.lastHighWater = used;
+  m_stats.maxHighWater = std::max(m_stats.maxHighWater, used);
+  m_stats.totalHighWater += used;
+
+  if (m_maxRetained) {
+    Trim();
+  }
+
   m_currPage = 0;
   current_ = m_pages[0]->mem;
 }
 
+void MemPool::Trim()
+{
+  while (m_pages.size() > 1 && m_stats.retained > m_maxRetained) {
+    Page *page = m_pages.back();
+    m_pages.pop_back();
+
+    m_stats.retained -= page->size;
+    m_stats.trimmed += page->size;
+    delete page;
+
+    // carry on doubling from the last page we kept
+    m_currSize = m_pages.back()->size;
+  }
+}
+
 }
 
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <limits>
 #include <iostream>
+#include "util/mmap.hh"
 
 namespace Moses2
 {
@@ -24,14 +25,32 @@ class MemPool
     uint8_t *mem;
     uint8_t *end;
     size_t size;
+    util::scoped_memory alloc;
 
-    Page() {
-    }
     Page(std::size_t size);
-    ~Page();
   };
 
 public:
+  // High-water marks are the bytes handed out between 2 calls to Reset(),
+  // ie. per sentence for the manager pool.
+  struct Stats {
+    size_t resets;
+    size_t lastHighWater;
+    size_t maxHighWater;
+    uint64_t totalHighWater;
+    size_t retained; // bytes in pages currently held
+    uint64_t trimmed; // bytes freed by trimming
+
+    Stats();
+
+    // aggregate over pools
+    void Add(const Stats &other);
+
+    size_t GetMeanHighWater() const {
+      return resets ? totalHighWater / resets : 0;
+    }
+  };
+
   MemPool(std::size_t initSize = 10000);
 
   ~MemPool();
@@ -67,8 +86,20 @@ public:
   // re-use pool
   void Reset();
 
+  // After Reset(), free pages beyond the first until no more than this many
+  // bytes are held. 0 = keep every page.
+  void SetMaxRetained(std::size_t bytes) {
+    m_maxRetained = bytes;
+  }
+
+  const Stats &GetStats() const {
+    return m_stats;
+  }
+
 private:
   uint8_t *More(std::size_t size);
+  void AddPage(std::size_t size);
+  void Trim();
 
   std::vector<Page*> m_pages;
 
@@ -76,6 +107,9 @@ private:
   size_t m_currPage;
   uint8_t *current_;
 
+  size_t m_maxRetained;
+  Stats m_stats;
+
   // no copying
   MemPool(const MemPool &);
   MemPool &operator=(const MemPool &);
@@ -153,6 +187,7 @@ private:
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
+std::ostream &operator<<(std::ostream &out, const MemPool::Stats &stats);
 
 }
 
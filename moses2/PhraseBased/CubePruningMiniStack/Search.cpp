@@ -119,6 +119,14 @@ void Search::Decode(size_t stackInd)
   cerr << endl;
    */
 
+  // With lazy scoring, the order in which hypos are popped doesn't depend on
+  // the stateful scores. Collect every popped hypo and score them together
+  // so the stateful FFs (in particular the LM) can interleave their lookups
+  // across the whole batch.
+  bool lazyScoring = mgr.system.options.cube.lazy_scoring;
+  Batch &batch = mgr.system.GetBatch(mgr.GetSystemPool());
+  batch.clear();
+
   size_t pops = 0;
   while (!m_queue.empty() && pops < mgr.system.options.cube.pop_limit) {
     // get best hypo from queue, add to stack
@@ -131,13 +139,13 @@ void Search::Decode(size_t stackInd)
     // add hypo to stack
     Hypothesis *hypo = item->hypo;
 
-    if (mgr.system.options.cube.lazy_scoring) {
-      hypo->EvaluateWhenApplied();
+    if (lazyScoring) {
+      batch.push_back(hypo);
+    } else {
+      //cerr << "hypo=" << *hypo << " " << hypo->GetBitmap() << endl;
+      m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
     }
 
-    //cerr << "hypo=" << *hypo << " " << hypo->GetBitmap() << endl;
-    m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
-
     edge->CreateNext(mgr, item, m_queue, m_seenPositions, m_queueItemRecycler);
 
     ++pops;
@@ -153,10 +161,23 @@ void Search::Decode(size_t stackInd)
         // add hypo to stack
         Hypothesis *hypo = item->hypo;
         //cerr << "hypo=" << *hypo << " " << hypo->GetBitmap() << endl;
-        m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
+        if (lazyScoring) {
+          batch.push_back(hypo);
+        } else {
+          m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
+        }
       }
     }
   }
+
+  if (lazyScoring && batch.size()) {
+    mgr.system.featureFunctions.EvaluateWhenAppliedBatch(batch);
+
+    BOOST_FOREACH(Hypothesis *hypo, batch) {
+      m_stack.Add(hypo, hypoRecycler, mgr.arcLists);
+    }
+    batch.clear();
+  }
 }
 
 void Search::PostDecode(size_t stackInd)
@@ -20,10 +20,9 @@ namespace NSNormal
 {
 
 Stack::Stack(const Manager &mgr) :
-  HypothesisColl(mgr)
+  // hypos are pruned once there are more than twice the stack size
+  HypothesisColl(mgr, 2 * mgr.GetStackSize() + 1)
 {
-  // TODO Auto-generated constructor stub
-
 }
 
 Stack::~Stack()
@@ -0,0 +1,141 @@
+/*
+ * RecombinationTable.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+#include <cstring>
+#include "RecombinationTable.h"
+#include "MemPool.h"
+
+namespace Moses2
+{
+
+namespace
+{
+const size_t MIN_CAPACITY = 16;
+}
+
+RecombinationTable::RecombinationTable(MemPool &pool, size_t reserve)
+  :m_pool(pool)
+  ,m_slots(NULL)
+  ,m_capacity(0)
+  ,m_size(0)
+  ,m_epoch(1)
+{
+  if (reserve) {
+    // keep load factor <= 1/2
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < reserve * 2) {
+      capacity *= 2;
+    }
+    Allocate(capacity);
+  }
+}
+
+void RecombinationTable::Allocate(size_t capacity)
+{
+  m_slots = m_pool.Allocate<Slot>(capacity);
+  memset(m_slots, 0, sizeof(Slot) * capacity);
+  m_capacity = capacity;
+}
+
+void RecombinationTable::Grow()
+{
+  Slot *oldSlots = m_slots;
+  size_t oldCapacity = m_capacity;
+  unsigned int oldEpoch = m_epoch;
+
+  Allocate(m_capacity ? m_capacity * 2 : MIN_CAPACITY);
+  m_epoch = 1;
+
+  for (size_t i = 0; i < oldCapacity; ++i) {
+    const Slot &slot = oldSlots[i];
+    if (slot.epoch == oldEpoch) {
+      size_t ind = slot.hash & (m_capacity - 1);
+      while (IsUsed(ind)) {
+        ind = (ind + 1) & (m_capacity - 1);
+      }
+      m_slots[ind] = slot;
+      m_slots[ind].epoch = m_epoch;
+    }
+  }
+}
+
+size_t RecombinationTable::FindSlot(const HypothesisBase *hypo, size_t hash) const
+{
+  size_t ind = hash & (m_capacity - 1);
+  while (IsUsed(ind)) {
+    const Slot &slot = m_slots[ind];
+    if (slot.hash == hash && *slot.hypo == *hypo) {
+      break;
+    }
+    ind = (ind + 1) & (m_capacity - 1);
+  }
+  return ind;
+}
+
+const HypothesisBase **RecombinationTable::Insert(const HypothesisBase *hypo)
+{
+  if ((m_size + 1) * 2 > m_capacity) {
+    Grow();
+  }
+
+  size_t hash = hypo->hash();
+  size_t ind = FindSlot(hypo, hash);
+  Slot &slot = m_slots[ind];
+  if (IsUsed(ind)) {
+    return &slot.hypo;
+  }
+
+  slot.hash = hash;
+  slot.hypo = hypo;
+  slot.epoch = m_epoch;
+  ++m_size;
+  return NULL;
+}
+
+bool RecombinationTable::Erase(const HypothesisBase *hypo)
+{
+  if (m_size == 0) {
+    return false;
+  }
+
+  size_t mask = m_capacity - 1;
+  size_t hole = FindSlot(hypo, hypo->hash());
+  if (!IsUsed(hole) || m_slots[hole].hypo != hypo) {
+    return false;
+  }
+
+  // backward-shift deletion, so lookups never need tombstones
+  size_t ind = hole;
+  while (true) {
+    ind = (ind + 1) & mask;
+    if (!IsUsed(ind)) {
+      break;
+    }
+
+    // move slot back if the hole lies between its home and where it is
+    size_t home = m_slots[ind].hash & mask;
+    if (((ind - home) & mask) >= ((ind - hole) & mask)) {
+      m_slots[hole] = m_slots[ind];
+      hole = ind;
+    }
+  }
+  m_slots[hole].epoch = m_epoch - 1;
+  --m_size;
+
+  return true;
+}
+
+void RecombinationTable::Clear()
+{
+  m_size = 0;
+  if (++m_epoch == 0) {
+    // wrapped. Old slots could look valid again
+    memset(m_slots, 0, sizeof(Slot) * m_capacity);
+    m_epoch = 1;
+  }
+}
+
+}
+
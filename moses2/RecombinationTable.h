@@ -0,0 +1,114 @@
+/*
+ * RecombinationTable.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include "HypothesisBase.h"
+
+namespace Moses2
+{
+
+class MemPool;
+
+// Open-addressing set of hypotheses used for recombination.
+// Slots hold the hypo's hash next to the pointer so probing rarely has to
+// look at the hypo itself. The slot array comes from the manager's pool, is
+// grown by doubling and is never freed - it goes when the pool is reset.
+// Clear() is O(1): slots are only valid if they carry the current epoch.
+class RecombinationTable
+{
+  struct Slot {
+    size_t hash;
+    const HypothesisBase *hypo;
+    unsigned int epoch;
+  };
+
+public:
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef const HypothesisBase *value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const HypothesisBase * const *pointer;
+    typedef const HypothesisBase *reference;
+
+    const_iterator(const RecombinationTable &table, size_t ind)
+      :m_table(&table)
+      ,m_ind(ind) {
+      SkipEmpty();
+    }
+
+    const HypothesisBase *operator*() const {
+      return m_table->m_slots[m_ind].hypo;
+    }
+
+    const_iterator &operator++() {
+      ++m_ind;
+      SkipEmpty();
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return m_ind == other.m_ind;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return m_ind != other.m_ind;
+    }
+
+  protected:
+    const RecombinationTable *m_table;
+    size_t m_ind;
+
+    void SkipEmpty() {
+      while (m_ind < m_table->m_capacity && !m_table->IsUsed(m_ind)) {
+        ++m_ind;
+      }
+    }
+  };
+
+  typedef const_iterator iterator;
+
+  // reserve = number of hypos expected, 0 to allocate on first insert
+  RecombinationTable(MemPool &pool, size_t reserve = 0);
+
+  const_iterator begin() const {
+    return const_iterator(*this, 0);
+  }
+  const_iterator end() const {
+    return const_iterator(*this, m_capacity);
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  // Returns the slot holding an equal hypo, which the caller may overwrite
+  // with a better one. If there wasn't one, hypo is added and NULL returned.
+  const HypothesisBase **Insert(const HypothesisBase *hypo);
+
+  bool Erase(const HypothesisBase *hypo);
+
+  void Clear();
+
+protected:
+  MemPool &m_pool;
+  Slot *m_slots;
+  size_t m_capacity; // power of 2
+  size_t m_size;
+  unsigned int m_epoch;
+
+  bool IsUsed(size_t ind) const {
+    return m_slots[ind].epoch == m_epoch;
+  }
+
+  void Allocate(size_t capacity);
+  void Grow();
+  size_t FindSlot(const HypothesisBase *hypo, size_t hash) const;
+};
+
+}
+
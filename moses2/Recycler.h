@@ -7,7 +7,6 @@
 #pragma once
 
 #include <cstddef>
-#include <deque>
 #include <vector>
 
 namespace Moses2
@@ -60,8 +59,9 @@ protected:
   // to give out another obj, must decrement THEN give out
   size_t m_currInd;
 
-  // objects that have been give back to us
-  std::deque<T> m_coll;
+  // objects that have been give back to us. A vector rather than a deque:
+  // it's only used as a stack and keeps its capacity across Clear()
+  std::vector<T> m_coll;
 };
 
 } /* namespace Moses2 */
@@ -31,6 +31,10 @@ System::System(const Parameter &paramsArg) :
   params.SetParameter(cpuAffinityOffset, "cpu-affinity-offset", -1);
   params.SetParameter(cpuAffinityOffsetIncr, "cpu-affinity-increment", 1);
 
+  size_t maxRetainedMB;
+  params.SetParameter<size_t>(maxRetainedMB, "pool-max-retained", 0);
+  m_managerPoolMaxRetained = maxRetainedMB << 20;
+
   const PARAM_VEC *section;
 
   // output collectors
@@ -168,7 +172,30 @@ MemPool &System::GetSystemPool() const
 
 MemPool &System::GetManagerPool() const
 {
-  return GetThreadSpecificObj(m_managerPool);
+  MemPool *obj = m_managerPool.get();
+  if (obj == NULL) {
+    obj = new MemPool();
+    obj->SetMaxRetained(m_managerPoolMaxRetained);
+    m_managerPool.reset(obj);
+  }
+  return *obj;
+}
+
+void System::UpdatePoolStats(const MemPool &pool) const
+{
+  boost::mutex::scoped_lock lock(m_poolStatsMutex);
+  m_poolStats[&pool] = pool.GetStats();
+}
+
+void System::GetPoolStats(std::vector<MemPool::Stats> &perThread, MemPool::Stats &total) const
+{
+  boost::mutex::scoped_lock lock(m_poolStatsMutex);
+  perThread.clear();
+  total = MemPool::Stats();
+  BOOST_FOREACH(const PoolStats::value_type &valPair, m_poolStats) {
+    perThread.push_back(valPair.second);
+    total.Add(valPair.second);
+  }
 }
 
 FactorCollection &System::GetVocab() const
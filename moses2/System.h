@@ -9,6 +9,8 @@
 #include <vector>
 #include <deque>
 #include <boost/thread/tss.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/pool/object_pool.hpp>
 #include <boost/shared_ptr.hpp>
 #include "FF/FeatureFunctions.h"
@@ -57,6 +59,12 @@ public:
 
   MemPool &GetSystemPool() const;
   MemPool &GetManagerPool() const;
+
+  // record the stats of a thread's manager pool. Called after each sentence
+  void UpdatePoolStats(const MemPool &pool) const;
+
+  // per thread, and their sum
+  void GetPoolStats(std::vector<MemPool::Stats> &perThread, MemPool::Stats &total) const;
   FactorCollection &GetVocab() const;
 
   Recycler<HypothesisBase*> &GetHypoRecycler() const;
@@ -67,6 +75,11 @@ protected:
   mutable FactorCollection m_vocab;
   mutable boost::thread_specific_ptr<MemPool> m_managerPool;
   mutable boost::thread_specific_ptr<MemPool> m_systemPool;
+  size_t m_managerPoolMaxRetained;
+
+  typedef boost::unordered_map<const MemPool*, MemPool::Stats> PoolStats;
+  mutable PoolStats m_poolStats;
+  mutable boost::mutex m_poolStatsMutex;
 
   mutable boost::thread_specific_ptr<Recycler<HypothesisBase*> > m_hypoRecycler;
 
@@ -0,0 +1,144 @@
+// $Id$
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../../TypeDef.h"
+#include "StringVector.h"
+#include "CanonicalHuffman.h"
+#include "TargetPhraseCollectionCache.h"
+
+namespace Moses2
+{
+
+class PhraseTableCompact;
+
+//! Decodes the Huffman/REnc/PREnc encoded target phrase collections of a
+//! .minphr file. Port of Moses::PhraseDecoder. Source phrases are passed in
+//! as tokens so the same code serves phrase-based and SCFG lookup; target
+//! words are returned as symbol ids, see TPCompact.
+class PhraseDecoder
+{
+protected:
+
+  friend class PhraseTableCompact;
+
+  typedef std::pair<unsigned char, unsigned char> AlignPoint;
+  typedef std::pair<unsigned, unsigned> SrcTrg;
+
+  enum Coding { None, REnc, PREnc } m_coding;
+
+  size_t m_numScoreComponent;
+  bool m_containsAlignmentInfo;
+  size_t m_maxRank;
+  size_t m_maxPhraseLength;
+
+  StringVector<unsigned char, unsigned, std::allocator> m_sourceSymbols;
+  StringVector<unsigned char, unsigned, std::allocator> m_targetSymbols;
+
+  std::vector<size_t> m_lexicalTableIndex;
+  std::vector<SrcTrg> m_lexicalTable;
+
+  CanonicalHuffman<unsigned>* m_symbolTree;
+
+  bool m_multipleScoreTrees;
+  std::vector<CanonicalHuffman<float>*> m_scoreTrees;
+
+  CanonicalHuffman<AlignPoint>* m_alignTree;
+
+  TargetPhraseCollectionCache m_decodingCache;
+
+  PhraseTableCompact& m_phraseDictionary;
+
+  // ***********************************************
+
+  std::string m_separator;
+
+  // ***********************************************
+
+  unsigned GetSourceSymbolId(const std::string& s) const;
+
+  size_t GetREncType(unsigned encodedSymbol) const;
+  size_t GetPREncType(unsigned encodedSymbol) const;
+
+  unsigned GetTranslation(unsigned srcIdx, size_t rank) const;
+
+  unsigned DecodeREncSymbol1(unsigned encodedSymbol) const;
+  unsigned DecodeREncSymbol2Rank(unsigned encodedSymbol) const;
+  unsigned DecodeREncSymbol2Position(unsigned encodedSymbol) const;
+  unsigned DecodeREncSymbol3(unsigned encodedSymbol) const;
+
+  unsigned DecodePREncSymbol1(unsigned encodedSymbol) const;
+  int DecodePREncSymbol2Left(unsigned encodedSymbol) const;
+  int DecodePREncSymbol2Right(unsigned encodedSymbol) const;
+  unsigned DecodePREncSymbol2Rank(unsigned encodedSymbol) const;
+
+  PhraseCompact MakeSourceKey(const std::vector<std::string> &sourceWords,
+                              size_t start, size_t end) const;
+
+public:
+
+  PhraseDecoder(
+    PhraseTableCompact &phraseDictionary,
+    size_t numScoreComponent
+  );
+
+  ~PhraseDecoder();
+
+  size_t Load(std::FILE* in);
+
+  size_t GetMaxSourcePhraseLength() const {
+    return m_maxPhraseLength;
+  }
+
+  size_t GetNumTargetSymbols() const {
+    return m_targetSymbols.size();
+  }
+
+  std::string GetTargetSymbol(unsigned id) const;
+
+  //! sourceWords are the source tokens exactly as in the text phrase table,
+  //! including the LHS for SCFG rules. Returns NULL if there is no entry.
+  TargetPhraseVectorPtr CreateTargetPhraseCollection(
+    const std::vector<std::string> &sourceWords,
+    bool topLevel = false);
+
+  TargetPhraseVectorPtr CreateTargetPhraseCollection(
+    const std::vector<std::string> &sourceWords,
+    size_t start, size_t end,
+    bool topLevel);
+
+  TargetPhraseVectorPtr DecodeCollection(TargetPhraseVectorPtr tpv,
+                                         BitWrapper<> &encodedBitStream,
+                                         const std::vector<std::string> &sourceWords,
+                                         size_t start, size_t end,
+                                         const PhraseCompact &sourceKey,
+                                         bool topLevel);
+
+  void PruneCache();
+};
+
+}
+
@@ -0,0 +1,413 @@
+/*
+ * PhraseTableCompact.cpp
+ *
+ * Compact phrase table (.minphr, created with processPhraseTableMin).
+ * Supports phrase-based and hierarchical tables.
+ */
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/foreach.hpp>
+#include "PhraseTableCompact.h"
+#include "PhraseDecoder.h"
+#include "util/exception.hh"
+#include "../../System.h"
+#include "../../Scores.h"
+#include "../../AlignmentInfoCollection.h"
+#include "../../legacy/FactorCollection.h"
+#include "../../legacy/Util2.h"
+#include "../../FF/FeatureFunctions.h"
+#include "../../PhraseBased/InputPath.h"
+#include "../../PhraseBased/Manager.h"
+#include "../../PhraseBased/TargetPhraseImpl.h"
+#include "../../PhraseBased/TargetPhrases.h"
+#include "../../SCFG/InputPath.h"
+#include "../../SCFG/Manager.h"
+#include "../../SCFG/TargetPhraseImpl.h"
+#include "../../SCFG/TargetPhrases.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+PhraseTableCompact::PhraseTableCompact(size_t startInd, const std::string &line)
+  :PhraseTable(startInd, line)
+  ,m_inMemory(false)
+  ,m_maxNonTerms(2)
+  ,m_hash(10, 16)
+  ,m_phraseDecoder(NULL)
+{
+  ReadParameters();
+}
+
+PhraseTableCompact::~PhraseTableCompact()
+{
+  delete m_phraseDecoder;
+}
+
+void PhraseTableCompact::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "in-memory") {
+    m_inMemory = Scan<bool>(value);
+  } else if (key == "max-nonterminals") {
+    // as extract-rules --MaxNonTerm
+    m_maxNonTerms = Scan<size_t>(value);
+  } else {
+    PhraseTable::SetParameter(key, value);
+  }
+}
+
+void PhraseTableCompact::Load(System &system)
+{
+  std::string tFilePath = m_path;
+
+  std::string suffix = ".minphr";
+  if (!boost::algorithm::ends_with(tFilePath, suffix)) tFilePath += suffix;
+  UTIL_THROW_IF2(!FileExists(tFilePath),
+                 "Error: File " << tFilePath << " does not exist.");
+
+  if (m_output.empty()) {
+    m_output.push_back(0);
+  }
+
+  m_phraseDecoder = new PhraseDecoder(*this, GetNumScores());
+
+  std::FILE* pFile = std::fopen(tFilePath.c_str() , "r");
+
+  // source phrase index
+  size_t indexSize = m_hash.Load(pFile);
+
+  size_t coderSize = m_phraseDecoder->Load(pFile);
+
+  size_t phraseSize;
+  if(m_inMemory)
+    // Load target phrase collections into memory
+    phraseSize = m_targetPhrasesMemory.load(pFile, false);
+  else
+    // Keep target phrase collections on disk
+    phraseSize = m_targetPhrasesMapped.load(pFile, true);
+
+  UTIL_THROW_IF2(indexSize == 0 || coderSize == 0 || phraseSize == 0,
+                 "Not successfully loaded");
+  UTIL_THROW_IF2(m_phraseDecoder->m_numScoreComponent != GetNumScores(),
+                 tFilePath << " has " << m_phraseDecoder->m_numScoreComponent
+                 << " scores, " << GetName() << " expects " << GetNumScores());
+
+  CreateTargetVocab(system);
+}
+
+void PhraseTableCompact::CreateTargetVocab(System &system)
+{
+  FactorCollection &vocab = system.GetVocab();
+  size_t numSymbols = m_phraseDecoder->GetNumTargetSymbols();
+
+  if (system.isPb) {
+    size_t numFactors = m_output.size();
+    m_targetVocab.resize(numSymbols * numFactors, NULL);
+
+    for (size_t id = 0; id < numSymbols; ++id) {
+      string wordStr = m_phraseDecoder->GetTargetSymbol(id);
+      if (numFactors == 1) {
+        m_targetVocab[id] = vocab.AddFactor(wordStr, system, false);
+      } else {
+        vector<string> toks = TokenizeMultiCharSeparator(wordStr, "|");
+        UTIL_THROW_IF2(toks.size() < numFactors,
+                       "Target word " << wordStr << " in " << GetName()
+                       << " has " << toks.size() << " factors, expected "
+                       << numFactors);
+        for (size_t i = 0; i < numFactors; ++i) {
+          m_targetVocab[id * numFactors + i] = vocab.AddFactor(toks[i], system, false);
+        }
+      }
+    }
+  } else {
+    m_targetVocab.resize(numSymbols, NULL);
+    m_targetIsNT.resize(numSymbols, false);
+
+    for (size_t id = 0; id < numSymbols; ++id) {
+      string wordStr = m_phraseDecoder->GetTargetSymbol(id);
+
+      // [X][NP] -> NP
+      bool isNT = wordStr.size() > 1
+                  && wordStr[0] == '['
+                  && wordStr[wordStr.size() - 1] == ']';
+      if (isNT) {
+        size_t startPos = wordStr.find("][");
+        if (startPos == string::npos) {
+          startPos = 1;
+        } else {
+          startPos += 2;
+        }
+        wordStr = wordStr.substr(startPos, wordStr.size() - startPos - 1);
+      }
+
+      m_targetVocab[id] = vocab.AddFactor(wordStr, system, isNT);
+      m_targetIsNT[id] = isNT;
+    }
+  }
+}
+
+void PhraseTableCompact::CleanUpAfterSentenceProcessing() const
+{
+  m_phraseDecoder->PruneCache();
+}
+
+TargetPhrases* PhraseTableCompact::Lookup(const Manager &mgr, MemPool &pool,
+    InputPath &inputPath) const
+{
+  const Phrase<Moses2::Word> &sourcePhrase = inputPath.subPhrase;
+  const System &system = mgr.system;
+
+  // There is no such source phrase if source phrase is longer than longest
+  // observed source phrase during compilation
+  size_t sourceSize = sourcePhrase.GetSize();
+  if (sourceSize > m_phraseDecoder->GetMaxSourcePhraseLength()) {
+    return NULL;
+  }
+
+  std::vector<std::string> sourceWords(sourceSize);
+  for (size_t i = 0; i < sourceSize; ++i) {
+    sourceWords[i] = sourcePhrase[i].GetString(m_input);
+  }
+
+  TargetPhraseVectorPtr decodedPhraseColl
+    = m_phraseDecoder->CreateTargetPhraseCollection(sourceWords, true);
+  if (decodedPhraseColl == NULL || decodedPhraseColl->empty()) {
+    return NULL;
+  }
+
+  const FeatureFunctions &ffs = system.featureFunctions;
+
+  TargetPhrases *tps = new (pool.Allocate<TargetPhrases>())
+  TargetPhrases(pool, decodedPhraseColl->size());
+
+  BOOST_FOREACH(const TPCompact &tpCompact, *decodedPhraseColl) {
+    TargetPhraseImpl *tp = CreateTargetPhrase(pool, system, tpCompact);
+    if (tp == NULL) {
+      continue;
+    }
+    ffs.EvaluateInIsolation(pool, system, sourcePhrase, *tp);
+    tps->AddTargetPhrase(*tp);
+  }
+
+  tps->SortAndPrune(m_tableLimit);
+  ffs.EvaluateAfterTablePruning(pool, *tps, sourcePhrase);
+
+  return tps;
+}
+
+TargetPhraseImpl *PhraseTableCompact::CreateTargetPhrase(MemPool &pool,
+    const System &system,
+    const TPCompact &tpCompact) const
+{
+  size_t numFactors = m_output.size();
+  size_t size = tpCompact.words.size();
+
+  // symbol id out of range can only come from a hash false positive
+  BOOST_FOREACH(unsigned id, tpCompact.words) {
+    if ((id + 1) * numFactors > m_targetVocab.size()) {
+      return NULL;
+    }
+  }
+
+  TargetPhraseImpl *tp =
+    new (pool.Allocate<TargetPhraseImpl>()) TargetPhraseImpl(pool, *this,
+        system, size);
+
+  tp->GetScores().PlusEquals(system, *this, tpCompact.scores);
+
+  for (size_t targetPos = 0; targetPos < size; ++targetPos) {
+    const Factor * const *factors = &m_targetVocab[tpCompact.words[targetPos] * numFactors];
+    Word &word = (*tp)[targetPos];
+    for (size_t i = 0; i < numFactors; ++i) {
+      word[m_output[i]] = factors[i];
+    }
+  }
+
+  tp->SetAlignTerm(tpCompact.alignment);
+
+  return tp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SCFG
+///////////////////////////////////////////////////////////////////////////////
+
+void PhraseTableCompact::InitActiveChart(
+  MemPool &pool,
+  const SCFG::Manager &mgr,
+  SCFG::InputPath &path) const
+{
+  size_t ptInd = GetPtInd();
+  SCFG::ActiveChartEntry *chartEntry = new (pool.Allocate<SCFG::ActiveChartEntry>()) SCFG::ActiveChartEntry(pool);
+  path.AddActiveChartEntry(ptInd, chartEntry);
+}
+
+void PhraseTableCompact::Lookup(MemPool &pool,
+                                const SCFG::Manager &mgr,
+                                size_t maxChartSpan,
+                                const SCFG::Stacks &stacks,
+                                SCFG::InputPath &path) const
+{
+  if (path.range.GetNumWordsCovered() > maxChartSpan) {
+    return;
+  }
+
+  size_t endPos = path.range.GetEndPos();
+
+  const SCFG::InputPath *prevPath = static_cast<const SCFG::InputPath*>(path.prefixPath);
+  UTIL_THROW_IF2(prevPath == NULL, "prefixPath == NULL");
+
+  // TERMINAL
+  const SCFG::Word &lastWord = path.subPhrase.Back();
+
+  const SCFG::InputPath &subPhrasePath = *mgr.GetInputPaths().GetMatrix().GetValue(endPos, 1);
+
+  LookupGivenWord(pool, mgr, *prevPath, lastWord, NULL, subPhrasePath.range, path);
+
+  // NON-TERMINAL
+  while (prevPath) {
+    const Range &prevRange = prevPath->range;
+
+    size_t startPos = prevRange.GetEndPos() + 1;
+    size_t ntSize = endPos - startPos + 1;
+    const SCFG::InputPath &subPhrasePath = *mgr.GetInputPaths().GetMatrix().GetValue(startPos, ntSize);
+
+    LookupNT(pool, mgr, subPhrasePath.range, *prevPath, stacks, path);
+
+    prevPath = static_cast<const SCFG::InputPath*>(prevPath->prefixPath);
+  }
+}
+
+std::string PhraseTableCompact::GetSourceString(const SCFG::Word &word) const
+{
+  if (word.isNonTerminal) {
+    // source side of hiero rules is unlabelled
+    return "[X][" + word[0]->GetString().as_string() + "]";
+  } else {
+    return word.GetString(m_input);
+  }
+}
+
+void PhraseTableCompact::LookupGivenNode(
+  MemPool &pool,
+  const SCFG::Manager &mgr,
+  const SCFG::ActiveChartEntry &prevEntry,
+  const SCFG::Word &wordSought,
+  const Moses2::Hypotheses *hypos,
+  const Moses2::Range &subPhraseRange,
+  SCFG::InputPath &outPath) const
+{
+  const SCFG::SymbolBind &prevSymbolBind = prevEntry.GetSymbolBind();
+
+  // source tokens of the rule, incl. the LHS
+  size_t numTokens = prevSymbolBind.GetSize() + 2;
+  size_t maxTokens = m_phraseDecoder->GetMaxSourcePhraseLength();
+  if (numTokens > maxTokens) {
+    return;
+  }
+  size_t numNT = prevSymbolBind.numNT + (hypos ? 1 : 0);
+  if (numNT > m_maxNonTerms) {
+    return;
+  }
+
+  std::vector<std::string> sourceWords;
+  sourceWords.reserve(numTokens);
+  BOOST_FOREACH(const SCFG::SymbolBindElement &ele, prevSymbolBind.coll) {
+    sourceWords.push_back(GetSourceString(*ele.word));
+  }
+  sourceWords.push_back(GetSourceString(wordSought));
+  sourceWords.push_back("[X]");
+
+  // The table has no prefix information, only hashes of whole rules. Extend
+  // the active chart for as long as a longer rule could still exist, going by
+  // the length of the longest rule and the non-terminal limit
+  SCFG::ActiveChartEntry *chartEntry = new (pool.Allocate<SCFG::ActiveChartEntry>()) SCFG::ActiveChartEntry(pool, prevEntry);
+  chartEntry->AddSymbolBindElement(subPhraseRange, wordSought, hypos, *this);
+
+  if (numTokens < maxTokens) {
+    size_t ptInd = GetPtInd();
+    outPath.AddActiveChartEntry(ptInd, chartEntry);
+  }
+
+  TargetPhraseVectorPtr decodedPhraseColl
+    = m_phraseDecoder->CreateTargetPhraseCollection(sourceWords, true);
+  if (decodedPhraseColl == NULL || decodedPhraseColl->empty()) {
+    return;
+  }
+
+  const System &system = mgr.system;
+  const FeatureFunctions &ffs = system.featureFunctions;
+  const Phrase<SCFG::Word> &sourcePhrase = outPath.subPhrase;
+
+  SCFG::TargetPhrases *tps = new (pool.Allocate<SCFG::TargetPhrases>())
+  SCFG::TargetPhrases(pool, decodedPhraseColl->size());
+
+  BOOST_FOREACH(const TPCompact &tpCompact, *decodedPhraseColl) {
+    SCFG::TargetPhraseImpl *tp = CreateTargetPhraseSCFG(pool, system, tpCompact);
+    if (tp == NULL) {
+      continue;
+    }
+    ffs.EvaluateInIsolation(pool, system, sourcePhrase, *tp);
+    tps->AddTargetPhrase(*tp);
+  }
+
+  tps->SortAndPrune(m_tableLimit);
+  ffs.EvaluateAfterTablePruning(pool, *tps, sourcePhrase);
+
+  outPath.AddTargetPhrasesToPath(pool, system, *this, *tps, chartEntry->GetSymbolBind());
+}
+
+SCFG::TargetPhraseImpl *PhraseTableCompact::CreateTargetPhraseSCFG(
+  MemPool &pool,
+  const System &system,
+  const TPCompact &tpCompact) const
+{
+  // last word is the LHS
+  size_t size = tpCompact.words.size();
+  if (size == 0) {
+    return NULL;
+  }
+  BOOST_FOREACH(unsigned id, tpCompact.words) {
+    if (id >= m_targetVocab.size()) {
+      return NULL;
+    }
+  }
+
+  SCFG::TargetPhraseImpl *tp =
+    new (pool.Allocate<SCFG::TargetPhraseImpl>()) SCFG::TargetPhraseImpl(pool, *this,
+        system, size - 1);
+
+  tp->GetScores().PlusEquals(system, *this, tpCompact.scores);
+
+  for (size_t i = 0; i < size - 1; ++i) {
+    unsigned id = tpCompact.words[i];
+    SCFG::Word &word = (*tp)[i];
+    word[0] = m_targetVocab[id];
+    word.isNonTerminal = m_targetIsNT[id];
+  }
+
+  unsigned lhsId = tpCompact.words.back();
+  tp->lhs[0] = m_targetVocab[lhsId];
+  tp->lhs.isNonTerminal = m_targetIsNT[lhsId];
+
+  // align
+  AlignmentInfo::CollType alignTerm, alignNonTerm;
+  BOOST_FOREACH(const AlignPointSizeT &alignPoint, tpCompact.alignment) {
+    if (alignPoint.second >= size - 1) {
+      continue;
+    }
+    if ((*tp)[alignPoint.second].isNonTerminal) {
+      alignNonTerm.insert(alignPoint);
+    } else {
+      alignTerm.insert(alignPoint);
+    }
+  }
+
+  tp->Parent::SetAlignTerm(alignTerm);
+  tp->SetAlignNonTerm(*AlignmentInfoCollection::Instance().Add(alignNonTerm));
+
+  return tp;
+}
+
+}
+
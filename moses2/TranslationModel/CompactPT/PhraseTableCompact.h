@@ -0,0 +1,103 @@
+/*
+ * PhraseTableCompact.h
+ *
+ * Compact phrase table (.minphr, created with processPhraseTableMin).
+ * Supports phrase-based and hierarchical tables.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../PhraseTable.h"
+#include "../../Phrase.h"
+#include "BlockHashIndex.h"
+#include "StringVector.h"
+#include "TargetPhraseCollectionCache.h"
+
+namespace Moses2
+{
+class Factor;
+class MemPool;
+class System;
+class TargetPhrases;
+class TargetPhraseImpl;
+class PhraseDecoder;
+
+namespace SCFG
+{
+class TargetPhraseImpl;
+class TargetPhrases;
+}
+
+class PhraseTableCompact: public PhraseTable
+{
+  friend class PhraseDecoder;
+
+public:
+  PhraseTableCompact(size_t startInd, const std::string &line);
+  virtual ~PhraseTableCompact();
+  void Load(System &system);
+
+  virtual void SetParameter(const std::string& key, const std::string& value);
+
+  virtual void CleanUpAfterSentenceProcessing() const;
+
+  virtual TargetPhrases *Lookup(const Manager &mgr, MemPool &pool,
+                                InputPath &inputPath) const;
+
+  // SCFG
+  void InitActiveChart(
+    MemPool &pool,
+    const SCFG::Manager &mgr,
+    SCFG::InputPath &path) const;
+
+  virtual void Lookup(MemPool &pool,
+                      const SCFG::Manager &mgr,
+                      size_t maxChartSpan,
+                      const SCFG::Stacks &stacks,
+                      SCFG::InputPath &path) const;
+
+protected:
+  bool m_inMemory;
+
+  // SCFG: rules have at most this many non-terminals on the source side. The
+  // table can't tell which prefixes lead to rules, so this is what bounds the
+  // active chart
+  size_t m_maxNonTerms;
+
+  BlockHashIndex m_hash;
+  PhraseDecoder* m_phraseDecoder;
+
+  StringVector<unsigned char, size_t, MmapAllocator>  m_targetPhrasesMapped;
+  StringVector<unsigned char, size_t, std::allocator> m_targetPhrasesMemory;
+
+  // target symbol id -> factors. For phrase-based tables there are
+  // m_output.size() entries per symbol, for SCFG exactly one
+  std::vector<const Factor*> m_targetVocab;
+  std::vector<bool> m_targetIsNT;
+
+  void CreateTargetVocab(System &system);
+
+  TargetPhraseImpl *CreateTargetPhrase(MemPool &pool, const System &system,
+                                       const TPCompact &tpCompact) const;
+
+  // SCFG
+  void LookupGivenNode(
+    MemPool &pool,
+    const SCFG::Manager &mgr,
+    const SCFG::ActiveChartEntry &prevEntry,
+    const SCFG::Word &wordSought,
+    const Moses2::Hypotheses *hypos,
+    const Moses2::Range &subPhraseRange,
+    SCFG::InputPath &outPath) const;
+
+  SCFG::TargetPhraseImpl *CreateTargetPhraseSCFG(MemPool &pool,
+      const System &system,
+      const TPCompact &tpCompact) const;
+
+  std::string GetSourceString(const SCFG::Word &word) const;
+
+};
+
+}
+
@@ -22,26 +22,26 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #pragma once
 
 #include <map>
+#include <string>
 #include <set>
 #include <vector>
 
 #include <boost/thread/tss.hpp>
 #include <boost/shared_ptr.hpp>
 
-#include "../../Word.h"
-#include "../../Phrase.h"
-
 namespace Moses2
 {
 typedef std::pair<size_t, size_t> AlignPointSizeT;
 
-struct PhraseCompact : public std::vector<Word> {
-public:
-  PhraseCompact(const Phrase<Word> &copy);
-};
+// Source phrase as it is keyed in the phrase table: factored words joined
+// by spaces. For SCFG rules this includes the non-terminals and the LHS.
+typedef std::string PhraseCompact;
 
+// Decoded target phrase. Words are ids into the phrase table's target
+// symbol table, they are mapped to factors when the phrase is
+// materialized as a TargetPhraseImpl
 struct TPCompact {
-  std::vector<Word> words;
+  std::vector<unsigned> words;
   std::set<AlignPointSizeT> alignment;
   std::vector<float> scores;
 
@@ -70,7 +70,7 @@ private:
   };
 
   typedef std::map<PhraseCompact, LastUsed> CacheMap;
-  static boost::thread_specific_ptr<CacheMap> m_phraseCache;
+  mutable boost::thread_specific_ptr<CacheMap> m_phraseCache;
 
 public:
 
@@ -106,7 +106,7 @@ public:
   }
 
   /** retrieve translations for source phrase from persistent cache **/
-  void Cache(const Phrase<Word> &sourcePhrase, TargetPhraseVectorPtr tpv,
+  void Cache(const PhraseCompact &sourcePhrase, TargetPhraseVectorPtr tpv,
              size_t bitsLeft = 0, size_t maxRank = 0) {
     if(!m_phraseCache.get())
       m_phraseCache.reset(new CacheMap());
@@ -127,7 +127,7 @@ public:
     }
   }
 
-  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase<Word> &sourcePhrase) {
+  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const PhraseCompact &sourcePhrase) {
     if(!m_phraseCache.get())
       m_phraseCache.reset(new CacheMap());
     iterator it = m_phraseCache->find(sourcePhrase);
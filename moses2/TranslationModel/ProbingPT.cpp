@@ -185,14 +185,51 @@ void ProbingPT::CreateAlignmentMap(System &system, const std::string path)
 
 void ProbingPT::Lookup(const Manager &mgr, InputPathsBase &inputPaths) const
 {
+  // query the table for all paths of the sentence in one batch
+  MemPool &pool = mgr.GetPool();
+  Vector<InputPath*> queryPaths(pool);
+  Vector<uint64_t> keys(pool);
+
   BOOST_FOREACH(InputPathBase *pathBase, inputPaths) {
     InputPath *path = static_cast<InputPath*>(pathBase);
 
     if (SatisfyBackoff(mgr, *path)) {
-      TargetPhrases *tpsPtr;
-      tpsPtr = Lookup(mgr, mgr.GetPool(), *path);
-      path->AddTargetPhrases(*this, tpsPtr);
+      const Phrase<Moses2::Word> &sourcePhrase = path->subPhrase;
+
+      // get hash for source phrase
+      std::pair<bool, uint64_t> keyStruct = GetKey(sourcePhrase);
+      if (!keyStruct.first) {
+        path->AddTargetPhrases(*this, NULL);
+        continue;
+      }
+
+      // check in cache
+      CachePb::const_iterator iter = m_cachePb.find(keyStruct.second);
+      if (iter != m_cachePb.end()) {
+        path->AddTargetPhrases(*this, iter->second);
+        continue;
+      }
+
+      queryPaths.push_back(path);
+      keys.push_back(keyStruct.second);
+    }
+  }
+
+  if (keys.empty()) {
+    return;
+  }
+
+  Vector<std::pair<bool, uint64_t> > results(pool, keys.size());
+  m_engine->query(&keys[0], keys.size(), &results[0]);
+
+  for (size_t i = 0; i < queryPaths.size(); ++i) {
+    InputPath *path = queryPaths[i];
+    TargetPhrases *tps = NULL;
+    if (results[i].first) {
+      tps = CreateTargetPhrases(pool, mgr.system, path->subPhrase,
+                                m_engine->memTPS + results[i].second);
     }
+    path->AddTargetPhrases(*this, tps);
   }
 }
 
@@ -265,26 +302,35 @@ TargetPhrases *ProbingPT::CreateTargetPhrases(MemPool &pool,
 
   if (query_result.first) {
     const char *offset = m_engine->memTPS + query_result.second;
-    uint64_t *numTP = (uint64_t*) offset;
+    tps = CreateTargetPhrases(pool, system, sourcePhrase, offset);
+  }
 
-    tps = new (pool.Allocate<TargetPhrases>()) TargetPhrases(pool, *numTP);
+  return tps;
+}
 
-    offset += sizeof(uint64_t);
-    for (size_t i = 0; i < *numTP; ++i) {
-      TargetPhraseImpl *tp = CreateTargetPhrase(pool, system, offset);
-      assert(tp);
-      const FeatureFunctions &ffs = system.featureFunctions;
-      ffs.EvaluateInIsolation(pool, system, sourcePhrase, *tp);
+TargetPhrases *ProbingPT::CreateTargetPhrases(MemPool &pool,
+    const System &system, const Phrase<Moses2::Word> &sourcePhrase,
+    const char *offset) const
+{
+  uint64_t *numTP = (uint64_t*) offset;
 
-      tps->AddTargetPhrase(*tp);
+  TargetPhrases *tps = new (pool.Allocate<TargetPhrases>()) TargetPhrases(pool, *numTP);
 
-    }
+  offset += sizeof(uint64_t);
+  for (size_t i = 0; i < *numTP; ++i) {
+    TargetPhraseImpl *tp = CreateTargetPhrase(pool, system, offset);
+    assert(tp);
+    const FeatureFunctions &ffs = system.featureFunctions;
+    ffs.EvaluateInIsolation(pool, system, sourcePhrase, *tp);
+
+    tps->AddTargetPhrase(*tp);
 
-    tps->SortAndPrune(m_tableLimit);
-    system.featureFunctions.EvaluateAfterTablePruning(pool, *tps, sourcePhrase);
-    //cerr << *tps << endl;
   }
 
+  tps->SortAndPrune(m_tableLimit);
+  system.featureFunctions.EvaluateAfterTablePruning(pool, *tps, sourcePhrase);
+  //cerr << *tps << endl;
+
   return tps;
 }
 
@@ -110,6 +110,9 @@ protected:
                         InputPath &inputPath) const;
   TargetPhrases *CreateTargetPhrases(MemPool &pool, const System &system,
                                      const Phrase<Moses2::Word> &sourcePhrase, uint64_t key) const;
+  // offset = start of the target phrase collection in the table
+  TargetPhrases *CreateTargetPhrases(MemPool &pool, const System &system,
+                                     const Phrase<Moses2::Word> &sourcePhrase, const char *offset) const;
   TargetPhraseImpl *CreateTargetPhrase(MemPool &pool, const System &system,
                                        const char *&offset) const;
 
@@ -0,0 +1,280 @@
+/*
+ * TranslationPipeline.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/thread.hpp>
+#include "TranslationPipeline.h"
+#include "TranslationTask.h"
+#include "System.h"
+#include "legacy/ThreadPool.h"
+#include "legacy/OutputCollector.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+namespace
+{
+
+class PipelineWorker: public Task
+{
+public:
+  PipelineWorker(TranslationPipeline &pipeline)
+    :m_pipeline(pipeline) {
+  }
+
+  virtual void Run() {
+    m_pipeline.Work();
+  }
+
+protected:
+  TranslationPipeline &m_pipeline;
+};
+
+size_t CountWords(const std::string &line)
+{
+  size_t ret = 0;
+  bool inWord = false;
+  for (size_t i = 0; i < line.size(); ++i) {
+    bool space = (line[i] == ' ' || line[i] == '\t');
+    ret += (!space && !inWord);
+    inWord = !space;
+  }
+  return ret;
+}
+
+}
+
+TranslationPipeline::TranslationPipeline(System &system, ThreadPool &pool, size_t numThreads)
+  :m_system(system)
+  ,m_pool(pool)
+  ,m_numThreads(std::max<size_t>(numThreads, 1))
+  ,m_queue(2 * m_numThreads)
+  ,m_queueItems(0)
+  ,m_queueSpace(2 * m_numThreads)
+  ,m_freeSlots(0)
+  ,m_slotsReady(0)
+  ,m_numSentences(std::numeric_limits<long>::max())
+  ,m_failed(false)
+{
+  system.params.SetParameter<size_t>(m_batchWords, "input-batch-words", 16);
+  system.params.SetParameter<size_t>(m_batchSentences, "input-batch-size", 32);
+  m_batchSentences = std::max<size_t>(m_batchSentences, 1);
+
+  m_longestFirst = system.params.GetParam("longest-first");
+  m_window = 0;
+  if (m_longestFirst) {
+    system.params.SetParameter<size_t>(m_window, "longest-first-window", 1000);
+    if (system.params.GetParam("longest-first-model")) {
+      m_costModel.reset(new TaskCostModel);
+    }
+  }
+
+  // enough for every batch that can be queued or running, plus the one being read
+  // and the window held back for sorting
+  m_numSlots = (2 * m_numThreads + m_numThreads + 1) * m_batchSentences + m_window;
+  m_slots.reset(new OutputSlot[m_numSlots]);
+  for (size_t i = 0; i < m_numSlots; ++i) {
+    m_slots[i].ready = false;
+    m_freeSlots.post();
+  }
+}
+
+TranslationPipeline::~TranslationPipeline()
+{
+}
+
+void TranslationPipeline::Run(std::istream &inStream)
+{
+  boost::thread writer(boost::bind(&TranslationPipeline::Write, this));
+
+  for (size_t i = 0; i < m_numThreads; ++i) {
+    m_pool.Submit(boost::make_shared<PipelineWorker>(boost::ref(*this)));
+  }
+
+  long translationId = 0;
+  InputBatch *batch = NULL;
+  size_t batchWords = 0;
+
+  std::vector<InputBatch*> window;
+  size_t windowSentences = 0;
+
+  string line;
+  while (!m_failed.load() && getline(inStream, line)) {
+    if (batch == NULL) {
+      batch = new InputBatch;
+      batch->firstId = translationId;
+      batch->cost = 0;
+      batchWords = 0;
+    }
+
+    // don't read ahead of the writer by more than the ring
+    util::WaitSemaphore(m_freeSlots);
+
+    size_t words = CountWords(line);
+    batchWords += words;
+    batch->lines.push_back(line);
+    batch->lengths.push_back(words);
+    if (m_longestFirst) {
+      batch->cost += m_costModel ? m_costModel->Estimate(words) : words;
+    }
+    ++translationId;
+
+    if (batchWords >= m_batchWords || batch->lines.size() >= m_batchSentences) {
+      if (m_longestFirst) {
+        window.push_back(batch);
+        windowSentences += batch->lines.size();
+        if (windowSentences >= m_window) {
+          SubmitWindow(window);
+          windowSentences = 0;
+        }
+      } else {
+        Submit(batch);
+      }
+      batch = NULL;
+    }
+  }
+
+  if (batch) {
+    window.push_back(batch);
+  }
+  SubmitWindow(window);
+
+  // stop workers
+  for (size_t i = 0; i < m_numThreads; ++i) {
+    Submit(NULL);
+  }
+
+  m_numSentences = translationId;
+  m_slotsReady.post();
+
+  writer.join();
+
+  if (m_error) {
+    std::rethrow_exception(m_error);
+  }
+}
+
+void TranslationPipeline::Submit(InputBatch *batch)
+{
+  util::WaitSemaphore(m_queueSpace);
+  bool pushed = m_queue.bounded_push(batch);
+  assert(pushed);
+  m_queueItems.post();
+}
+
+void TranslationPipeline::SubmitWindow(std::vector<InputBatch*> &window)
+{
+  std::stable_sort(window.begin(), window.end(), MoreCostly);
+  for (size_t i = 0; i < window.size(); ++i) {
+    Submit(window[i]);
+  }
+  window.clear();
+}
+
+void TranslationPipeline::Work()
+{
+  while (true) {
+    util::WaitSemaphore(m_queueItems);
+    InputBatch *batch;
+    bool popped = m_queue.pop(batch);
+    assert(popped);
+    m_queueSpace.post();
+
+    if (batch == NULL) {
+      break;
+    }
+
+    for (size_t i = 0; i < batch->lines.size(); ++i) {
+      long translationId = batch->firstId + i;
+      OutputSlot &slot = m_slots[translationId % m_numSlots];
+
+      // after a failure, the rest only has to drain
+      if (!m_failed.load()) {
+        try {
+          Translate(*batch, i, slot);
+        } catch (...) {
+          slot.best.clear();
+          slot.nbest.clear();
+          slot.detailed.clear();
+          boost::mutex::scoped_lock lock(m_errorLock);
+          if (!m_error) {
+            m_error = std::current_exception();
+          }
+          m_failed = true;
+        }
+      }
+
+      // the writer waits for every slot, failed or not
+      slot.ready.store(true, boost::memory_order_release);
+      m_slotsReady.post();
+    }
+
+    delete batch;
+  }
+}
+
+void TranslationPipeline::Translate(const InputBatch &batch, size_t i, OutputSlot &slot)
+{
+  TranslationTask task(m_system, batch.lines[i], batch.firstId + i);
+  if (m_costModel && batch.lengths[i]) {
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    task.Run(slot.best, slot.nbest, slot.detailed);
+    boost::posix_time::time_duration took = boost::posix_time::microsec_clock::universal_time() - start;
+    m_costModel->Update(batch.lengths[i], took.total_microseconds() * 1e-6f);
+  } else {
+    task.Run(slot.best, slot.nbest, slot.detailed);
+  }
+}
+
+void TranslationPipeline::Write()
+{
+  bool nbest = m_system.options.nbest.nbest_size;
+  bool detailed = !m_system.options.output.detailed_transrep_filepath.empty();
+
+  // posts taken from m_slotsReady that haven't been matched to a slot yet
+  size_t credit = 0;
+
+  long translationId = 0;
+  while (translationId < m_numSentences.load()) {
+    OutputSlot &slot = m_slots[translationId % m_numSlots];
+    if (!slot.ready.load(boost::memory_order_acquire)) {
+      util::WaitSemaphore(m_slotsReady);
+      ++credit;
+      continue;
+    }
+
+    // every slot written uses up one post
+    if (credit) {
+      --credit;
+    } else {
+      util::WaitSemaphore(m_slotsReady);
+    }
+
+    // in order, so the collectors write straight through
+    m_system.bestCollector->Write(translationId, slot.best);
+    if (nbest) {
+      m_system.nbestCollector->Write(translationId, slot.nbest);
+    }
+    if (detailed) {
+      m_system.detailedTranslationCollector->Write(translationId, slot.detailed);
+    }
+
+    slot.best.clear();
+    slot.nbest.clear();
+    slot.detailed.clear();
+    slot.ready.store(false, boost::memory_order_relaxed);
+    m_freeSlots.post();
+
+    ++translationId;
+  }
+}
+
+}
+
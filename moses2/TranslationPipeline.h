@@ -0,0 +1,104 @@
+/*
+ * TranslationPipeline.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+#pragma once
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "util/pcqueue.hh"
+
+namespace Moses2
+{
+
+class System;
+class ThreadPool;
+class TaskCostModel;
+
+/** Batch mode decoding as a bounded pipeline:
+ *  - the calling thread reads input and groups short sentences into
+ *    micro-batches, which are decoded one after the other by a single worker
+ *  - batches go through a fixed-size lock-free queue to a long-running task
+ *    on each thread of the pool
+ *  - workers put translations into a ring of output slots, indexed by
+ *    translation id, and a single writer thread drains the ring in order.
+ * The reader has to claim an output slot for every sentence before queueing
+ * it, so nothing can run more than the ring size ahead of the writer.
+ * With longest-first, the reader holds back a window of input and queues it
+ * most expensive batch first. Output is still written in order.
+ * If a sentence fails, the pipeline stops reading, outputs empty lines for
+ * everything that was still in flight and Run() rethrows the first error.
+ */
+class TranslationPipeline
+{
+public:
+  TranslationPipeline(System &system, ThreadPool &pool, size_t numThreads);
+  ~TranslationPipeline();
+
+  // translate every line, returns once all output is written. Rethrows the
+  // first exception thrown by a worker
+  void Run(std::istream &inStream);
+
+  // worker loop, run on each thread of the pool
+  void Work();
+
+protected:
+  struct InputBatch {
+    long firstId;
+    std::vector<std::string> lines;
+    std::vector<size_t> lengths;
+    float cost;
+  };
+
+  static bool MoreCostly(const InputBatch *a, const InputBatch *b) {
+    return a->cost > b->cost;
+  }
+
+  struct OutputSlot {
+    std::string best, nbest, detailed;
+    boost::atomic<bool> ready;
+  };
+
+  System &m_system;
+  ThreadPool &m_pool;
+  size_t m_numThreads;
+
+  // close a batch once it has this many words or sentences
+  size_t m_batchWords;
+  size_t m_batchSentences;
+
+  // longest-first scheduling
+  bool m_longestFirst;
+  size_t m_window;
+  boost::scoped_ptr<TaskCostModel> m_costModel;
+
+  boost::lockfree::queue<InputBatch*, boost::lockfree::fixed_sized<true> > m_queue;
+  util::Semaphore m_queueItems, m_queueSpace;
+
+  size_t m_numSlots;
+  boost::scoped_array<OutputSlot> m_slots;
+  util::Semaphore m_freeSlots;
+  // posted once for each slot that becomes ready, and at the end of input
+  util::Semaphore m_slotsReady;
+  boost::atomic<long> m_numSentences;
+
+  // first error in a worker
+  boost::atomic<bool> m_failed;
+  boost::mutex m_errorLock;
+  std::exception_ptr m_error;
+
+  void Submit(InputBatch *batch);
+  void SubmitWindow(std::vector<InputBatch*> &window);
+  void Write();
+  void Translate(const InputBatch &batch, size_t i, OutputSlot &slot);
+};
+
+}
+
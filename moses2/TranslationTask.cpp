@@ -26,26 +26,39 @@ TranslationTask::~TranslationTask()
 
 void TranslationTask::Run()
 {
+  long translationId = m_mgr->GetTranslationId();
+  const System &system = m_mgr->system;
 
-  m_mgr->Decode();
+  string best, nbest, detailed;
+  Run(best, nbest, detailed);
+
+  system.bestCollector->Write(translationId, best);
+
+  if (system.options.nbest.nbest_size) {
+    system.nbestCollector->Write(translationId, nbest);
+  }
+
+  if (!system.options.output.detailed_transrep_filepath.empty()) {
+    system.detailedTranslationCollector->Write(translationId, detailed);
+  }
+}
 
-  string out;
+void TranslationTask::Run(std::string &best, std::string &nbest, std::string &detailed)
+{
+  m_mgr->Decode();
 
-  out = m_mgr->OutputBest() + "\n";
-  m_mgr->system.bestCollector->Write(m_mgr->GetTranslationId(), out);
+  best = m_mgr->OutputBest() + "\n";
 
   if (m_mgr->system.options.nbest.nbest_size) {
-    out = m_mgr->OutputNBest();
-    m_mgr->system.nbestCollector->Write(m_mgr->GetTranslationId(), out);
+    nbest = m_mgr->OutputNBest();
   }
 
   if (!m_mgr->system.options.output.detailed_transrep_filepath.empty()) {
-    out = m_mgr->OutputTransOpt();
-    m_mgr->system.detailedTranslationCollector->Write(m_mgr->GetTranslationId(), out);
+    detailed = m_mgr->OutputTransOpt();
   }
 
   delete m_mgr;
+  m_mgr = NULL;
 }
 
 }
-
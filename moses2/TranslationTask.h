@@ -17,6 +17,10 @@ public:
   virtual ~TranslationTask();
   virtual void Run();
 
+  // decode and return the output instead of writing it to the collectors.
+  // nbest and detailed are only filled in if they're switched on
+  void Run(std::string &best, std::string &nbest, std::string &detailed);
+
 protected:
   ManagerBase *m_mgr;
 };
@@ -196,6 +196,16 @@ Parameter::Parameter()
   // input options
   po::options_description input_opts("Input Format Options");
   AddParam(input_opts, "input-factors", "list of factors in the input");
+  AddParam(input_opts, "input-batch-words",
+           "Batch mode: give short sentences to a thread together until they have this many words. Default = 16");
+  AddParam(input_opts, "input-batch-size",
+           "Batch mode: maximum number of sentences given to a thread together. Default = 32");
+  AddParam(input_opts, "longest-first",
+           "Batch mode: translate sentences longest first within a window of input. Output order is unchanged");
+  AddParam(input_opts, "longest-first-model",
+           "With longest-first, order by decoding time per sentence length, learnt while decoding");
+  AddParam(input_opts, "longest-first-window",
+           "With longest-first, number of sentences read ahead and sorted. Default = 1000");
   AddParam(input_opts, "inputtype",
            "text (0), confusion network (1), word lattice (2), tree (3) (default = 0)");
   AddParam(input_opts, "xml-input", "xi",
@@ -308,6 +318,10 @@ Parameter::Parameter()
            "Max. number of seconds the server will keep a persistent connection alive.");
   AddParam(server_opts,"server-timeout",
            "Max. number of seconds the server will wait for a client to submit a request once a connection has been established.");
+  AddParam(server_opts,"server-max-queue",
+           "Max. No. of segments waiting to be translated. Requests that don't fit are refused (default 0 = no limit).");
+  AddParam(server_opts,"server-degraded-stack",
+           "Stack size used for segments that would otherwise miss their deadline (default 10).");
 
   po::options_description irstlm_opts("IRSTLM Options");
   //AddParam(irstlm_opts, "clean-lm-cache",
@@ -358,6 +372,8 @@ Parameter::Parameter()
   AddParam(misc_opts, "cpu-affinity-offset", "CPU Affinity. Default = -1 (no affinity)");
   AddParam(misc_opts, "cpu-affinity-increment",
            "Set to 1 (default) to put each thread on different cores. 0 to run all threads on one core");
+  AddParam(misc_opts, "pool-max-retained",
+           "Memory (MB) each decoding thread keeps for its per-sentence pool after a sentence needed more. Default = 0 (keep everything)");
 
   // Compact phrase table and reordering table.
   po::options_description cpt_opts(
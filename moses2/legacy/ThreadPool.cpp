@@ -28,6 +28,7 @@
 #include <errno.h>
 #include <thread>
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include "ThreadPool.h"
 
 using namespace std;
@@ -38,9 +39,34 @@ namespace Moses2
 #define handle_error_en(en, msg) \
   do { errno = en; perror(msg); exit(EXIT_FAILURE); } while (0)
 
+float TaskCostModel::Estimate(size_t length) const
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (m_totalWords == 0) {
+    return length;
+  }
+  if (length < m_timeByLength.size() && m_timeByLength[length].second) {
+    const std::pair<float, size_t> &obs = m_timeByLength[length];
+    return obs.first / obs.second;
+  }
+  return m_totalTime / m_totalWords * length;
+}
+
+void TaskCostModel::Update(size_t length, float seconds)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (length >= m_timeByLength.size()) {
+    m_timeByLength.resize(length + 1, std::make_pair(0.0f, (size_t) 0));
+  }
+  m_timeByLength[length].first += seconds;
+  ++m_timeByLength[length].second;
+  m_totalTime += seconds;
+  m_totalWords += length;
+}
+
 ThreadPool::ThreadPool(size_t numThreads, int cpuAffinityOffset,
                        int cpuAffinityIncr) :
-  m_stopped(false), m_stopping(false), m_queueLimit(0)
+  m_seq(0), m_stopped(false), m_stopping(false), m_queueLimit(0)
 {
 #if defined(_WIN32) || defined(_WIN64)
   size_t numCPU = std::thread::hardware_concurrency();
@@ -93,6 +119,7 @@ void ThreadPool::Execute()
 {
   do {
     boost::shared_ptr<Task> task;
+    size_t length = 0;
     {
       // Find a job to perform
       boost::mutex::scoped_lock lock(m_mutex);
@@ -100,7 +127,8 @@ void ThreadPool::Execute()
         m_threadNeeded.wait(lock);
       }
       if (!m_stopped && !m_tasks.empty()) {
-        task = m_tasks.front();
+        task = m_tasks.top().task;
+        length = m_tasks.top().length;
         m_tasks.pop();
       }
     }
@@ -109,13 +137,31 @@ void ThreadPool::Execute()
       // must read from task before run. otherwise task may be deleted by main thread
       // race condition
       task->DeleteAfterExecution();
-      task->Run();
+      if (m_costModel && length) {
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        task->Run();
+        boost::posix_time::time_duration took = boost::posix_time::microsec_clock::universal_time() - start;
+        m_costModel->Update(length, took.total_microseconds() * 1e-6f);
+      } else {
+        task->Run();
+      }
     }
     m_threadAvailable.notify_all();
   } while (!m_stopped);
 }
 
 void ThreadPool::Submit(boost::shared_ptr<Task> task)
+{
+  Push(task, 0, 0);
+}
+
+void ThreadPool::Submit(boost::shared_ptr<Task> task, size_t length)
+{
+  float cost = m_costModel ? m_costModel->Estimate(length) : length;
+  Push(task, cost, length);
+}
+
+void ThreadPool::Push(boost::shared_ptr<Task> task, float cost, size_t length)
 {
   boost::mutex::scoped_lock lock(m_mutex);
   if (m_stopping) {
@@ -124,7 +170,12 @@ void ThreadPool::Submit(boost::shared_ptr<Task> task)
   while (m_queueLimit > 0 && m_tasks.size() >= m_queueLimit) {
     m_threadAvailable.wait(lock);
   }
-  m_tasks.push(task);
+  QueuedTask queued;
+  queued.task = task;
+  queued.cost = cost;
+  queued.length = length;
+  queued.seq = m_seq++;
+  m_tasks.push(queued);
   m_threadNeeded.notify_all();
 }
 
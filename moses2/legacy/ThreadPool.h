@@ -26,6 +26,7 @@
 #include <vector>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #ifdef WITH_THREADS
 #include <boost/bind.hpp>
@@ -58,6 +59,32 @@ public:
   }
 };
 
+/** Estimates how long a sentence will take to decode from its length.
+ *  Without observations the cost is the length itself. Once tasks have been
+ *  timed, it is the mean time for that length, or the mean time per word
+ *  times the length for lengths not seen yet.
+ */
+class TaskCostModel
+{
+public:
+  TaskCostModel() : m_totalTime(0), m_totalWords(0) {}
+
+  float Estimate(size_t length) const;
+  void Update(size_t length, float seconds);
+
+  // true once any task has been timed, ie. Estimate() is in seconds
+  bool IsTrained() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_totalWords > 0;
+  }
+
+private:
+  mutable boost::mutex m_mutex;
+  std::vector<std::pair<float, size_t> > m_timeByLength; // total time, count
+  float m_totalTime;
+  size_t m_totalWords;
+};
+
 class ThreadPool
 {
 public:
@@ -76,6 +103,13 @@ public:
    **/
   void Submit(boost::shared_ptr<Task> task);
 
+  /**
+   * Add a job translating a sentence of the given length. Queued jobs run
+   * longest first, jobs submitted without a length run after them in order.
+   * If SetCostModel() was called, jobs are timed to learn the cost per length.
+   **/
+  void Submit(boost::shared_ptr<Task> task, size_t length);
+
   /**
    * Wait until all queued jobs have completed, and shut down
    * the ThreadPool.
@@ -89,13 +123,39 @@ public:
     m_queueLimit = limit;
   }
 
+  /**
+   * Learn the cost of each sentence length online, rather than using the length
+   **/
+  void SetCostModel(bool online) {
+    m_costModel.reset(online ? new TaskCostModel : NULL);
+  }
+
 private:
   /**
    * The main loop executed by each thread.
    **/
   void Execute();
 
-  std::queue<boost::shared_ptr<Task> > m_tasks;
+  struct QueuedTask {
+    boost::shared_ptr<Task> task;
+    float cost;
+    size_t length; // 0 if unknown
+    size_t seq;
+
+    // priority_queue::top() is the most costly, then the earliest
+    bool operator<(const QueuedTask &other) const {
+      if (cost != other.cost) {
+        return cost < other.cost;
+      }
+      return seq > other.seq;
+    }
+  };
+
+  void Push(boost::shared_ptr<Task> task, float cost, size_t length);
+
+  std::priority_queue<QueuedTask> m_tasks;
+  size_t m_seq;
+  boost::scoped_ptr<TaskCostModel> m_costModel;
   boost::thread_group m_threads;
   boost::mutex m_mutex;
   boost::condition_variable m_threadNeeded;
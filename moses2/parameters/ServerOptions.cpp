@@ -46,6 +46,8 @@ ServerOptions()
   , keepaliveTimeout(15)
   , keepaliveMaxConn(30)
   , timeout(15)
+  , maxQueue(0)
+  , degradedStackSize(10)
 { }
 
 ServerOptions::
@@ -72,6 +74,10 @@ init(Parameter const& P)
   P.SetParameter(this->keepaliveMaxConn,"server-keepalive-maxconn", 30);
   P.SetParameter(this->timeout,"server-timeout",15);
 
+  // request queue
+  P.SetParameter(this->maxQueue, "server-max-queue", size_t(0));
+  P.SetParameter(this->degradedStackSize, "server-degraded-stack", size_t(10));
+
   // the stuff below is related to Moses translation sessions
   std::string timeout_spec;
   P.SetParameter(timeout_spec, "session-timeout",std::string("30m"));
@@ -27,6 +27,9 @@ struct
   int keepaliveMaxConn;  // this is for the abyss server
   int timeout;           // this is for the abyss server
 
+  size_t maxQueue;          // max. segments waiting to be decoded, 0 = no limit
+  size_t degradedStackSize; // stack size for segments that would miss their deadline
+
   bool init(Parameter const& param);
   ServerOptions(Parameter const& param);
   ServerOptions();
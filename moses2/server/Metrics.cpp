@@ -0,0 +1,55 @@
+/*
+ * Metrics.cpp
+ *
+ *  Created on: 17 Oct 2026
+ */
+#include <map>
+#include <string>
+#include <vector>
+#include "Metrics.h"
+#include "Translator.h"
+
+using namespace std;
+
+namespace Moses2
+{
+
+Metrics::Metrics(const Translator &translator)
+  :m_translator(translator)
+{
+  this->_signature = "S:";
+  this->_help = "Queue length, and queue and decoding times by priority";
+}
+
+void Metrics::execute(xmlrpc_c::paramList const& paramList,
+                      xmlrpc_c::value *const  retvalP)
+{
+  typedef std::map<std::string,xmlrpc_c::value> param_t;
+  typedef std::map<int, Translator::Stats> stats_t;
+
+  stats_t stats = m_translator.GetStats();
+
+  vector<xmlrpc_c::value> priorities;
+  for (stats_t::const_iterator iter = stats.begin(); iter != stats.end(); ++iter) {
+    const Translator::Stats &s = iter->second;
+    double done = s.segments - s.dropped;
+
+    param_t entry;
+    entry["priority"] = xmlrpc_c::value_int(iter->first);
+    entry["segments"] = xmlrpc_c::value_int(s.segments);
+    entry["dropped"] = xmlrpc_c::value_int(s.dropped);
+    entry["degraded"] = xmlrpc_c::value_int(s.degraded);
+    entry["mean-queue-time"] = xmlrpc_c::value_double(s.segments ? s.queueTime / s.segments : 0);
+    entry["max-queue-time"] = xmlrpc_c::value_double(s.maxQueueTime);
+    entry["mean-decode-time"] = xmlrpc_c::value_double(done ? s.decodeTime / done : 0);
+    entry["max-decode-time"] = xmlrpc_c::value_double(s.maxDecodeTime);
+    priorities.push_back(xmlrpc_c::value_struct(entry));
+  }
+
+  param_t retData;
+  retData["queue-size"] = xmlrpc_c::value_int(m_translator.GetQueueSize());
+  retData["priorities"] = xmlrpc_c::value_array(priorities);
+  *retvalP = xmlrpc_c::value_struct(retData);
+}
+
+} /* namespace Moses2 */
@@ -0,0 +1,32 @@
+/*
+ * Metrics.h
+ *
+ *  Created on: 17 Oct 2026
+ */
+
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+
+namespace Moses2
+{
+class Translator;
+
+/** The "metrics" method.
+ *  Returns the length of the translator's queue and, for each priority seen,
+ *  the number of segments translated, dropped and degraded, and mean and max
+ *  seconds spent waiting in the queue and decoding.
+ */
+class Metrics : public xmlrpc_c::method
+{
+public:
+  Metrics(const Translator &translator);
+
+  void execute(xmlrpc_c::paramList const& paramList,
+               xmlrpc_c::value *   const  retvalP);
+
+protected:
+  const Translator &m_translator;
+};
+
+} /* namespace Moses2 */
@@ -8,6 +8,7 @@
 #include "../System.h"
 #include "Server.h"
 #include "Translator.h"
+#include "Metrics.h"
 #include "../parameters/ServerOptions.h"
 
 using namespace std;
@@ -17,9 +18,13 @@ namespace Moses2
 
 Server::Server(ServerOptions &server_options, System &system)
   :m_server_options(server_options)
-  ,m_translator(new Translator(*this, system))
 {
+  Translator *translator = new Translator(*this, system);
+  m_translator = xmlrpc_c::methodPtr(translator);
+  m_metrics = xmlrpc_c::methodPtr(new Metrics(*translator));
+
   m_registry.addMethod("translate", m_translator);
+  m_registry.addMethod("metrics", m_metrics);
 }
 
 Server::~Server()
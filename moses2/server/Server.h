@@ -31,7 +31,8 @@ protected:
   ServerOptions &m_server_options;
   std::string m_pidfile;
   xmlrpc_c::registry m_registry;
-  xmlrpc_c::methodPtr const m_translator;
+  xmlrpc_c::methodPtr m_translator;
+  xmlrpc_c::methodPtr m_metrics;
 
 };
 
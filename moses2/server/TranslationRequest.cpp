@@ -1,4 +1,5 @@
 #include <boost/foreach.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include "TranslationRequest.h"
 #include "../ManagerBase.h"
 #include "../System.h"
@@ -18,6 +19,8 @@ TranslationRequest(xmlrpc_c::paramList const& paramList,
   ,m_cond(cond)
   ,m_mutex(mut)
   ,m_done(false)
+  ,m_queueTime(0)
+  ,m_decodeTime(0)
 {
 
 }
@@ -39,23 +42,58 @@ create(Translator* translator,
   return ret;
 }
 
+void
+TranslationRequest::
+Degrade(size_t stackSize)
+{
+  m_mgr->SetStackSize(stackSize);
+  m_retData["degraded"] = xmlrpc_c::value_boolean(true);
+}
+
+void
+TranslationRequest::
+Drop()
+{
+  m_retData["text"] = xmlrpc_c::value_string("");
+  m_retData["dropped"] = xmlrpc_c::value_boolean(true);
+  m_retData["queue-time"] = xmlrpc_c::value_double(m_queueTime);
+
+  delete m_mgr;
+  m_mgr = NULL;
+
+  Done();
+}
+
 void
 TranslationRequest::
 Run()
 {
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
   m_mgr->Decode();
 
   string out;
   out = m_mgr->OutputBest();
+  m_decodeTime = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() * 1e-6f;
+
   m_retData["text"] = xmlrpc_c::value_string(out);
+  m_retData["queue-time"] = xmlrpc_c::value_double(m_queueTime);
+  m_retData["decode-time"] = xmlrpc_c::value_double(m_decodeTime);
+
+  delete m_mgr;
+  m_mgr = NULL;
+
+  Done();
+}
 
+void
+TranslationRequest::
+Done()
+{
   {
     boost::lock_guard<boost::mutex> lock(m_mutex);
     m_done = true;
   }
   m_cond.notify_one();
-
-  delete m_mgr;
 }
 
 void TranslationRequest::pack_hypothesis(const Manager& manager, Hypothesis const* h,
@@ -32,6 +32,8 @@ protected:
   boost::mutex& m_mutex;
   bool m_done;
 
+  float m_queueTime, m_decodeTime; // seconds
+
   TranslationRequest(xmlrpc_c::paramList const& paramList,
                      boost::condition_variable& cond,
                      boost::mutex& mut,
@@ -44,6 +46,9 @@ protected:
                   std::string const& key,
                   std::map<std::string, xmlrpc_c::value> & dest) const;
 
+  void
+  Done();
+
 public:
 
   static
@@ -72,6 +77,25 @@ public:
     return m_retData;
   }
 
+  float
+  GetDecodeTime() const {
+    return m_decodeTime;
+  }
+
+  // time spent in the server's queue, returned to the client
+  void
+  SetQueueTime(float seconds) {
+    m_queueTime = seconds;
+  }
+
+  // decode with a smaller stack, to meet a deadline
+  void
+  Degrade(size_t stackSize);
+
+  // don't decode at all, the deadline has passed
+  void
+  Drop();
+
   void
   Run();
 
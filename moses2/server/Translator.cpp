@@ -4,10 +4,14 @@
  *  Created on: 1 Apr 2016
  *      Author: hieu
  */
+#include <algorithm>
+#include <cassert>
+#include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 #include "Translator.h"
 #include "TranslationRequest.h"
 #include "Server.h"
+#include "../System.h"
 #include "../parameters/ServerOptions.h"
 
 using namespace std;
@@ -15,17 +19,78 @@ using namespace std;
 namespace Moses2
 {
 
+namespace
+{
+
+class DispatchTask: public Task
+{
+public:
+  DispatchTask(Translator &translator)
+    :m_translator(translator) {
+  }
+
+  virtual void Run() {
+    m_translator.Dispatch();
+  }
+
+protected:
+  Translator &m_translator;
+};
+
+size_t CountWords(const std::string &line)
+{
+  size_t ret = 0;
+  bool inWord = false;
+  for (size_t i = 0; i < line.size(); ++i) {
+    bool space = (line[i] == ' ' || line[i] == '\t');
+    ret += (!space && !inWord);
+    inWord = !space;
+  }
+  return ret;
+}
+
+float Seconds(const boost::posix_time::time_duration &duration)
+{
+  return duration.total_microseconds() * 1e-6f;
+}
+
+}
+
+Translator::Stats::Stats()
+  :segments(0), dropped(0), degraded(0)
+  ,queueTime(0), maxQueueTime(0)
+  ,decodeTime(0), maxDecodeTime(0)
+{
+}
+
+bool Translator::QueuedRequest::operator<(const QueuedRequest &other) const
+{
+  if (priority != other.priority) {
+    return priority < other.priority;
+  }
+  if (deadline != other.deadline) {
+    // no deadline goes last
+    if (deadline.is_not_a_date_time()) return true;
+    if (other.deadline.is_not_a_date_time()) return false;
+    return deadline > other.deadline;
+  }
+  return seq > other.seq;
+}
+
 Translator::Translator(Server& server, System &system)
   : m_server(server),
     m_threadPool(server.options().numThreads),
     m_system(system),
-    m_translationId(0)
+    m_translationId(0),
+    m_seq(0)
 {
   // signature and help strings are documentation -- the client
   // can query this information with a system.methodSignature and
   // system.methodHelp RPC.
   this->_signature = "S:S";
-  this->_help = "Does translation";
+  this->_help = "Does translation. Pass a sentence in 'text', or an array of "
+                "them in 'segments'. Optional 'priority' (higher goes first) "
+                "and 'deadline' (milliseconds)";
 }
 
 Translator::~Translator()
@@ -39,30 +104,172 @@ void Translator::execute(xmlrpc_c::paramList const& paramList,
   typedef std::map<std::string,xmlrpc_c::value> param_t;
   param_t const& params = paramList.getStruct(0);
   param_t::const_iterator si;
-  si = params.find("text");
-  if (si == params.end()) {
-    throw xmlrpc_c::fault("Missing source text", xmlrpc_c::fault::CODE_PARSE);
+
+  vector<string> lines;
+  bool batch = false;
+  si = params.find("segments");
+  if (si != params.end()) {
+    batch = true;
+    vector<xmlrpc_c::value> segments = xmlrpc_c::value_array(si->second).vectorValueValue();
+    for (size_t i = 0; i < segments.size(); ++i) {
+      lines.push_back(xmlrpc_c::value_string(segments[i]));
+    }
+  } else {
+    si = params.find("text");
+    if (si == params.end()) {
+      throw xmlrpc_c::fault("Missing source text", xmlrpc_c::fault::CODE_PARSE);
+    }
+    lines.push_back(xmlrpc_c::value_string(si->second));
+  }
+
+  int priority = 0;
+  si = params.find("priority");
+  if (si != params.end()) {
+    priority = xmlrpc_c::value_int(si->second);
+  }
+
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+  boost::posix_time::ptime deadline(boost::posix_time::not_a_date_time);
+  si = params.find("deadline");
+  if (si != params.end()) {
+    double ms = si->second.type() == xmlrpc_c::value::TYPE_INT
+                ? (double) xmlrpc_c::value_int(si->second)
+                : (double) xmlrpc_c::value_double(si->second);
+    deadline = now + boost::posix_time::microseconds((long) (ms * 1000));
   }
 
-  string line = xmlrpc_c::value_string(si->second);
   long translationId;
 
-  // get unique id. Thread safe
+  // get unique ids. Thread safe
   {
     boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-    translationId = m_translationId++;
+    translationId = m_translationId;
+    m_translationId += lines.size();
   }
 
   boost::condition_variable cond;
   boost::mutex mut;
-  boost::shared_ptr<TranslationRequest> task;
-  task = TranslationRequest::create(this, paramList,cond,mut, m_system, line, translationId);
-  m_threadPool.Submit(task);
+  vector<boost::shared_ptr<TranslationRequest> > tasks;
+
+  {
+    boost::mutex::scoped_lock lock(m_queueMutex);
+    size_t maxQueue = m_server.options().maxQueue;
+    if (maxQueue && m_queue.size() + lines.size() > maxQueue) {
+      throw xmlrpc_c::fault("Server busy", xmlrpc_c::fault::CODE_LIMIT_EXCEEDED);
+    }
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+      QueuedRequest queued;
+      queued.request = TranslationRequest::create(this, paramList, cond, mut, m_system, lines[i], translationId + i);
+      queued.priority = priority;
+      queued.deadline = deadline;
+      queued.queued = now;
+      queued.length = CountWords(lines[i]);
+      queued.seq = m_seq++;
+      m_queue.push(queued);
+
+      tasks.push_back(queued.request);
+    }
+  }
+
+  // any free thread takes whatever is at the front of the queue
+  for (size_t i = 0; i < lines.size(); ++i) {
+    m_threadPool.Submit(boost::make_shared<DispatchTask>(boost::ref(*this)));
+  }
+
   boost::unique_lock<boost::mutex> lock(mut);
-  while (!task->IsDone()) {
-    cond.wait(lock);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    while (!tasks[i]->IsDone()) {
+      cond.wait(lock);
+    }
+  }
+
+  if (batch) {
+    vector<xmlrpc_c::value> ret;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      ret.push_back(xmlrpc_c::value_struct(tasks[i]->GetRetData()));
+    }
+    param_t retData;
+    retData["segments"] = xmlrpc_c::value_array(ret);
+    *retvalP = xmlrpc_c::value_struct(retData);
+  } else {
+    if (tasks[0]->GetRetData().count("dropped")) {
+      throw xmlrpc_c::fault("Deadline exceeded", xmlrpc_c::fault::CODE_TIMEOUT);
+    }
+    *retvalP = xmlrpc_c::value_struct(tasks[0]->GetRetData());
+  }
+}
+
+void Translator::Dispatch()
+{
+  QueuedRequest queued;
+  {
+    boost::mutex::scoped_lock lock(m_queueMutex);
+    assert(!m_queue.empty());
+    queued = m_queue.top();
+    m_queue.pop();
+  }
+
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+  float queueTime = Seconds(now - queued.queued);
+  queued.request->SetQueueTime(queueTime);
+
+  bool dropped = false, degraded = false;
+  if (!queued.deadline.is_not_a_date_time()) {
+    float left = Seconds(queued.deadline - now);
+    size_t degradedStack = m_server.options().degradedStackSize;
+    if (left <= 0) {
+      dropped = true;
+    } else if (degradedStack && degradedStack < m_system.options.search.stack_size
+               && m_costModel.IsTrained()
+               && m_costModel.Estimate(queued.length) > left) {
+      degraded = true;
+    }
+  }
+
+  float decodeTime = 0;
+  if (dropped) {
+    queued.request->Drop();
+  } else {
+    if (degraded) {
+      queued.request->Degrade(m_server.options().degradedStackSize);
+    }
+    queued.request->Run();
+    decodeTime = queued.request->GetDecodeTime();
+
+    // only full decodes say how long a sentence takes
+    if (!degraded && queued.length) {
+      m_costModel.Update(queued.length, decodeTime);
+    }
   }
-  *retvalP = xmlrpc_c::value_struct(task->GetRetData());
+
+  UpdateStats(queued.priority, queueTime, decodeTime, dropped, degraded);
+}
+
+size_t Translator::GetQueueSize() const
+{
+  boost::mutex::scoped_lock lock(m_queueMutex);
+  return m_queue.size();
+}
+
+std::map<int, Translator::Stats> Translator::GetStats() const
+{
+  boost::mutex::scoped_lock lock(m_statsMutex);
+  return m_stats;
+}
+
+void Translator::UpdateStats(int priority, float queueTime, float decodeTime,
+                             bool dropped, bool degraded)
+{
+  boost::mutex::scoped_lock lock(m_statsMutex);
+  Stats &stats = m_stats[priority];
+  ++stats.segments;
+  stats.dropped += dropped;
+  stats.degraded += degraded;
+  stats.queueTime += queueTime;
+  stats.maxQueueTime = std::max<double>(stats.maxQueueTime, queueTime);
+  stats.decodeTime += decodeTime;
+  stats.maxDecodeTime = std::max<double>(stats.maxDecodeTime, decodeTime);
 }
 
 } /* namespace Moses2 */
@@ -6,6 +6,10 @@
  */
 
 #pragma once
+#include <map>
+#include <queue>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
@@ -17,23 +21,72 @@ namespace Moses2
 class Server;
 class System;
 class Manager;
+class TranslationRequest;
 
+/** The "translate" method.
+ *  Takes either one sentence in "text" or an array of them in "segments".
+ *  Segments wait in a queue shared by all calls and are decoded highest
+ *  "priority" first, then earliest "deadline" (milliseconds after the call
+ *  arrives), then in order of arrival. A segment whose deadline has passed
+ *  when it reaches the front of the queue is dropped. One that would miss it,
+ *  going by the decoding times seen so far, is decoded with a smaller stack.
+ */
 class Translator : public xmlrpc_c::method
 {
 public:
+  // per priority, times in seconds
+  struct Stats {
+    size_t segments, dropped, degraded;
+    double queueTime, maxQueueTime;
+    double decodeTime, maxDecodeTime;
+
+    Stats();
+  };
+
   Translator(Server& server, System &system);
   virtual ~Translator();
 
   void execute(xmlrpc_c::paramList const& paramList,
                xmlrpc_c::value *   const  retvalP);
 
+  // decode the segment at the front of the queue. Run on the thread pool,
+  // once for every segment queued
+  void Dispatch();
+
+  size_t GetQueueSize() const;
+  std::map<int, Stats> GetStats() const;
+
 protected:
+  struct QueuedRequest {
+    boost::shared_ptr<TranslationRequest> request;
+    int priority;
+    boost::posix_time::ptime deadline; // not_a_date_time if there isn't one
+    boost::posix_time::ptime queued;
+    size_t length;
+    size_t seq;
+
+    // priority_queue::top() is the one to decode next
+    bool operator<(const QueuedRequest &other) const;
+  };
+
   Server& m_server;
   Moses2::ThreadPool m_threadPool;
   System &m_system;
   long m_translationId;
   boost::shared_mutex m_accessLock;
 
+  std::priority_queue<QueuedRequest> m_queue;
+  size_t m_seq;
+  mutable boost::mutex m_queueMutex;
+
+  // decoding time by sentence length, to see which deadlines are at risk
+  TaskCostModel m_costModel;
+
+  std::map<int, Stats> m_stats;
+  mutable boost::mutex m_statsMutex;
+
+  void UpdateStats(int priority, float queueTime, float decodeTime,
+                   bool dropped, bool degraded);
 };
 
 } /* namespace Moses2 */
@@ -24,6 +24,8 @@
 #include <boost/iostreams/filter/gzip.hpp>
 #include "OutputFileStream.h"
 #include "gzfilebuf.h"
+#include "util/file.hh"
+#include "util/write_compressed.hh"
 
 using namespace std;
 using namespace boost::algorithm;
@@ -33,12 +35,14 @@ namespace Moses
 OutputFileStream::OutputFileStream()
   :boost::iostreams::filtering_ostream()
   ,m_outFile(NULL)
+  ,m_compressedBuf(NULL)
   ,m_open(false)
 {
 }
 
 OutputFileStream::OutputFileStream(const std::string &filePath)
   :m_outFile(NULL)
+  ,m_compressedBuf(NULL)
   ,m_open(false)
 {
   Open(filePath);
@@ -52,9 +56,14 @@ OutputFileStream::~OutputFileStream()
 bool OutputFileStream::Open(const std::string &filePath)
 {
   assert(!m_open);
+  util::Compression compression = util::CompressionFromExtension(filePath);
   if (filePath == std::string("-")) {
     // Write to standard output.  Leave m_outFile null.
     this->push(std::cout);
+  } else if (compression == util::ZSTD || compression == util::LZ4) {
+    // The compressor writes the file itself.  Leave m_outFile null.
+    m_compressedBuf = new util::WriteCompressedBuf(util::CreateOrThrow(filePath.c_str()), compression);
+    this->push(*m_compressedBuf);
   } else {
     m_outFile = new ofstream(filePath.c_str(), ios_base::out | ios_base::binary);
     if (m_outFile->fail()) {
@@ -82,6 +91,13 @@ void OutputFileStream::Close()
     delete m_outFile;
     m_outFile = NULL;
   }
+  if (m_compressedBuf) {
+    this->pop();
+
+    // ends the compressed stream and closes the file
+    delete m_compressedBuf;
+    m_compressedBuf = NULL;
+  }
   m_open = false;
 }
 
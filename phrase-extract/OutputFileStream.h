@@ -27,14 +27,19 @@
 #include <iostream>
 #include <boost/iostreams/filtering_stream.hpp>
 
+namespace util
+{
+class WriteCompressedBuf;
+}
+
 namespace Moses
 {
 
 /** Version of std::ostream with transparent compression.
  *
  * Transparently compresses output when writing to a file whose name ends in
- * ".gz".  Or, writes to stdout instead of a file when given a filename
- * consisting of just a dash ("-").
+ * ".gz", ".zst" or ".lz4".  Or, writes to stdout instead of a file when given
+ * a filename consisting of just a dash ("-").
  */
 class OutputFileStream : public boost::iostreams::filtering_ostream
 {
@@ -45,6 +50,9 @@ private:
    */
   std::ofstream *m_outFile;
 
+  /// zstd or lz4 compressor that owns the file, or NULL.
+  util::WriteCompressedBuf *m_compressedBuf;
+
   /// Is this stream open?
   bool m_open;
 
@@ -64,7 +72,8 @@ public:
    *
    * If filePath is "-" (just a dash), this opens the stream for writing to
    * standard output.  Otherwise, it opens the given file.  If the filename
-   * has the ".gz" suffix, output will be transparently compressed.
+   * has the ".gz", ".zst" or ".lz4" suffix, output will be transparently
+   * compressed.
    *
    * Call Close() to close the file.
    *
@@ -0,0 +1,95 @@
+#!/bin/bash
+# Check that extract-ghkm --Threads 3 writes the same files as --Threads 1,
+# and that an unreadable tree is reported, and fails the run, either way.
+#
+# Arguments: the extract-ghkm binary.
+set -e -o pipefail
+
+extract_ghkm=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+export LC_ALL=C
+
+# A few thousand short parsed sentences, so some dozens of batches.  The
+# source sentence is the subject reversed, the rest of the verb phrase
+# reversed, then the verb; determiners are left unaligned.
+awk -v sentences=2500 '
+function rnd(n) { x = (x * 16807) % 2147483647; return x % n }
+function pick(list,    w, n) { n = split(list, w, " "); return w[1 + rnd(n)] }
+function word(tag, w) {
+  tree = tree " <tree label=\"" tag "\"> " w " </tree>"
+  t[++nt] = w
+}
+function np() {
+  tree = tree " <tree label=\"NP\">"
+  word("DT", pick("the a this"))
+  if (rnd(3) == 0) word("JJ", pick("big small red old new"))
+  word("NN", pick("cat dog house tree car bird man woman book"))
+  tree = tree " </tree>"
+}
+BEGIN {
+  x = 12345
+  for (s = 0; s < sentences; ++s) {
+    tree = "<tree label=\"TOP\"> <tree label=\"S\">"
+    nt = 0
+    np(); subj = nt
+    tree = tree " <tree label=\"VP\">"
+    word("VBZ", pick("sees likes has finds reads")); verb = nt
+    np()
+    if (rnd(2)) {
+      tree = tree " <tree label=\"PP\">"
+      word("IN", pick("in on near with"))
+      np()
+      tree = tree " </tree>"
+    }
+    tree = tree " </tree> </tree> </tree>"
+    # source: subject, objects, verb last
+    src = ""; aln = ""; ns = 0
+    for (i = subj; i >= 1; --i) emit(i)
+    for (i = nt; i > verb; --i) emit(i)
+    emit(verb)
+    print tree > "e"
+    print substr(src, 2) > "f"
+    print substr(aln, 2) > "a"
+  }
+}
+function emit(i) {
+  src = src " f_" t[i]
+  if (t[i] !~ /^(the|a|this)$/) aln = aln " " ns "-" (i - 1)
+  ++ns
+}' /dev/null
+
+files="extract extract.inv extract.phraseOrientationPriors glue unknown"
+for threads in 1 3; do
+  mkdir $threads
+  "$extract_ghkm" e f a $threads/extract --Threads $threads \
+    --GlueGrammar $threads/glue --UnknownWordLabel $threads/unknown \
+    --PhraseOrientation --TreeFragments 2> /dev/null
+done
+for file in $files; do
+  if ! cmp 1/$file 3/$file; then
+    diff 1/$file 3/$file | head -20 || true
+    echo "extract-ghkm --Threads 3 writes a different $file" >&2
+    exit 1
+  fi
+done
+if [ $(wc -l < 1/extract) -lt 2500 ]; then
+  echo "extract-ghkm extracted too few rules" >&2
+  exit 1
+fi
+
+# An unclosed tree in the third batch, which a worker thread reads.
+sed '250s|</tree> </tree>$||' e > e.bad
+for threads in 1 3; do
+  if "$extract_ghkm" e.bad f a bad.$threads --Threads $threads 2> err.$threads; then
+    echo "extract-ghkm --Threads $threads accepted a bad tree" >&2
+    exit 1
+  fi
+  if ! grep -q "error: Failed to parse target XML tree at line 250" err.$threads; then
+    cat err.$threads >&2
+    echo "extract-ghkm --Threads $threads did not report the bad tree" >&2
+    exit 1
+  fi
+done
@@ -19,16 +19,24 @@
 
 #include "ExtractGHKM.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <string>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 #include <boost/program_options.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#endif
 
 #include "syntax-common/exception.h"
 #include "syntax-common/xml_tree_parser.h"
@@ -39,6 +47,10 @@
 #include "SyntaxNodeCollection.h"
 #include "SyntaxTree.h"
 #include "tables-core.h"
+#include "util/usage.hh"
+#ifdef WITH_THREADS
+#include "util/pcqueue.hh"
+#endif
 #include "XmlException.h"
 #include "XmlTree.h"
 
@@ -46,9 +58,11 @@
 #include "AlignmentGraph.h"
 #include "Node.h"
 #include "Options.h"
+#include "OrderedBatchQueue.h"
 #include "PhraseOrientation.h"
 #include "ScfgRule.h"
 #include "ScfgRuleWriter.h"
+#include "SentenceBatch.h"
 #include "Span.h"
 #include "StsgRule.h"
 #include "StsgRuleWriter.h"
@@ -60,6 +74,59 @@ namespace Syntax
 namespace GHKM
 {
 
+namespace
+{
+
+// Appends the rules of a sentence, one line in fwd and one in inv each, to
+// the batch's output in sorted order.
+void AppendSorted(const std::string &fwd, const std::string &inv,
+                  SentenceBatch &batch)
+{
+  std::vector<std::pair<std::string, std::string> > rules;
+  std::istringstream fwdStream(fwd);
+  std::istringstream invStream(inv);
+  std::string fwdLine;
+  std::string invLine;
+  while (std::getline(fwdStream, fwdLine) && std::getline(invStream, invLine)) {
+    rules.push_back(std::make_pair(fwdLine, invLine));
+  }
+  std::sort(rules.begin(), rules.end());
+  for (std::size_t i = 0; i < rules.size(); ++i) {
+    batch.fwd += rules[i].first;
+    batch.fwd += '\n';
+    batch.inv += rules[i].second;
+    batch.inv += '\n';
+  }
+}
+
+}  // namespace
+
+#ifdef WITH_THREADS
+// The first exception thrown on a worker thread.  Workers skip the batches
+// that are left, and the main thread reports it once they have been joined.
+struct ExtractGHKM::WorkerError {
+  WorkerError() : failed(false) {}
+
+  // call from a catch block
+  void Capture() {
+    boost::mutex::scoped_lock lock(mutex);
+    if (!failed) {
+      error = std::current_exception();
+      failed = true;
+    }
+  }
+
+  bool Failed() {
+    boost::mutex::scoped_lock lock(mutex);
+    return failed;
+  }
+
+  boost::mutex mutex;
+  bool failed;
+  std::exception_ptr error;
+};
+#endif
+
 int ExtractGHKM::Main(int argc, char *argv[])
 {
   using Moses::InputFileStream;
@@ -121,37 +188,184 @@ int ExtractGHKM::Main(int argc, char *argv[])
     OpenOutputFileOrDie(options.unknownWordSoftMatchesFile, unknownWordSoftMatchesStream);
   }
 
-  // Word count statistics for producing unknown word labels.
-  std::map<std::string, int> targetWordCount;
-  std::map<std::string, std::string> targetWordLabel;
+  // Each thread has its own parsers.  The label sets they collect are merged
+  // once all sentences have been read.
+  const int numThreads = std::max(options.threads, 1);
+  boost::ptr_vector<XmlTreeParser> targetXmlTreeParsers;
+  boost::ptr_vector<XmlTreeParser> sourceXmlTreeParsers;
+  for (int i = 0; i < numThreads; ++i) {
+    targetXmlTreeParsers.push_back(new XmlTreeParser());
+    sourceXmlTreeParsers.push_back(new XmlTreeParser());
+  }
 
-  // Word count statistics for producing unknown word labels: source side.
-  std::map<std::string, int> sourceWordCount;
-  std::map<std::string, std::string> sourceWordLabel;
+  // Word counts and orientation priors, accumulated in input order.
+  SentenceBatch totals;
+  totals.l2rOrientationPriorCounts.assign(PhraseOrientation::REO_CLASS_UNKNOWN+1, 0.0f);
+  totals.r2lOrientationPriorCounts.assign(PhraseOrientation::REO_CLASS_UNKNOWN+1, 0.0f);
 
-  std::string targetLine;
-  std::string sourceLine;
-  std::string alignmentLine;
-  Alignment alignment;
-  XmlTreeParser targetXmlTreeParser;
-  XmlTreeParser sourceXmlTreeParser;
-  ScfgRuleWriter scfgWriter(fwdExtractStream, invExtractStream, options);
-  StsgRuleWriter stsgWriter(fwdExtractStream, invExtractStream, options);
   size_t lineNum = options.sentenceOffset;
-  while (true) {
-    std::getline(targetStream, targetLine);
-    std::getline(sourceStream, sourceLine);
-    std::getline(alignmentStream, alignmentLine);
+  if (numThreads == 1) {
+    while (true) {
+      SentenceBatch batch;
+      if (!ReadBatch(targetStream, sourceStream, alignmentStream, lineNum,
+                     batch)) {
+        break;
+      }
+      try {
+        ProcessBatch(options, targetXmlTreeParsers[0], sourceXmlTreeParsers[0],
+                     batch);
+      } catch (const Exception &e) {
+        Error(e.msg());
+      }
+      WriteBatch(batch, fwdExtractStream, invExtractStream, totals);
+    }
+  } else {
+#ifdef WITH_THREADS
+    // The main thread reads batches, the workers extract rules from them, and
+    // the writer thread writes them out in input order.
+    util::PCQueue<SentenceBatch *> input(numThreads * 2);
+    OrderedBatchQueue output(options.maxBufferedOutput);
+    WorkerError workerError;
+    boost::thread_group workers;
+    for (int i = 0; i < numThreads; ++i) {
+      workers.create_thread(boost::bind(&ExtractGHKM::RunWorker, this,
+                                        boost::cref(options),
+                                        boost::ref(targetXmlTreeParsers[i]),
+                                        boost::ref(sourceXmlTreeParsers[i]),
+                                        boost::ref(input),
+                                        boost::ref(output),
+                                        boost::ref(workerError)));
+    }
+    boost::thread writer(boost::bind(&ExtractGHKM::RunWriter, this,
+                                     boost::ref(output),
+                                     boost::ref(fwdExtractStream),
+                                     boost::ref(invExtractStream),
+                                     boost::ref(totals)));
+    size_t batchCount = 0;
+    while (!workerError.Failed()) {
+      std::auto_ptr<SentenceBatch> batch(new SentenceBatch());
+      batch->id = batchCount;
+      if (!ReadBatch(targetStream, sourceStream, alignmentStream, lineNum,
+                     *batch)) {
+        break;
+      }
+      input.Produce(batch.release());
+      ++batchCount;
+    }
+    for (int i = 0; i < numThreads; ++i) {
+      input.Produce(0);
+    }
+    workers.join_all();
+    output.Finish(batchCount);
+    writer.join();
+    if (workerError.failed) {
+      try {
+        std::rethrow_exception(workerError.error);
+      } catch (const Exception &e) {
+        Error(e.msg());
+      }
+    }
+#endif
+  }
 
-    if (targetStream.eof() && sourceStream.eof() && alignmentStream.eof()) {
-      break;
+  for (int i = 0; i <= PhraseOrientation::REO_CLASS_UNKNOWN; ++i) {
+    PhraseOrientation::REO_CLASS orient =
+      static_cast<PhraseOrientation::REO_CLASS>(i);
+    PhraseOrientation::IncrementPriorCount(PhraseOrientation::REO_DIR_L2R,
+                                           orient, totals.l2rOrientationPriorCounts[i]);
+    PhraseOrientation::IncrementPriorCount(PhraseOrientation::REO_DIR_R2L,
+                                           orient, totals.r2lOrientationPriorCounts[i]);
+  }
+
+  std::set<std::string> targetLabelSet;
+  std::map<std::string, int> targetTopLabelSet;
+  std::set<std::string> sourceLabelSet;
+  for (int i = 0; i < numThreads; ++i) {
+    const XmlTreeParser &target = targetXmlTreeParsers[i];
+    targetLabelSet.insert(target.label_set().begin(), target.label_set().end());
+    for (std::map<std::string, int>::const_iterator p =
+           target.top_label_set().begin();
+         p != target.top_label_set().end(); ++p) {
+      targetTopLabelSet[p->first] += p->second;
     }
+    const XmlTreeParser &source = sourceXmlTreeParsers[i];
+    sourceLabelSet.insert(source.label_set().begin(), source.label_set().end());
+  }
 
-    if (targetStream.eof() || sourceStream.eof() || alignmentStream.eof()) {
-      Error("Files must contain same number of lines");
+  if (options.phraseOrientation) {
+    std::string phraseOrientationPriorsFileName = options.extractFile + std::string(".phraseOrientationPriors");
+    OutputFileStream phraseOrientationPriorsStream;
+    OpenOutputFileOrDie(phraseOrientationPriorsFileName, phraseOrientationPriorsStream);
+    PhraseOrientation::WritePriorCounts(phraseOrientationPriorsStream);
+  }
+
+  std::map<std::string,size_t> sourceLabels;
+  if (options.sourceLabels && !options.sourceLabelSetFile.empty()) {
+    std::set<std::string> extendedLabelSet = sourceLabelSet;
+    extendedLabelSet.insert("XLHS"); // non-matching label (left-hand side)
+    extendedLabelSet.insert("XRHS"); // non-matching label (right-hand side)
+    extendedLabelSet.insert("TOPLABEL");  // as used in the glue grammar
+    extendedLabelSet.insert("SOMELABEL"); // as used in the glue grammar
+    size_t index = 0;
+    for (std::set<std::string>::const_iterator iter=extendedLabelSet.begin();
+         iter!=extendedLabelSet.end(); ++iter, ++index) {
+      sourceLabels.insert(std::pair<std::string,size_t>(*iter,index));
     }
+    WriteSourceLabelSet(sourceLabels, sourceLabelSetStream);
+  }
 
-    ++lineNum;
+  std::set<std::string> strippedTargetLabelSet;
+  std::map<std::string, int> strippedTargetTopLabelSet;
+  if (options.stripBitParLabels &&
+      (!options.glueGrammarFile.empty() || !options.unknownWordSoftMatchesFile.empty())) {
+    StripBitParLabels(targetLabelSet, targetTopLabelSet,
+                      strippedTargetLabelSet, strippedTargetTopLabelSet);
+  }
+
+  if (!options.glueGrammarFile.empty()) {
+    if (options.stripBitParLabels) {
+      WriteGlueGrammar(strippedTargetLabelSet, strippedTargetTopLabelSet, sourceLabels, options, glueGrammarStream);
+    } else {
+      WriteGlueGrammar(targetLabelSet, targetTopLabelSet,
+                       sourceLabels, options, glueGrammarStream);
+    }
+  }
+
+  if (!options.targetUnknownWordFile.empty()) {
+    WriteUnknownWordLabel(totals.targetWordCount, totals.targetWordLabel,
+                          options, targetUnknownWordStream);
+  }
+
+  if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
+    WriteUnknownWordLabel(totals.sourceWordCount, totals.sourceWordLabel,
+                          options, sourceUnknownWordStream, true);
+  }
+
+  if (!options.unknownWordSoftMatchesFile.empty()) {
+    if (options.stripBitParLabels) {
+      WriteUnknownWordSoftMatches(strippedTargetLabelSet, unknownWordSoftMatchesStream);
+    } else {
+      WriteUnknownWordSoftMatches(targetLabelSet,
+                                  unknownWordSoftMatchesStream);
+    }
+  }
+
+  return 0;
+}
+
+void ExtractGHKM::ProcessBatch(const Options &options,
+                               XmlTreeParser &targetXmlTreeParser,
+                               XmlTreeParser &sourceXmlTreeParser,
+                               SentenceBatch &batch)
+{
+  Alignment alignment;
+  batch.l2rOrientationPriorCounts.assign(PhraseOrientation::REO_CLASS_UNKNOWN+1, 0.0f);
+  batch.r2lOrientationPriorCounts.assign(PhraseOrientation::REO_CLASS_UNKNOWN+1, 0.0f);
+  for (std::size_t i = 0; i < batch.lineNums.size(); ++i) {
+    const std::string &targetLine = batch.targetLines[i];
+    const std::string &sourceLine = batch.sourceLines[i];
+    const std::string &alignmentLine = batch.alignmentLines[i];
+    const size_t lineNum = batch.lineNums[i];
 
     // Parse target tree.
     if (targetLine.size() == 0) {
@@ -168,7 +382,7 @@ int ExtractGHKM::Main(int argc, char *argv[])
       if (!e.msg().empty()) {
         oss << ": " << e.msg();
       }
-      Error(oss.str());
+      throw Exception(oss.str());
     }
 
     // Read source tokens (and parse tree if using source labels).
@@ -186,7 +400,7 @@ int ExtractGHKM::Main(int argc, char *argv[])
         if (!e.msg().empty()) {
           oss << ": " << e.msg();
         }
-        Error(oss.str());
+        throw Exception(oss.str());
       }
       sourceTokens = sourceXmlTreeParser.words();
     }
@@ -198,7 +412,7 @@ int ExtractGHKM::Main(int argc, char *argv[])
       std::ostringstream oss;
       oss << "Failed to read alignment at line " << lineNum << ": ";
       oss << e.msg();
-      Error(oss.str());
+      throw Exception(oss.str());
     }
     if (alignment.size() == 0) {
       std::cerr << "skipping line " << lineNum << " without alignment points\n";
@@ -210,14 +424,14 @@ int ExtractGHKM::Main(int argc, char *argv[])
 
     // Record word counts.
     if (!options.targetUnknownWordFile.empty()) {
-      CollectWordLabelCounts(*targetParseTree, options, targetWordCount,
-                             targetWordLabel);
+      CollectWordLabelCounts(*targetParseTree, options, batch.targetWordCount,
+                             batch.targetWordLabel);
     }
 
     // Record word counts: source side.
     if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
-      CollectWordLabelCounts(*sourceParseTree, options, sourceWordCount,
-                             sourceWordLabel);
+      CollectWordLabelCounts(*sourceParseTree, options, batch.sourceWordCount,
+                             batch.sourceWordLabel);
     }
 
     // Form an alignment graph from the target tree, source words, and
@@ -236,7 +450,13 @@ int ExtractGHKM::Main(int argc, char *argv[])
     PhraseOrientation phraseOrientation(sourceTokens.size(),
                                         targetXmlTreeParser.words().size(), alignment);
 
-    // Write the rules, subject to scope pruning.
+    // Write the rules, subject to scope pruning.  Their order depends on
+    // where the graph's nodes were allocated, so they are sorted before they
+    // are added to the batch, to come out the same on any thread.
+    std::ostringstream fwdExtractStream;
+    std::ostringstream invExtractStream;
+    ScfgRuleWriter scfgWriter(fwdExtractStream, invExtractStream, options);
+    StsgRuleWriter stsgWriter(fwdExtractStream, invExtractStream, options);
     const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
     for (std::vector<Node *>::const_iterator p = targetNodes.begin();
          p != targetNodes.end(); ++p) {
@@ -289,8 +509,8 @@ int ExtractGHKM::Main(int argc, char *argv[])
             fwdExtractStream << " ";
             phraseOrientation.WriteOrientation(fwdExtractStream,r2lOrientation);
             fwdExtractStream << "}}";
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_L2R,l2rOrientation,1);
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_R2L,r2lOrientation,1);
+            batch.l2rOrientationPriorCounts[l2rOrientation] += 1;
+            batch.r2lOrientationPriorCounts[r2lOrientation] += 1;
           }
           fwdExtractStream << std::endl;
           invExtractStream << std::endl;
@@ -298,68 +518,113 @@ int ExtractGHKM::Main(int argc, char *argv[])
         delete r;
       }
     }
+    AppendSorted(fwdExtractStream.str(), invExtractStream.str(), batch);
   }
 
-  if (options.phraseOrientation) {
-    std::string phraseOrientationPriorsFileName = options.extractFile + std::string(".phraseOrientationPriors");
-    OutputFileStream phraseOrientationPriorsStream;
-    OpenOutputFileOrDie(phraseOrientationPriorsFileName, phraseOrientationPriorsStream);
-    PhraseOrientation::WritePriorCounts(phraseOrientationPriorsStream);
-  }
+  // Only the output is kept while the batch waits to be written.
+  std::vector<std::string>().swap(batch.targetLines);
+  std::vector<std::string>().swap(batch.sourceLines);
+  std::vector<std::string>().swap(batch.alignmentLines);
+}
 
-  std::map<std::string,size_t> sourceLabels;
-  if (options.sourceLabels && !options.sourceLabelSetFile.empty()) {
-    std::set<std::string> extendedLabelSet = sourceXmlTreeParser.label_set();
-    extendedLabelSet.insert("XLHS"); // non-matching label (left-hand side)
-    extendedLabelSet.insert("XRHS"); // non-matching label (right-hand side)
-    extendedLabelSet.insert("TOPLABEL");  // as used in the glue grammar
-    extendedLabelSet.insert("SOMELABEL"); // as used in the glue grammar
-    size_t index = 0;
-    for (std::set<std::string>::const_iterator iter=extendedLabelSet.begin();
-         iter!=extendedLabelSet.end(); ++iter, ++index) {
-      sourceLabels.insert(std::pair<std::string,size_t>(*iter,index));
-    }
-    WriteSourceLabelSet(sourceLabels, sourceLabelSetStream);
-  }
+bool ExtractGHKM::ReadBatch(Moses::InputFileStream &targetStream,
+                            Moses::InputFileStream &sourceStream,
+                            Moses::InputFileStream &alignmentStream,
+                            size_t &lineNum, SentenceBatch &batch) const
+{
+  const size_t batchSize = 100;
+  std::string targetLine;
+  std::string sourceLine;
+  std::string alignmentLine;
+  while (batch.lineNums.size() < batchSize) {
+    std::getline(targetStream, targetLine);
+    std::getline(sourceStream, sourceLine);
+    std::getline(alignmentStream, alignmentLine);
 
-  std::set<std::string> strippedTargetLabelSet;
-  std::map<std::string, int> strippedTargetTopLabelSet;
-  if (options.stripBitParLabels &&
-      (!options.glueGrammarFile.empty() || !options.unknownWordSoftMatchesFile.empty())) {
-    StripBitParLabels(targetXmlTreeParser.label_set(),
-                      targetXmlTreeParser.top_label_set(),
-                      strippedTargetLabelSet, strippedTargetTopLabelSet);
-  }
+    if (targetStream.eof() && sourceStream.eof() && alignmentStream.eof()) {
+      break;
+    }
 
-  if (!options.glueGrammarFile.empty()) {
-    if (options.stripBitParLabels) {
-      WriteGlueGrammar(strippedTargetLabelSet, strippedTargetTopLabelSet, sourceLabels, options, glueGrammarStream);
-    } else {
-      WriteGlueGrammar(targetXmlTreeParser.label_set(),
-                       targetXmlTreeParser.top_label_set(),
-                       sourceLabels, options, glueGrammarStream);
+    if (targetStream.eof() || sourceStream.eof() || alignmentStream.eof()) {
+      Error("Files must contain same number of lines");
     }
+
+    ++lineNum;
+    batch.targetLines.push_back(targetLine);
+    batch.sourceLines.push_back(sourceLine);
+    batch.alignmentLines.push_back(alignmentLine);
+    batch.lineNums.push_back(lineNum);
   }
+  return !batch.lineNums.empty();
+}
 
-  if (!options.targetUnknownWordFile.empty()) {
-    WriteUnknownWordLabel(targetWordCount, targetWordLabel, options, targetUnknownWordStream);
+void ExtractGHKM::WriteBatch(const SentenceBatch &batch,
+                             std::ostream &fwdExtractStream,
+                             std::ostream &invExtractStream,
+                             SentenceBatch &totals) const
+{
+  fwdExtractStream << batch.fwd;
+  invExtractStream << batch.inv;
+
+  // Later sentences overwrite a word's label, as when counting serially.
+  for (std::map<std::string, int>::const_iterator p =
+         batch.targetWordCount.begin(); p != batch.targetWordCount.end(); ++p) {
+    totals.targetWordCount[p->first] += p->second;
+  }
+  for (std::map<std::string, std::string>::const_iterator p =
+         batch.targetWordLabel.begin(); p != batch.targetWordLabel.end(); ++p) {
+    totals.targetWordLabel[p->first] = p->second;
+  }
+  for (std::map<std::string, int>::const_iterator p =
+         batch.sourceWordCount.begin(); p != batch.sourceWordCount.end(); ++p) {
+    totals.sourceWordCount[p->first] += p->second;
+  }
+  for (std::map<std::string, std::string>::const_iterator p =
+         batch.sourceWordLabel.begin(); p != batch.sourceWordLabel.end(); ++p) {
+    totals.sourceWordLabel[p->first] = p->second;
   }
 
-  if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
-    WriteUnknownWordLabel(sourceWordCount, sourceWordLabel, options, sourceUnknownWordStream, true);
+  for (size_t i = 0; i < batch.l2rOrientationPriorCounts.size(); ++i) {
+    totals.l2rOrientationPriorCounts[i] += batch.l2rOrientationPriorCounts[i];
+    totals.r2lOrientationPriorCounts[i] += batch.r2lOrientationPriorCounts[i];
   }
+}
 
-  if (!options.unknownWordSoftMatchesFile.empty()) {
-    if (options.stripBitParLabels) {
-      WriteUnknownWordSoftMatches(strippedTargetLabelSet, unknownWordSoftMatchesStream);
-    } else {
-      WriteUnknownWordSoftMatches(targetXmlTreeParser.label_set(),
-                                  unknownWordSoftMatchesStream);
+#ifdef WITH_THREADS
+void ExtractGHKM::RunWorker(const Options &options,
+                            XmlTreeParser &targetXmlTreeParser,
+                            XmlTreeParser &sourceXmlTreeParser,
+                            util::PCQueue<SentenceBatch *> &input,
+                            OrderedBatchQueue &output,
+                            WorkerError &error)
+{
+  // After an error, batches still go through the queues, unprocessed, so
+  // that the reader and the writer don't wait for them.
+  SentenceBatch *batch;
+  while ((batch = input.Consume())) {
+    if (!error.Failed()) {
+      try {
+        ProcessBatch(options, targetXmlTreeParser, sourceXmlTreeParser, *batch);
+      } catch (...) {
+        error.Capture();
+      }
     }
+    output.Push(batch);
   }
+}
 
-  return 0;
+void ExtractGHKM::RunWriter(OrderedBatchQueue &output,
+                            std::ostream &fwdExtractStream,
+                            std::ostream &invExtractStream,
+                            SentenceBatch &totals) const
+{
+  SentenceBatch *batch;
+  while ((batch = output.Pop())) {
+    WriteBatch(*batch, fwdExtractStream, invExtractStream, totals);
+    delete batch;
+  }
 }
+#endif
 
 void ExtractGHKM::ProcessOptions(int argc, char *argv[],
                                  Options &options) const
@@ -367,6 +632,8 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
   namespace po = boost::program_options;
   namespace cls = boost::program_options::command_line_style;
 
+  std::string maxBufferedOutput = "256M";
+
   // Construct the 'top' of the usage message: the bit that comes before the
   // options list.
   std::ostringstream usageTop;
@@ -428,6 +695,9 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
    "write gzipped extract files")
   ("IncludeSentenceId",
    "include sentence ID")
+  ("MaxBufferedOutput",
+   po::value(&maxBufferedOutput)->default_value(maxBufferedOutput),
+   "with --Threads, set the amount of extracted output held back to keep it in input order (bytes, or with suffix K, M, G)")
   ("MaxNodes",
    po::value(&options.maxNodes)->default_value(options.maxNodes),
    "set maximum number of tree nodes for composed rules")
@@ -456,6 +726,9 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
    "output STSG rules (default is SCFG)")
   ("T2S",
    "enable tree-to-string rule extraction (string-to-tree is assumed by default)")
+  ("Threads",
+   po::value(&options.threads)->default_value(options.threads),
+   "set number of extraction threads")
   ("TreeFragments",
    "output parse tree information")
   ("SourceLabels",
@@ -591,6 +864,18 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
     options.unpairedExtractFormat = true;
   }
 
+  // Process the output buffer size.
+  try {
+    options.maxBufferedOutput = util::ParseSize(maxBufferedOutput);
+  } catch (const std::exception &e) {
+    Error(std::string("Bad value for MaxBufferedOutput: ") + e.what());
+  }
+#ifndef WITH_THREADS
+  if (options.threads > 1) {
+    Error("Threads requires a multi-threaded build");
+  }
+#endif
+
   // Workaround for extract-parallel issue.
   if (options.sentenceOffset > 0) {
     options.targetUnknownWordFile.clear();
@@ -25,19 +25,30 @@
 #include <string>
 #include <vector>
 
+#include "InputFileStream.h"
 #include "OutputFileStream.h"
 #include "SyntaxTree.h"
 
 #include "syntax-common/tool.h"
 
+namespace util
+{
+template <class T> class PCQueue;
+}
+
 namespace MosesTraining
 {
 namespace Syntax
 {
+
+class XmlTreeParser;
+
 namespace GHKM
 {
 
+class OrderedBatchQueue;
 struct Options;
+struct SentenceBatch;
 
 class ExtractGHKM : public Tool
 {
@@ -75,6 +86,20 @@ private:
   std::vector<std::string> ReadTokens(const SyntaxTree &root) const;
 
   void ProcessOptions(int, char *[], Options &) const;
+
+  bool ReadBatch(Moses::InputFileStream &, Moses::InputFileStream &,
+                 Moses::InputFileStream &, size_t &, SentenceBatch &) const;
+  // Throws Exception if a sentence cannot be read.
+  void ProcessBatch(const Options &, XmlTreeParser &, XmlTreeParser &,
+                    SentenceBatch &);
+  void WriteBatch(const SentenceBatch &, std::ostream &, std::ostream &,
+                  SentenceBatch &) const;
+  struct WorkerError;
+  void RunWorker(const Options &, XmlTreeParser &, XmlTreeParser &,
+                 util::PCQueue<SentenceBatch *> &, OrderedBatchQueue &,
+                 WorkerError &);
+  void RunWriter(OrderedBatchQueue &, std::ostream &, std::ostream &,
+                 SentenceBatch &) const;
 };
 
 }  // namespace GHKM
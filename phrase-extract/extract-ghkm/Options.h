@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
 
 namespace MosesTraining
@@ -35,6 +36,7 @@ public:
     , conditionOnTargetLhs(false)
     , gzOutput(false)
     , includeSentenceId(false)
+    , maxBufferedOutput(256 << 20)
     , maxNodes(15)
     , maxRuleDepth(3)
     , maxRuleSize(3)
@@ -49,6 +51,7 @@ public:
     , stripBitParLabels(false)
     , stsg(false)
     , t2s(false)
+    , threads(1)
     , treeFragments(false)
     , unknownWordMinRelFreq(0.03f)
     , unknownWordUniform(false)
@@ -66,6 +69,7 @@ public:
   std::string glueGrammarFile;
   bool gzOutput;
   bool includeSentenceId;
+  std::size_t maxBufferedOutput;
   int maxNodes;
   int maxRuleDepth;
   int maxRuleSize;
@@ -83,6 +87,7 @@ public:
   bool stsg;
   bool t2s;
   std::string targetUnknownWordFile;
+  int threads;
   bool treeFragments;
   float unknownWordMinRelFreq;
   std::string unknownWordSoftMatchesFile;
@@ -0,0 +1,84 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifdef WITH_THREADS
+
+#include "OrderedBatchQueue.h"
+
+#include "SentenceBatch.h"
+
+namespace MosesTraining
+{
+namespace Syntax
+{
+namespace GHKM
+{
+
+OrderedBatchQueue::OrderedBatchQueue(std::size_t maxBufferedOutput)
+  : m_maxBufferedOutput(maxBufferedOutput)
+  , m_bufferedOutput(0)
+  , m_next(0)
+  , m_end(0)
+  , m_finished(false)
+{
+}
+
+void OrderedBatchQueue::Push(SentenceBatch *batch)
+{
+  const std::size_t size = batch->OutputSize();
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  while (batch->id != m_next &&
+         m_bufferedOutput + size > m_maxBufferedOutput) {
+    m_popped.wait(lock);
+  }
+  m_bufferedOutput += size;
+  m_batches[batch->id] = batch;
+  m_pushed.notify_all();
+}
+
+SentenceBatch *OrderedBatchQueue::Pop()
+{
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  while (m_batches.empty() || m_batches.begin()->first != m_next) {
+    if (m_finished && m_next == m_end) {
+      return 0;
+    }
+    m_pushed.wait(lock);
+  }
+  SentenceBatch *batch = m_batches.begin()->second;
+  m_batches.erase(m_batches.begin());
+  m_bufferedOutput -= batch->OutputSize();
+  ++m_next;
+  m_popped.notify_all();
+  return batch;
+}
+
+void OrderedBatchQueue::Finish(std::size_t batchCount)
+{
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  m_finished = true;
+  m_end = batchCount;
+  m_pushed.notify_all();
+}
+
+}  // namespace GHKM
+}  // namespace Syntax
+}  // namespace MosesTraining
+
+#endif
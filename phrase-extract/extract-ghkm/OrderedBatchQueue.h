@@ -0,0 +1,80 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#ifdef WITH_THREADS
+
+#include <cstddef>
+#include <map>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace MosesTraining
+{
+namespace Syntax
+{
+namespace GHKM
+{
+
+struct SentenceBatch;
+
+// Hands extracted batches from the worker threads to the writer in input
+// order.  Batches that finish early wait here, and the total size of their
+// output is capped: a worker that would take it over the cap blocks until
+// the writer catches up.  The batch the writer is waiting for is always
+// accepted, so the workers cannot deadlock.
+class OrderedBatchQueue
+{
+public:
+  explicit OrderedBatchQueue(std::size_t maxBufferedOutput);
+
+  // Called by the workers.  Takes ownership of the batch.
+  void Push(SentenceBatch *);
+
+  // Called by the writer.  Returns the next batch in input order, which the
+  // caller must delete, or 0 once all batches have been returned.
+  SentenceBatch *Pop();
+
+  // Tells the queue how many batches there are in total.  Call after the
+  // last Push.
+  void Finish(std::size_t batchCount);
+
+private:
+  // Disallow copying
+  OrderedBatchQueue(const OrderedBatchQueue &);
+  OrderedBatchQueue &operator=(const OrderedBatchQueue &);
+
+  const std::size_t m_maxBufferedOutput;
+  std::size_t m_bufferedOutput;
+  std::size_t m_next;
+  std::size_t m_end;
+  bool m_finished;
+  std::map<std::size_t, SentenceBatch *> m_batches;
+  boost::mutex m_mutex;
+  boost::condition_variable m_pushed;
+  boost::condition_variable m_popped;
+};
+
+}  // namespace GHKM
+}  // namespace Syntax
+}  // namespace MosesTraining
+
+#endif
@@ -0,0 +1,70 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2011 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace MosesTraining
+{
+namespace Syntax
+{
+namespace GHKM
+{
+
+// A run of consecutive input sentences together with everything extracted
+// from them.  Batches are extracted independently, possibly on different
+// threads, and then written in input order.
+struct SentenceBatch {
+  SentenceBatch() : id(0) {}
+
+  // Position of the batch in the input.
+  std::size_t id;
+
+  // Input.  lineNums holds the line number of each sentence.
+  std::vector<std::string> targetLines;
+  std::vector<std::string> sourceLines;
+  std::vector<std::string> alignmentLines;
+  std::vector<std::size_t> lineNums;
+
+  // Extract file text.
+  std::string fwd;
+  std::string inv;
+
+  // Word count statistics for producing unknown word labels.
+  std::map<std::string, int> targetWordCount;
+  std::map<std::string, std::string> targetWordLabel;
+  std::map<std::string, int> sourceWordCount;
+  std::map<std::string, std::string> sourceWordLabel;
+
+  // Phrase orientation prior counts, indexed by PhraseOrientation::REO_CLASS.
+  std::vector<float> l2rOrientationPriorCounts;
+  std::vector<float> r2lOrientationPriorCounts;
+
+  std::size_t OutputSize() const {
+    return fwd.size() + inv.size();
+  }
+};
+
+}  // namespace GHKM
+}  // namespace Syntax
+}  // namespace MosesTraining
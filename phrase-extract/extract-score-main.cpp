@@ -0,0 +1,919 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "tables-core.h"
+#include "InputFileStream.h"
+#include "OutputFileStream.h"
+#include "SentenceAlignment.h"
+
+#include "util/file.hh"
+#include "util/pcqueue.hh"
+#include "util/scoped.hh"
+#include "util/sized_iterator.hh"
+#include "util/stream/chain.hh"
+#include "util/stream/multi_stream.hh"
+#include "util/stream/sort.hh"
+#include "util/stream/stream.hh"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace MosesTraining;
+
+/* Phrase extraction and scoring in one process.  The phrase table is the
+ * same as extract, sort, score, score --Inverse and consolidate write with
+ * their default options, without the text files in between.
+ *
+ * Phrase pairs are fixed-size records of word ids.  Threads extract them and
+ * util::stream::Sort sorts them three times: by source phrase to count c(f)
+ * and pick the alignment, by target phrase to count c(e), then by spelling,
+ * like LC_ALL=C sort, for output.
+ */
+
+namespace
+{
+
+// The alignment of a phrase pair is a bit matrix in a uint64_t.
+const std::size_t kMaxPhraseLength = 8;
+
+// Pads phrases shorter than the maximum length.
+const WORD_ID kEndOfPhrase = 0;
+// The first word in both vocabularies.  Unaligned words are explained by NULL
+// in the lexical weights.
+const WORD_ID kNullWord = 1;
+
+const std::size_t kBatchSentences = 1000;
+
+class Vocab
+{
+public:
+  Vocab() {
+    m_words.push_back("");
+    FindOrInsert("NULL");
+  }
+
+  WORD_ID FindOrInsert(const std::string &word) {
+    std::pair<Lookup::iterator, bool> found(m_lookup.insert(std::make_pair(word, static_cast<WORD_ID>(m_words.size()))));
+    if (found.second) m_words.push_back(word);
+    return found.first->second;
+  }
+
+  const std::string &Word(WORD_ID id) const {
+    return m_words[id];
+  }
+
+  // Rank of each word when words are sorted by bytes.  Phrases are followed
+  // by " |||" in the text tables, so the end of a phrase ranks like "|||".
+  void Ranks(std::vector<WORD_ID> &ranks) const;
+
+private:
+  typedef boost::unordered_map<std::string, WORD_ID> Lookup;
+  Lookup m_lookup;
+  std::vector<std::string> m_words;
+};
+
+class SpellingOrder
+{
+public:
+  explicit SpellingOrder(const std::vector<std::string> &spelling) : m_spelling(&spelling) {}
+
+  bool operator()(WORD_ID first, WORD_ID second) const {
+    return (*m_spelling)[first] < (*m_spelling)[second];
+  }
+
+private:
+  const std::vector<std::string> *m_spelling;
+};
+
+void Vocab::Ranks(std::vector<WORD_ID> &ranks) const
+{
+  std::vector<std::string> spelling(m_words);
+  spelling[kEndOfPhrase] = "|||";
+  std::vector<WORD_ID> order(spelling.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), SpellingOrder(spelling));
+  ranks.resize(order.size());
+  WORD_ID rank = 0;
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    if (i && spelling[order[i]] != spelling[order[i - 1]]) ++rank;
+    ranks[order[i]] = rank;
+  }
+}
+
+// Words aligned to one word, as a bit mask of positions on the other side.
+unsigned Links(uint64_t alignment, std::size_t word, bool byTarget)
+{
+  unsigned ret = 0;
+  for (std::size_t other = 0; other < kMaxPhraseLength; ++other) {
+    std::size_t bit = byTarget ? other * kMaxPhraseLength + word : word * kMaxPhraseLength + other;
+    if (alignment & (static_cast<uint64_t>(1) << bit)) ret |= 1u << other;
+  }
+  return ret;
+}
+
+// Compares two Links the way std::set<size_t> compares.
+int CompareLinks(unsigned first, unsigned second)
+{
+  for (std::size_t position = 0; position < kMaxPhraseLength; ++position) {
+    unsigned mask = 1u << position;
+    if ((first & mask) == (second & mask)) continue;
+    unsigned above = ~((mask << 1) - 1);
+    if (first & mask) return (second & above) ? -1 : 1;
+    return (first & above) ? 1 : -1;
+  }
+  return 0;
+}
+
+// Whether first is greater than second when both are written as score's
+// ALIGNMENT: the set of source words aligned to each target word, or the
+// other way around for score --Inverse.
+bool AlignmentGreater(uint64_t first, uint64_t second, std::size_t words, bool byTarget)
+{
+  for (std::size_t word = 0; word < words; ++word) {
+    int compared = CompareLinks(Links(first, word, byTarget), Links(second, word, byTarget));
+    if (compared) return compared > 0;
+  }
+  return false;
+}
+
+/* Word translation probabilities, counted from the word alignment while the
+ * corpus is read.  These are the lex.f2e and lex.e2f tables train-model.perl
+ * writes, rounded to the same 7 decimal places so the scores match.
+ */
+class LexicalTable
+{
+public:
+  void Count(WORD_ID source, WORD_ID target) {
+    m_table[Key(source, target)].forward += 1.0;
+  }
+
+  // Turn counts into probabilities once the corpus has been read.
+  void Finish();
+
+  // lex(e|f) for the target words, given the alignment.
+  double Forward(const WORD_ID *source, const WORD_ID *target, std::size_t targetWords, uint64_t alignment) const;
+
+  // lex(f|e) for the source words.
+  double Backward(const WORD_ID *source, const WORD_ID *target, std::size_t sourceWords, uint64_t alignment) const;
+
+private:
+  struct Entry {
+    Entry() : forward(0.0), backward(0.0) {}
+    // Holds the count until Finish.
+    double forward;
+    double backward;
+  };
+
+  typedef boost::unordered_map<uint64_t, Entry> Table;
+
+  static uint64_t Key(WORD_ID source, WORD_ID target) {
+    return (static_cast<uint64_t>(source) << 32) | target;
+  }
+
+  // Missing entries score 1, as in score.
+  const Entry *Find(WORD_ID source, WORD_ID target) const {
+    Table::const_iterator i = m_table.find(Key(source, target));
+    return i == m_table.end() ? NULL : &i->second;
+  }
+
+  double ForwardProb(WORD_ID source, WORD_ID target) const {
+    const Entry *entry = Find(source, target);
+    return entry ? entry->forward : 1.0;
+  }
+
+  double BackwardProb(WORD_ID source, WORD_ID target) const {
+    const Entry *entry = Find(source, target);
+    return entry ? entry->backward : 1.0;
+  }
+
+  Table m_table;
+};
+
+double RoundLikeLexFile(double prob)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.7f", prob);
+  return std::atof(buffer);
+}
+
+void LexicalTable::Finish()
+{
+  std::vector<double> sourceTotal, targetTotal;
+  for (Table::const_iterator i = m_table.begin(); i != m_table.end(); ++i) {
+    WORD_ID source = i->first >> 32, target = i->first & 0xffffffff;
+    if (source >= sourceTotal.size()) sourceTotal.resize(source + 1);
+    if (target >= targetTotal.size()) targetTotal.resize(target + 1);
+    sourceTotal[source] += i->second.forward;
+    targetTotal[target] += i->second.forward;
+  }
+  for (Table::iterator i = m_table.begin(); i != m_table.end(); ++i) {
+    double count = i->second.forward;
+    i->second.forward = RoundLikeLexFile(count / sourceTotal[i->first >> 32]);
+    i->second.backward = RoundLikeLexFile(count / targetTotal[i->first & 0xffffffff]);
+  }
+}
+
+double LexicalTable::Forward(const WORD_ID *source, const WORD_ID *target, std::size_t targetWords, uint64_t alignment) const
+{
+  double score = 1.0;
+  for (std::size_t t = 0; t < targetWords; ++t) {
+    unsigned links = Links(alignment, t, true);
+    if (!links) {
+      score *= ForwardProb(kNullWord, target[t]);
+      continue;
+    }
+    double sum = 0.0;
+    unsigned aligned = 0;
+    for (std::size_t s = 0; s < kMaxPhraseLength; ++s) {
+      if (!(links & (1u << s))) continue;
+      sum += ForwardProb(source[s], target[t]);
+      ++aligned;
+    }
+    score *= sum / static_cast<double>(aligned);
+  }
+  return score;
+}
+
+double LexicalTable::Backward(const WORD_ID *source, const WORD_ID *target, std::size_t sourceWords, uint64_t alignment) const
+{
+  double score = 1.0;
+  for (std::size_t s = 0; s < sourceWords; ++s) {
+    unsigned links = Links(alignment, s, false);
+    if (!links) {
+      score *= BackwardProb(source[s], kNullWord);
+      continue;
+    }
+    double sum = 0.0;
+    unsigned aligned = 0;
+    for (std::size_t t = 0; t < kMaxPhraseLength; ++t) {
+      if (!(links & (1u << t))) continue;
+      sum += BackwardProb(source[s], target[t]);
+      ++aligned;
+    }
+    score *= sum / static_cast<double>(aligned);
+  }
+  return score;
+}
+
+struct PairPayload {
+  // Bit s * kMaxPhraseLength + t is set if source word s is aligned to target
+  // word t.  After the first pass, the most frequent alignment.
+  uint64_t alignment;
+  // The most frequent alignment with ties broken the way score --Inverse does.
+  uint64_t inverseAlignment;
+  float count;
+  float sourceCount;
+  float targetCount;
+  float lexForward;
+  float lexBackward;
+};
+
+/* A phrase pair record is the source phrase, then the target phrase, each
+ * padded to the maximum length with kEndOfPhrase, then a PairPayload.
+ */
+class PairLayout
+{
+public:
+  explicit PairLayout(std::size_t length) : m_length(length) {}
+
+  std::size_t Length() const {
+    return m_length;
+  }
+
+  std::size_t PhraseSize() const {
+    return m_length * sizeof(WORD_ID);
+  }
+
+  std::size_t Size() const {
+    return 2 * PhraseSize() + sizeof(PairPayload);
+  }
+
+  WORD_ID *Source(void *pair) const {
+    return static_cast<WORD_ID*>(pair);
+  }
+  const WORD_ID *Source(const void *pair) const {
+    return static_cast<const WORD_ID*>(pair);
+  }
+
+  WORD_ID *Target(void *pair) const {
+    return Source(pair) + m_length;
+  }
+  const WORD_ID *Target(const void *pair) const {
+    return Source(pair) + m_length;
+  }
+
+  PairPayload &Payload(void *pair) const {
+    return *reinterpret_cast<PairPayload*>(Source(pair) + 2 * m_length);
+  }
+  const PairPayload &Payload(const void *pair) const {
+    return *reinterpret_cast<const PairPayload*>(Source(pair) + 2 * m_length);
+  }
+
+  std::size_t Words(const WORD_ID *phrase) const {
+    return std::find(phrase, phrase + m_length, kEndOfPhrase) - phrase;
+  }
+
+private:
+  std::size_t m_length;
+};
+
+// Source phrase, target phrase, then alignment, compared as bytes.  The order
+// of word ids is arbitrary but each source phrase is contiguous.
+class PairOrder
+{
+public:
+  explicit PairOrder(const PairLayout &layout) : m_layout(layout) {}
+
+  bool operator()(const void *first, const void *second) const {
+    return memcmp(first, second, KeySize()) < 0;
+  }
+
+  std::size_t KeySize() const {
+    return 2 * m_layout.PhraseSize() + sizeof(uint64_t);
+  }
+
+  const PairLayout &Layout() const {
+    return m_layout;
+  }
+
+private:
+  PairLayout m_layout;
+};
+
+struct CombinePairs {
+  bool operator()(void *first, const void *second, const PairOrder &compare) const {
+    if (memcmp(first, second, compare.KeySize())) return false;
+    compare.Layout().Payload(first).count += compare.Layout().Payload(second).count;
+    return true;
+  }
+};
+
+class TargetOrder
+{
+public:
+  explicit TargetOrder(const PairLayout &layout) : m_layout(layout) {}
+
+  bool operator()(const void *first, const void *second) const {
+    int compared = memcmp(m_layout.Target(first), m_layout.Target(second), m_layout.PhraseSize());
+    if (compared) return compared < 0;
+    return memcmp(first, second, m_layout.PhraseSize()) < 0;
+  }
+
+private:
+  PairLayout m_layout;
+};
+
+// Source then target phrase in the order LC_ALL=C sort puts the text lines.
+class SpellingPairOrder
+{
+public:
+  SpellingPairOrder(const PairLayout &layout, const std::vector<WORD_ID> &sourceRanks, const std::vector<WORD_ID> &targetRanks)
+    : m_layout(layout), m_sourceRanks(&sourceRanks), m_targetRanks(&targetRanks) {}
+
+  bool operator()(const void *first, const void *second) const {
+    const WORD_ID *a = m_layout.Source(first), *b = m_layout.Source(second);
+    for (std::size_t i = 0; i < m_layout.Length(); ++i) {
+      WORD_ID rankA = (*m_sourceRanks)[a[i]], rankB = (*m_sourceRanks)[b[i]];
+      if (rankA != rankB) return rankA < rankB;
+    }
+    a = m_layout.Target(first);
+    b = m_layout.Target(second);
+    for (std::size_t i = 0; i < m_layout.Length(); ++i) {
+      WORD_ID rankA = (*m_targetRanks)[a[i]], rankB = (*m_targetRanks)[b[i]];
+      if (rankA != rankB) return rankA < rankB;
+    }
+    return false;
+  }
+
+private:
+  PairLayout m_layout;
+  const std::vector<WORD_ID> *m_sourceRanks, *m_targetRanks;
+};
+
+struct AlignedSentence {
+  std::vector<WORD_ID> source, target;
+  std::vector<int> alignedCountS;
+  std::vector<std::vector<int> > alignedToT;
+};
+
+typedef boost::shared_ptr<std::vector<AlignedSentence> > SentenceBatch;
+
+// Writes phrase pairs to a chain.  Full blocks are sorted and duplicates
+// combined, and the block is only passed on once that no longer frees half of
+// it, which keeps frequent pairs from reaching the disk many times over.
+class PairWriter
+{
+public:
+  PairWriter(const PairLayout &layout, const util::stream::ChainPosition &position)
+    : m_layout(layout), m_block(position),
+      m_blockSize(position.GetChain().BlockSize()),
+      m_current(Begin()) {}
+
+  // Same phrase pairs as ExtractTask::extract for phrase-based models.
+  void Extract(const AlignedSentence &sentence);
+
+  void Finish() {
+    m_current = SortAndCombine(Begin(), m_current);
+    m_block->SetValidSize(m_current - Begin());
+    (++m_block).Poison();
+  }
+
+private:
+  uint8_t *Begin() {
+    return static_cast<uint8_t*>(m_block->Get());
+  }
+
+  uint8_t *SortAndCombine(uint8_t *begin, uint8_t *end) const;
+
+  void Add(const AlignedSentence &sentence, int startE, int endE, int startF, int endF);
+
+  PairLayout m_layout;
+  util::stream::Link m_block;
+  const std::size_t m_blockSize;
+  uint8_t *m_current;
+};
+
+uint8_t *PairWriter::SortAndCombine(uint8_t *begin, uint8_t *end) const
+{
+  const std::size_t size = m_layout.Size();
+  PairOrder compare(m_layout);
+  std::sort(util::SizedIt(begin, size), util::SizedIt(end, size), util::SizedCompare<PairOrder>(compare));
+  if (begin == end) return end;
+  CombinePairs combine;
+  uint8_t *out = begin;
+  for (uint8_t *in = begin + size; in != end; in += size) {
+    if (combine(out, in, compare)) continue;
+    out += size;
+    if (out != in) memcpy(out, in, size);
+  }
+  return out + size;
+}
+
+void PairWriter::Add(const AlignedSentence &sentence, int startE, int endE, int startF, int endF)
+{
+  if (m_current == Begin() + m_blockSize) {
+    m_current = SortAndCombine(Begin(), m_current);
+    if (static_cast<std::size_t>(m_current - Begin()) > m_blockSize / 2) {
+      m_block->SetValidSize(m_current - Begin());
+      ++m_block;
+      m_current = Begin();
+    }
+  }
+  memset(m_current, 0, m_layout.Size());
+  WORD_ID *source = m_layout.Source(m_current);
+  for (int fi = startF; fi <= endF; ++fi) {
+    source[fi - startF] = sentence.source[fi];
+  }
+  WORD_ID *target = m_layout.Target(m_current);
+  PairPayload &payload = m_layout.Payload(m_current);
+  for (int ei = startE; ei <= endE; ++ei) {
+    target[ei - startE] = sentence.target[ei];
+    for (size_t i = 0; i < sentence.alignedToT[ei].size(); ++i) {
+      int fi = sentence.alignedToT[ei][i];
+      payload.alignment |= static_cast<uint64_t>(1) << ((fi - startF) * kMaxPhraseLength + (ei - startE));
+    }
+  }
+  payload.count = 1.0;
+  m_current += m_layout.Size();
+}
+
+void PairWriter::Extract(const AlignedSentence &sentence)
+{
+  const int countE = sentence.target.size();
+  const int countF = sentence.source.size();
+  const int maxPhraseLength = m_layout.Length();
+
+  for (int startE = 0; startE < countE; startE++) {
+    for (int endE = startE; endE < countE && endE < startE + maxPhraseLength; endE++) {
+      int minF = std::numeric_limits<int>::max();
+      int maxF = -1;
+      std::vector<int> usedF = sentence.alignedCountS;
+      for (int ei = startE; ei <= endE; ei++) {
+        for (size_t i = 0; i < sentence.alignedToT[ei].size(); i++) {
+          int fi = sentence.alignedToT[ei][i];
+          minF = std::min(minF, fi);
+          maxF = std::max(maxF, fi);
+          usedF[fi]--;
+        }
+      }
+
+      if (maxF < 0 || maxF - minF >= maxPhraseLength) continue;
+
+      // check if source words are aligned to out of bound target words
+      bool out_of_bounds = false;
+      for (int fi = minF; fi <= maxF && !out_of_bounds; fi++) {
+        out_of_bounds = usedF[fi] > 0;
+      }
+      if (out_of_bounds) continue;
+
+      // start point of source phrase may retreat over unaligned
+      for (int startF = minF;
+           startF >= 0 && startF > maxF - maxPhraseLength &&
+           (startF == minF || sentence.alignedCountS[startF] == 0);
+           startF--) {
+        // end point of source phrase may advance over unaligned
+        for (int endF = maxF;
+             endF < countF && endF < startF + maxPhraseLength &&
+             (endF == maxF || sentence.alignedCountS[endF] == 0);
+             endF++) {
+          Add(sentence, startE, endE, startF, endF);
+        }
+      }
+    }
+  }
+}
+
+void ExtractShard(const PairLayout &layout, const util::stream::ChainPosition &position, util::PCQueue<SentenceBatch> &queue)
+{
+  try {
+    PairWriter writer(layout, position);
+    SentenceBatch batch;
+    while ((batch = queue.Consume())) {
+      for (std::vector<AlignedSentence>::const_iterator i = batch->begin(); i != batch->end(); ++i) {
+        writer.Extract(*i);
+      }
+    }
+    writer.Finish();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    abort();
+  }
+}
+
+// Reads the corpus on one thread and hands batches of sentences to a thread
+// for each chain, which extracts their phrase pairs.
+class ExtractPairs
+{
+public:
+  ExtractPairs(const PairLayout &layout, Moses::InputFileStream &target, Moses::InputFileStream &source, Moses::InputFileStream &alignment,
+               Vocab &sourceVocab, Vocab &targetVocab, LexicalTable &lex)
+    : m_layout(layout), m_target(target), m_source(source), m_alignment(alignment),
+      m_sourceVocab(sourceVocab), m_targetVocab(targetVocab), m_lex(lex) {}
+
+  void Run(const util::stream::ChainPositions &positions);
+
+private:
+  void ReadSentences(boost::ptr_vector<util::PCQueue<SentenceBatch> > &queues);
+
+  PairLayout m_layout;
+  Moses::InputFileStream &m_target, &m_source, &m_alignment;
+  Vocab &m_sourceVocab, &m_targetVocab;
+  LexicalTable &m_lex;
+};
+
+void ExtractPairs::Run(const util::stream::ChainPositions &positions)
+{
+  boost::ptr_vector<util::PCQueue<SentenceBatch> > queues;
+  boost::thread_group shards;
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    queues.push_back(new util::PCQueue<SentenceBatch>(2));
+    shards.add_thread(new boost::thread(ExtractShard, boost::cref(m_layout), boost::cref(positions[i]), boost::ref(queues[i])));
+  }
+
+  try {
+    ReadSentences(queues);
+  } catch (...) {
+    for (std::size_t i = 0; i < queues.size(); ++i) {
+      queues[i].Produce(SentenceBatch());
+    }
+    shards.join_all();
+    throw;
+  }
+  for (std::size_t i = 0; i < queues.size(); ++i) {
+    queues[i].Produce(SentenceBatch());
+  }
+  shards.join_all();
+}
+
+void ExtractPairs::ReadSentences(boost::ptr_vector<util::PCQueue<SentenceBatch> > &queues)
+{
+  SentenceBatch batch(new std::vector<AlignedSentence>());
+  std::size_t next = 0;
+  int i = 0;
+  std::string targetString, sourceString, alignmentString;
+  while (getline(m_target, targetString)) {
+    i++;
+    if (i%10000 == 0) std::cerr << "." << std::flush;
+
+    getline(m_source, sourceString);
+    getline(m_alignment, alignmentString);
+
+    SentenceAlignment sentence;
+    if (!sentence.create(targetString.c_str(), sourceString.c_str(), alignmentString.c_str(), "", i, false)) {
+      continue;
+    }
+
+    batch->push_back(AlignedSentence());
+    AlignedSentence &aligned = batch->back();
+    aligned.source.resize(sentence.source.size());
+    for (size_t s = 0; s < sentence.source.size(); ++s) {
+      aligned.source[s] = m_sourceVocab.FindOrInsert(sentence.source[s]);
+    }
+    aligned.target.resize(sentence.target.size());
+    for (size_t t = 0; t < sentence.target.size(); ++t) {
+      aligned.target[t] = m_targetVocab.FindOrInsert(sentence.target[t]);
+    }
+    aligned.alignedCountS.swap(sentence.alignedCountS);
+    aligned.alignedToT.swap(sentence.alignedToT);
+
+    for (size_t t = 0; t < aligned.target.size(); ++t) {
+      const std::vector<int> &links = aligned.alignedToT[t];
+      if (links.empty()) {
+        m_lex.Count(kNullWord, aligned.target[t]);
+      }
+      for (size_t l = 0; l < links.size(); ++l) {
+        m_lex.Count(aligned.source[links[l]], aligned.target[t]);
+      }
+    }
+    for (size_t s = 0; s < aligned.source.size(); ++s) {
+      if (!aligned.alignedCountS[s]) {
+        m_lex.Count(aligned.source[s], kNullWord);
+      }
+    }
+
+    if (batch->size() == kBatchSentences) {
+      queues[next].Produce(batch);
+      next = (next + 1) % queues.size();
+      batch.reset(new std::vector<AlignedSentence>());
+    }
+  }
+  if (!batch->empty()) {
+    queues[next].Produce(batch);
+  }
+  std::cerr << std::endl;
+}
+
+/* Reads pairs sorted by PairOrder, so the alignments of a pair are together
+ * and pairs with the same source are together.  Writes each pair once with
+ * its most frequent alignment, c(f) and both lexical weights.
+ */
+class ScoreForward
+{
+public:
+  ScoreForward(const PairLayout &layout, const LexicalTable &lex, const util::stream::ChainPosition &input)
+    : m_layout(layout), m_lex(&lex), m_input(input) {}
+
+  void Run(const util::stream::ChainPosition &output) {
+    util::stream::Stream in(m_input), out(output);
+    const std::size_t size = m_layout.Size();
+    std::vector<uint8_t> group;
+    while (in) {
+      group.clear();
+      float sourceCount = 0.0;
+      // Counts of the best alignments of the last pair in group.
+      float bestCount = 0.0, bestInverseCount = 0.0;
+      do {
+        const PairPayload &next = m_layout.Payload(in.Get());
+        sourceCount += next.count;
+        if (group.empty() || memcmp(m_layout.Target(&group[group.size() - size]), m_layout.Target(in.Get()), m_layout.PhraseSize())) {
+          group.insert(group.end(), static_cast<const uint8_t*>(in.Get()), static_cast<const uint8_t*>(in.Get()) + size);
+          PairPayload &pair = m_layout.Payload(&group[group.size() - size]);
+          pair.inverseAlignment = pair.alignment;
+          bestCount = bestInverseCount = next.count;
+        } else {
+          uint8_t *last = &group[group.size() - size];
+          PairPayload &pair = m_layout.Payload(last);
+          pair.count += next.count;
+          if (next.count > bestCount || (next.count == bestCount &&
+                                         AlignmentGreater(next.alignment, pair.alignment, m_layout.Words(m_layout.Target(last)), true))) {
+            pair.alignment = next.alignment;
+            bestCount = next.count;
+          }
+          if (next.count > bestInverseCount || (next.count == bestInverseCount &&
+                                                AlignmentGreater(next.alignment, pair.inverseAlignment, m_layout.Words(m_layout.Source(last)), false))) {
+            pair.inverseAlignment = next.alignment;
+            bestInverseCount = next.count;
+          }
+        }
+      } while (++in && !memcmp(in.Get(), &group[0], m_layout.PhraseSize()));
+
+      for (std::size_t offset = 0; offset < group.size(); offset += size, ++out) {
+        void *pair = &group[offset];
+        const WORD_ID *source = m_layout.Source(pair), *target = m_layout.Target(pair);
+        PairPayload &payload = m_layout.Payload(pair);
+        payload.sourceCount = sourceCount;
+        payload.lexForward = m_lex->Forward(source, target, m_layout.Words(target), payload.alignment);
+        payload.lexBackward = m_lex->Backward(source, target, m_layout.Words(source), payload.inverseAlignment);
+        memcpy(out.Get(), pair, size);
+      }
+    }
+    out.Poison();
+  }
+
+private:
+  PairLayout m_layout;
+  const LexicalTable *m_lex;
+  util::stream::ChainPosition m_input;
+};
+
+// Reads pairs sorted by TargetOrder and fills in c(e).
+class ScoreBackward
+{
+public:
+  ScoreBackward(const PairLayout &layout, const util::stream::ChainPosition &input)
+    : m_layout(layout), m_input(input) {}
+
+  void Run(const util::stream::ChainPosition &output) {
+    util::stream::Stream in(m_input), out(output);
+    const std::size_t size = m_layout.Size();
+    std::vector<uint8_t> group;
+    while (in) {
+      group.clear();
+      float targetCount = 0.0;
+      do {
+        targetCount += m_layout.Payload(in.Get()).count;
+        group.insert(group.end(), static_cast<const uint8_t*>(in.Get()), static_cast<const uint8_t*>(in.Get()) + size);
+      } while (++in && !memcmp(m_layout.Target(in.Get()), m_layout.Target(&group[0]), m_layout.PhraseSize()));
+
+      for (std::size_t offset = 0; offset < group.size(); offset += size, ++out) {
+        m_layout.Payload(&group[offset]).targetCount = targetCount;
+        memcpy(out.Get(), &group[offset], size);
+      }
+    }
+    out.Poison();
+  }
+
+private:
+  PairLayout m_layout;
+  util::stream::ChainPosition m_input;
+};
+
+// Writes lines in consolidate's format.
+class WritePhraseTable
+{
+public:
+  WritePhraseTable(const PairLayout &layout, const Vocab &sourceVocab, const Vocab &targetVocab, std::ostream &out)
+    : m_layout(layout), m_sourceVocab(&sourceVocab), m_targetVocab(&targetVocab), m_out(&out) {}
+
+  void Run(const util::stream::ChainPosition &position) {
+    std::ostream &out = *m_out;
+    for (util::stream::Stream in(position); in; ++in) {
+      const WORD_ID *source = m_layout.Source(in.Get()), *target = m_layout.Target(in.Get());
+      const PairPayload &pair = m_layout.Payload(in.Get());
+      const std::size_t sourceWords = m_layout.Words(source), targetWords = m_layout.Words(target);
+
+      for (std::size_t s = 0; s < sourceWords; ++s) {
+        out << m_sourceVocab->Word(source[s]) << ' ';
+      }
+      out << "|||";
+      for (std::size_t t = 0; t < targetWords; ++t) {
+        out << ' ' << m_targetVocab->Word(target[t]);
+      }
+      out << " ||| " << (pair.count / pair.targetCount) << ' ' << pair.lexBackward
+          << ' ' << (pair.count / pair.sourceCount) << ' ' << pair.lexForward << " |||";
+      for (std::size_t t = 0; t < targetWords; ++t) {
+        unsigned links = Links(pair.alignment, t, true);
+        for (std::size_t s = 0; s < sourceWords; ++s) {
+          if (links & (1u << s)) out << ' ' << s << '-' << t;
+        }
+      }
+      out << " ||| " << pair.targetCount << ' ' << pair.sourceCount << ' ' << pair.count << " ||| |||\n";
+    }
+  }
+
+private:
+  PairLayout m_layout;
+  const Vocab *m_sourceVocab, *m_targetVocab;
+  std::ostream *m_out;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  std::cerr << "ExtractScore -- "
+            << "phrase extraction and scoring in one process" << std::endl;
+
+  if (argc < 6) {
+    std::cerr <<
+              "syntax: extract-score en de align phrase-table max-length "
+              "[--Threads n] "
+              "[--Memory size] "
+              "[--TempDir dir]" << std::endl;
+    exit(1);
+  }
+
+  const std::string fileNameE = argv[1];
+  const std::string fileNameF = argv[2];
+  const std::string fileNameA = argv[3];
+  const std::string fileNamePhraseTable = argv[4];
+  const int maxPhraseLength = std::atoi(argv[5]);
+  if (maxPhraseLength < 1 || maxPhraseLength > static_cast<int>(kMaxPhraseLength)) {
+    std::cerr << "ERROR: max-length must be between 1 and " << kMaxPhraseLength << std::endl;
+    exit(1);
+  }
+
+  std::size_t threads = 1;
+  std::string memoryString = "1G";
+  util::stream::SortConfig sortConfig;
+  sortConfig.temp_prefix = "/tmp/";
+  for (int i = 6; i < argc; ++i) {
+    if (strcmp(argv[i], "--Threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--Memory") == 0 && i + 1 < argc) {
+      memoryString = argv[++i];
+    } else if (strcmp(argv[i], "--TempDir") == 0 && i + 1 < argc) {
+      sortConfig.temp_prefix = argv[++i];
+    } else {
+      std::cerr << "ERROR: unknown option " << argv[i] << std::endl;
+      exit(1);
+    }
+  }
+  const std::size_t memory = util::ParseSize(memoryString);
+  util::NormalizeTempPrefix(sortConfig.temp_prefix);
+  sortConfig.total_memory = memory;
+  sortConfig.buffer_size = std::min<std::size_t>(64 << 20, memory / 16);
+  sortConfig.merge_threads = threads;
+
+  Moses::InputFileStream eFile(fileNameE);
+  Moses::InputFileStream fFile(fileNameF);
+  Moses::InputFileStream aFile(fileNameA);
+  if (eFile.fail() || fFile.fail() || aFile.fail()) {
+    std::cerr << "ERROR: could not open the corpus or alignment" << std::endl;
+    exit(1);
+  }
+
+  Moses::OutputFileStream phraseTable;
+  if (!phraseTable.Open(fileNamePhraseTable)) {
+    std::cerr << "ERROR: could not open phrase table file " << fileNamePhraseTable << std::endl;
+    exit(1);
+  }
+
+  const PairLayout layout(maxPhraseLength);
+  Vocab sourceVocab, targetVocab;
+  LexicalTable lex;
+
+  // Extract, sorting by pair.  Each thread gets its own chain.
+  util::scoped_ptr<util::stream::Sort<PairOrder, CombinePairs> > byPair;
+  {
+    util::stream::Chains chains(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+      chains.push_back(util::stream::ChainConfig(layout.Size(), 2, memory / 2 / threads));
+    }
+    ExtractPairs extractor(layout, eFile, fFile, aFile, sourceVocab, targetVocab, lex);
+    chains >> boost::ref(extractor);
+    byPair.reset(new util::stream::Sort<PairOrder, CombinePairs>(chains, sortConfig, PairOrder(layout), CombinePairs()));
+    chains.Wait(true);
+  }
+  lex.Finish();
+
+  std::cerr << "scoring by source phrase" << std::endl;
+  util::scoped_ptr<util::stream::Sort<TargetOrder> > byTarget;
+  {
+    util::stream::Chain in(util::stream::ChainConfig(layout.Size(), 2, memory / 8));
+    byPair->Output(in, memory / 4);
+    util::stream::ChainPosition reading(in.Add());
+    in >> util::stream::kRecycle;
+    util::stream::Chain out(util::stream::ChainConfig(layout.Size(), 2, memory / 4));
+    out >> ScoreForward(layout, lex, reading);
+    byTarget.reset(new util::stream::Sort<TargetOrder>(out, sortConfig, TargetOrder(layout)));
+    out.Wait(true);
+    in.Wait(true);
+  }
+  byPair.reset();
+
+  std::cerr << "scoring by target phrase" << std::endl;
+  std::vector<WORD_ID> sourceRanks, targetRanks;
+  sourceVocab.Ranks(sourceRanks);
+  targetVocab.Ranks(targetRanks);
+  util::scoped_ptr<util::stream::Sort<SpellingPairOrder> > bySpelling;
+  {
+    util::stream::Chain in(util::stream::ChainConfig(layout.Size(), 2, memory / 8));
+    byTarget->Output(in, memory / 4);
+    util::stream::ChainPosition reading(in.Add());
+    in >> util::stream::kRecycle;
+    util::stream::Chain out(util::stream::ChainConfig(layout.Size(), 2, memory / 4));
+    out >> ScoreBackward(layout, reading);
+    bySpelling.reset(new util::stream::Sort<SpellingPairOrder>(out, sortConfig, SpellingPairOrder(layout, sourceRanks, targetRanks)));
+    out.Wait(true);
+    in.Wait(true);
+  }
+  byTarget.reset();
+
+  std::cerr << "writing phrase table" << std::endl;
+  {
+    util::stream::Chain in(util::stream::ChainConfig(layout.Size(), 2, memory / 4));
+    bySpelling->Output(in, memory / 2);
+    in >> WritePhraseTable(layout, sourceVocab, targetVocab, phraseTable) >> util::stream::kRecycle;
+    in.Wait(true);
+  }
+
+  phraseTable.Close();
+  eFile.Close();
+  fFile.Close();
+  aFile.Close();
+}
@@ -0,0 +1,46 @@
+#!/bin/bash
+# Check that extract-score writes the same phrase table as the
+#   extract | sort | score | score --Inverse | consolidate
+# pipeline of train-model.perl, on the corpus in extract-score-test/.
+#
+# Arguments: the extract-score, extract, extract-lex, score and consolidate
+# binaries, in any order.
+set -e -o pipefail
+
+for bin in "$@"; do
+  bin=$(cd "$(dirname "$bin")" && pwd)/$(basename "$bin")
+  case $(basename "$bin") in
+    extract-score) extract_score=$bin ;;
+    extract) extract=$bin ;;
+    extract-lex) extract_lex=$bin ;;
+    score) score=$bin ;;
+    consolidate) consolidate=$bin ;;
+  esac
+done
+
+data=$(cd "$(dirname "$0")/extract-score-test" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cd "$work"
+export LC_ALL=C
+
+max_length=7
+
+"$extract" $data/e $data/f $data/a extract $max_length > /dev/null 2>&1
+"$extract_lex" $data/e $data/f $data/a lex.f2e lex.e2f > /dev/null 2>&1
+sort extract > extract.sorted
+sort extract.inv > extract.inv.sorted
+"$score" extract.sorted lex.f2e pt.direct 2> /dev/null
+"$score" extract.inv.sorted lex.e2f pt.indirect --Inverse 2> /dev/null
+sort pt.indirect > pt.indirect.sorted
+"$consolidate" pt.direct pt.indirect.sorted pt.pipeline 2> /dev/null
+
+for threads in 1 3; do
+  "$extract_score" $data/e $data/f $data/a pt.$threads $max_length \
+    --Threads $threads --TempDir "$work" 2> /dev/null
+  if ! cmp pt.pipeline pt.$threads; then
+    diff pt.pipeline pt.$threads | head -20 || true
+    echo "extract-score --Threads $threads differs from the pipeline" >&2
+    exit 1
+  fi
+done
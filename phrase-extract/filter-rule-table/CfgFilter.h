@@ -1,10 +1,10 @@
 #pragma once
 
-#include <istream>
-#include <ostream>
 #include <string>
 #include <vector>
 
+#include "RuleFilter.h"
+
 namespace MosesTraining
 {
 namespace Syntax
@@ -14,15 +14,10 @@ namespace FilterRuleTable
 
 // Base class for StringCfgFilter and TreeCfgFilter, both of which filter rule
 // tables where the source-side is CFG.
-class CfgFilter
+class CfgFilter : public RuleFilter
 {
 public:
   virtual ~CfgFilter() {}
-
-  // Read a rule table from 'in' and filter it according to the test sentences.
-  virtual void Filter(std::istream &in, std::ostream &out) = 0;
-
-protected:
 };
 
 }  // namespace FilterRuleTable
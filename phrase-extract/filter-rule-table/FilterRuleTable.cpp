@@ -16,9 +16,12 @@
 #include "syntax-common/xml_tree_parser.h"
 
 #include "InputFileStream.h"
+#include "OutputFileStream.h"
+#include "util/usage.hh"
 
 #include "ForestTsgFilter.h"
 #include "Options.h"
+#include "RuleFilter.h"
 #include "StringCfgFilter.h"
 #include "StringForest.h"
 #include "StringForestParser.h"
@@ -74,13 +77,18 @@ int FilterRuleTable::Main(int argc, char *argv[])
     Error(std::string("unsupported model type: ") + options.model);
   }
 
+  // Open output file (standard output by default).  Not before the arguments
+  // have been checked, so that a bad command line doesn't truncate it.
+  Moses::OutputFileStream outStream;
+  OpenOutputFileOrDie(options.outputFile, outStream);
+
   // Read the test sentences then set up and run the filter.
   if (testSentenceFormat == kString) {
     assert(sourceSideRuleFormat == kCfg);
     std::vector<boost::shared_ptr<std::string> > testStrings;
     ReadTestSet(testStream, testStrings);
     StringCfgFilter filter(testStrings);
-    filter.Filter(std::cin, std::cout);
+    RunFilter(filter, options, outStream);
   } else if (testSentenceFormat == kTree) {
     std::vector<boost::shared_ptr<SyntaxTree> > testTrees;
     ReadTestSet(testStream, testTrees);
@@ -88,10 +96,10 @@ int FilterRuleTable::Main(int argc, char *argv[])
       // TODO Implement TreeCfgFilter
       Warn("tree/cfg filtering algorithm not implemented: input will be copied unchanged to output");
       TreeCfgFilter filter(testTrees);
-      filter.Filter(std::cin, std::cout);
+      RunFilter(filter, options, outStream);
     } else if (sourceSideRuleFormat == kTsg) {
       TreeTsgFilter filter(testTrees);
-      filter.Filter(std::cin, std::cout);
+      RunFilter(filter, options, outStream);
     } else {
       assert(false);
     }
@@ -100,12 +108,33 @@ int FilterRuleTable::Main(int argc, char *argv[])
     ReadTestSet(testStream, testForests);
     assert(sourceSideRuleFormat == kTsg);
     ForestTsgFilter filter(testForests);
-    filter.Filter(std::cin, std::cout);
+    RunFilter(filter, options, outStream);
   }
 
+  outStream.Close();
   return 0;
 }
 
+void FilterRuleTable::RunFilter(RuleFilter &filter, const Options &options,
+                                std::ostream &out)
+{
+  const double startTime = util::WallTime();
+  FilterStatistics stats;
+  filter.Filter(std::cin, out, options.threads, &stats);
+  if (options.statistics) {
+    const double seconds = util::WallTime() - startTime;
+    std::cerr << "rules read: " << stats.rules << "\n"
+              << "rules kept: " << stats.keptRules << "\n"
+              << "source-sides tested: " << stats.matchedSources << "\n"
+              << "time: " << seconds << "s";
+    if (seconds > 0) {
+      std::cerr << " (" << static_cast<std::size_t>(stats.rules / seconds)
+                << " rules/s)";
+    }
+    std::cerr << std::endl;
+  }
+}
+
 void FilterRuleTable::ReadTestSet(
   std::istream &input,
   std::vector<boost::shared_ptr<std::string> > &sentences)
@@ -179,6 +208,16 @@ void FilterRuleTable::ProcessOptions(int argc, char *argv[],
 
   // Declare the command line options that are visible to the user.
   po::options_description visible(usageTop.str());
+  visible.add_options()
+  ("OutputFile",
+   po::value(&options.outputFile)->default_value(options.outputFile),
+   "write the filtered table to named file (compressed if it ends in .gz, .zst or .lz4)")
+  ("Statistics",
+   "report rule counts and throughput on standard error")
+  ("Threads",
+   po::value(&options.threads)->default_value(options.threads),
+   "set number of threads used for matching rules")
+  ;
 
   // Declare the command line options that are hidden from the user
   // (these are used as positional options).
@@ -224,6 +263,17 @@ void FilterRuleTable::ProcessOptions(int argc, char *argv[],
     std::cerr << visible << usageBottom.str() << std::endl;
     std::exit(1);
   }
+
+  // Process Boolean options.
+  if (vm.count("Statistics")) {
+    options.statistics = true;
+  }
+
+#ifndef WITH_THREADS
+  if (options.threads > 1) {
+    Error("Threads requires a multi-threaded build");
+  }
+#endif
 }
 
 }  // namespace FilterRuleTable
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ostream>
 #include <vector>
 #include <string>
 
@@ -19,6 +20,7 @@ namespace FilterRuleTable
 {
 
 struct Options;
+class RuleFilter;
 
 class FilterRuleTable : public Tool
 {
@@ -36,6 +38,10 @@ private:
 
   void ProcessOptions(int, char *[], Options &) const;
 
+  // Filter rule table (on std::cin) using the given filter and write the
+  // result to out.
+  void RunFilter(RuleFilter &, const Options &, std::ostream &);
+
   // Read test set (string version)
   void ReadTestSet(std::istream &,
                    std::vector<boost::shared_ptr<std::string> > &);
@@ -11,11 +11,19 @@ namespace FilterRuleTable
 
 struct Options {
 public:
-  Options() {}
+  Options()
+    : outputFile("-")
+    , statistics(false)
+    , threads(1) {}
 
   // Positional options
   std::string model;
   std::string testSetFile;
+
+  // All other options
+  std::string outputFile;
+  bool statistics;
+  int threads;
 };
 
 }  // namespace FilterRuleTable
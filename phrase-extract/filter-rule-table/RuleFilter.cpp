@@ -0,0 +1,178 @@
+#include "RuleFilter.h"
+
+#include <cstring>
+#include <string>
+
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#endif
+
+#include "util/pcqueue.hh"
+#include "util/tokenize_piece.hh"
+
+namespace MosesTraining
+{
+namespace Syntax
+{
+namespace FilterRuleTable
+{
+
+namespace
+{
+// Size of the blocks the rule table is read in.  Chunks are a little longer
+// because they are extended to the end of the last line.
+const std::size_t kChunkSize = 1 << 22;
+}
+
+struct RuleFilter::Chunk {
+  Chunk() : done(0) {}
+
+  // Whole lines of the rule table, each ending in a newline.
+  std::string text;
+  // The rules that were kept.
+  std::string output;
+  FilterStatistics stats;
+  // Posted once output is complete.
+  util::Semaphore done;
+};
+
+void RuleFilter::Filter(std::istream &in, std::ostream &out, int threads,
+                        FilterStatistics *stats)
+{
+  FilterStatistics total;
+#ifdef WITH_THREADS
+  if (threads > 1) {
+    FilterInParallel(in, out, threads, total);
+  } else
+#endif
+  {
+    Chunk chunk;
+    while (ReadChunk(in, chunk)) {
+      FilterChunk(chunk);
+      out << chunk.output;
+      total += chunk.stats;
+    }
+  }
+  out.flush();
+  if (stats) {
+    *stats = total;
+  }
+}
+
+#ifdef WITH_THREADS
+void RuleFilter::FilterInParallel(std::istream &in, std::ostream &out,
+                                  int threads, FilterStatistics &stats)
+{
+  // Chunks go to the workers and, in the same order, to the writer, which
+  // waits for each one to be filtered.  The queues bound the number of chunks
+  // in memory.
+  util::PCQueue<Chunk *> toWorkers(threads * 2);
+  util::PCQueue<Chunk *> toWriter(threads * 4);
+  boost::thread_group workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.create_thread(boost::bind(&RuleFilter::FilterChunks, this,
+                                      boost::ref(toWorkers)));
+  }
+  boost::thread writer(boost::bind(&RuleFilter::WriteChunks, this,
+                                   boost::ref(toWriter), boost::ref(out),
+                                   boost::ref(stats)));
+  while (true) {
+    Chunk *chunk = new Chunk();
+    if (!ReadChunk(in, *chunk)) {
+      delete chunk;
+      break;
+    }
+    toWorkers.Produce(chunk);
+    toWriter.Produce(chunk);
+  }
+  for (int i = 0; i < threads; ++i) {
+    toWorkers.Produce(0);
+  }
+  toWriter.Produce(0);
+  workers.join_all();
+  writer.join();
+}
+#endif
+
+bool RuleFilter::ReadChunk(std::istream &in, Chunk &chunk) const
+{
+  chunk.text.resize(kChunkSize);
+  in.read(&chunk.text[0], kChunkSize);
+  chunk.text.resize(in.gcount());
+  if (chunk.text.empty()) {
+    return false;
+  }
+  // Extend the chunk to the end of the line.
+  if (chunk.text[chunk.text.size()-1] != '\n') {
+    std::string rest;
+    std::getline(in, rest);
+    chunk.text += rest;
+    chunk.text += '\n';
+  }
+  return true;
+}
+
+void RuleFilter::FilterChunk(Chunk &chunk) const
+{
+  const util::MultiCharacter fieldDelimiter("|||");
+
+  chunk.output.clear();
+  chunk.stats = FilterStatistics();
+
+  StringPiece source;
+  bool keep = true;
+  const char *end = chunk.text.data() + chunk.text.size();
+  for (const char *begin = chunk.text.data(); begin != end; ) {
+    const char *newline =
+      static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+    const StringPiece line(begin, newline - begin);
+    begin = newline + 1;
+    ++chunk.stats.rules;
+
+    // Read the source-side of the rule.
+    util::TokenIter<util::MultiCharacter> it(line, fieldDelimiter);
+
+    // Check if this rule has the same source-side as the previous rule.  If
+    // it does then we already know whether or not to keep the rule.  This
+    // optimisation is based on the assumption that the rule table is sorted
+    // (which is the case in the standard Moses training pipeline).
+    if (*it != source) {
+      source = *it;
+      keep = KeepSource(source);
+      ++chunk.stats.matchedSources;
+    }
+    if (keep) {
+      chunk.output.append(line.data(), line.size());
+      chunk.output += '\n';
+      ++chunk.stats.keptRules;
+    }
+  }
+}
+
+void RuleFilter::FilterChunks(util::PCQueue<Chunk *> &chunks) const
+{
+  Chunk *chunk;
+  while ((chunk = chunks.Consume())) {
+    FilterChunk(*chunk);
+    // The text is not needed while the chunk waits to be written.
+    std::string().swap(chunk->text);
+    chunk->done.post();
+  }
+}
+
+void RuleFilter::WriteChunks(util::PCQueue<Chunk *> &chunks, std::ostream &out,
+                             FilterStatistics &stats) const
+{
+  Chunk *chunk;
+  while ((chunk = chunks.Consume())) {
+    util::WaitSemaphore(chunk->done);
+    out << chunk->output;
+    stats += chunk->stats;
+    delete chunk;
+  }
+}
+
+}  // namespace FilterRuleTable
+}  // namespace Syntax
+}  // namespace MosesTraining
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+#include "util/string_piece.hh"
+
+namespace util
+{
+template <class T> class PCQueue;
+}
+
+namespace MosesTraining
+{
+namespace Syntax
+{
+namespace FilterRuleTable
+{
+
+// Counts collected while filtering a rule table.
+struct FilterStatistics {
+  FilterStatistics() : rules(0), keptRules(0), matchedSources(0) {}
+
+  FilterStatistics &operator+=(const FilterStatistics &other) {
+    rules += other.rules;
+    keptRules += other.keptRules;
+    matchedSources += other.matchedSources;
+    return *this;
+  }
+
+  // Number of rules read.
+  std::size_t rules;
+  // Number of rules written.
+  std::size_t keptRules;
+  // Number of rules whose source-side was matched against the test set (the
+  // rest had the same source-side as the rule before them).
+  std::size_t matchedSources;
+};
+
+// Base class for CfgFilter and TsgFilter.  Streams a rule table through the
+// filter, keeping the rules whose source-side can be applied to the test set.
+class RuleFilter
+{
+public:
+  virtual ~RuleFilter() {}
+
+  // Read a rule table from 'in' and filter it according to the test sentences.
+  // With more than one thread, chunks of the rule table are filtered in
+  // parallel and written to 'out' in their original order.
+  void Filter(std::istream &in, std::ostream &out, int threads=1,
+              FilterStatistics *stats=0);
+
+protected:
+  // Decide whether to keep the rules with the given source-side.  This is
+  // called from several threads at once, so it must not modify the filter.
+  virtual bool KeepSource(const StringPiece &source) const = 0;
+
+private:
+  struct Chunk;
+
+  // Read the next chunk of whole lines.  Returns false at the end of input.
+  bool ReadChunk(std::istream &, Chunk &) const;
+
+  // Copy the chunk's rules that are kept to its output.
+  void FilterChunk(Chunk &) const;
+
+  void FilterInParallel(std::istream &, std::ostream &, int,
+                        FilterStatistics &);
+  void FilterChunks(util::PCQueue<Chunk *> &) const;
+  void WriteChunks(util::PCQueue<Chunk *> &, std::ostream &,
+                   FilterStatistics &) const;
+};
+
+}  // namespace FilterRuleTable
+}  // namespace Syntax
+}  // namespace MosesTraining
@@ -50,57 +50,21 @@ StringCfgFilter::StringCfgFilter(
   }
 }
 
-void StringCfgFilter::Filter(std::istream &in, std::ostream &out)
+bool StringCfgFilter::KeepSource(const StringPiece &source) const
 {
-  const util::MultiCharacter fieldDelimiter("|||");
   const util::AnyCharacter symbolDelimiter(" \t");
 
-  std::string line;
-  std::string prevLine;
-  StringPiece source;
+  // Tokenize the source-side.
   std::vector<StringPiece> symbols;
-  Pattern pattern;
-  bool keep = true;
-  int lineNum = 0;
-
-  while (std::getline(in, line)) {
-    ++lineNum;
-
-    // Read the source-side of the rule.
-    util::TokenIter<util::MultiCharacter> it(line, fieldDelimiter);
-
-    // Check if this rule has the same source-side as the previous rule.  If
-    // it does then we already know whether or not to keep the rule.  This
-    // optimisation is based on the assumption that the rule table is sorted
-    // (which is the case in the standard Moses training pipeline).
-    if (*it == source) {
-      if (keep) {
-        out << line << std::endl;
-      }
-      continue;
-    }
-
-    // The source-side is different from the previous rule's.
-    source = *it;
-
-    // Tokenize the source-side.
-    symbols.clear();
-    for (util::TokenIter<util::AnyCharacter, true> p(source, symbolDelimiter);
-         p; ++p) {
-      symbols.push_back(*p);
-    }
-
-    // Generate a pattern (fails if any source-side terminal is not in the
-    // test set vocabulary) and attempt to match it against the test sentences.
-    keep = GeneratePattern(symbols, pattern) && MatchPattern(pattern);
-    if (keep) {
-      out << line << std::endl;
-    }
-
-    // Retain line for the next iteration (in order that the source StringPiece
-    // remains valid).
-    prevLine.swap(line);
+  for (util::TokenIter<util::AnyCharacter, true> p(source, symbolDelimiter);
+       p; ++p) {
+    symbols.push_back(*p);
   }
+
+  // Generate a pattern (fails if any source-side terminal is not in the
+  // test set vocabulary) and attempt to match it against the test sentences.
+  Pattern pattern;
+  return GeneratePattern(symbols, pattern) && MatchPattern(pattern);
 }
 
 void StringCfgFilter::AddSentenceNGrams(
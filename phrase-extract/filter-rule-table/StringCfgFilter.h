@@ -29,7 +29,8 @@ public:
   // Initialize the filter for a given set of test sentences.
   StringCfgFilter(const std::vector<boost::shared_ptr<std::string> > &);
 
-  void Filter(std::istream &in, std::ostream &out);
+protected:
+  bool KeepSource(const StringPiece &source) const;
 
 private:
   // Filtering works by converting the source LHSs of translation rules to
@@ -16,13 +16,10 @@ TreeCfgFilter::TreeCfgFilter(
 {
 }
 
-void TreeCfgFilter::Filter(std::istream &in, std::ostream &out)
+bool TreeCfgFilter::KeepSource(const StringPiece &source) const
 {
   // TODO Implement filtering!
-  std::string line;
-  while (std::getline(in, line)) {
-    out << line << std::endl;
-  }
+  return true;
 }
 
 }  // namespace FilterRuleTable
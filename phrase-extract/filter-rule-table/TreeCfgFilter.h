@@ -32,7 +32,8 @@ public:
   // Initialize the filter for a given set of test sentences.
   TreeCfgFilter(const std::vector<boost::shared_ptr<SyntaxTree> > &);
 
-  void Filter(std::istream &in, std::ostream &out);
+protected:
+  bool KeepSource(const StringPiece &source) const;
 };
 
 }  // namespace FilterRuleTable
@@ -13,7 +13,7 @@ namespace Syntax
 namespace FilterRuleTable
 {
 
-// Read a rule table from 'in' and filter it according to the test sentences.
+// Decide whether to keep the rules with a given source-side.
 //
 // This involves testing TSG fragments for matches against at potential match
 // sites in the set of test parse trees / forests.  There are a few
@@ -47,68 +47,30 @@ namespace FilterRuleTable
 // 24.1M    Number of rules requiring full tree matching test
 //  6.7M    Number of rules retained after filtering
 //
-void TsgFilter::Filter(std::istream &in, std::ostream &out)
+bool TsgFilter::KeepSource(const StringPiece &source) const
 {
-  const util::MultiCharacter delimiter("|||");
-
-  std::string line;
-  std::string prevLine;
-  StringPiece source;
-  bool keep = true;
-  int lineNum = 0;
+  // Tokenize the source-side tree fragment.
   std::vector<TreeFragmentToken> tokens;
-  std::vector<IdTree *> leaves;
-
-  while (std::getline(in, line)) {
-    ++lineNum;
-
-    // Read the source-side of the rule.
-    util::TokenIter<util::MultiCharacter> it(line, delimiter);
-
-    // Check if this rule has the same source-side as the previous rule.  If
-    // it does then we already know whether or not to keep the rule.  This
-    // optimisation is based on the assumption that the rule table is sorted
-    // (which is the case in the standard Moses training pipeline).
-    if (*it == source) {
-      if (keep) {
-        out << line << std::endl;
-      }
-      continue;
-    }
-
-    // The source-side is different from the previous rule's.
-    source = *it;
-
-    // Tokenize the source-side tree fragment.
-    tokens.clear();
-    for (TreeFragmentTokenizer p(source); p != TreeFragmentTokenizer(); ++p) {
-      tokens.push_back(*p);
-    }
-
-    // Construct an IdTree representing the source-side tree fragment.  This
-    // will fail if the fragment contains any symbols that don't occur in
-    // m_testVocab and in that case the rule can be discarded.  In practice,
-    // this catches a lot of discardable rules (see comment at the top of this
-    // function).  If the fragment is successfully created then we attempt to
-    // match the tree fragment against the test trees.  This test is exact, but
-    // slow.
-    int i = 0;
-    leaves.clear();
-    boost::scoped_ptr<IdTree> fragment(BuildTree(tokens, i, leaves));
-    keep = fragment.get() && MatchFragment(*fragment, leaves);
-    if (keep) {
-      out << line << std::endl;
-    }
-
-    // Retain line for the next iteration (in order that the source StringPiece
-    // remains valid).
-    prevLine.swap(line);
+  for (TreeFragmentTokenizer p(source); p != TreeFragmentTokenizer(); ++p) {
+    tokens.push_back(*p);
   }
+
+  // Construct an IdTree representing the source-side tree fragment.  This
+  // will fail if the fragment contains any symbols that don't occur in
+  // m_testVocab and in that case the rule can be discarded.  In practice,
+  // this catches a lot of discardable rules (see comment at the top of this
+  // function).  If the fragment is successfully created then we attempt to
+  // match the tree fragment against the test trees.  This test is exact, but
+  // slow.
+  int i = 0;
+  std::vector<IdTree *> leaves;
+  boost::scoped_ptr<IdTree> fragment(BuildTree(tokens, i, leaves));
+  return fragment.get() && MatchFragment(*fragment, leaves);
 }
 
 TsgFilter::IdTree *TsgFilter::BuildTree(
   const std::vector<TreeFragmentToken> &tokens, int &i,
-  std::vector<IdTree *> &leaves)
+  std::vector<IdTree *> &leaves) const
 {
   // The subtree starting at tokens[i] is either:
   // 1. a single non-variable symbol (like NP or dog), or
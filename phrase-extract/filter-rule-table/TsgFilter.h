@@ -1,7 +1,5 @@
 #pragma once
 
-#include <istream>
-#include <ostream>
 #include <string>
 #include <vector>
 
@@ -9,6 +7,8 @@
 #include "syntax-common/tree.h"
 #include "syntax-common/tree_fragment_tokenizer.h"
 
+#include "RuleFilter.h"
+
 namespace MosesTraining
 {
 namespace Syntax
@@ -18,15 +18,14 @@ namespace FilterRuleTable
 
 // Base class for TreeTsgFilter and ForestTsgFilter, both of which filter rule
 // tables where the source-side is TSG.
-class TsgFilter
+class TsgFilter : public RuleFilter
 {
 public:
   virtual ~TsgFilter() {}
 
-  // Read a rule table from 'in' and filter it according to the test sentences.
-  void Filter(std::istream &in, std::ostream &out);
-
 protected:
+  bool KeepSource(const StringPiece &source) const;
+
   // Maps symbols (terminals and non-terminals) from strings to integers.
   typedef NumberedSet<std::string, std::size_t> Vocabulary;
 
@@ -40,11 +39,12 @@ protected:
   // pointers to the fragment's leaves.  If the build fails then i and leaves
   // are undefined.
   IdTree *BuildTree(const std::vector<TreeFragmentToken> &tokens, int &i,
-                    std::vector<IdTree *> &leaves);
+                    std::vector<IdTree *> &leaves) const;
 
   // Try to match a fragment.  The implementation depends on whether the test
   // sentences are trees or forests.
-  virtual bool MatchFragment(const IdTree &, const std::vector<IdTree *> &) = 0;
+  virtual bool MatchFragment(const IdTree &,
+                             const std::vector<IdTree *> &) const = 0;
 
   // The symbol vocabulary of the test sentences.
   Vocabulary m_testVocab;
@@ -0,0 +1,2 @@
+#!/bin/sh
+./bjam --with-probing-pt --with-mm -q
@@ -18,6 +18,8 @@ int main(int argc, char* argv[])
   bool log_prob = false;
   bool scfg = false;
   int max_cache_size = 50000;
+  int num_threads = 1;
+  uint64_t memory = 1ULL << 30;
 
   namespace po = boost::program_options;
   po::options_description desc("Options");
@@ -30,6 +32,8 @@ int main(int argc, char* argv[])
   ("log-prob", "log (and floor) probabilities before storing")
   ("max-cache-size", po::value<int>()->default_value(max_cache_size), "Maximum number of high-count source lines to write to cache file. 0=no cache, negative=no limit")
   ("scfg", "Rules are SCFG in Moses format (ie. with non-terms and LHS")
+  ("threads", po::value<int>()->default_value(num_threads), "Number of threads parsing the text pt")
+  ("memory", po::value<string>()->default_value("1G"), "Memory for text and rules in flight between reading, parsing and writing (not including the hash table). Suffixes K, M, G, T or %")
 
   ;
 
@@ -58,6 +62,8 @@ int main(int argc, char* argv[])
   if (vm.count("num-scores")) num_scores = vm["num-scores"].as<int>();
   if (vm.count("num-lex-scores")) num_lex_scores = vm["num-lex-scores"].as<int>();
   if (vm.count("max-cache-size")) max_cache_size = vm["max-cache-size"].as<int>();
+  if (vm.count("threads")) num_threads = vm["threads"].as<int>();
+  if (vm.count("memory")) memory = util::ParseSize(vm["memory"].as<string>());
   if (vm.count("log-prob")) log_prob = true;
   if (vm.count("scfg")) scfg = true;
 
@@ -66,7 +72,7 @@ int main(int argc, char* argv[])
     inPath = ReformatSCFGFile(inPath);
   }
 
-  probingpt::createProbingPT(inPath, outPath, num_scores, num_lex_scores, log_prob, max_cache_size, scfg);
+  probingpt::createProbingPT(inPath, outPath, num_scores, num_lex_scores, log_prob, max_cache_size, scfg, num_threads, memory);
 
   //util::PrintUsage(std::cout);
   return 0;
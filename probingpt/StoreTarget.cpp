@@ -31,7 +31,8 @@ StoreTarget::StoreTarget(const std::string &basepath)
 
 StoreTarget::~StoreTarget()
 {
-  assert(m_coll.empty());
+  // only left over if the build failed half-way
+  Moses2::RemoveAllInColl(m_coll);
   m_fileTargetColl.close();
 
   // vocab
@@ -61,7 +62,7 @@ uint64_t StoreTarget::Save()
 void StoreTarget::Save(const target_text &rule)
 {
   // metadata for each tp
-  TargetPhraseInfo tpInfo;
+  TargetPhraseInfo tpInfo = TargetPhraseInfo(); // zero filler and padding
   tpInfo.alignTerm = GetAlignId(rule.word_align_term);
   tpInfo.alignNonTerm = GetAlignId(rule.word_align_non_term);
   tpInfo.numWords = rule.target_phrase.size();
@@ -106,6 +107,24 @@ void StoreTarget::SaveAlignment()
 void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
 {
   target_text *rule = new target_text;
+  std::vector<StringPiece> factors;
+  Parse(line, log_prob, scfg, *rule, factors);
+  Append(rule, factors);
+}
+
+void StoreTarget::Append(target_text *rule, const std::vector<StringPiece> &factors)
+{
+  rule->target_phrase.reserve(factors.size());
+  for (size_t i = 0; i < factors.size(); ++i) {
+    uint32_t vocabId = m_vocab.GetVocabId(factors[i].as_string());
+    rule->target_phrase.push_back(vocabId);
+  }
+  m_coll.push_back(rule);
+}
+
+void StoreTarget::Parse(const line_text &line, bool log_prob, bool scfg,
+                        target_text &rule, std::vector<StringPiece> &factors)
+{
   //cerr << "line.target_phrase=" << line.target_phrase << endl;
 
   // target_phrase
@@ -131,12 +150,7 @@ void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
     itFactor = util::TokenIter<util::SingleCharacter>(word,
                util::SingleCharacter('|'));
     while (itFactor) {
-      StringPiece factor = *itFactor;
-
-      string factorStr = factor.as_string();
-      uint32_t vocabId = m_vocab.GetVocabId(factorStr);
-
-      rule->target_phrase.push_back(vocabId);
+      factors.push_back(*itFactor);
 
       itFactor++;
     }
@@ -156,7 +170,7 @@ void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
       if (prob == 0.0f) prob = 0.0000000001;
     }
 
-    rule->prob.push_back(prob);
+    rule.prob.push_back(prob);
     it++;
   }
 
@@ -190,12 +204,12 @@ void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
     //cerr << targetPos << "=" << nonTerm << endl;
 
     if (nonTerm) {
-      rule->word_align_non_term.push_back(sourcePos);
-      rule->word_align_non_term.push_back(targetPos);
+      rule.word_align_non_term.push_back(sourcePos);
+      rule.word_align_non_term.push_back(targetPos);
       //cerr << (int) rule->word_all1.back() << " ";
     } else {
-      rule->word_align_term.push_back(sourcePos);
-      rule->word_align_term.push_back(targetPos);
+      rule.word_align_term.push_back(sourcePos);
+      rule.word_align_term.push_back(targetPos);
     }
 
     it++;
@@ -203,7 +217,7 @@ void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
 
   // extra scores
   string prop = line.property.as_string();
-  AppendLexRO(prop, rule->prob, log_prob);
+  AppendLexRO(prop, rule.prob, log_prob);
 
   //cerr << "line.property=" << line.property << endl;
   //cerr << "prop=" << prop << endl;
@@ -214,7 +228,6 @@ void StoreTarget::Append(const line_text &line, bool log_prob, bool scfg)
    rule->property.push_back(prop[i]);
    }
    */
-  m_coll.push_back(rule);
 }
 
 uint32_t StoreTarget::GetAlignId(const std::vector<size_t> &align)
@@ -231,7 +244,7 @@ uint32_t StoreTarget::GetAlignId(const std::vector<size_t> &align)
 }
 
 void StoreTarget::AppendLexRO(std::string &prop, std::vector<float> &retvector,
-                              bool log_prob) const
+                              bool log_prob)
 {
   size_t startPos = prop.find("{{LexRO ");
 
@@ -12,6 +12,7 @@
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 #include "StoreVocab.h"
+#include "util/string_piece.hh"
 
 namespace probingpt
 {
@@ -29,6 +30,16 @@ public:
   void SaveAlignment();
 
   void Append(const line_text &line, bool log_prob, bool scfg);
+
+  // Append a rule filled in by Parse(). Takes ownership of rule once it
+  // returns, not if it throws, and assigns target vocab ids to factors, which
+  // must still point into the input text.
+  void Append(target_text *rule, const std::vector<StringPiece> &factors);
+
+  // Everything Append() does that doesn't touch the vocab or alignment ids,
+  // so it can run on worker threads.
+  static void Parse(const line_text &line, bool log_prob, bool scfg,
+                    target_text &rule, std::vector<StringPiece> &factors);
 protected:
   std::string m_basePath;
   std::fstream m_fileTargetColl;
@@ -42,8 +53,8 @@ protected:
   uint32_t GetAlignId(const std::vector<size_t> &align);
   void Save(const target_text &rule);
 
-  void AppendLexRO(std::string &prop, std::vector<float> &retvector,
-                   bool log_prob) const;
+  static void AppendLexRO(std::string &prop, std::vector<float> &retvector,
+                          bool log_prob);
 
 };
 
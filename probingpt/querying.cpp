@@ -1,5 +1,7 @@
 #include "querying.h"
 #include "util/exception.hh"
+#include "util/mmap.hh"
+#include "util/prefetch.hh"
 #include "moses2/legacy/Util2.h"
 
 using namespace std;
@@ -8,6 +10,8 @@ namespace probingpt
 {
 
 QueryEngine::QueryEngine(const char * filepath, util::LoadMethod load_method)
+  :advise_(load_method == util::LAZY)
+  ,page_size_(util::SizePage())
 {
 
   //Create filepaths
@@ -118,6 +122,54 @@ std::pair<bool, uint64_t> QueryEngine::query(uint64_t key)
   return ret;
 }
 
+void QueryEngine::query(const uint64_t keys[], size_t size,
+                        std::pair<bool, uint64_t> results[]) const
+{
+  if (advise_) {
+    std::vector<uintptr_t> pages(size);
+    for (size_t i = 0; i < size; ++i) {
+      pages[i] = reinterpret_cast<uintptr_t>(table.Ideal(keys[i])) & ~(page_size_ - 1);
+    }
+    advise(pages);
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    table.Prefetch(keys[i]);
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    const Entry * entry;
+    results[i].first = table.Find(keys[i], entry);
+    if (results[i].first) {
+      results[i].second = entry->value;
+      if (entry->value != NONE) {
+        util::PrefetchRead(memTPS + entry->value);
+      }
+    }
+  }
+
+  if (advise_) {
+    std::vector<uintptr_t> pages;
+    pages.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      if (results[i].first && results[i].second != NONE) {
+        pages.push_back(reinterpret_cast<uintptr_t>(memTPS + results[i].second) & ~(page_size_ - 1));
+      }
+    }
+    advise(pages);
+  }
+}
+
+void QueryEngine::advise(std::vector<uintptr_t> &pages) const
+{
+  // one syscall per distinct page
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    util::AdviseWillNeed(reinterpret_cast<const void*>(pages[i]), 1);
+  }
+}
+
 void QueryEngine::read_alignments(const std::string &alignPath)
 {
   std::ifstream strm(alignPath.c_str());
@@ -37,6 +37,11 @@ class QueryEngine
   util::scoped_fd fileTPS_;
   util::scoped_memory memoryTPS_;
 
+  // table is mmapped without populating, see query() for batches
+  bool advise_;
+  std::size_t page_size_;
+
+  void advise(std::vector<uintptr_t> &pages) const;
   void read_alignments(const std::string &alignPath);
   void file_exits(const std::string &basePath);
 
@@ -51,6 +56,14 @@ public:
 
   std::pair<bool, uint64_t> query(uint64_t key);
 
+  // Look up size keys at once, eg. all source spans of a sentence.
+  // Prefetches every bucket before probing any of them so the cache misses
+  // overlap, then prefetches the target phrase collections that were found.
+  // If the files are mapped lazily, also madvise(WILLNEED)s their pages.
+  // results[i] is the answer to keys[i], as for query(key).
+  void query(const uint64_t keys[], size_t size,
+             std::pair<bool, uint64_t> results[]) const;
+
   const std::map<uint64_t, std::string> &getSourceVocab() const {
     return source_vocabids;
   }
@@ -1,11 +1,17 @@
 #include <sys/stat.h>
+#include <algorithm>
+#include <exception>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include "line_splitter.h"
 #include "storing.h"
 #include "StoreTarget.h"
 #include "StoreVocab.h"
 #include "moses2/legacy/Util2.h"
-#include "InputFileStream.h"
+#include "util/pcqueue.hh"
 
 using namespace std;
 
@@ -13,59 +19,174 @@ namespace probingpt
 {
 
 ///////////////////////////////////////////////////////////////////////
-void Node::Add(Table &table, const SourcePhrase &sourcePhrase, size_t pos)
+namespace
 {
-  if (pos < sourcePhrase.size()) {
-    uint64_t vocabId = sourcePhrase[pos];
-
-    Node *child;
-    Children::iterator iter = m_children.find(vocabId);
-    if (iter == m_children.end()) {
-      // New node. Write other children then discard them
-      BOOST_FOREACH(Children::value_type &valPair, m_children) {
-        Node &otherChild = valPair.second;
-        otherChild.Write(table);
+
+// A phrase table line after the work that doesn't depend on previous lines.
+struct ParsedLine {
+  ParsedLine() : rule(NULL) {}
+
+  StringPiece source;
+  std::vector<uint64_t> sourceIds;
+  target_text *rule; // owned by the batch until AppendRule()
+  std::vector<StringPiece> factors;
+  bool hasCount;
+  float count;
+};
+
+// A block of whole lines, parsed by any worker then merged in order.
+struct Batch {
+  Batch() : ready(0) {}
+
+  // frees the rules that weren't merged
+  ~Batch() {
+    for (size_t i = 0; i < lines.size(); ++i) {
+      delete lines[i].rule;
+    }
+  }
+
+  std::string text;
+  std::vector<ParsedLine> lines;
+  util::Semaphore ready;
+};
+
+// The first exception thrown on one of the threads. The others see Failed()
+// and wind down, so the main thread can join them and rethrow it.
+class ThreadError
+{
+public:
+  ThreadError() : m_failed(false) {}
+
+  // call from a catch block
+  void Capture() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_failed) {
+      m_error = std::current_exception();
+      m_failed = true;
+    }
+  }
+
+  bool Failed() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_failed;
+  }
+
+  void Rethrow() const {
+    if (m_failed) {
+      std::rethrow_exception(m_error);
+    }
+  }
+
+private:
+  mutable boost::mutex m_mutex;
+  bool m_failed;
+  std::exception_ptr m_error;
+};
+
+// Stands in for the hash table to count what goes into it.
+struct EntryCounter {
+  EntryCounter() : count(0) {}
+  void Insert(const Entry &) {
+    ++count;
+  }
+  uint64_t count;
+};
+
+// Parsed rules take a few times the space of their text.
+const uint64_t kParsedExpansion = 4;
+const uint64_t kMinBatchBytes = 1 << 20;
+
+void ReadBatches(util::FilePiece &filein, uint64_t batchBytes, size_t numWorkers,
+                 util::PCQueue<Batch*> &work, util::PCQueue<Batch*> &merge,
+                 ThreadError &error)
+{
+  Batch *batch = new Batch;
+  try {
+    StringPiece line;
+    while (!error.Failed() && filein.ReadLineOrEOF(line)) {
+      batch->text.append(line.data(), line.size());
+      batch->text += '\n';
+
+      if (batch->text.size() >= batchBytes) {
+        merge.Produce(batch);
+        work.Produce(batch);
+        batch = new Batch;
       }
-      m_children.clear();
-
-      // create new node
-      child = &m_children[vocabId];
-      assert(!child->done);
-      child->key = key + (vocabId << pos);
-    } else {
-      child = &iter->second;
     }
+  } catch (...) {
+    error.Capture();
+  }
 
-    child->Add(table, sourcePhrase, pos + 1);
-  } else {
-    // this node was written previously 'cos it has rules
-    done = true;
+  // the end markers go out regardless, or the other threads would wait forever
+  merge.Produce(batch);
+  work.Produce(batch);
+  merge.Produce(NULL);
+  for (size_t i = 0; i < numWorkers; ++i) {
+    work.Produce(NULL);
   }
 }
 
-void Node::Write(Table &table)
+void ParseBatch(Batch &batch, bool log_prob, bool scfg, int max_cache_size)
 {
-  //cerr << "START write " << done << " " << key << endl;
-  BOOST_FOREACH(Children::value_type &valPair, m_children) {
-    Node &child = valPair.second;
-    child.Write(table);
+  // every line, including the last, is terminated by '\n'
+  size_t begin = 0, end;
+  while ((end = batch.text.find('\n', begin)) != std::string::npos) {
+    StringPiece text(batch.text.data() + begin, end - begin);
+    begin = end + 1;
+    line_text line = splitLine(text, scfg);
+
+    batch.lines.push_back(ParsedLine());
+    ParsedLine &parsed = batch.lines.back();
+    parsed.source = line.source_phrase;
+    parsed.sourceIds = getVocabIDs(line.source_phrase);
+    parsed.rule = new target_text;
+    StoreTarget::Parse(line, log_prob, scfg, *parsed.rule, parsed.factors);
+
+    parsed.hasCount = false;
+    if (max_cache_size) {
+      std::string countStr = line.counts.as_string();
+      countStr = Moses2::Trim(countStr);
+      if (!countStr.empty()) {
+        std::vector<float> toks = Moses2::Tokenize<float>(countStr);
+        if (toks.size() >= 2) {
+          parsed.hasCount = true;
+          parsed.count = toks[1];
+        }
+      }
+    }
   }
+}
 
-  if (!done) {
-    // save
-    Entry sourceEntry;
-    sourceEntry.value = NONE;
-    sourceEntry.key = key;
-
-    //Put into table
-    table.Insert(sourceEntry);
+void ParseBatches(util::PCQueue<Batch*> &work, bool log_prob, bool scfg, int max_cache_size,
+                  ThreadError &error)
+{
+  Batch *batch;
+  while (work.Consume(batch)) {
+    if (!error.Failed()) {
+      try {
+        ParseBatch(*batch, log_prob, scfg, max_cache_size);
+      } catch (...) {
+        error.Capture();
+      }
+    }
+    // the main thread waits for every batch, parsed or not
+    batch->ready.post();
   }
 }
 
-///////////////////////////////////////////////////////////////////////
+// Hand the rule of a line over to storeTarget.
+void AppendRule(StoreTarget &storeTarget, ParsedLine &line)
+{
+  storeTarget.Append(line.rule, line.factors);
+  line.rule = NULL;
+}
+
+}
+
 void createProbingPT(const std::string &phrasetable_path,
                      const std::string &basepath, int num_scores, int num_lex_scores,
-                     bool log_prob, int max_cache_size, bool scfg)
+                     bool log_prob, int max_cache_size, bool scfg,
+                     int num_threads, uint64_t memory)
 {
 #if defined(_WIN32) || defined(_WIN64)
   std::cerr << "Create not implemented for Windows" << std::endl;
@@ -77,8 +198,9 @@ void createProbingPT(const std::string &phrasetable_path,
 
   StoreTarget storeTarget(basepath);
 
-  //Get uniq lines:
-  unsigned long uniq_entries = countUniqueSource(phrasetable_path);
+  //Get uniq lines, and prefixes for SCFG:
+  unsigned long uniq_entries = 0;
+  uint64_t table_entries = countSourceEntries(phrasetable_path, scfg);
 
   //Source phrase vocabids
   StoreVocab<uint64_t> sourceVocab(basepath + "/source_vocabids");
@@ -86,11 +208,30 @@ void createProbingPT(const std::string &phrasetable_path,
   //Read the file
   util::FilePiece filein(phrasetable_path.c_str());
 
+  // Batches waiting to be merged bound everything in flight: each one is
+  // either queued, being parsed or being merged.
+  size_t numWorkers = std::max(num_threads, 1);
+  size_t maxBatches = 2 * numWorkers;
+  uint64_t batchBytes = std::max(kMinBatchBytes,
+                                 memory / kParsedExpansion / (maxBatches + 2));
+  util::PCQueue<Batch*> work(maxBatches + 2);
+  util::PCQueue<Batch*> merge(maxBatches);
+
   //Init the probing hash table
-  size_t size = Table::Size(uniq_entries, 1.2);
-  char * mem = new char[size];
-  memset(mem, 0, size);
-  Table sourceEntries(mem, size);
+  size_t size = Table::Size(table_entries, 1.2);
+  boost::scoped_array<char> mem(new char[size]);
+  memset(mem.get(), 0, size);
+  Table sourceEntries(mem.get(), size);
+
+  ThreadError error;
+  boost::thread_group threads;
+  threads.create_thread(boost::bind(&ReadBatches, boost::ref(filein),
+                                    batchBytes, numWorkers, boost::ref(work), boost::ref(merge),
+                                    boost::ref(error)));
+  for (size_t i = 0; i < numWorkers; ++i) {
+    threads.create_thread(boost::bind(&ParseBatches, boost::ref(work),
+                                      log_prob, scfg, max_cache_size, boost::ref(error)));
+  }
 
   std::priority_queue<CacheItem*, std::vector<CacheItem*>, CacheItemOrderer> cache;
   float totalSourceCount = 0;
@@ -100,131 +241,126 @@ void createProbingPT(const std::string &phrasetable_path,
 
   //Read everything and processs
   std::string prevSource;
+  std::vector<uint64_t> prevVocabIds;
 
   Node sourcePhrases;
   sourcePhrases.done = true;
   sourcePhrases.key = 0;
 
-  while (true) {
+  Batch *batch;
+  while (merge.Consume(batch)) {
+    util::WaitSemaphore(batch->ready);
+    if (error.Failed()) {
+      // keep taking batches until the reader stops
+      delete batch;
+      continue;
+    }
+
     try {
-      //Process line read
-      line_text line;
-      line = splitLine(filein.ReadLine(), scfg);
-      //cerr << "line=" << line.source_phrase << endl;
-
-      ++line_num;
-      if (line_num % 1000000 == 0) {
-        std::cerr << line_num << " " << std::flush;
-      }
+      for (size_t i = 0; i < batch->lines.size(); ++i) {
+        ParsedLine &line = batch->lines[i];
 
-      //Add source phrases to vocabularyIDs
-      add_to_map(sourceVocab, line.source_phrase);
-
-      if (prevSource.empty()) {
-        // 1st line
-        prevSource = line.source_phrase.as_string();
-        storeTarget.Append(line, log_prob, scfg);
-      } else if (prevSource == line.source_phrase) {
-        //If we still have the same line, just append to it:
-        storeTarget.Append(line, log_prob, scfg);
-      } else {
-        assert(prevSource != line.source_phrase);
-
-        //Create a new entry even
-
-        // save
-        uint64_t targetInd = storeTarget.Save();
-
-        // next line
-        storeTarget.Append(line, log_prob, scfg);
-
-        //Create an entry for the previous source phrase:
-        Entry sourceEntry;
-        sourceEntry.value = targetInd;
-        //The key is the sum of hashes of individual words bitshifted by their position in the phrase.
-        //Probably not entirerly correct, but fast and seems to work fine in practise.
-        std::vector<uint64_t> vocabid_source = getVocabIDs(prevSource);
-        if (scfg) {
-          // storing prefixes?
-          sourcePhrases.Add(sourceEntries, vocabid_source);
+        ++line_num;
+        if (line_num % 1000000 == 0) {
+          std::cerr << line_num << " " << std::flush;
         }
-        sourceEntry.key = getKey(vocabid_source);
-
-        /*
-        cerr << "prevSource=" << prevSource << flush
-            << " vocabids=" << Debug(vocabid_source) << flush
-            << " key=" << sourceEntry.key << endl;
-        */
-        //Put into table
-        sourceEntries.Insert(sourceEntry);
-
-        // update cache - CURRENT source phrase, not prev
-        if (max_cache_size) {
-          std::string countStr = line.counts.as_string();
-          countStr = Moses2::Trim(countStr);
-          if (!countStr.empty()) {
-            std::vector<float> toks = Moses2::Tokenize<float>(countStr);
-            //cerr << "CACHE:" << line.source_phrase << " " << countStr << " " << toks[1] << endl;
-
-            if (toks.size() >= 2) {
-              totalSourceCount += toks[1];
-
-              // compute key for CURRENT source
-              std::vector<uint64_t> currVocabidSource = getVocabIDs(line.source_phrase.as_string());
-              uint64_t currKey = getKey(currVocabidSource);
-
-              CacheItem *item = new CacheItem(
-                Moses2::Trim(line.source_phrase.as_string()),
-                currKey,
-                toks[1]);
-              cache.push(item);
-
-              if (max_cache_size > 0 && cache.size() > max_cache_size) {
-                cache.pop();
-              }
+
+        if (line_num == 1) {
+          // 1st line
+          add_to_map(sourceVocab, line.source);
+          prevSource = line.source.as_string();
+          prevVocabIds.swap(line.sourceIds);
+          AppendRule(storeTarget, line);
+        } else if (prevSource == line.source) {
+          //If we still have the same line, just append to it:
+          AppendRule(storeTarget, line);
+        } else {
+          //Add source phrases to vocabularyIDs
+          add_to_map(sourceVocab, line.source);
+
+          // save
+          uint64_t targetInd = storeTarget.Save();
+
+          // next line
+          AppendRule(storeTarget, line);
+
+          //Create an entry for the previous source phrase:
+          Entry sourceEntry;
+          sourceEntry.value = targetInd;
+          //The key is the sum of hashes of individual words bitshifted by their position in the phrase.
+          //Probably not entirerly correct, but fast and seems to work fine in practise.
+          if (scfg) {
+            // storing prefixes?
+            sourcePhrases.Add(sourceEntries, prevVocabIds);
+          }
+          sourceEntry.key = getKey(prevVocabIds);
+
+          //Put into table
+          sourceEntries.Insert(sourceEntry);
+          ++uniq_entries;
+
+          // update cache - CURRENT source phrase, not prev
+          if (line.hasCount) {
+            totalSourceCount += line.count;
+
+            // compute key for CURRENT source
+            uint64_t currKey = getKey(line.sourceIds);
+
+            CacheItem *item = new CacheItem(
+              Moses2::Trim(line.source.as_string()),
+              currKey,
+              line.count);
+            cache.push(item);
+
+            if (max_cache_size > 0 && cache.size() > max_cache_size) {
+              cache.pop();
             }
           }
-        }
 
-        //Set prevLine
-        prevSource = line.source_phrase.as_string();
+          //Set prevLine
+          prevSource = line.source.as_string();
+          prevVocabIds.swap(line.sourceIds);
+        }
       }
+    } catch (...) {
+      error.Capture();
+    }
 
-    } catch (util::EndOfFileException e) {
-      std::cerr
-          << "Reading phrase table finished, writing remaining files to disk."
-          << std::endl;
+    delete batch;
+  }
+  threads.join_all();
+  error.Rethrow();
 
-      //After the final entry is constructed we need to add it to the phrase_table
-      //Create an entry for the previous source phrase:
-      uint64_t targetInd = storeTarget.Save();
+  std::cerr
+      << "Reading phrase table finished, writing remaining files to disk."
+      << std::endl;
 
-      Entry sourceEntry;
-      sourceEntry.value = targetInd;
+  if (line_num) {
+    //After the final entry is constructed we need to add it to the phrase_table
+    //Create an entry for the previous source phrase:
+    uint64_t targetInd = storeTarget.Save();
 
-      //The key is the sum of hashes of individual words. Probably not entirerly correct, but fast
-      std::vector<uint64_t> vocabid_source = getVocabIDs(prevSource);
-      sourceEntry.key = getKey(vocabid_source);
+    Entry sourceEntry;
+    sourceEntry.value = targetInd;
 
-      //Put into table
-      sourceEntries.Insert(sourceEntry);
+    //The key is the sum of hashes of individual words. Probably not entirerly correct, but fast
+    sourceEntry.key = getKey(prevVocabIds);
 
-      break;
-    }
+    //Put into table
+    sourceEntries.Insert(sourceEntry);
+    ++uniq_entries;
   }
 
   sourcePhrases.Write(sourceEntries);
 
   storeTarget.SaveAlignment();
 
-  serialize_table(mem, size, (basepath + "/probing_hash.dat"));
+  serialize_table(mem.get(), size, (basepath + "/probing_hash.dat"));
 
   sourceVocab.Save();
 
   serialize_cache(cache, (basepath + "/cache"), totalSourceCount);
 
-  delete[] mem;
-
   //Write configfile
   std::ofstream configfile;
   configfile.open((basepath + "/config").c_str());
@@ -237,25 +373,6 @@ void createProbingPT(const std::string &phrasetable_path,
 #endif
 }
 
-size_t countUniqueSource(const std::string &path)
-{
-  size_t ret = 0;
-  InputFileStream strme(path);
-
-  std::string line, prevSource;
-  while (std::getline(strme, line)) {
-    std::vector<std::string> toks = Moses2::TokenizeMultiCharSeparator(line, "|||");
-    assert(toks.size() != 0);
-
-    if (prevSource != toks[0]) {
-      prevSource = toks[0];
-      ++ret;
-    }
-  }
-
-  return ret;
-}
-
 void serialize_cache(
   std::priority_queue<CacheItem*, std::vector<CacheItem*>, CacheItemOrderer> &cache,
   const std::string &path, float totalSourceCount)
@@ -282,6 +399,36 @@ void serialize_cache(
   os.close();
 }
 
+uint64_t countSourceEntries(const std::string &path, bool scfg)
+{
+  EntryCounter counter;
+  Node prefixes;
+  prefixes.done = true;
+  prefixes.key = 0;
+
+  // the same phrases, in the same order, as createProbingPT() adds them
+  util::FilePiece filein(path.c_str());
+  std::string prevSource;
+  bool first = true;
+  StringPiece line;
+  while (filein.ReadLineOrEOF(line)) {
+    StringPiece source = Trim(*util::TokenIter<util::MultiCharacter>(line, util::MultiCharacter("|||")));
+    if (!first && prevSource == source) {
+      continue;
+    }
+    if (scfg && !first) {
+      // added when the next phrase starts, so never for the last one
+      prefixes.Add(counter, getVocabIDs(prevSource));
+    }
+    first = false;
+    prevSource.assign(source.data(), source.size());
+    ++counter.count;
+  }
+  prefixes.Write(counter);
+
+  return counter.count;
+}
+
 uint64_t getKey(const std::vector<uint64_t> &vocabid_source)
 {
   return probingpt::getKey(vocabid_source.data(), vocabid_source.size());
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <boost/foreach.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/unordered_map.hpp>
+#include <cassert>
 #include <cstdio>
 #include <sstream>
 #include <fstream>
@@ -35,14 +37,77 @@ public:
     :done(false)
   {}
 
-  void Add(Table &table, const SourcePhrase &sourcePhrase, size_t pos = 0);
-  void Write(Table &table);
+  // Sink is the hash Table, or anything else with Insert(const Entry&)
+  template<typename Sink>
+  void Add(Sink &table, const SourcePhrase &sourcePhrase, size_t pos = 0);
+  template<typename Sink>
+  void Write(Sink &table);
 };
 
+template<typename Sink>
+void Node::Add(Sink &table, const SourcePhrase &sourcePhrase, size_t pos)
+{
+  if (pos < sourcePhrase.size()) {
+    uint64_t vocabId = sourcePhrase[pos];
+
+    Node *child;
+    Children::iterator iter = m_children.find(vocabId);
+    if (iter == m_children.end()) {
+      // New node. Write other children then discard them
+      BOOST_FOREACH(Children::value_type &valPair, m_children) {
+        Node &otherChild = valPair.second;
+        otherChild.Write(table);
+      }
+      m_children.clear();
+
+      // create new node
+      child = &m_children[vocabId];
+      assert(!child->done);
+      child->key = key + (vocabId << pos);
+    } else {
+      child = &iter->second;
+    }
+
+    child->Add(table, sourcePhrase, pos + 1);
+  } else {
+    // this node was written previously 'cos it has rules
+    done = true;
+  }
+}
+
+template<typename Sink>
+void Node::Write(Sink &table)
+{
+  //cerr << "START write " << done << " " << key << endl;
+  BOOST_FOREACH(Children::value_type &valPair, m_children) {
+    Node &child = valPair.second;
+    child.Write(table);
+  }
+
+  if (!done) {
+    // save
+    Entry sourceEntry;
+    sourceEntry.value = NONE;
+    sourceEntry.key = key;
+
+    //Put into table
+    table.Insert(sourceEntry);
+  }
+}
+
 
+/** Binarize a sorted text phrase table.
+ * Reading/decompression, line parsing and the ordered merge that assigns ids
+ * and writes the files run on separate threads; num_threads is the number of
+ * parsing threads. memory bounds the text and parsed rules in flight between
+ * the stages (the hash table itself is not included). The output is identical
+ * for any number of threads. An exception on any of the threads is rethrown
+ * once they have all stopped.
+ */
 void createProbingPT(const std::string &phrasetable_path,
                      const std::string &basepath, int num_scores, int num_lex_scores,
-                     bool log_prob, int max_cache_size, bool scfg);
+                     bool log_prob, int max_cache_size, bool scfg,
+                     int num_threads = 1, uint64_t memory = 1ULL << 30);
 uint64_t getKey(const std::vector<uint64_t> &source_phrase);
 
 std::vector<uint64_t> CreatePrefix(const std::vector<uint64_t> &vocabid_source, size_t endPos);
@@ -57,7 +122,9 @@ std::string Debug(const std::vector<T> &vec)
   return strm.str();
 }
 
-size_t countUniqueSource(const std::string &path);
+// Number of entries the source phrase hash table needs: one per distinct
+// source phrase and, for SCFG, one per prefix that isn't a source phrase.
+uint64_t countSourceEntries(const std::string &path, bool scfg);
 
 class CacheItem
 {
@@ -0,0 +1,84 @@
+#include "storing.h"
+
+#define BOOST_TEST_MODULE StoringTest
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace probingpt
+{
+namespace
+{
+
+namespace fs = boost::filesystem;
+
+struct TempDir {
+  TempDir() : path(fs::temp_directory_path() / fs::unique_path("storing_test-%%%%-%%%%")) {
+    fs::create_directories(path);
+  }
+  ~TempDir() {
+    fs::remove_all(path);
+  }
+  fs::path path;
+};
+
+// Several MB of rules, so that the builder reads them in many batches. Two
+// or three target phrases per source phrase; every other source phrase
+// shares its first word with the one before it.
+void WriteTable(const fs::path &path, bool scfg)
+{
+  std::ofstream out(path.string().c_str());
+  const char *lhs = scfg ? " [X]" : "";
+  for (unsigned i = 0; i < 60000; ++i) {
+    std::ostringstream source;
+    source << "p" << 100000 + i / 2 << " q" << 100000 + i << lhs;
+    for (unsigned j = 0; j < 2 + i % 2; ++j) {
+      out << source.str() << " ||| t" << i % 97 << " u" << j << lhs
+          << " ||| 0." << 1 + j << " 0.5 0." << 1 + i % 9 << " 0.25"
+          << " ||| 0-0 1-1 ||| " << 3 + j << " " << 2 + i % 5 << " 1\n";
+    }
+  }
+}
+
+std::string ReadFile(const fs::path &path)
+{
+  std::ifstream in(path.string().c_str(), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// The table built on 4 threads with the smallest batches is the one built
+// on a single thread, byte for byte.
+void CheckSameTable(bool scfg)
+{
+  TempDir dir;
+  fs::path table = dir.path / "phrase-table";
+  WriteTable(table, scfg);
+  createProbingPT(table.string(), (dir.path / "serial").string(), 4, 0, true, 100, scfg, 1, 1ULL << 30);
+  createProbingPT(table.string(), (dir.path / "parallel").string(), 4, 0, true, 100, scfg, 4, 0);
+
+  size_t files = 0;
+  for (fs::directory_iterator i(dir.path / "serial"), end; i != end; ++i) {
+    fs::path other = dir.path / "parallel" / i->path().filename();
+    BOOST_REQUIRE(fs::exists(other));
+    BOOST_CHECK_MESSAGE(ReadFile(i->path()) == ReadFile(other),
+                        i->path().filename().string() << " differs");
+    ++files;
+  }
+  BOOST_CHECK_EQUAL(files, std::distance(fs::directory_iterator(dir.path / "parallel"), fs::directory_iterator()));
+  BOOST_CHECK_GT(fs::file_size(dir.path / "serial" / "probing_hash.dat"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(PhraseBased) {
+  CheckSameTable(false);
+}
+
+BOOST_AUTO_TEST_CASE(SCFG) {
+  CheckSameTable(true);
+}
+
+} // namespace
+} // namespace probingpt
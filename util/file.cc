@@ -298,6 +298,12 @@ void ErsatzPWrite(int fd, const void *from_void, std::size_t size, uint64_t off)
   }
 }
 
+void AdviseReadAhead(int fd, uint64_t off, uint64_t size) {
+#if !defined(_WIN32) && !defined(_WIN64) && defined(POSIX_FADV_WILLNEED)
+  posix_fadvise(fd, off, size, POSIX_FADV_WILLNEED);
+#endif
+}
+
 
 void FSyncOrThrow(int fd) {
 // Apparently windows doesn't have fsync?
@@ -124,6 +124,10 @@ void WriteOrThrow(FILE *to, const void *data, std::size_t size);
 void ErsatzPRead(int fd, void *to, std::size_t size, uint64_t off);
 void ErsatzPWrite(int fd, const void *data_void, std::size_t size, uint64_t off);
 
+// Hint that [off, off + size) will be read soon so the kernel can start
+// reading it in the background.  Does nothing where unsupported.
+void AdviseReadAhead(int fd, uint64_t off, uint64_t size);
+
 void FSyncOrThrow(int fd);
 
 // Seeking
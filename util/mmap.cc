@@ -37,6 +37,24 @@ std::size_t SizePage() {
 #endif
 }
 
+void AdviseWillNeed(const void *addr, std::size_t size) {
+#if !defined(_WIN32) && !defined(_WIN64) && defined(MADV_WILLNEED)
+  static const uintptr_t page = SizePage();
+  uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+  uintptr_t end = reinterpret_cast<uintptr_t>(addr) + size;
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+}
+
+void AdviseRandom(const void *addr, std::size_t size) {
+#if !defined(_WIN32) && !defined(_WIN64) && defined(MADV_RANDOM)
+  static const uintptr_t page = SizePage();
+  uintptr_t begin = reinterpret_cast<uintptr_t>(addr) & ~(page - 1);
+  uintptr_t end = reinterpret_cast<uintptr_t>(addr) + size;
+  madvise(reinterpret_cast<void*>(begin), end - begin, MADV_RANDOM);
+#endif
+}
+
 scoped_mmap::~scoped_mmap() {
   if (data_ != (void*)-1) {
     try {
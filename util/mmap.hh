@@ -14,6 +14,15 @@ class scoped_fd;
 
 std::size_t SizePage();
 
+// Tell the kernel that the pages covering [addr, addr + size) will be read
+// soon, so reads of a lazily mapped file can start before the page faults.
+// No-op where madvise is not available.
+void AdviseWillNeed(const void *addr, std::size_t size);
+
+// Tell the kernel that [addr, addr + size) will be read in random order, so
+// page faults don't read ahead. No-op where madvise is not available.
+void AdviseRandom(const void *addr, std::size_t size);
+
 // (void*)-1 is MAP_FAILED; this is done to avoid including the mmap header here.
 class scoped_mmap {
   public:
@@ -0,0 +1,32 @@
+#ifndef UTIL_PREFETCH_H
+#define UTIL_PREFETCH_H
+
+/* Software prefetch hints.  These never change program behavior; they only
+ * ask the CPU to start pulling a cache line in so that a later dependent load
+ * does not stall on DRAM.  Useful for hash table probes that are issued in
+ * batches: compute every bucket address first, prefetch, then probe.
+ */
+
+namespace util {
+
+// Prefetch for reading with low temporal locality (we probe once and move on).
+inline void PrefetchRead(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address, 0, 0);
+#else
+  (void)address;
+#endif
+}
+
+// Prefetch for a write that will happen soon.
+inline void PrefetchWrite(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address, 1, 0);
+#else
+  (void)address;
+#endif
+}
+
+} // namespace util
+
+#endif // UTIL_PREFETCH_H
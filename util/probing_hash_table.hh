@@ -3,6 +3,7 @@
 
 #include "util/exception.hh"
 #include "util/mmap.hh"
+#include "util/prefetch.hh"
 
 #include <algorithm>
 #include <cstddef>
@@ -208,6 +209,12 @@ template <class EntryT, class HashT, class EqualT = std::equal_to<typename Entry
       return FindFromIdeal(key, out);
     }
 
+    // Start pulling the ideal bucket for key into cache.  Call this a few
+    // lookups ahead of Find to overlap memory latency across independent keys.
+    template <class Key> void Prefetch(const Key key) const {
+      PrefetchRead(Ideal(key));
+    }
+
     // Like Find but we're sure it must be there.
     template <class Key> ConstIterator MustFind(const Key key) const {
       for (ConstIterator i(Ideal(key));; mod_.Next(begin_, end_, i)) {
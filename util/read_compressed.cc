@@ -24,6 +24,14 @@
 #include <lzma.h>
 #endif
 
+#ifdef HAVE_ZSTDLIB
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4LIB
+#include <lz4frame.h>
+#endif
+
 namespace util {
 
 CompressedException::CompressedException() throw() {}
@@ -38,6 +46,12 @@ BZException::~BZException() throw() {}
 XZException::XZException() throw() {}
 XZException::~XZException() throw() {}
 
+ZStdException::ZStdException() throw() {}
+ZStdException::~ZStdException() throw() {}
+
+LZ4Exception::LZ4Exception() throw() {}
+LZ4Exception::~LZ4Exception() throw() {}
+
 class ReadBase {
   public:
     virtual ~ReadBase() {}
@@ -326,6 +340,123 @@ class XZip {
 };
 #endif // HAVE_XZLIB
 
+#if defined(HAVE_ZSTDLIB) || defined(HAVE_LZ4LIB)
+// The part of a zlib-style stream that StreamCompressed looks at, for
+// libraries that don't have one.
+struct StreamPointers {
+  const uint8_t *next_in;
+  std::size_t avail_in;
+  uint8_t *next_out;
+};
+#endif
+
+#ifdef HAVE_ZSTDLIB
+class ZStd {
+  public:
+    ZStd(const void *base, std::size_t amount) : stream_(ZSTD_createDStream()) {
+      if (!stream_) throw std::bad_alloc();
+      HandleError(ZSTD_initDStream(stream_));
+      SetInput(base, amount);
+    }
+
+    ~ZStd() {
+      ZSTD_freeDStream(stream_);
+    }
+
+    void SetOutput(void *base, std::size_t amount) {
+      out_.dst = base;
+      out_.size = amount;
+      out_.pos = 0;
+      pointers_.next_out = static_cast<uint8_t*>(base);
+    }
+
+    void SetInput(const void *base, std::size_t amount) {
+      in_.src = base;
+      in_.size = amount;
+      in_.pos = 0;
+      pointers_.next_in = static_cast<const uint8_t*>(base);
+      pointers_.avail_in = amount;
+    }
+
+    const StreamPointers &Stream() const { return pointers_; }
+
+    bool Process() {
+      bool at_end = (in_.size == 0);
+      std::size_t before = out_.pos;
+      std::size_t ret = HandleError(ZSTD_decompressStream(stream_, &out_, &in_));
+      pointers_.next_in = static_cast<const uint8_t*>(in_.src) + in_.pos;
+      pointers_.avail_in = in_.size - in_.pos;
+      pointers_.next_out = static_cast<uint8_t*>(out_.dst) + out_.pos;
+      // 0 means the frame is decoded and flushed.
+      if (!ret) return false;
+      UTIL_THROW_IF(at_end && out_.pos == before, ZStdException, "zstd file ended in the middle of a frame");
+      return true;
+    }
+
+  private:
+    std::size_t HandleError(std::size_t value) {
+      UTIL_THROW_IF(ZSTD_isError(value), ZStdException, "zstd says " << ZSTD_getErrorName(value));
+      return value;
+    }
+
+    ZSTD_DStream *stream_;
+    ZSTD_inBuffer in_;
+    ZSTD_outBuffer out_;
+    StreamPointers pointers_;
+};
+#endif // HAVE_ZSTDLIB
+
+#ifdef HAVE_LZ4LIB
+class LZ4 {
+  public:
+    LZ4(const void *base, std::size_t amount) {
+      HandleError(LZ4F_createDecompressionContext(&context_, LZ4F_VERSION));
+      SetInput(base, amount);
+    }
+
+    ~LZ4() {
+      LZ4F_freeDecompressionContext(context_);
+    }
+
+    void SetOutput(void *base, std::size_t amount) {
+      pointers_.next_out = static_cast<uint8_t*>(base);
+      out_end_ = pointers_.next_out + amount;
+    }
+
+    void SetInput(const void *base, std::size_t amount) {
+      pointers_.next_in = static_cast<const uint8_t*>(base);
+      pointers_.avail_in = amount;
+      at_end_ = !amount;
+    }
+
+    const StreamPointers &Stream() const { return pointers_; }
+
+    bool Process() {
+      std::size_t out_size = out_end_ - pointers_.next_out;
+      std::size_t in_size = pointers_.avail_in;
+      std::size_t ret = HandleError(LZ4F_decompress(context_, pointers_.next_out, &out_size, pointers_.next_in, &in_size, NULL));
+      pointers_.next_out += out_size;
+      pointers_.next_in += in_size;
+      pointers_.avail_in -= in_size;
+      // 0 means the frame is complete.
+      if (!ret) return false;
+      UTIL_THROW_IF(at_end_ && !out_size, LZ4Exception, "lz4 file ended in the middle of a frame");
+      return true;
+    }
+
+  private:
+    std::size_t HandleError(std::size_t value) {
+      UTIL_THROW_IF(LZ4F_isError(value), LZ4Exception, "lz4 says " << LZ4F_getErrorName(value));
+      return value;
+    }
+
+    LZ4F_dctx *context_;
+    StreamPointers pointers_;
+    uint8_t *out_end_;
+    bool at_end_;
+};
+#endif // HAVE_LZ4LIB
+
 class IStreamReader : public ReadBase {
   public:
     explicit IStreamReader(std::istream &stream) : stream_(stream) {}
@@ -344,7 +475,7 @@ class IStreamReader : public ReadBase {
 };
 
 enum MagicResult {
-  UTIL_UNKNOWN, UTIL_GZIP, UTIL_BZIP, UTIL_XZIP
+  UTIL_UNKNOWN, UTIL_GZIP, UTIL_BZIP, UTIL_XZIP, UTIL_ZSTD, UTIL_LZ4
 };
 
 MagicResult DetectMagic(const void *from_void, std::size_t length) {
@@ -360,6 +491,14 @@ MagicResult DetectMagic(const void *from_void, std::size_t length) {
   if (length >= sizeof(kXZMagic) && !memcmp(header, kXZMagic, sizeof(kXZMagic))) {
     return UTIL_XZIP;
   }
+  const uint8_t kZStdMagic[4] = { 0x28, 0xB5, 0x2F, 0xFD };
+  if (length >= sizeof(kZStdMagic) && !memcmp(header, kZStdMagic, sizeof(kZStdMagic))) {
+    return UTIL_ZSTD;
+  }
+  const uint8_t kLZ4Magic[4] = { 0x04, 0x22, 0x4D, 0x18 };
+  if (length >= sizeof(kLZ4Magic) && !memcmp(header, kLZ4Magic, sizeof(kLZ4Magic))) {
+    return UTIL_LZ4;
+  }
   return UTIL_UNKNOWN;
 }
 
@@ -394,6 +533,18 @@ ReadBase *ReadFactory(int fd, uint64_t &raw_amount, const void *already_data, co
       return new StreamCompressed<XZip>(hold.release(), header.data(), header.size());
 #else
       UTIL_THROW(CompressedException, "This looks like an xz file, but xz support was not compiled in.");
+#endif
+    case UTIL_ZSTD:
+#ifdef HAVE_ZSTDLIB
+      return new StreamCompressed<ZStd>(hold.release(), header.data(), header.size());
+#else
+      UTIL_THROW(CompressedException, "This looks like a zstd file, but zstd support was not compiled in.");
+#endif
+    case UTIL_LZ4:
+#ifdef HAVE_LZ4LIB
+      return new StreamCompressed<LZ4>(hold.release(), header.data(), header.size());
+#else
+      UTIL_THROW(CompressedException, "This looks like an lz4 file, but lz4 support was not compiled in.");
 #endif
     default:
       UTIL_THROW_IF(require_compressed, CompressedException, "Uncompressed data detected after a compresssed file.  This could be supported but usually indicates an error.");
@@ -1,6 +1,7 @@
 #include "util/read_compressed.hh"
 
 #include "util/file.hh"
+#include "util/write_compressed.hh"
 #include "util/have.hh"
 
 #define BOOST_TEST_MODULE ReadCompressedTest
@@ -8,6 +9,7 @@
 #include <boost/scoped_ptr.hpp>
 
 #include <fstream>
+#include <ostream>
 #include <string>
 #include <cstdlib>
 
@@ -112,6 +114,69 @@ BOOST_AUTO_TEST_CASE(ReadXZ) {
 }
 #endif
 
+// Write with WriteCompressed, in two streams back to back.
+void TestWrite(Compression compression) {
+  char name[] = "tempXXXXXX";
+  scoped_fd file(mkstemp(name));
+  BOOST_REQUIRE(file.get() > 0);
+  BOOST_CHECK_EQUAL(0, unlink(name));
+  for (uint32_t half = 0; half < 2; ++half) {
+    WriteCompressed writer(DupOrThrow(file.get()), compression);
+    for (uint32_t i = half * kSize4 / 2; i < (half + 1) * kSize4 / 2; ++i) {
+      writer.Write(&i, sizeof(uint32_t));
+    }
+  }
+  SeekOrThrow(file.get(), 0);
+  ReadCompressed reader(file.release());
+  VerifyRead(reader);
+}
+
+BOOST_AUTO_TEST_CASE(WriteUncompressed) {
+  TestWrite(UNCOMPRESSED);
+}
+
+#ifdef HAVE_ZLIB
+BOOST_AUTO_TEST_CASE(WriteGZ) {
+  TestWrite(GZIP);
+}
+#endif
+
+#ifdef HAVE_ZSTDLIB
+BOOST_AUTO_TEST_CASE(WriteZStd) {
+  TestWrite(ZSTD);
+}
+#endif
+
+#ifdef HAVE_LZ4LIB
+BOOST_AUTO_TEST_CASE(WriteLZ4) {
+  TestWrite(LZ4);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(StreamAfterFinish) {
+  char name[] = "tempXXXXXX";
+  scoped_fd file(mkstemp(name));
+  BOOST_REQUIRE(file.get() > 0);
+  BOOST_CHECK_EQUAL(0, unlink(name));
+  WriteCompressedBuf buf(DupOrThrow(file.get()), UNCOMPRESSED);
+  std::ostream out(&buf);
+  out << "before" << std::flush;
+  buf.Finish();
+  buf.Finish();
+  out << std::flush;
+  BOOST_CHECK(out);
+  out << "after" << std::flush;
+  BOOST_CHECK(!out);
+  BOOST_CHECK_EQUAL(6, SizeOrThrow(file.get()));
+}
+
+BOOST_AUTO_TEST_CASE(Extension) {
+  BOOST_CHECK_EQUAL(GZIP, CompressionFromExtension("extract.sorted.gz"));
+  BOOST_CHECK_EQUAL(ZSTD, CompressionFromExtension("extract.sorted.zst"));
+  BOOST_CHECK_EQUAL(LZ4, CompressionFromExtension("/tmp/lm.lz4"));
+  BOOST_CHECK_EQUAL(UNCOMPRESSED, CompressionFromExtension("nbest.txt"));
+}
+
 #ifdef HAVE_ZLIB
 BOOST_AUTO_TEST_CASE(AppendGZ) {
 }
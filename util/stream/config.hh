@@ -49,6 +49,9 @@ struct ChainConfig {
  */
 struct SortConfig {
 
+  /** Constructs a configuration that merges on one thread with a heap. */
+  SortConfig() : merge_threads(1), loser_tree(false) {}
+
   /** Filename prefix where temporary files should be placed. */
   std::string temp_prefix;
 
@@ -57,6 +60,15 @@ struct SortConfig {
 
   /** Total memory to use when running alone. */
   std::size_t total_memory;
+
+  /**
+   * Threads for merge passes that write to a temporary file.  Each merges
+   * its own range of keys.  The lazy merge into a chain is on one thread.
+   */
+  std::size_t merge_threads;
+
+  /** Merge with a tree of losers instead of a binary heap. */
+  bool loser_tree;
 };
 
 }} // namespaces
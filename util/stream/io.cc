@@ -74,5 +74,29 @@ void PWriteAndRecycle::Run(const ChainPosition &position) {
   util::ResizeOrThrow(file_, offset);
 }
 
+void CompressedWrite::Run(const ChainPosition &position) {
+  WriteCompressed out(file_, compression_);
+  for (Link link(position); link; ++link) {
+    out.Write(link->Get(), link->ValidSize());
+  }
+  out.Finish();
+}
+
+void CompressedRead::Run(const ChainPosition &position) {
+  ReadCompressed in(file_);
+  const std::size_t block_size = position.GetChain().BlockSize();
+  const std::size_t entry_size = position.GetChain().EntrySize();
+  for (Link link(position); link; ++link) {
+    std::size_t got = in.ReadOrEOF(link->Get(), block_size);
+    UTIL_THROW_IF(got % entry_size, ReadSizeException, "Compressed file ended with " << got << " bytes, not a multiple of " << entry_size << ".");
+    if (got == 0) {
+      link.Poison();
+      return;
+    } else {
+      link->SetValidSize(got);
+    }
+  }
+}
+
 } // namespace stream
 } // namespace util
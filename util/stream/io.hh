@@ -3,6 +3,7 @@
 
 #include "util/exception.hh"
 #include "util/file.hh"
+#include "util/write_compressed.hh"
 
 namespace util {
 namespace stream {
@@ -59,6 +60,27 @@ class PWriteAndRecycle {
     int file_;
 };
 
+// Like Write but compressed, e.g. with LZ4 to save disk for temporary files
+// at little CPU cost.  Takes ownership of fd and ends the compressed stream
+// at poison.
+class CompressedWrite {
+  public:
+    CompressedWrite(int fd, Compression compression) : file_(fd), compression_(compression) {}
+    void Run(const ChainPosition &position);
+  private:
+    int file_;
+    Compression compression_;
+};
+
+// Like Read but decompresses anything ReadCompressed can.  Takes ownership of
+// fd.
+class CompressedRead {
+  public:
+    explicit CompressedRead(int fd) : file_(fd) {}
+    void Run(const ChainPosition &position);
+  private:
+    int file_;
+};
 
 // Reuse the same file over and over again to buffer output.
 class FileBuffer {
@@ -21,6 +21,7 @@
 #include "util/stream/chain.hh"
 #include "util/stream/config.hh"
 #include "util/stream/io.hh"
+#include "util/stream/multi_stream.hh"
 #include "util/stream/stream.hh"
 #include "util/stream/timer.hh"
 
@@ -29,10 +30,14 @@
 #include "util/scoped.hh"
 #include "util/sized_iterator.hh"
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <algorithm>
 #include <iostream>
 #include <queue>
 #include <string>
+#include <vector>
 
 namespace util {
 namespace stream {
@@ -121,6 +126,54 @@ class Offsets {
     uint64_t output_sum_;
 };
 
+// Don't use this directly.  A sorted run being merged, read through a buffer.
+class MergeEntry {
+  public:
+    MergeEntry() {}
+
+    MergeEntry(void *base, int fd, uint64_t offset, uint64_t amount, std::size_t buf_size) {
+      offset_ = offset;
+      remaining_ = amount;
+      buffer_end_ = static_cast<uint8_t*>(base) + buf_size;
+      Read(fd, buf_size);
+    }
+
+    bool Increment(int fd, std::size_t buf_size, std::size_t entry_size) {
+      current_ += entry_size;
+      if (current_ != buffer_end_) return true;
+      return Read(fd, buf_size);
+    }
+
+    const void *Current() const { return current_; }
+
+  private:
+    bool Read(int fd, std::size_t buf_size) {
+      current_ = buffer_end_ - buf_size;
+      std::size_t amount;
+      if (static_cast<uint64_t>(buf_size) < remaining_) {
+        amount = buf_size;
+      } else if (!remaining_) {
+        return false;
+      } else {
+        amount = remaining_;
+        buffer_end_ = current_ + remaining_;
+      }
+      ErsatzPRead(fd, current_, amount, offset_);
+      offset_ += amount;
+      assert(current_ <= buffer_end_);
+      remaining_ -= amount;
+      // Have the kernel fetch the next buffer while this one is merged.
+      if (remaining_)
+        AdviseReadAhead(fd, offset_, std::min<uint64_t>(buf_size, remaining_));
+      return true;
+    }
+
+    // Buffer
+    uint8_t *current_, *buffer_end_;
+    // File
+    uint64_t remaining_, offset_;
+};
+
 // A priority queue of entries backed by file buffers
 template <class Compare> class MergeQueue {
   public:
@@ -128,15 +181,18 @@ template <class Compare> class MergeQueue {
       : queue_(Greater(compare)), in_(fd), buffer_size_(buffer_size), entry_size_(entry_size) {}
 
     void Push(void *base, uint64_t offset, uint64_t amount) {
-      queue_.push(Entry(base, in_, offset, amount, buffer_size_));
+      queue_.push(MergeEntry(base, in_, offset, amount, buffer_size_));
     }
 
+    // Nothing to do: the heap is kept up to date by Push.
+    void Build() {}
+
     const void *Top() const {
       return queue_.top().Current();
     }
 
     void Pop() {
-      Entry top(queue_.top());
+      MergeEntry top(queue_.top());
       queue_.pop();
       if (top.Increment(in_, buffer_size_, entry_size_))
         queue_.push(top);
@@ -151,57 +207,12 @@ template <class Compare> class MergeQueue {
     }
 
   private:
-    // Priority queue contains these entries.
-    class Entry {
-      public:
-        Entry() {}
-
-        Entry(void *base, int fd, uint64_t offset, uint64_t amount, std::size_t buf_size) {
-          offset_ = offset;
-          remaining_ = amount;
-          buffer_end_ = static_cast<uint8_t*>(base) + buf_size;
-          Read(fd, buf_size);
-        }
-
-        bool Increment(int fd, std::size_t buf_size, std::size_t entry_size) {
-          current_ += entry_size;
-          if (current_ != buffer_end_) return true;
-          return Read(fd, buf_size);
-        }
-
-        const void *Current() const { return current_; }
-
-      private:
-        bool Read(int fd, std::size_t buf_size) {
-          current_ = buffer_end_ - buf_size;
-          std::size_t amount;
-          if (static_cast<uint64_t>(buf_size) < remaining_) {
-            amount = buf_size;
-          } else if (!remaining_) {
-            return false;
-          } else {
-            amount = remaining_;
-            buffer_end_ = current_ + remaining_;
-          }
-          ErsatzPRead(fd, current_, amount, offset_);
-          offset_ += amount;
-          assert(current_ <= buffer_end_);
-          remaining_ -= amount;
-          return true;
-        }
-
-        // Buffer
-        uint8_t *current_, *buffer_end_;
-        // File
-        uint64_t remaining_, offset_;
-    };
-
     // Wrapper comparison function for queue entries.
-    class Greater : public std::binary_function<const Entry &, const Entry &, bool> {
+    class Greater : public std::binary_function<const MergeEntry &, const MergeEntry &, bool> {
       public:
         explicit Greater(const Compare &compare) : compare_(compare) {}
 
-        bool operator()(const Entry &first, const Entry &second) const {
+        bool operator()(const MergeEntry &first, const MergeEntry &second) const {
           return compare_(second.Current(), first.Current());
         }
 
@@ -209,7 +220,7 @@ template <class Compare> class MergeQueue {
         const Compare compare_;
     };
 
-    typedef std::priority_queue<Entry, std::vector<Entry>, Greater> Queue;
+    typedef std::priority_queue<MergeEntry, std::vector<MergeEntry>, Greater> Queue;
     Queue queue_;
 
     const int in_;
@@ -217,6 +228,96 @@ template <class Compare> class MergeQueue {
     const std::size_t entry_size_;
 };
 
+/* Drop-in replacement for MergeQueue that keeps a tree of losers: each
+ * internal node remembers the run that lost the match played there.  Taking
+ * the next entry replays one path from leaf to root, which is one comparison
+ * per level instead of about two for a binary heap.  Call Build after the last
+ * Push.
+ */
+template <class Compare> class LoserTree {
+  public:
+    LoserTree(int fd, std::size_t buffer_size, std::size_t entry_size, const Compare &compare)
+      : compare_(compare), in_(fd), buffer_size_(buffer_size), entry_size_(entry_size), winner_(0), live_(0) {}
+
+    void Push(void *base, uint64_t offset, uint64_t amount) {
+      entries_.push_back(MergeEntry(base, in_, offset, amount, buffer_size_));
+      ++live_;
+    }
+
+    void Build() {
+      // Leaves are nodes [size, 2 * size) and node 0 is unused.
+      tree_.resize(entries_.size());
+      done_.assign(entries_.size(), false);
+      if (!entries_.empty()) winner_ = Play(1);
+    }
+
+    const void *Top() const {
+      return entries_[winner_].Current();
+    }
+
+    void Pop() {
+      if (!entries_[winner_].Increment(in_, buffer_size_, entry_size_)) {
+        done_[winner_] = true;
+        --live_;
+      }
+      for (std::size_t node = (winner_ + entries_.size()) / 2; node; node /= 2) {
+        if (Less(tree_[node], winner_)) std::swap(tree_[node], winner_);
+      }
+    }
+
+    std::size_t Size() const {
+      return live_;
+    }
+
+    bool Empty() const {
+      return !live_;
+    }
+
+  private:
+    // Runs that have run out lose to everything.
+    bool Less(std::size_t first, std::size_t second) const {
+      if (done_[first]) return false;
+      if (done_[second]) return true;
+      return compare_(entries_[first].Current(), entries_[second].Current());
+    }
+
+    // Fill in the losers below node and return the winner.
+    std::size_t Play(std::size_t node) {
+      if (node >= entries_.size()) return node - entries_.size();
+      std::size_t left = Play(2 * node), right = Play(2 * node + 1);
+      if (Less(right, left)) {
+        tree_[node] = left;
+        return right;
+      }
+      tree_[node] = right;
+      return left;
+    }
+
+    const Compare compare_;
+
+    std::vector<MergeEntry> entries_;
+    std::vector<std::size_t> tree_;
+    std::vector<bool> done_;
+
+    const int in_;
+    const std::size_t buffer_size_;
+    const std::size_t entry_size_;
+
+    std::size_t winner_;
+    std::size_t live_;
+};
+
+// Size of the buffer for each run in a merge.  Bigger if there are fewer runs
+// left to merge.
+inline uint64_t MergeBufferSize(std::size_t buffer_size, std::size_t total_memory, uint64_t remaining_blocks, std::size_t entry_size) {
+  uint64_t per_buffer = static_cast<uint64_t>(std::max<std::size_t>(
+      buffer_size,
+      static_cast<std::size_t>((static_cast<uint64_t>(total_memory) / remaining_blocks))));
+  per_buffer -= per_buffer % entry_size;
+  assert(per_buffer);
+  return per_buffer;
+}
+
 /* A worker object that merges.  If the number of pieces to merge exceeds the
  * arity, it outputs multiple sorted blocks, recording to out_offsets.
  * However, users will only every see a single sorted block out output because
@@ -225,11 +326,12 @@ template <class Compare> class MergeQueue {
  */
 template <class Compare, class Combine> class MergingReader {
   public:
-    MergingReader(int in, Offsets *in_offsets, Offsets *out_offsets, std::size_t buffer_size, std::size_t total_memory, const Compare &compare, const Combine &combine) :
+    MergingReader(int in, Offsets *in_offsets, Offsets *out_offsets, std::size_t buffer_size, std::size_t total_memory, const Compare &compare, const Combine &combine, bool loser_tree = false) :
         compare_(compare), combine_(combine),
         in_(in),
         in_offsets_(in_offsets), out_offsets_(out_offsets),
-        buffer_size_(buffer_size), total_memory_(total_memory) {}
+        buffer_size_(buffer_size), total_memory_(total_memory),
+        loser_tree_(loser_tree) {}
 
     void Run(const ChainPosition &position) {
       Run(position, false);
@@ -254,54 +356,59 @@ template <class Compare, class Combine> class MergingReader {
 
       Stream str(position);
       scoped_malloc buffer(MallocOrThrow(total_memory_));
-      uint8_t *const buffer_end = static_cast<uint8_t*>(buffer.get()) + total_memory_;
 
       const std::size_t entry_size = position.GetChain().EntrySize();
 
       while (in_offsets_->RemainingBlocks()) {
-        // Use bigger buffers if there's less remaining.
-        uint64_t per_buffer = static_cast<uint64_t>(std::max<std::size_t>(
-            buffer_size_,
-            static_cast<std::size_t>((static_cast<uint64_t>(total_memory_) / in_offsets_->RemainingBlocks()))));
-        per_buffer -= per_buffer % entry_size;
-        assert(per_buffer);
-
-        // Populate queue.
-        MergeQueue<Compare> queue(in_, per_buffer, entry_size, compare_);
-        for (uint8_t *buf = static_cast<uint8_t*>(buffer.get());
-            in_offsets_->RemainingBlocks() && (buf + std::min(per_buffer, in_offsets_->PeekSize()) <= buffer_end);) {
-          uint64_t offset = in_offsets_->TotalOffset();
-          uint64_t size = in_offsets_->NextSize();
-          queue.Push(buf, offset, size);
-          buf += static_cast<std::size_t>(std::min<uint64_t>(size, per_buffer));
-        }
-        // This shouldn't happen but it's probably better to die than loop indefinitely.
-        if (queue.Size() < 2 && in_offsets_->RemainingBlocks()) {
-          std::cerr << "Bug in sort implementation: not merging at least two stripes." << std::endl;
-          abort();
+        uint64_t per_buffer = MergeBufferSize(buffer_size_, total_memory_, in_offsets_->RemainingBlocks(), entry_size);
+        if (loser_tree_) {
+          LoserTree<Compare> queue(in_, per_buffer, entry_size, compare_);
+          MergeGroup(queue, static_cast<uint8_t*>(buffer.get()), per_buffer, entry_size, str, assert_one);
+        } else {
+          MergeQueue<Compare> queue(in_, per_buffer, entry_size, compare_);
+          MergeGroup(queue, static_cast<uint8_t*>(buffer.get()), per_buffer, entry_size, str, assert_one);
         }
-        if (assert_one && in_offsets_->RemainingBlocks()) {
-          std::cerr << "Bug in sort implementation: should only be one merge group for lazy sort" << std::endl;
-          abort();
-        }
-
-        uint64_t written = 0;
-        // Merge including combiner support.
-        memcpy(str.Get(), queue.Top(), entry_size);
-        for (queue.Pop(); !queue.Empty(); queue.Pop()) {
-          if (!combine_(str.Get(), queue.Top(), compare_)) {
-            ++written; ++str;
-            memcpy(str.Get(), queue.Top(), entry_size);
-          }
-        }
-        ++written; ++str;
-        if (out_offsets_)
-          out_offsets_->Append(written * entry_size);
       }
       str.Poison();
     }
 
   private:
+    // Merge as many runs as fit in the buffer.
+    template <class Queue> void MergeGroup(Queue &queue, uint8_t *buffer, uint64_t per_buffer, std::size_t entry_size, Stream &str, bool assert_one) {
+      uint8_t *const buffer_end = buffer + total_memory_;
+      // Populate queue.
+      for (uint8_t *buf = buffer;
+          in_offsets_->RemainingBlocks() && (buf + std::min(per_buffer, in_offsets_->PeekSize()) <= buffer_end);) {
+        uint64_t offset = in_offsets_->TotalOffset();
+        uint64_t size = in_offsets_->NextSize();
+        queue.Push(buf, offset, size);
+        buf += static_cast<std::size_t>(std::min<uint64_t>(size, per_buffer));
+      }
+      queue.Build();
+      // This shouldn't happen but it's probably better to die than loop indefinitely.
+      if (queue.Size() < 2 && in_offsets_->RemainingBlocks()) {
+        std::cerr << "Bug in sort implementation: not merging at least two stripes." << std::endl;
+        abort();
+      }
+      if (assert_one && in_offsets_->RemainingBlocks()) {
+        std::cerr << "Bug in sort implementation: should only be one merge group for lazy sort" << std::endl;
+        abort();
+      }
+
+      uint64_t written = 0;
+      // Merge including combiner support.
+      memcpy(str.Get(), queue.Top(), entry_size);
+      for (queue.Pop(); !queue.Empty(); queue.Pop()) {
+        if (!combine_(str.Get(), queue.Top(), compare_)) {
+          ++written; ++str;
+          memcpy(str.Get(), queue.Top(), entry_size);
+        }
+      }
+      ++written; ++str;
+      if (out_offsets_)
+        out_offsets_->Append(written * entry_size);
+    }
+
     void ReadSingle(uint64_t offset, const uint64_t size, const ChainPosition &position) {
       // Special case: only one to read.
       const uint64_t end = offset + size;
@@ -330,6 +437,8 @@ template <class Compare, class Combine> class MergingReader {
 
     std::size_t buffer_size_;
     std::size_t total_memory_;
+
+    bool loser_tree_;
 };
 
 // The lazy step owns the remaining files.  This keeps track of them.
@@ -337,8 +446,8 @@ template <class Compare, class Combine> class OwningMergingReader : public Mergi
   private:
     typedef MergingReader<Compare, Combine> P;
   public:
-    OwningMergingReader(int data, const Offsets &offsets, std::size_t buffer, std::size_t lazy, const Compare &compare, const Combine &combine)
-      : P(data, NULL, NULL, buffer, lazy, compare, combine),
+    OwningMergingReader(int data, const Offsets &offsets, std::size_t buffer, std::size_t lazy, const Compare &compare, const Combine &combine, bool loser_tree = false)
+      : P(data, NULL, NULL, buffer, lazy, compare, combine, loser_tree),
         data_(data),
         offsets_(offsets) {}
 
@@ -354,6 +463,243 @@ template <class Compare, class Combine> class OwningMergingReader : public Mergi
     Offsets offsets_;
 };
 
+/* Don't use this directly.  One pass of merge sort from file to file, like
+ * MergingReader feeding WriteAndRecycle, but using several threads.  Each
+ * group of runs is cut into key ranges at splitters sampled from the runs and
+ * the ranges are merged at the same time.  Every entry equal to a splitter
+ * goes to the range that starts there, so entries the combiner could join
+ * always meet.  This assumes the combiner only joins entries that compare
+ * equal.  Memory is divided between the threads.
+ */
+template <class Compare, class Combine> class ParallelMerge {
+  public:
+    ParallelMerge(int in, Offsets &in_offsets, int out, Offsets &out_offsets, std::size_t entry_size, const SortConfig &config, std::size_t reading_memory, const Compare &compare, const Combine &combine)
+      : compare_(compare), combine_(combine),
+        in_(in), out_(out),
+        in_offsets_(&in_offsets), out_offsets_(&out_offsets),
+        entry_size_(entry_size),
+        config_(config),
+        threads_(std::max<std::size_t>(1, config.merge_threads)),
+        reading_memory_(reading_memory) {}
+
+    void Run() {
+      uint64_t out_end = 0;
+      while (in_offsets_->RemainingBlocks()) {
+        uint64_t per_buffer = MergeBufferSize(config_.buffer_size, reading_memory_, in_offsets_->RemainingBlocks(), entry_size_);
+        // Same groups as MergingReader.
+        runs_.clear();
+        for (uint64_t used = 0; in_offsets_->RemainingBlocks() && used + std::min(per_buffer, in_offsets_->PeekSize()) <= reading_memory_;) {
+          Piece piece;
+          piece.offset = in_offsets_->TotalOffset();
+          piece.size = in_offsets_->NextSize();
+          used += std::min(piece.size, per_buffer);
+          runs_.push_back(piece);
+        }
+        if (runs_.size() < 2 && in_offsets_->RemainingBlocks()) {
+          std::cerr << "Bug in sort implementation: not merging at least two stripes." << std::endl;
+          abort();
+        }
+        uint64_t written = MergeGroup(per_buffer, out_end);
+        out_offsets_->Append(written);
+        out_end += written;
+      }
+      ResizeOrThrow(out_, out_end);
+    }
+
+  private:
+    struct Piece {
+      uint64_t offset, size;
+    };
+
+    struct Range {
+      // Where this range goes in the output if nothing is combined.
+      uint64_t out;
+      uint64_t written;
+    };
+
+    class RangeWorker {
+      public:
+        RangeWorker(ParallelMerge &merge, std::size_t range) : merge_(&merge), range_(range) {}
+
+        void operator()() {
+          try {
+            merge_->MergeRange(range_);
+          } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            abort();
+          }
+        }
+
+      private:
+        ParallelMerge *merge_;
+        std::size_t range_;
+    };
+
+    // Returns bytes written starting at out_begin.
+    uint64_t MergeGroup(uint64_t per_buffer, uint64_t out_begin) {
+      FindBounds();
+      ranges_.resize(threads_);
+      uint64_t out = out_begin;
+      for (std::size_t r = 0; r < threads_; ++r) {
+        ranges_[r].out = out;
+        ranges_[r].written = 0;
+        for (std::size_t i = 0; i < runs_.size(); ++i) {
+          out += (Bound(i, r + 1) - Bound(i, r)) * entry_size_;
+        }
+      }
+      run_buffer_ = std::max<std::size_t>(entry_size_, per_buffer / threads_);
+      run_buffer_ -= run_buffer_ % entry_size_;
+      write_buffer_ = std::max<std::size_t>(entry_size_, 2 * config_.buffer_size / threads_);
+      write_buffer_ -= write_buffer_ % entry_size_;
+
+      std::vector<boost::thread*> workers;
+      for (std::size_t r = 1; r < threads_; ++r) {
+        workers.push_back(new boost::thread(RangeWorker(*this, r)));
+      }
+      RangeWorker(*this, 0)();
+      for (std::size_t r = 0; r < workers.size(); ++r) {
+        workers[r]->join();
+        delete workers[r];
+      }
+
+      // Close any gaps left by combining.
+      uint64_t to = out_begin + ranges_[0].written;
+      for (std::size_t r = 1; r < threads_; ++r) {
+        if (to != ranges_[r].out) MoveDown(ranges_[r].out, to, ranges_[r].written);
+        to += ranges_[r].written;
+      }
+      return to - out_begin;
+    }
+
+    // Index of the first entry of run i that belongs to range r.
+    uint64_t &Bound(std::size_t i, std::size_t r) {
+      return bounds_[i * (threads_ + 1) + r];
+    }
+
+    void FindBounds() {
+      bounds_.resize(runs_.size() * (threads_ + 1));
+      for (std::size_t i = 0; i < runs_.size(); ++i) {
+        Bound(i, 0) = 0;
+        Bound(i, threads_) = runs_[i].size / entry_size_;
+      }
+      if (threads_ == 1) return;
+
+      // Sample about kSamples entries per range, from each run in proportion
+      // to its size.
+      const uint64_t kSamples = 16;
+      uint64_t total = 0;
+      for (std::size_t i = 0; i < runs_.size(); ++i) {
+        total += runs_[i].size / entry_size_;
+      }
+      const uint64_t step = std::max<uint64_t>(1, total / (kSamples * threads_));
+      std::vector<uint8_t> samples;
+      for (std::size_t i = 0; i < runs_.size(); ++i) {
+        for (uint64_t e = step / 2; e < Bound(i, threads_); e += step) {
+          samples.resize(samples.size() + entry_size_);
+          ErsatzPRead(in_, &*samples.end() - entry_size_, entry_size_, runs_[i].offset + e * entry_size_);
+        }
+      }
+      const std::size_t count = samples.size() / entry_size_;
+      if (!count) {
+        for (std::size_t i = 0; i < runs_.size(); ++i) {
+          for (std::size_t r = 1; r < threads_; ++r) Bound(i, r) = 0;
+        }
+        return;
+      }
+      std::sort(SizedIt(&samples[0], entry_size_), SizedIt(&samples[0] + samples.size(), entry_size_), SizedCompare<Compare>(compare_));
+
+      std::vector<uint8_t> probe(entry_size_);
+      for (std::size_t r = 1; r < threads_; ++r) {
+        const void *splitter = &samples[(r * count / threads_) * entry_size_];
+        for (std::size_t i = 0; i < runs_.size(); ++i) {
+          // Binary search for the first entry that isn't less than splitter.
+          uint64_t low = Bound(i, r - 1), high = Bound(i, threads_);
+          while (low < high) {
+            uint64_t mid = low + (high - low) / 2;
+            ErsatzPRead(in_, &probe[0], entry_size_, runs_[i].offset + mid * entry_size_);
+            if (compare_(&probe[0], splitter)) {
+              low = mid + 1;
+            } else {
+              high = mid;
+            }
+          }
+          Bound(i, r) = low;
+        }
+      }
+    }
+
+    void MergeRange(std::size_t r) {
+      if (config_.loser_tree) {
+        LoserTree<Compare> queue(in_, run_buffer_, entry_size_, compare_);
+        MergeRange(queue, r);
+      } else {
+        MergeQueue<Compare> queue(in_, run_buffer_, entry_size_, compare_);
+        MergeRange(queue, r);
+      }
+    }
+
+    template <class Queue> void MergeRange(Queue &queue, std::size_t r) {
+      scoped_malloc buffer(MallocOrThrow(run_buffer_ * runs_.size() + write_buffer_));
+      uint8_t *buf = static_cast<uint8_t*>(buffer.get());
+      for (std::size_t i = 0; i < runs_.size(); ++i) {
+        uint64_t amount = (Bound(i, r + 1) - Bound(i, r)) * entry_size_;
+        if (!amount) continue;
+        queue.Push(buf, runs_[i].offset + Bound(i, r) * entry_size_, amount);
+        buf += static_cast<std::size_t>(std::min<uint64_t>(amount, run_buffer_));
+      }
+      queue.Build();
+      if (queue.Empty()) return;
+
+      Range &range = ranges_[r];
+      uint8_t *const write_begin = buf, *const write_end = buf + write_buffer_;
+      uint8_t *cur = write_begin;
+      // Merge including combiner support.
+      memcpy(cur, queue.Top(), entry_size_);
+      for (queue.Pop(); !queue.Empty(); queue.Pop()) {
+        if (!combine_(cur, queue.Top(), compare_)) {
+          cur += entry_size_;
+          if (cur == write_end) {
+            ErsatzPWrite(out_, write_begin, write_buffer_, range.out + range.written);
+            range.written += write_buffer_;
+            cur = write_begin;
+          }
+          memcpy(cur, queue.Top(), entry_size_);
+        }
+      }
+      cur += entry_size_;
+      ErsatzPWrite(out_, write_begin, cur - write_begin, range.out + range.written);
+      range.written += cur - write_begin;
+    }
+
+    // Copy size bytes from offset from to offset to < from in the output.
+    void MoveDown(uint64_t from, uint64_t to, uint64_t size) {
+      scoped_malloc buffer(MallocOrThrow(config_.buffer_size));
+      for (uint64_t done = 0; done < size;) {
+        std::size_t amount = static_cast<std::size_t>(std::min<uint64_t>(config_.buffer_size, size - done));
+        ErsatzPRead(out_, buffer.get(), amount, from + done);
+        ErsatzPWrite(out_, buffer.get(), amount, to + done);
+        done += amount;
+      }
+    }
+
+    const Compare compare_;
+    const Combine combine_;
+
+    const int in_, out_;
+    Offsets *in_offsets_, *out_offsets_;
+
+    const std::size_t entry_size_;
+    const SortConfig config_;
+    const std::size_t threads_;
+    const std::size_t reading_memory_;
+
+    // Current group.
+    std::vector<Piece> runs_;
+    std::vector<uint64_t> bounds_;
+    std::vector<Range> ranges_;
+    std::size_t run_buffer_, write_buffer_;
+};
+
 // Don't use this directly.  Worker that sorts blocks.
 template <class Compare> class BlockSorter {
   public:
@@ -383,6 +729,60 @@ template <class Compare> class BlockSorter {
     SizedCompare<Compare> compare_;
 };
 
+// Don't use this directly.  Lets several chains append sorted blocks to the
+// same file.  Offsets are recorded in the order blocks are written.
+class SharedSortedBlocks {
+  public:
+    SharedSortedBlocks(int fd, Offsets &offsets, std::size_t writers)
+      : fd_(fd), offsets_(&offsets), writers_(writers) {}
+
+    void Append(const void *data, std::size_t size) {
+      boost::mutex::scoped_lock lock(mutex_);
+      WriteOrThrow(fd_, data, size);
+      offsets_->Append(size);
+    }
+
+    void Finished() {
+      boost::mutex::scoped_lock lock(mutex_);
+      if (!--writers_) offsets_->FinishedAppending();
+    }
+
+  private:
+    boost::mutex mutex_;
+    int fd_;
+    Offsets *offsets_;
+    std::size_t writers_;
+};
+
+// Don't use this directly.  Worker that sorts blocks from one of several
+// chains and writes them to the shared file.
+template <class Compare> class SharedBlockSorter {
+  public:
+    SharedBlockSorter(SharedSortedBlocks &shared, const Compare &compare) :
+      shared_(&shared), compare_(compare) {}
+
+    void Run(const ChainPosition &position) {
+      const std::size_t entry_size = position.GetChain().EntrySize();
+      for (Link link(position); link; ++link) {
+        void *end = static_cast<uint8_t*>(link->Get()) + link->ValidSize();
+#if defined(_WIN32) || defined(_WIN64)
+        std::stable_sort
+#else
+        std::sort
+#endif
+          (SizedIt(link->Get(), entry_size),
+           SizedIt(end, entry_size),
+           compare_);
+        shared_->Append(link->Get(), link->ValidSize());
+      }
+      shared_->Finished();
+    }
+
+  private:
+    SharedSortedBlocks *shared_;
+    SizedCompare<Compare> compare_;
+};
+
 class BadSortConfig : public Exception {
   public:
     BadSortConfig() throw() {}
@@ -399,14 +799,29 @@ template <class Compare, class Combine = NeverCombine> class Sort {
         offsets_file_(MakeTemp(config.temp_prefix)), offsets_(offsets_file_.get()),
         compare_(compare), combine_(combine),
         entry_size_(in.EntrySize()) {
-      UTIL_THROW_IF(!entry_size_, BadSortConfig, "Sorting entries of size 0");
-      // Make buffer_size a multiple of the entry_size.
-      config_.buffer_size -= config_.buffer_size % entry_size_;
-      UTIL_THROW_IF(!config_.buffer_size, BadSortConfig, "Sort buffer too small");
-      UTIL_THROW_IF(config_.total_memory < config_.buffer_size * 4, BadSortConfig, "Sorting memory " << config_.total_memory << " is too small for four buffers (two read and two write).");
+      CheckConfig();
       in >> BlockSorter<Compare>(offsets_, compare_) >> WriteAndRecycle(data_.get());
     }
 
+    /** Sorts everything that comes down several chains with the same entry
+     * size, e.g. written by parallel workers.  Each chain sorts its blocks on
+     * its own thread.  Output is the same as if they had come down one chain
+     * in any order, provided the combiner doesn't care about order.
+     */
+    Sort(Chains &in, const SortConfig &config, const Compare &compare = Compare(), const Combine &combine = Combine())
+      : config_(config),
+        data_(MakeTemp(config.temp_prefix)),
+        offsets_file_(MakeTemp(config.temp_prefix)), offsets_(offsets_file_.get()),
+        compare_(compare), combine_(combine),
+        entry_size_(in.empty() ? 0 : in[0].EntrySize()),
+        shared_(new SharedSortedBlocks(data_.get(), offsets_, in.size())) {
+      CheckConfig();
+      for (Chain *i = in.begin(); i != in.end(); ++i) {
+        UTIL_THROW_IF(i->EntrySize() != entry_size_, BadSortConfig, "Chains to sort have different entry sizes");
+        *i >> SharedBlockSorter<Compare>(*shared_, compare_) >> kRecycle;
+      }
+    }
+
     uint64_t Size() const {
       return SizeOrThrow(data_.get());
     }
@@ -430,12 +845,15 @@ template <class Compare, class Combine = NeverCombine> class Sort {
       Offsets offsets2(offsets2_file.get());
       Offsets *offsets_in = &offsets_, *offsets_out = &offsets2;
 
-      // Double buffered writing.
-      ChainConfig chain_config;
-      chain_config.entry_size = entry_size_;
-      chain_config.block_count = 2;
-      chain_config.total_memory = config_.buffer_size * 2;
-      Chain chain(chain_config);
+      // Double buffered writing.  ParallelMerge has its own write buffers.
+      scoped_ptr<Chain> chain;
+      if (config_.merge_threads <= 1) {
+        ChainConfig chain_config;
+        chain_config.entry_size = entry_size_;
+        chain_config.block_count = 2;
+        chain_config.total_memory = config_.buffer_size * 2;
+        chain.reset(new Chain(chain_config));
+      }
 
       while (offsets_in->RemainingBlocks() > lazy_arity) {
         if (size <= static_cast<uint64_t>(lazy_memory)) break;
@@ -444,15 +862,24 @@ template <class Compare, class Combine = NeverCombine> class Sort {
           reading_memory = static_cast<std::size_t>(size);
         }
         SeekOrThrow(fd_in, 0);
-        chain >>
-          MergingReader<Compare, Combine>(
-              fd_in,
-              offsets_in, offsets_out,
-              config_.buffer_size,
+        if (chain.get()) {
+          *chain >>
+            MergingReader<Compare, Combine>(
+                fd_in,
+                offsets_in, offsets_out,
+                config_.buffer_size,
+                reading_memory,
+                compare_, combine_, config_.loser_tree) >>
+            WriteAndRecycle(fd_out);
+          chain->Wait();
+        } else {
+          ParallelMerge<Compare, Combine>(
+              fd_in, *offsets_in,
+              fd_out, *offsets_out,
+              entry_size_, config_,
               reading_memory,
-              compare_, combine_) >>
-          WriteAndRecycle(fd_out);
-        chain.Wait();
+              compare_, combine_).Run();
+        }
         offsets_out->FinishedAppending();
         ResizeOrThrow(fd_in, 0);
         offsets_in->Reset();
@@ -473,11 +900,11 @@ template <class Compare, class Combine = NeverCombine> class Sort {
     }
 
     // Output to chain, using this amount of memory, maximum, for lazy merge
-    // sort.
+    // sort.  The lazy merge runs on one thread since it feeds a single chain.
     void Output(Chain &out, std::size_t lazy_memory) {
       Merge(lazy_memory);
       out.SetProgressTarget(Size());
-      out >> OwningMergingReader<Compare, Combine>(data_.get(), offsets_, config_.buffer_size, lazy_memory, compare_, combine_);
+      out >> OwningMergingReader<Compare, Combine>(data_.get(), offsets_, config_.buffer_size, lazy_memory, compare_, combine_, config_.loser_tree);
       data_.release();
       offsets_file_.release();
     }
@@ -524,6 +951,14 @@ template <class Compare, class Combine = NeverCombine> class Sort {
     }
 
   private:
+    void CheckConfig() {
+      UTIL_THROW_IF(!entry_size_, BadSortConfig, "Sorting entries of size 0");
+      // Make buffer_size a multiple of the entry_size.
+      config_.buffer_size -= config_.buffer_size % entry_size_;
+      UTIL_THROW_IF(!config_.buffer_size, BadSortConfig, "Sort buffer too small");
+      UTIL_THROW_IF(config_.total_memory < config_.buffer_size * 4, BadSortConfig, "Sorting memory " << config_.total_memory << " is too small for four buffers (two read and two write).");
+    }
+
     SortConfig config_;
 
     scoped_fd data_;
@@ -534,6 +969,9 @@ template <class Compare, class Combine = NeverCombine> class Sort {
     const Compare compare_;
     const Combine combine_;
     const std::size_t entry_size_;
+
+    // Only when sorting several chains.
+    scoped_ptr<SharedSortedBlocks> shared_;
 };
 
 // returns bytes to be read on demand.
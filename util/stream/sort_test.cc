@@ -30,7 +30,7 @@ struct Putter {
   std::vector<uint64_t> &shuffled_;
 };
 
-BOOST_AUTO_TEST_CASE(FromShuffled) {
+void SortShuffled(const SortConfig &merge_config) {
   std::vector<uint64_t> shuffled;
   shuffled.reserve(kSize);
   for (uint64_t i = 0; i < kSize; ++i) {
@@ -43,11 +43,6 @@ BOOST_AUTO_TEST_CASE(FromShuffled) {
   config.total_memory = 800;
   config.block_count = 3;
 
-  SortConfig merge_config;
-  merge_config.temp_prefix = "sort_test_temp";
-  merge_config.buffer_size = 800;
-  merge_config.total_memory = 3300;
-
   Chain chain(config);
   chain >> Putter(shuffled);
   BlockingSort(chain, merge_config, CompareUInt64(), NeverCombine());
@@ -59,4 +54,82 @@ BOOST_AUTO_TEST_CASE(FromShuffled) {
   BOOST_CHECK(!sorted);
 }
 
+SortConfig SmallConfig() {
+  SortConfig merge_config;
+  merge_config.temp_prefix = "sort_test_temp";
+  merge_config.buffer_size = 800;
+  merge_config.total_memory = 3300;
+  return merge_config;
+}
+
+BOOST_AUTO_TEST_CASE(FromShuffled) {
+  SortShuffled(SmallConfig());
+}
+
+BOOST_AUTO_TEST_CASE(LoserTreeFromShuffled) {
+  SortConfig merge_config(SmallConfig());
+  merge_config.loser_tree = true;
+  SortShuffled(merge_config);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelFromShuffled) {
+  SortConfig merge_config(SmallConfig());
+  merge_config.merge_threads = 3;
+  SortShuffled(merge_config);
+  merge_config.loser_tree = true;
+  SortShuffled(merge_config);
+}
+
+// Entries are a key and a count.  Equal keys are combined by adding counts.
+struct CombineCount {
+  template <class Compare> bool operator()(void *into_void, const void *option_void, const Compare &) const {
+    uint64_t *into = static_cast<uint64_t*>(into_void);
+    const uint64_t *option = static_cast<const uint64_t*>(option_void);
+    if (into[0] != option[0]) return false;
+    into[1] += option[1];
+    return true;
+  }
+};
+
+struct KeyPutter {
+  void Run(const ChainPosition &position) {
+    Stream put(position);
+    for (uint64_t i = 0; i < kSize; ++i, ++put) {
+      uint64_t *entry = static_cast<uint64_t*>(put.Get());
+      // Each key appears four times, spread across the input.
+      entry[0] = (i * 7919) % (kSize / 4);
+      entry[1] = 1;
+    }
+    put.Poison();
+  }
+};
+
+BOOST_AUTO_TEST_CASE(ParallelCombine) {
+  ChainConfig config;
+  config.entry_size = 16;
+  config.total_memory = 1600;
+  config.block_count = 3;
+
+  SortConfig merge_config;
+  merge_config.temp_prefix = "sort_test_temp";
+  merge_config.buffer_size = 1600;
+  merge_config.total_memory = 6600;
+  merge_config.merge_threads = 4;
+
+  Chain chain(config);
+  chain >> KeyPutter();
+  Sort<CompareUInt64, CombineCount> sorter(chain, merge_config, CompareUInt64(), CombineCount());
+  chain.Wait(true);
+  // Merge completely so only the parallel passes combine.
+  util::scoped_fd sorted_file(sorter.StealCompleted());
+  uint64_t size = SizeOrThrow(sorted_file.get());
+  BOOST_REQUIRE_EQUAL(kSize / 4 * 16, size);
+  std::vector<uint64_t> sorted(size / 8);
+  ReadOrThrow(sorted_file.get(), &sorted[0], size);
+  for (uint64_t i = 0; i < kSize / 4; ++i) {
+    BOOST_CHECK_EQUAL(i, sorted[2 * i]);
+    BOOST_CHECK_EQUAL(4U, sorted[2 * i + 1]);
+  }
+}
+
 }}} // namespaces
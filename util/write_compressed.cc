@@ -0,0 +1,355 @@
+#include "util/write_compressed.hh"
+
+#include "util/file.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTDLIB
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4LIB
+#include <lz4frame.h>
+#endif
+
+namespace util {
+
+Compression CompressionFromExtension(StringPiece path) {
+  if (path.ends_with(".gz")) return GZIP;
+  if (path.ends_with(".zst")) return ZSTD;
+  if (path.ends_with(".lz4")) return LZ4;
+  return UNCOMPRESSED;
+}
+
+Compression CompressionFromName(StringPiece name) {
+  if (name == "none") return UNCOMPRESSED;
+  if (name == "gz" || name == "gzip") return GZIP;
+  if (name == "zst" || name == "zstd") return ZSTD;
+  if (name == "lz4") return LZ4;
+  UTIL_THROW(CompressedException, "Unknown compression " << name << ".  Expected none, gz, zst or lz4.");
+}
+
+bool HaveCompression(Compression compression) {
+  switch (compression) {
+    case UNCOMPRESSED:
+      return true;
+    case GZIP:
+#ifdef HAVE_ZLIB
+      return true;
+#else
+      return false;
+#endif
+    case ZSTD:
+#ifdef HAVE_ZSTDLIB
+      return true;
+#else
+      return false;
+#endif
+    case LZ4:
+#ifdef HAVE_LZ4LIB
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+class WriteBase {
+  public:
+    explicit WriteBase(int fd) : fd_(fd) {}
+
+    virtual ~WriteBase() {}
+
+    virtual void Write(const void *data, std::size_t amount) = 0;
+
+    virtual void Finish() = 0;
+
+  protected:
+    scoped_fd fd_;
+};
+
+namespace {
+
+const std::size_t kOutputBuffer = 65536;
+
+class UncompressedWrite : public WriteBase {
+  public:
+    explicit UncompressedWrite(int fd) : WriteBase(fd) {}
+
+    void Write(const void *data, std::size_t amount) {
+      WriteOrThrow(fd_.get(), data, amount);
+    }
+
+    void Finish() {}
+};
+
+#ifdef HAVE_ZLIB
+class GZipWrite : public WriteBase {
+  public:
+    explicit GZipWrite(int fd) : WriteBase(fd), buffer_(MallocOrThrow(kOutputBuffer)) {
+      memset(&stream_, 0, sizeof(stream_));
+      // 16 + 15 for a gzip header and the maximum window size.
+      UTIL_THROW_IF(Z_OK != deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY), GZException, "Failed to initialize zlib.");
+    }
+
+    ~GZipWrite() {
+      deflateEnd(&stream_);
+    }
+
+    void Write(const void *data, std::size_t amount) {
+      const Bytef *from = static_cast<const Bytef*>(data);
+      while (amount) {
+        std::size_t sending = std::min<std::size_t>(std::numeric_limits<uInt>::max(), amount);
+        stream_.next_in = const_cast<Bytef*>(from);
+        stream_.avail_in = sending;
+        while (stream_.avail_in) Deflate(Z_NO_FLUSH);
+        from += sending;
+        amount -= sending;
+      }
+    }
+
+    void Finish() {
+      while (Deflate(Z_FINISH) != Z_STREAM_END) {}
+    }
+
+  private:
+    int Deflate(int flush) {
+      stream_.next_out = static_cast<Bytef*>(buffer_.get());
+      stream_.avail_out = kOutputBuffer;
+      int result = deflate(&stream_, flush);
+      UTIL_THROW_IF(result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR, GZException, "zlib encountered " << (stream_.msg ? stream_.msg : "an error ") << " code " << result);
+      WriteOrThrow(fd_.get(), buffer_.get(), kOutputBuffer - stream_.avail_out);
+      return result;
+    }
+
+    z_stream stream_;
+    scoped_malloc buffer_;
+};
+#endif // HAVE_ZLIB
+
+#ifdef HAVE_ZSTDLIB
+class ZStdWrite : public WriteBase {
+  public:
+    explicit ZStdWrite(int fd) : WriteBase(fd), context_(ZSTD_createCCtx()), buffer_size_(ZSTD_CStreamOutSize()), buffer_(MallocOrThrow(buffer_size_)) {
+      if (!context_) throw std::bad_alloc();
+    }
+
+    ~ZStdWrite() {
+      ZSTD_freeCCtx(context_);
+    }
+
+    void Write(const void *data, std::size_t amount) {
+      ZSTD_inBuffer in;
+      in.src = data;
+      in.size = amount;
+      in.pos = 0;
+      while (in.pos != in.size) Compress(in, ZSTD_e_continue);
+    }
+
+    void Finish() {
+      ZSTD_inBuffer in;
+      in.src = NULL;
+      in.size = 0;
+      in.pos = 0;
+      // Returns how much is left to flush.
+      while (Compress(in, ZSTD_e_end)) {}
+    }
+
+  private:
+    std::size_t Compress(ZSTD_inBuffer &in, ZSTD_EndDirective directive) {
+      ZSTD_outBuffer out;
+      out.dst = buffer_.get();
+      out.size = buffer_size_;
+      out.pos = 0;
+      std::size_t ret = ZSTD_compressStream2(context_, &out, &in, directive);
+      UTIL_THROW_IF(ZSTD_isError(ret), ZStdException, "zstd says " << ZSTD_getErrorName(ret));
+      WriteOrThrow(fd_.get(), buffer_.get(), out.pos);
+      return ret;
+    }
+
+    ZSTD_CCtx *context_;
+    std::size_t buffer_size_;
+    scoped_malloc buffer_;
+};
+#endif // HAVE_ZSTDLIB
+
+#ifdef HAVE_LZ4LIB
+class LZ4Write : public WriteBase {
+  public:
+    explicit LZ4Write(int fd) : WriteBase(fd) {
+      HandleError(LZ4F_createCompressionContext(&context_, LZ4F_VERSION));
+      // Big enough for any kOutputBuffer of input, the header, or the end.
+      buffer_size_ = LZ4F_compressBound(kOutputBuffer, NULL);
+      buffer_.reset(MallocOrThrow(buffer_size_));
+      Flush(HandleError(LZ4F_compressBegin(context_, buffer_.get(), buffer_size_, NULL)));
+    }
+
+    ~LZ4Write() {
+      LZ4F_freeCompressionContext(context_);
+    }
+
+    void Write(const void *data, std::size_t amount) {
+      const uint8_t *from = static_cast<const uint8_t*>(data);
+      while (amount) {
+        std::size_t sending = std::min(amount, kOutputBuffer);
+        Flush(HandleError(LZ4F_compressUpdate(context_, buffer_.get(), buffer_size_, from, sending, NULL)));
+        from += sending;
+        amount -= sending;
+      }
+    }
+
+    void Finish() {
+      Flush(HandleError(LZ4F_compressEnd(context_, buffer_.get(), buffer_size_, NULL)));
+    }
+
+  private:
+    std::size_t HandleError(std::size_t value) {
+      UTIL_THROW_IF(LZ4F_isError(value), LZ4Exception, "lz4 says " << LZ4F_getErrorName(value));
+      return value;
+    }
+
+    void Flush(std::size_t amount) {
+      WriteOrThrow(fd_.get(), buffer_.get(), amount);
+    }
+
+    LZ4F_cctx *context_;
+    std::size_t buffer_size_;
+    scoped_malloc buffer_;
+};
+#endif // HAVE_LZ4LIB
+
+WriteBase *WriteFactory(int fd, Compression compression) {
+  scoped_fd hold(fd);
+  switch (compression) {
+    case UNCOMPRESSED:
+      return new UncompressedWrite(hold.release());
+    case GZIP:
+#ifdef HAVE_ZLIB
+      return new GZipWrite(hold.release());
+#else
+      UTIL_THROW(CompressedException, "gzip support was not compiled in.");
+#endif
+    case ZSTD:
+#ifdef HAVE_ZSTDLIB
+      return new ZStdWrite(hold.release());
+#else
+      UTIL_THROW(CompressedException, "zstd support was not compiled in.");
+#endif
+    case LZ4:
+#ifdef HAVE_LZ4LIB
+      return new LZ4Write(hold.release());
+#else
+      UTIL_THROW(CompressedException, "lz4 support was not compiled in.");
+#endif
+  }
+  UTIL_THROW(CompressedException, "Unknown compression " << compression);
+}
+
+} // namespace
+
+WriteCompressed::WriteCompressed(int fd, Compression compression)
+  : internal_(WriteFactory(fd, compression)) {}
+
+WriteCompressed::~WriteCompressed() {
+  if (!internal_.get()) return;
+  try {
+    Finish();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    abort();
+  }
+}
+
+void WriteCompressed::Write(const void *data, std::size_t amount) {
+  internal_->Write(data, amount);
+}
+
+void WriteCompressed::Finish() {
+  internal_->Finish();
+  // Closes the file.
+  internal_.reset();
+}
+
+WriteCompressedBuf::WriteCompressedBuf(int fd, Compression compression)
+  : out_(fd, compression), buffer_(MallocOrThrow(kOutputBuffer)), finished_(false) {
+  char *begin = static_cast<char*>(buffer_.get());
+  setp(begin, begin + kOutputBuffer);
+}
+
+WriteCompressedBuf::~WriteCompressedBuf() {
+  if (finished_) return;
+  try {
+    Finish();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    abort();
+  }
+}
+
+void WriteCompressedBuf::Finish() {
+  if (finished_) return;
+  FlushBuffer();
+  out_.Finish();
+  finished_ = true;
+  // Every later write goes through overflow or xsputn, which refuse it.
+  setp(NULL, NULL);
+}
+
+void WriteCompressedBuf::FlushBuffer() {
+  out_.Write(pbase(), pptr() - pbase());
+  setp(pbase(), epptr());
+}
+
+WriteCompressedBuf::int_type WriteCompressedBuf::overflow(int_type c) {
+  if (finished_) return traits_type::eof();
+  FlushBuffer();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize WriteCompressedBuf::xsputn(const char *s, std::streamsize n) {
+  if (finished_) return 0;
+  if (n < epptr() - pptr()) {
+    memcpy(pptr(), s, n);
+    pbump(n);
+  } else {
+    FlushBuffer();
+    out_.Write(s, n);
+  }
+  return n;
+}
+
+int WriteCompressedBuf::sync() {
+  if (!finished_) FlushBuffer();
+  return 0;
+}
+
+ReadCompressedBuf::ReadCompressedBuf(int fd)
+  : in_(fd), buffer_(MallocOrThrow(kOutputBuffer)) {
+  char *begin = static_cast<char*>(buffer_.get());
+  setg(begin, begin, begin);
+}
+
+ReadCompressedBuf::int_type ReadCompressedBuf::underflow() {
+  if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+  char *begin = static_cast<char*>(buffer_.get());
+  std::size_t got = in_.Read(begin, kOutputBuffer);
+  if (!got) return traits_type::eof();
+  setg(begin, begin, begin + got);
+  return traits_type::to_int_type(*gptr());
+}
+
+} // namespace util
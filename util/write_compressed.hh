@@ -0,0 +1,95 @@
+#ifndef UTIL_WRITE_COMPRESSED_H
+#define UTIL_WRITE_COMPRESSED_H
+
+#include "util/read_compressed.hh"
+#include "util/scoped.hh"
+#include "util/string_piece.hh"
+
+#include <cstddef>
+#include <streambuf>
+
+namespace util {
+
+enum Compression {
+  UNCOMPRESSED, GZIP, ZSTD, LZ4
+};
+
+// .gz, .zst or .lz4 at the end of path.  Anything else is UNCOMPRESSED.
+Compression CompressionFromExtension(StringPiece path);
+
+// none, gz (or gzip), zst (or zstd) or lz4.  Throws CompressedException for
+// anything else.
+Compression CompressionFromName(StringPiece name);
+
+// Whether this build can write the format.  UNCOMPRESSED always works.
+bool HaveCompression(Compression compression);
+
+class WriteBase;
+
+/* The writing side of ReadCompressed, which can read everything written here.
+ * Output is buffered so small writes are fine.  zstd and lz4 are much cheaper
+ * on CPU than gzip, which makes them better for temporary files.
+ */
+class WriteCompressed {
+  public:
+    // Takes ownership of fd.  Throws CompressedException if compression was
+    // not compiled in.
+    WriteCompressed(int fd, Compression compression);
+
+    // Calls Finish if it hasn't been called.
+    ~WriteCompressed();
+
+    void Write(const void *data, std::size_t amount);
+
+    // End the compressed stream and write everything out.  Write may not be
+    // called afterwards.
+    void Finish();
+
+  private:
+    scoped_ptr<WriteBase> internal_;
+};
+
+// For iostreams: a std::streambuf that writes through WriteCompressed.
+class WriteCompressedBuf : public std::streambuf {
+  public:
+    // Takes ownership of fd.
+    WriteCompressedBuf(int fd, Compression compression);
+
+    // Calls Finish if it hasn't been called.
+    ~WriteCompressedBuf();
+
+    // Flush and end the compressed stream.  Writes after this fail; flushing
+    // and calling Finish again do nothing.
+    void Finish();
+
+  protected:
+    int_type overflow(int_type c);
+    std::streamsize xsputn(const char *s, std::streamsize n);
+    int sync();
+
+  private:
+    void FlushBuffer();
+
+    WriteCompressed out_;
+    scoped_malloc buffer_;
+    bool finished_;
+};
+
+// For iostreams: a std::streambuf that reads through ReadCompressed, so it
+// handles every format ReadCompressed does.
+class ReadCompressedBuf : public std::streambuf {
+  public:
+    // Takes ownership of fd.
+    explicit ReadCompressedBuf(int fd);
+
+  protected:
+    int_type underflow();
+
+  private:
+    ReadCompressed in_;
+    scoped_malloc buffer_;
+};
+
+} // namespace util
+
+#endif // UTIL_WRITE_COMPRESSED_H